@@ -20,6 +20,8 @@ Maintainer: Sylvain Miermont
 /* -------------------------------------------------------------------------- */
 /* --- DEPENDANCIES --------------------------------------------------------- */
 
+#include <stdbool.h>    /* bool type */
+
 #include "config.h"    /* library configuration options (dynamically generated) */
 
 /* -------------------------------------------------------------------------- */
@@ -43,6 +45,24 @@ Maintainer: Sylvain Miermont
 */
 void wait_ms(unsigned long t);
 
+/**
+@brief Wait for a certain time (microsecond accuracy)
+@param t number of microseconds to wait.
+*/
+void wait_us(unsigned long t);
+
+/**
+@brief Poll a condition until it is met, or until a timeout expires
+The condition is evaluated once more after the timeout expired, so that a
+descheduled caller does not report a timeout for a condition that is met.
+@param cond function returning true when the condition is met
+@param arg argument passed to the condition function
+@param timeout_ms maximum time to wait, in milliseconds
+@param period_us time between two evaluations of the condition, in microseconds
+@return true if the condition is met, false if the timeout expired
+*/
+bool wait_cond(bool (*cond)(void *arg), void *arg, unsigned long timeout_ms, unsigned long period_us);
+
 #endif
 
 /* --- EOF ------------------------------------------------------------------ */
@@ -25,6 +25,8 @@ Maintainer: Michael Coracin
 #include <stdint.h>     /* C99 types */
 #include <stdbool.h>    /* bool type */
 
+#include "loragw_reg.h"    /* compile-time specialised register accessors */
+
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC CONSTANTS ----------------------------------------------------- */
 
@@ -81,6 +83,50 @@ this file is autogenerated from registers description
 #define LGW_FPGA_NOTCH_FREQ_OFFSET 37
 #define LGW_FPGA_TOTALREGS 38
 
+/*
+descriptors of the FPGA registers: page, addr, offs, sign, leng, rdon, dflt
+used to build the register table, and by the LGW_*REG_W/R accessors
+*/
+
+#define LGW_FPGA_SOFT_RESET_DESC -1,0,0,0,1,0,0
+#define LGW_FPGA_FEATURE_DESC -1,0,1,0,4,1,0
+#define LGW_FPGA_LBT_INITIAL_FREQ_DESC -1,0,5,0,3,1,0
+#define LGW_FPGA_VERSION_DESC -1,1,0,0,8,1,0
+#define LGW_FPGA_STATUS_DESC -1,2,0,0,8,1,0
+#define LGW_FPGA_CTRL_FEATURE_START_DESC -1,3,0,0,1,0,0
+#define LGW_FPGA_CTRL_RADIO_RESET_DESC -1,3,1,0,1,0,0
+#define LGW_FPGA_CTRL_INPUT_SYNC_I_DESC -1,3,2,0,1,0,0
+#define LGW_FPGA_CTRL_INPUT_SYNC_Q_DESC -1,3,3,0,1,0,0
+#define LGW_FPGA_CTRL_OUTPUT_SYNC_DESC -1,3,4,0,1,0,0
+#define LGW_FPGA_CTRL_INVERT_IQ_DESC -1,3,5,0,1,0,0
+#define LGW_FPGA_CTRL_ACCESS_HISTO_MEM_DESC -1,3,6,0,1,0,0
+#define LGW_FPGA_CTRL_CLEAR_HISTO_MEM_DESC -1,3,7,0,1,0,0
+#define LGW_FPGA_HISTO_RAM_ADDR_DESC -1,4,0,0,8,0,0
+#define LGW_FPGA_HISTO_RAM_DATA_DESC -1,5,0,0,8,1,0
+#define LGW_FPGA_HISTO_NB_READ_DESC -1,8,0,0,16,0,1000
+#define LGW_FPGA_LBT_TIMESTAMP_CH_DESC -1,14,0,0,16,1,0
+#define LGW_FPGA_LBT_TIMESTAMP_SELECT_CH_DESC -1,17,0,0,4,0,0
+#define LGW_FPGA_LBT_CH0_FREQ_OFFSET_DESC -1,18,0,0,8,0,0
+#define LGW_FPGA_LBT_CH1_FREQ_OFFSET_DESC -1,19,0,0,8,0,0
+#define LGW_FPGA_LBT_CH2_FREQ_OFFSET_DESC -1,20,0,0,8,0,0
+#define LGW_FPGA_LBT_CH3_FREQ_OFFSET_DESC -1,21,0,0,8,0,0
+#define LGW_FPGA_LBT_CH4_FREQ_OFFSET_DESC -1,22,0,0,8,0,0
+#define LGW_FPGA_LBT_CH5_FREQ_OFFSET_DESC -1,23,0,0,8,0,0
+#define LGW_FPGA_LBT_CH6_FREQ_OFFSET_DESC -1,24,0,0,8,0,0
+#define LGW_FPGA_LBT_CH7_FREQ_OFFSET_DESC -1,25,0,0,8,0,0
+#define LGW_FPGA_SCAN_FREQ_OFFSET_DESC -1,26,0,0,8,0,0
+#define LGW_FPGA_LBT_SCAN_TIME_CH0_DESC -1,28,0,0,1,0,0
+#define LGW_FPGA_LBT_SCAN_TIME_CH1_DESC -1,28,1,0,1,0,0
+#define LGW_FPGA_LBT_SCAN_TIME_CH2_DESC -1,28,2,0,1,0,0
+#define LGW_FPGA_LBT_SCAN_TIME_CH3_DESC -1,28,3,0,1,0,0
+#define LGW_FPGA_LBT_SCAN_TIME_CH4_DESC -1,28,4,0,1,0,0
+#define LGW_FPGA_LBT_SCAN_TIME_CH5_DESC -1,28,5,0,1,0,0
+#define LGW_FPGA_LBT_SCAN_TIME_CH6_DESC -1,28,6,0,1,0,0
+#define LGW_FPGA_LBT_SCAN_TIME_CH7_DESC -1,28,7,0,1,0,0
+#define LGW_FPGA_RSSI_TARGET_DESC -1,30,0,0,8,0,160
+#define LGW_FPGA_HISTO_SCAN_FREQ_DESC -1,31,0,0,24,0,0
+#define LGW_FPGA_NOTCH_FREQ_OFFSET_DESC -1,34,0,0,6,0,0
+
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC FUNCTIONS PROTOTYPES ------------------------------------------ */
 
@@ -131,5 +177,12 @@ int lgw_fpga_reg_wb(uint16_t register_id, uint8_t *data, uint16_t size);
 */
 int lgw_fpga_reg_rb(uint16_t register_id, uint8_t *data, uint16_t size);
 
+/* -------------------------------------------------------------------------- */
+/* --- INTERNAL SHARED ACCESSORS -------------------------------------------- */
+
+/* same as LGW_REG_W/LGW_REG_R, for FPGA registers (eg. LGW_FPGA_REG_R(LGW_FPGA_VERSION, &val)) */
+#define LGW_FPGA_REG_W(reg, value)  reg_w_desc(LGW_SPI_MUX_TARGET_FPGA, -1, reg##_DESC, (value))
+#define LGW_FPGA_REG_R(reg, value)  reg_r_desc(LGW_SPI_MUX_TARGET_FPGA, -1, reg##_DESC, (value))
+
 #endif
 /* --- EOF ------------------------------------------------------------------ */
@@ -155,6 +155,24 @@ Maintainer: Sylvain Miermont
 /* LBT constants */
 #define LBT_CHANNEL_FREQ_NB 8 /* Number of LBT channels */
 
+/* Firmware loading verification modes */
+#define LGW_FW_CHECK_FULL       0   /* read back and compare the whole program RAM (default) */
+#define LGW_FW_CHECK_SAMPLE     1   /* read back and compare the first LGW_FW_CHECK_SAMPLE_SIZE bytes only */
+#define LGW_FW_CHECK_SAMPLE_SIZE    256
+
+/* Calibration cache constants */
+#define LGW_CALCACHE_PATH_SIZE  128 /* maximum size of the cache file path, including terminating null */
+
+/* phases of lgw_start, profiled by lgw_start_profile */
+#define LGW_START_PHASE_CONNECT 0   /* SPI connection and SX1301 soft reset */
+#define LGW_START_PHASE_RADIO   1   /* radios reset and setup (XTAL start-up, PLL lock) */
+#define LGW_START_PHASE_LBT     2   /* LBT setup, and wait for the first scan of all channels */
+#define LGW_START_PHASE_CAL     3   /* radios calibration, or restoration from the cache */
+#define LGW_START_PHASE_MODEM   4   /* modems and IF chains configuration */
+#define LGW_START_PHASE_FW      5   /* ARB & AGC firmwares load and version check */
+#define LGW_START_PHASE_AGC     6   /* AGC firmware initialization (TX gain LUT, radio select) */
+#define LGW_START_PHASE_NB      7   /* number of phases */
+
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC TYPES --------------------------------------------------------- */
 
@@ -200,6 +218,27 @@ struct lgw_conf_lbt_s {
     int8_t                      rssi_offset;        /*!> RSSI offset to be applied to SX127x RSSI values */
 };
 
+/**
+@struct lgw_conf_fw_s
+@brief Configuration structure for the loading of the MCU firmwares
+*/
+struct lgw_conf_fw_s {
+    uint8_t     check;          /*!> verification of the program RAM after loading (LGW_FW_CHECK_xxx) */
+    bool        keep_resident;  /*!> do not reload a firmware still present in program RAM (no power loss) */
+};
+
+/**
+@struct lgw_conf_calcache_s
+@brief Configuration structure for the calibration cache (warm restarts)
+*/
+struct lgw_conf_calcache_s {
+    bool        enable;                         /*!> enable or disable the calibration cache */
+    char        path[LGW_CALCACHE_PATH_SIZE];   /*!> file storing the results of the last calibration */
+    uint64_t    board_id;                       /*!> identity of the board (eg. gateway EUI), part of the cache key */
+    uint32_t    max_age_s;                      /*!> calibrate again if the cached results are older (seconds), 0 for no limit */
+    uint16_t    max_reuse;                      /*!> calibrate again after that many warm restarts, 0 for no limit */
+};
+
 /**
 @struct lgw_conf_rxrf_s
 @brief Configuration structure for a RF chain
@@ -250,6 +289,37 @@ struct lgw_pkt_rx_s {
     uint8_t     payload[256];   /*!> buffer containing the payload */
 };
 
+/**
+@struct lgw_conf_rxfilter_s
+@brief Configuration structure for the RX packet filters
+Packets rejected by a filter are removed from the RX FIFO by lgw_receive
+without transferring their payload. The CRC filters only use the FIFO status,
+the other filters read the metadata of the packet first.
+*/
+struct lgw_conf_rxfilter_s {
+    bool        enable;         /*!> enable or disable the RX packet filters */
+    bool        drop_crc_bad;   /*!> drop the packets with a bad CRC */
+    bool        drop_no_crc;    /*!> drop the packets without CRC */
+    uint16_t    if_chain_mask;  /*!> IF chains accepted, bit i for IF chain i, 0 to accept all */
+    bool        rssi_check;     /*!> drop the packets with a RSSI lower than rssi_min */
+    float       rssi_min;       /*!> minimum RSSI in dB, after correction */
+    bool        snr_check;      /*!> drop the LoRa packets with a SNR lower than snr_min */
+    float       snr_min;        /*!> minimum average SNR in dB */
+    bool        (*accept)(const struct lgw_pkt_rx_s *pkt, void *arg); /*!> user predicate on the metadata (payload not fetched yet), NULL for none */
+    void        *accept_arg;    /*!> argument passed to the user predicate */
+};
+
+/**
+@struct lgw_rxpoll_s
+@brief State of the adaptive RX polling policy (see lgw_rxpoll_next)
+*/
+struct lgw_rxpoll_s {
+    uint32_t    min_us;         /*!> shortest polling interval */
+    uint32_t    max_us;         /*!> longest polling interval, when idle */
+    uint32_t    fill_us;        /*!> shortest time for the RX FIFO to overflow, predicted from the channel plan */
+    uint32_t    interval_us;    /*!> current polling interval */
+};
+
 /**
 @struct lgw_pkt_tx_s
 @brief Structure containing the configuration of a packet to send and a pointer to the payload
@@ -273,6 +343,31 @@ struct lgw_pkt_tx_s {
     uint8_t     payload[256];   /*!> buffer containing the payload */
 };
 
+/**
+@struct lgw_start_phase_s
+@brief Time and SPI traffic of one phase of lgw_start
+A phase entered several times (eg. LBT) accumulates its durations and counters.
+*/
+struct lgw_start_phase_s {
+    const char  *name;          /*!> name of the phase, for reports */
+    uint64_t    start_ns;       /*!> first entry in the phase, in ns since the beginning of lgw_start */
+    uint64_t    duration_ns;    /*!> time spent in the phase, in ns */
+    uint32_t    nb_spi_call;    /*!> number of SPI transactions (a batch counts as one) */
+    uint64_t    nb_spi_byte;    /*!> number of SPI data bytes transferred */
+};
+
+/**
+@struct lgw_start_profile_s
+@brief Profile of the last call to lgw_start
+*/
+struct lgw_start_profile_s {
+    int                         status;         /*!> value returned by lgw_start */
+    uint8_t                     last_phase;     /*!> phase in which lgw_start returned (LGW_START_PHASE_xxx) */
+    uint64_t                    timestamp_ns;   /*!> beginning of lgw_start, CLOCK_MONOTONIC in ns */
+    uint64_t                    total_ns;       /*!> duration of lgw_start, in ns */
+    struct lgw_start_phase_s    phase[LGW_START_PHASE_NB];
+};
+
 /**
 @struct lgw_tx_gain_s
 @brief Structure containing all gains of Tx chain
@@ -311,6 +406,37 @@ int lgw_board_setconf(struct lgw_conf_board_s conf);
 */
 int lgw_lbt_setconf(struct lgw_conf_lbt_s conf);
 
+/**
+@brief Configure the loading of the MCU firmwares (must configure before start)
+The program RAM can only be read sequentially from its start, so the sample
+verification checks the beginning of the firmware; the firmware version is
+always checked once the MCU runs.
+@param conf structure containing the configuration parameters
+@return LGW_HAL_ERROR id the operation failed, LGW_HAL_SUCCESS else
+*/
+int lgw_fw_setconf(struct lgw_conf_fw_s conf);
+
+/**
+@brief Configure the calibration cache (must configure before start)
+When enabled, the results of the radio calibration are stored in a file and
+reused by the next starts, as long as the board, radio types, RF frequencies
+and clock source are the same and the expiry limits are not reached.
+@param conf structure containing the configuration parameters
+@return LGW_HAL_ERROR id the operation failed, LGW_HAL_SUCCESS else
+*/
+int lgw_calcache_setconf(struct lgw_conf_calcache_s conf);
+
+/**
+@brief Enable the start-up script
+The modems configuration written by lgw_start only depends on the configuration
+set: when enabled, it is compiled once in a script of bursts (page-sorted, no
+read-modify-write), and the next starts with the same configuration replay it
+in a single SPI batch. Calibration and firmwares are handled as usual.
+@param enable true to enable the script, false to write the registers at each start (default)
+@return LGW_HAL_SUCCESS
+*/
+int lgw_start_script_enable(bool enable);
+
 /**
 @brief Configure an RF chain (must configure before start)
 @param rf_chain number of the RF chain to configure [0, LGW_RF_CHAIN_NB - 1]
@@ -327,6 +453,27 @@ int lgw_rxrf_setconf(uint8_t rf_chain, struct lgw_conf_rxrf_s conf);
 */
 int lgw_rxif_setconf(uint8_t if_chain, struct lgw_conf_rxif_s conf);
 
+/**
+@brief Change the IF channel plan and/or RSSI offsets of a running concentrator
+Only the modem registers whose value changes are written, in one burst; radios,
+calibration and firmwares are left untouched. The radio of the LoRa 'multi'
+IF chains cannot be changed without a restart.
+@param if_conf array of LGW_IF_CHAIN_NB IF chains configurations, NULL to keep the current ones
+@param rssi_offset array of LGW_RF_CHAIN_NB RSSI offsets, NULL to keep the current ones
+@return LGW_HAL_ERROR if the concentrator is not running or the configuration is invalid (nothing is changed), LGW_HAL_SUCCESS else
+If writing the registers fails, the previous configuration is restored and its
+register values are written back; if that also fails, the modem state is undefined
+and the concentrator must be restarted.
+*/
+int lgw_reconfigure(const struct lgw_conf_rxif_s *if_conf, const float *rssi_offset);
+
+/**
+@brief Configure the RX packet filters applied by lgw_receive (can be changed at any time)
+@param conf structure containing the configuration parameters
+@return LGW_HAL_ERROR if the configuration is invalid, LGW_HAL_SUCCESS else
+*/
+int lgw_rxfilter_setconf(struct lgw_conf_rxfilter_s conf);
+
 /**
 @brief Configure the Tx gain LUT
 @param pointer to structure defining the LUT
@@ -336,6 +483,7 @@ int lgw_txgain_setconf(struct lgw_tx_gain_lut_s *conf);
 
 /**
 @brief Connect to the LoRa concentrator, reset it and configure it according to previously set parameters
+While it runs, the HAL functions called from other threads return LGW_HAL_ERROR.
 @return LGW_HAL_ERROR id the operation failed, LGW_HAL_SUCCESS else
 */
 int lgw_start(void);
@@ -346,6 +494,14 @@ int lgw_start(void);
 */
 int lgw_stop(void);
 
+/**
+@brief Get the profile (time and SPI traffic per phase) of the last call to lgw_start
+The profile is kept after lgw_stop, and is also filled when lgw_start fails.
+@param profile pointer to the structure to fill
+@return LGW_HAL_ERROR if lgw_start was never called, LGW_HAL_SUCCESS else
+*/
+int lgw_start_profile(struct lgw_start_profile_s *profile);
+
 /**
 @brief A non-blocking function that will fetch up to 'max_pkt' packets from the LoRa concentrator FIFO and data buffer
 @param max_pkt maximum number of packet that must be retrieved (equal to the size of the array of struct)
@@ -354,6 +510,32 @@ int lgw_stop(void);
 */
 int lgw_receive(uint8_t max_pkt, struct lgw_pkt_rx_s *pkt_data);
 
+/**
+@brief Initialize the adaptive RX polling policy, from the current channel plan
+Each enabled IF chain may complete a packet already in flight, then one packet
+every time on air of the shortest packet it can receive (fastest datarate,
+empty payload): the policy never waits long enough for the RX FIFO to overflow.
+To be called again after lgw_reconfigure.
+@param rxpoll state of the policy
+@param min_us shortest polling interval, in microseconds (not null)
+@param max_us longest polling interval (latency bound when idle), in microseconds
+@return LGW_HAL_ERROR if the parameters are invalid, LGW_HAL_SUCCESS else
+*/
+int lgw_rxpoll_init(struct lgw_rxpoll_s *rxpoll, uint32_t min_us, uint32_t max_us);
+
+/**
+@brief Compute the time to wait before the next lgw_receive call
+The interval backs off when idle, tightens with the observed packet rate (next
+poll expected when the FIFO is half full, but not before the shortest time on
+air of the received packets), and is bounded by the predicted FIFO fill time.
+@param rxpoll state of the policy
+@param pkt_data packets returned by the last lgw_receive call
+@param nb_pkt value returned by the last lgw_receive call
+@param max_pkt maximum number of packets of the last lgw_receive call
+@return time to wait in microseconds, 0 to call lgw_receive again immediately
+*/
+uint32_t lgw_rxpoll_next(struct lgw_rxpoll_s *rxpoll, const struct lgw_pkt_rx_s *pkt_data, int nb_pkt, int max_pkt);
+
 /**
 @brief Schedule a packet to be send immediately or after a delay depending on tx_mode
 @param pkt_data structure containing the data and metadata for the packet to send
@@ -66,5 +66,12 @@ int lbt_is_channel_free(struct lgw_pkt_tx_s * pkt_data, uint16_t tx_start_delay,
 */
 bool lbt_is_enabled(void);
 
+/**
+@brief Wait for the LBT FSM to have scanned all the active channels once
+@param timeout_ms maximum time to wait, in milliseconds
+@return LGW_LBT_ERROR if the timeout expired, LGW_LBT_SUCCESS else
+*/
+int lbt_wait_ready(unsigned long timeout_ms);
+
 #endif
 /* --- EOF ------------------------------------------------------------------ */
@@ -22,6 +22,8 @@ Maintainer: Michael Coracin
 #include <stdint.h>     /* C99 types */
 #include <stdbool.h>    /* bool type */
 
+#include "loragw_hal.h"  /* enum lgw_radio_type_e */
+
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC CONSTANTS ----------------------------------------------------- */
 
@@ -57,13 +59,37 @@ enum lgw_sx127x_rxbw_e {
     LGW_SX127X_RXBW_250K_HZ
 };
 
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC TYPES --------------------------------------------------------- */
+
+/**
+@struct lgw_sx125x_reg_s
+@brief Address and value of a SX125x register, for multiple registers accesses
+*/
+struct lgw_sx125x_reg_s {
+    uint8_t address;    /*!> register address (7 bit) */
+    uint8_t value;      /*!> value written, or filled by the read */
+};
+
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC FUNCTIONS PROTOTYPES ------------------------------------------ */
 
 int lgw_setup_sx125x(uint8_t rf_chain, uint8_t rf_clkout, bool rf_enable, uint8_t rf_radio_type, uint32_t freq_hz);
 
+int lgw_setup_sx125x_all(uint8_t rf_clkout, const bool *rf_enable, const enum lgw_radio_type_e *rf_radio_type, const uint32_t *freq_hz);
+
+int lgw_sx125x_reg_w(uint8_t rf_chain, uint8_t address, uint8_t reg_value);
+
+int lgw_sx125x_reg_r(uint8_t rf_chain, uint8_t address, uint8_t *reg_value);
+
+int lgw_sx125x_reg_w_multi(uint8_t rf_chain, const struct lgw_sx125x_reg_s *regs, int nb_regs);
+
+int lgw_sx125x_reg_r_multi(uint8_t rf_chain, struct lgw_sx125x_reg_s *regs, int nb_regs);
+
 int lgw_setup_sx127x(uint32_t frequency, uint8_t modulation, enum lgw_sx127x_rxbw_e rxbw_khz, int8_t rssi_offset);
 
+int lgw_sx127x_retune(uint32_t frequency, enum lgw_sx127x_rxbw_e rxbw_khz);
+
 int lgw_sx127x_reg_w(uint8_t address, uint8_t reg_value);
 
 int lgw_sx127x_reg_r(uint8_t address, uint8_t *reg_value);
@@ -25,8 +25,10 @@ Maintainer: Sylvain Miermont
 
 #include <stdint.h>        /* C99 types */
 #include <stdbool.h>    /* bool type */
+#include <stddef.h>     /* NULL */
 
 #include "config.h"    /* library configuration options (dynamically generated) */
+#include "loragw_spi.h"    /* SPI mux targets used by the register accessors */
 
 /* -------------------------------------------------------------------------- */
 /* --- INTERNAL SHARED TYPES ------------------------------------------------ */
@@ -47,12 +49,33 @@ struct lgw_reg_s {
 int reg_w_align32(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, struct lgw_reg_s r, int32_t reg_value);
 int reg_r_align32(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, struct lgw_reg_s r, int32_t *reg_value);
 
+/* byte-level accesses used by the LGW_REG_W/LGW_REG_R accessors (page switch & shadow aware) */
+/* register_id is only used for statistics, -1 for FPGA registers */
+int reg_w_bits(uint8_t spi_mux_target, int register_id, int8_t page, uint8_t addr, uint8_t mask, uint8_t data);
+int reg_w_bytes(uint8_t spi_mux_target, int register_id, int8_t page, uint8_t addr, const uint8_t *data, uint8_t size);
+int reg_r_bytes(uint8_t spi_mux_target, int register_id, int8_t page, uint8_t addr, uint8_t *data, uint8_t size);
+
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC CONSTANTS ----------------------------------------------------- */
 
 #define LGW_REG_SUCCESS  0
 #define LGW_REG_ERROR    -1
 
+#define LGW_REG_MULTI_MAX   128 /* maximum number of registers accessed by lgw_reg_w_multi/lgw_reg_r_multi */
+#define LGW_REG_BURST_SEQ_MAX 32 /* maximum number of bursts in a lgw_reg_burst_seq sequence */
+#define LGW_REG_SCRIPT_SIZE 512 /* maximum size of a compiled script (3 bytes of header per burst + content) */
+
+#define LGW_REG_PHASE_OTHER     0   /* register accesses outside of the phases below */
+#define LGW_REG_PHASE_START     1   /* register accesses done by lgw_start */
+#define LGW_REG_PHASE_RECEIVE   2   /* register accesses done by lgw_receive */
+#define LGW_REG_PHASE_SEND      3   /* register accesses done by lgw_send */
+#define LGW_REG_PHASE_LBT       4   /* register accesses done by the LBT channel check */
+#define LGW_REG_PHASE_GPS       5   /* register accesses done for GPS synchronization (lgw_get_trigcnt) */
+#define LGW_REG_PHASE_NB        6   /* number of phases */
+
+#define LGW_REG_SNAPSHOT_PAGES      3   /* number of register pages captured by a snapshot */
+#define LGW_REG_SNAPSHOT_FPGA_SIZE  64  /* size of the FPGA register space captured by a snapshot */
+
 /*
 auto generated register mapping for C code : 11-Jul-2013 13:20:40
 this file contains autogenerated C struct used to access the LORA registers
@@ -389,6 +412,405 @@ this file is autogenerated from registers description
 
 #define LGW_TOTALREGS 326
 
+/*
+descriptors of the LoRa registers: page, addr, offs, sign, leng, rdon, dflt
+used to build the register table, and by the LGW_*REG_W/R accessors
+*/
+
+#define LGW_PAGE_REG_DESC -1,0,0,0,2,0,0
+#define LGW_SOFT_RESET_DESC -1,0,7,0,1,0,0
+#define LGW_VERSION_DESC -1,1,0,0,8,1,103
+#define LGW_RX_DATA_BUF_ADDR_DESC -1,2,0,0,16,0,0
+#define LGW_RX_DATA_BUF_DATA_DESC -1,4,0,0,8,0,0
+#define LGW_TX_DATA_BUF_ADDR_DESC -1,5,0,0,8,0,0
+#define LGW_TX_DATA_BUF_DATA_DESC -1,6,0,0,8,0,0
+#define LGW_CAPTURE_RAM_ADDR_DESC -1,7,0,0,8,0,0
+#define LGW_CAPTURE_RAM_DATA_DESC -1,8,0,0,8,1,0
+#define LGW_MCU_PROM_ADDR_DESC -1,9,0,0,8,0,0
+#define LGW_MCU_PROM_DATA_DESC -1,10,0,0,8,0,0
+#define LGW_RX_PACKET_DATA_FIFO_NUM_STORED_DESC -1,11,0,0,8,0,0
+#define LGW_RX_PACKET_DATA_FIFO_ADDR_POINTER_DESC -1,12,0,0,16,1,0
+#define LGW_RX_PACKET_DATA_FIFO_STATUS_DESC -1,14,0,0,8,1,0
+#define LGW_RX_PACKET_DATA_FIFO_PAYLOAD_SIZE_DESC -1,15,0,0,8,1,0
+#define LGW_MBWSSF_MODEM_ENABLE_DESC -1,16,0,0,1,0,0
+#define LGW_CONCENTRATOR_MODEM_ENABLE_DESC -1,16,1,0,1,0,0
+#define LGW_FSK_MODEM_ENABLE_DESC -1,16,2,0,1,0,0
+#define LGW_GLOBAL_EN_DESC -1,16,3,0,1,0,0
+#define LGW_CLK32M_EN_DESC -1,17,0,0,1,0,1
+#define LGW_CLKHS_EN_DESC -1,17,1,0,1,0,1
+#define LGW_START_BIST0_DESC -1,18,0,0,1,0,0
+#define LGW_START_BIST1_DESC -1,18,1,0,1,0,0
+#define LGW_CLEAR_BIST0_DESC -1,18,2,0,1,0,0
+#define LGW_CLEAR_BIST1_DESC -1,18,3,0,1,0,0
+#define LGW_BIST0_FINISHED_DESC -1,19,0,0,1,1,0
+#define LGW_BIST1_FINISHED_DESC -1,19,1,0,1,1,0
+#define LGW_MCU_AGC_PROG_RAM_BIST_STATUS_DESC -1,20,0,0,1,1,0
+#define LGW_MCU_ARB_PROG_RAM_BIST_STATUS_DESC -1,20,1,0,1,1,0
+#define LGW_CAPTURE_RAM_BIST_STATUS_DESC -1,20,2,0,1,1,0
+#define LGW_CHAN_FIR_RAM0_BIST_STATUS_DESC -1,20,3,0,1,1,0
+#define LGW_CHAN_FIR_RAM1_BIST_STATUS_DESC -1,20,4,0,1,1,0
+#define LGW_CORR0_RAM_BIST_STATUS_DESC -1,21,0,0,1,1,0
+#define LGW_CORR1_RAM_BIST_STATUS_DESC -1,21,1,0,1,1,0
+#define LGW_CORR2_RAM_BIST_STATUS_DESC -1,21,2,0,1,1,0
+#define LGW_CORR3_RAM_BIST_STATUS_DESC -1,21,3,0,1,1,0
+#define LGW_CORR4_RAM_BIST_STATUS_DESC -1,21,4,0,1,1,0
+#define LGW_CORR5_RAM_BIST_STATUS_DESC -1,21,5,0,1,1,0
+#define LGW_CORR6_RAM_BIST_STATUS_DESC -1,21,6,0,1,1,0
+#define LGW_CORR7_RAM_BIST_STATUS_DESC -1,21,7,0,1,1,0
+#define LGW_MODEM0_RAM0_BIST_STATUS_DESC -1,22,0,0,1,1,0
+#define LGW_MODEM1_RAM0_BIST_STATUS_DESC -1,22,1,0,1,1,0
+#define LGW_MODEM2_RAM0_BIST_STATUS_DESC -1,22,2,0,1,1,0
+#define LGW_MODEM3_RAM0_BIST_STATUS_DESC -1,22,3,0,1,1,0
+#define LGW_MODEM4_RAM0_BIST_STATUS_DESC -1,22,4,0,1,1,0
+#define LGW_MODEM5_RAM0_BIST_STATUS_DESC -1,22,5,0,1,1,0
+#define LGW_MODEM6_RAM0_BIST_STATUS_DESC -1,22,6,0,1,1,0
+#define LGW_MODEM7_RAM0_BIST_STATUS_DESC -1,22,7,0,1,1,0
+#define LGW_MODEM0_RAM1_BIST_STATUS_DESC -1,23,0,0,1,1,0
+#define LGW_MODEM1_RAM1_BIST_STATUS_DESC -1,23,1,0,1,1,0
+#define LGW_MODEM2_RAM1_BIST_STATUS_DESC -1,23,2,0,1,1,0
+#define LGW_MODEM3_RAM1_BIST_STATUS_DESC -1,23,3,0,1,1,0
+#define LGW_MODEM4_RAM1_BIST_STATUS_DESC -1,23,4,0,1,1,0
+#define LGW_MODEM5_RAM1_BIST_STATUS_DESC -1,23,5,0,1,1,0
+#define LGW_MODEM6_RAM1_BIST_STATUS_DESC -1,23,6,0,1,1,0
+#define LGW_MODEM7_RAM1_BIST_STATUS_DESC -1,23,7,0,1,1,0
+#define LGW_MODEM0_RAM2_BIST_STATUS_DESC -1,24,0,0,1,1,0
+#define LGW_MODEM1_RAM2_BIST_STATUS_DESC -1,24,1,0,1,1,0
+#define LGW_MODEM2_RAM2_BIST_STATUS_DESC -1,24,2,0,1,1,0
+#define LGW_MODEM3_RAM2_BIST_STATUS_DESC -1,24,3,0,1,1,0
+#define LGW_MODEM4_RAM2_BIST_STATUS_DESC -1,24,4,0,1,1,0
+#define LGW_MODEM5_RAM2_BIST_STATUS_DESC -1,24,5,0,1,1,0
+#define LGW_MODEM6_RAM2_BIST_STATUS_DESC -1,24,6,0,1,1,0
+#define LGW_MODEM7_RAM2_BIST_STATUS_DESC -1,24,7,0,1,1,0
+#define LGW_MODEM_MBWSSF_RAM0_BIST_STATUS_DESC -1,25,0,0,1,1,0
+#define LGW_MODEM_MBWSSF_RAM1_BIST_STATUS_DESC -1,25,1,0,1,1,0
+#define LGW_MODEM_MBWSSF_RAM2_BIST_STATUS_DESC -1,25,2,0,1,1,0
+#define LGW_MCU_AGC_DATA_RAM_BIST0_STATUS_DESC -1,26,0,0,1,1,0
+#define LGW_MCU_AGC_DATA_RAM_BIST1_STATUS_DESC -1,26,1,0,1,1,0
+#define LGW_MCU_ARB_DATA_RAM_BIST0_STATUS_DESC -1,26,2,0,1,1,0
+#define LGW_MCU_ARB_DATA_RAM_BIST1_STATUS_DESC -1,26,3,0,1,1,0
+#define LGW_TX_TOP_RAM_BIST0_STATUS_DESC -1,26,4,0,1,1,0
+#define LGW_TX_TOP_RAM_BIST1_STATUS_DESC -1,26,5,0,1,1,0
+#define LGW_DATA_MNGT_RAM_BIST0_STATUS_DESC -1,26,6,0,1,1,0
+#define LGW_DATA_MNGT_RAM_BIST1_STATUS_DESC -1,26,7,0,1,1,0
+#define LGW_GPIO_SELECT_INPUT_DESC -1,27,0,0,4,0,0
+#define LGW_GPIO_SELECT_OUTPUT_DESC -1,28,0,0,4,0,0
+#define LGW_GPIO_MODE_DESC -1,29,0,0,5,0,0
+#define LGW_GPIO_PIN_REG_IN_DESC -1,30,0,0,5,1,0
+#define LGW_GPIO_PIN_REG_OUT_DESC -1,31,0,0,5,0,0
+#define LGW_MCU_AGC_STATUS_DESC -1,32,0,0,8,1,0
+#define LGW_MCU_ARB_STATUS_DESC -1,125,0,0,8,1,0
+#define LGW_CHIP_ID_DESC -1,126,0,0,8,1,1
+#define LGW_EMERGENCY_FORCE_HOST_CTRL_DESC -1,127,0,0,1,0,1
+#define LGW_RX_INVERT_IQ_DESC 0,33,0,0,1,0,0
+#define LGW_MODEM_INVERT_IQ_DESC 0,33,1,0,1,0,1
+#define LGW_MBWSSF_MODEM_INVERT_IQ_DESC 0,33,2,0,1,0,0
+#define LGW_RX_EDGE_SELECT_DESC 0,33,3,0,1,0,0
+#define LGW_MISC_RADIO_EN_DESC 0,33,4,0,1,0,0
+#define LGW_FSK_MODEM_INVERT_IQ_DESC 0,33,5,0,1,0,0
+#define LGW_FILTER_GAIN_DESC 0,34,0,0,4,0,7
+#define LGW_RADIO_SELECT_DESC 0,35,0,0,8,0,240
+#define LGW_IF_FREQ_0_DESC 0,36,0,1,13,0,-384
+#define LGW_IF_FREQ_1_DESC 0,38,0,1,13,0,-128
+#define LGW_IF_FREQ_2_DESC 0,40,0,1,13,0,128
+#define LGW_IF_FREQ_3_DESC 0,42,0,1,13,0,384
+#define LGW_IF_FREQ_4_DESC 0,44,0,1,13,0,-384
+#define LGW_IF_FREQ_5_DESC 0,46,0,1,13,0,-128
+#define LGW_IF_FREQ_6_DESC 0,48,0,1,13,0,128
+#define LGW_IF_FREQ_7_DESC 0,50,0,1,13,0,384
+#define LGW_IF_FREQ_8_DESC 0,52,0,1,13,0,0
+#define LGW_IF_FREQ_9_DESC 0,54,0,1,13,0,0
+#define LGW_CHANN_OVERRIDE_AGC_GAIN_DESC 0,64,0,0,1,0,0
+#define LGW_CHANN_AGC_GAIN_DESC 0,64,1,0,4,0,7
+#define LGW_CORR0_DETECT_EN_DESC 0,65,0,0,7,0,0
+#define LGW_CORR1_DETECT_EN_DESC 0,66,0,0,7,0,0
+#define LGW_CORR2_DETECT_EN_DESC 0,67,0,0,7,0,0
+#define LGW_CORR3_DETECT_EN_DESC 0,68,0,0,7,0,0
+#define LGW_CORR4_DETECT_EN_DESC 0,69,0,0,7,0,0
+#define LGW_CORR5_DETECT_EN_DESC 0,70,0,0,7,0,0
+#define LGW_CORR6_DETECT_EN_DESC 0,71,0,0,7,0,0
+#define LGW_CORR7_DETECT_EN_DESC 0,72,0,0,7,0,0
+#define LGW_CORR_SAME_PEAKS_OPTION_SF6_DESC 0,73,0,0,1,0,0
+#define LGW_CORR_SAME_PEAKS_OPTION_SF7_DESC 0,73,1,0,1,0,1
+#define LGW_CORR_SAME_PEAKS_OPTION_SF8_DESC 0,73,2,0,1,0,1
+#define LGW_CORR_SAME_PEAKS_OPTION_SF9_DESC 0,73,3,0,1,0,1
+#define LGW_CORR_SAME_PEAKS_OPTION_SF10_DESC 0,73,4,0,1,0,1
+#define LGW_CORR_SAME_PEAKS_OPTION_SF11_DESC 0,73,5,0,1,0,1
+#define LGW_CORR_SAME_PEAKS_OPTION_SF12_DESC 0,73,6,0,1,0,1
+#define LGW_CORR_SIG_NOISE_RATIO_SF6_DESC 0,74,0,0,4,0,4
+#define LGW_CORR_SIG_NOISE_RATIO_SF7_DESC 0,74,4,0,4,0,4
+#define LGW_CORR_SIG_NOISE_RATIO_SF8_DESC 0,75,0,0,4,0,4
+#define LGW_CORR_SIG_NOISE_RATIO_SF9_DESC 0,75,4,0,4,0,4
+#define LGW_CORR_SIG_NOISE_RATIO_SF10_DESC 0,76,0,0,4,0,4
+#define LGW_CORR_SIG_NOISE_RATIO_SF11_DESC 0,76,4,0,4,0,4
+#define LGW_CORR_SIG_NOISE_RATIO_SF12_DESC 0,77,0,0,4,0,4
+#define LGW_CORR_NUM_SAME_PEAK_DESC 0,78,0,0,4,0,4
+#define LGW_CORR_MAC_GAIN_DESC 0,78,4,0,3,0,5
+#define LGW_ADJUST_MODEM_START_OFFSET_RDX4_DESC 0,81,0,0,12,0,0
+#define LGW_ADJUST_MODEM_START_OFFSET_SF12_RDX4_DESC 0,83,0,0,12,0,4092
+#define LGW_DBG_CORR_SELECT_SF_DESC 0,85,0,0,8,0,7
+#define LGW_DBG_CORR_SELECT_CHANNEL_DESC 0,86,0,0,8,0,0
+#define LGW_DBG_DETECT_CPT_DESC 0,87,0,0,8,1,0
+#define LGW_DBG_SYMB_CPT_DESC 0,88,0,0,8,1,0
+#define LGW_CHIRP_INVERT_RX_DESC 0,89,0,0,1,0,1
+#define LGW_DC_NOTCH_EN_DESC 0,89,1,0,1,0,1
+#define LGW_IMPLICIT_CRC_EN_DESC 0,90,0,0,1,0,0
+#define LGW_IMPLICIT_CODING_RATE_DESC 0,90,1,0,3,0,0
+#define LGW_IMPLICIT_PAYLOAD_LENGHT_DESC 0,91,0,0,8,0,0
+#define LGW_FREQ_TO_TIME_INVERT_DESC 0,92,0,0,8,0,29
+#define LGW_FREQ_TO_TIME_DRIFT_DESC 0,93,0,0,6,0,9
+#define LGW_PAYLOAD_FINE_TIMING_GAIN_DESC 0,94,0,0,2,0,2
+#define LGW_PREAMBLE_FINE_TIMING_GAIN_DESC 0,94,2,0,2,0,1
+#define LGW_TRACKING_INTEGRAL_DESC 0,94,4,0,2,0,0
+#define LGW_FRAME_SYNCH_PEAK1_POS_DESC 0,95,0,0,4,0,1
+#define LGW_FRAME_SYNCH_PEAK2_POS_DESC 0,95,4,0,4,0,2
+#define LGW_PREAMBLE_SYMB1_NB_DESC 0,96,0,0,16,0,10
+#define LGW_FRAME_SYNCH_GAIN_DESC 0,98,0,0,1,0,1
+#define LGW_SYNCH_DETECT_TH_DESC 0,98,1,0,1,0,1
+#define LGW_LLR_SCALE_DESC 0,99,0,0,4,0,8
+#define LGW_SNR_AVG_CST_DESC 0,99,4,0,2,0,2
+#define LGW_PPM_OFFSET_DESC 0,100,0,0,7,0,0
+#define LGW_MAX_PAYLOAD_LEN_DESC 0,101,0,0,8,0,255
+#define LGW_ONLY_CRC_EN_DESC 0,102,0,0,1,0,1
+#define LGW_ZERO_PAD_DESC 0,103,0,0,8,0,0
+#define LGW_DEC_GAIN_OFFSET_DESC 0,104,0,0,4,0,8
+#define LGW_CHAN_GAIN_OFFSET_DESC 0,104,4,0,4,0,7
+#define LGW_FORCE_HOST_RADIO_CTRL_DESC 0,105,1,0,1,0,1
+#define LGW_FORCE_HOST_FE_CTRL_DESC 0,105,2,0,1,0,1
+#define LGW_FORCE_DEC_FILTER_GAIN_DESC 0,105,3,0,1,0,1
+#define LGW_MCU_RST_0_DESC 0,106,0,0,1,0,1
+#define LGW_MCU_RST_1_DESC 0,106,1,0,1,0,1
+#define LGW_MCU_SELECT_MUX_0_DESC 0,106,2,0,1,0,0
+#define LGW_MCU_SELECT_MUX_1_DESC 0,106,3,0,1,0,0
+#define LGW_MCU_CORRUPTION_DETECTED_0_DESC 0,106,4,0,1,1,0
+#define LGW_MCU_CORRUPTION_DETECTED_1_DESC 0,106,5,0,1,1,0
+#define LGW_MCU_SELECT_EDGE_0_DESC 0,106,6,0,1,0,0
+#define LGW_MCU_SELECT_EDGE_1_DESC 0,106,7,0,1,0,0
+#define LGW_CHANN_SELECT_RSSI_DESC 0,107,0,0,8,0,1
+#define LGW_RSSI_BB_DEFAULT_VALUE_DESC 0,108,0,0,8,0,32
+#define LGW_RSSI_DEC_DEFAULT_VALUE_DESC 0,109,0,0,8,0,100
+#define LGW_RSSI_CHANN_DEFAULT_VALUE_DESC 0,110,0,0,8,0,100
+#define LGW_RSSI_BB_FILTER_ALPHA_DESC 0,111,0,0,5,0,7
+#define LGW_RSSI_DEC_FILTER_ALPHA_DESC 0,112,0,0,5,0,5
+#define LGW_RSSI_CHANN_FILTER_ALPHA_DESC 0,113,0,0,5,0,8
+#define LGW_IQ_MISMATCH_A_AMP_COEFF_DESC 0,114,0,0,6,0,0
+#define LGW_IQ_MISMATCH_A_PHI_COEFF_DESC 0,115,0,0,6,0,0
+#define LGW_IQ_MISMATCH_B_AMP_COEFF_DESC 0,116,0,0,6,0,0
+#define LGW_IQ_MISMATCH_B_SEL_I_DESC 0,116,6,0,1,0,0
+#define LGW_IQ_MISMATCH_B_PHI_COEFF_DESC 0,117,0,0,6,0,0
+#define LGW_TX_TRIG_IMMEDIATE_DESC 1,33,0,0,1,0,0
+#define LGW_TX_TRIG_DELAYED_DESC 1,33,1,0,1,0,0
+#define LGW_TX_TRIG_GPS_DESC 1,33,2,0,1,0,0
+#define LGW_TX_START_DELAY_DESC 1,34,0,0,16,0,0
+#define LGW_TX_FRAME_SYNCH_PEAK1_POS_DESC 1,36,0,0,4,0,1
+#define LGW_TX_FRAME_SYNCH_PEAK2_POS_DESC 1,36,4,0,4,0,2
+#define LGW_TX_RAMP_DURATION_DESC 1,37,0,0,3,0,0
+#define LGW_TX_OFFSET_I_DESC 1,39,0,1,8,0,0
+#define LGW_TX_OFFSET_Q_DESC 1,40,0,1,8,0,0
+#define LGW_TX_MODE_DESC 1,41,0,0,1,0,0
+#define LGW_TX_ZERO_PAD_DESC 1,41,1,0,4,0,0
+#define LGW_TX_EDGE_SELECT_DESC 1,41,5,0,1,0,0
+#define LGW_TX_EDGE_SELECT_TOP_DESC 1,41,6,0,1,0,0
+#define LGW_TX_GAIN_DESC 1,42,0,0,2,0,0
+#define LGW_TX_CHIRP_LOW_PASS_DESC 1,42,2,0,3,0,5
+#define LGW_TX_FCC_WIDEBAND_DESC 1,42,5,0,2,0,0
+#define LGW_TX_SWAP_IQ_DESC 1,42,7,0,1,0,1
+#define LGW_MBWSSF_IMPLICIT_HEADER_DESC 1,43,0,0,1,0,0
+#define LGW_MBWSSF_IMPLICIT_CRC_EN_DESC 1,43,1,0,1,0,0
+#define LGW_MBWSSF_IMPLICIT_CODING_RATE_DESC 1,43,2,0,3,0,0
+#define LGW_MBWSSF_IMPLICIT_PAYLOAD_LENGHT_DESC 1,44,0,0,8,0,0
+#define LGW_MBWSSF_AGC_FREEZE_ON_DETECT_DESC 1,45,0,0,1,0,1
+#define LGW_MBWSSF_FRAME_SYNCH_PEAK1_POS_DESC 1,46,0,0,4,0,1
+#define LGW_MBWSSF_FRAME_SYNCH_PEAK2_POS_DESC 1,46,4,0,4,0,2
+#define LGW_MBWSSF_PREAMBLE_SYMB1_NB_DESC 1,47,0,0,16,0,10
+#define LGW_MBWSSF_FRAME_SYNCH_GAIN_DESC 1,49,0,0,1,0,1
+#define LGW_MBWSSF_SYNCH_DETECT_TH_DESC 1,49,1,0,1,0,1
+#define LGW_MBWSSF_DETECT_MIN_SINGLE_PEAK_DESC 1,50,0,0,8,0,10
+#define LGW_MBWSSF_DETECT_TRIG_SAME_PEAK_NB_DESC 1,51,0,0,3,0,3
+#define LGW_MBWSSF_FREQ_TO_TIME_INVERT_DESC 1,52,0,0,8,0,29
+#define LGW_MBWSSF_FREQ_TO_TIME_DRIFT_DESC 1,53,0,0,6,0,36
+#define LGW_MBWSSF_PPM_CORRECTION_DESC 1,54,0,0,12,0,0
+#define LGW_MBWSSF_PAYLOAD_FINE_TIMING_GAIN_DESC 1,56,0,0,2,0,2
+#define LGW_MBWSSF_PREAMBLE_FINE_TIMING_GAIN_DESC 1,56,2,0,2,0,1
+#define LGW_MBWSSF_TRACKING_INTEGRAL_DESC 1,56,4,0,2,0,0
+#define LGW_MBWSSF_ZERO_PAD_DESC 1,57,0,0,8,0,0
+#define LGW_MBWSSF_MODEM_BW_DESC 1,58,0,0,2,0,0
+#define LGW_MBWSSF_RADIO_SELECT_DESC 1,58,2,0,1,0,0
+#define LGW_MBWSSF_RX_CHIRP_INVERT_DESC 1,58,3,0,1,0,1
+#define LGW_MBWSSF_LLR_SCALE_DESC 1,59,0,0,4,0,8
+#define LGW_MBWSSF_SNR_AVG_CST_DESC 1,59,4,0,2,0,3
+#define LGW_MBWSSF_PPM_OFFSET_DESC 1,59,6,0,1,0,0
+#define LGW_MBWSSF_RATE_SF_DESC 1,60,0,0,4,0,7
+#define LGW_MBWSSF_ONLY_CRC_EN_DESC 1,60,4,0,1,0,1
+#define LGW_MBWSSF_MAX_PAYLOAD_LEN_DESC 1,61,0,0,8,0,255
+#define LGW_TX_STATUS_DESC 1,62,0,0,8,1,128
+#define LGW_FSK_CH_BW_EXPO_DESC 1,63,0,0,3,0,0
+#define LGW_FSK_RSSI_LENGTH_DESC 1,63,3,0,3,0,0
+#define LGW_FSK_RX_INVERT_DESC 1,63,6,0,1,0,0
+#define LGW_FSK_PKT_MODE_DESC 1,63,7,0,1,0,0
+#define LGW_FSK_PSIZE_DESC 1,64,0,0,3,0,0
+#define LGW_FSK_CRC_EN_DESC 1,64,3,0,1,0,0
+#define LGW_FSK_DCFREE_ENC_DESC 1,64,4,0,2,0,0
+#define LGW_FSK_CRC_IBM_DESC 1,64,6,0,1,0,0
+#define LGW_FSK_ERROR_OSR_TOL_DESC 1,65,0,0,5,0,0
+#define LGW_FSK_RADIO_SELECT_DESC 1,65,7,0,1,0,0
+#define LGW_FSK_BR_RATIO_DESC 1,66,0,0,16,0,0
+#define LGW_FSK_REF_PATTERN_LSB_DESC 1,68,0,0,32,0,0
+#define LGW_FSK_REF_PATTERN_MSB_DESC 1,72,0,0,32,0,0
+#define LGW_FSK_PKT_LENGTH_DESC 1,76,0,0,8,0,0
+#define LGW_FSK_TX_GAUSSIAN_EN_DESC 1,77,0,0,1,0,1
+#define LGW_FSK_TX_GAUSSIAN_SELECT_BT_DESC 1,77,1,0,2,0,0
+#define LGW_FSK_TX_PATTERN_EN_DESC 1,77,3,0,1,0,1
+#define LGW_FSK_TX_PREAMBLE_SEQ_DESC 1,77,4,0,1,0,0
+#define LGW_FSK_TX_PSIZE_DESC 1,77,5,0,3,0,0
+#define LGW_FSK_NODE_ADRS_DESC 1,80,0,0,8,0,0
+#define LGW_FSK_BROADCAST_DESC 1,81,0,0,8,0,0
+#define LGW_FSK_AUTO_AFC_ON_DESC 1,82,0,0,1,0,1
+#define LGW_FSK_PATTERN_TIMEOUT_CFG_DESC 1,83,0,0,10,0,0
+#define LGW_SPI_RADIO_A__DATA_DESC 2,33,0,0,8,0,0
+#define LGW_SPI_RADIO_A__DATA_READBACK_DESC 2,34,0,0,8,1,0
+#define LGW_SPI_RADIO_A__ADDR_DESC 2,35,0,0,8,0,0
+#define LGW_SPI_RADIO_A__CS_DESC 2,37,0,0,1,0,0
+#define LGW_SPI_RADIO_B__DATA_DESC 2,38,0,0,8,0,0
+#define LGW_SPI_RADIO_B__DATA_READBACK_DESC 2,39,0,0,8,1,0
+#define LGW_SPI_RADIO_B__ADDR_DESC 2,40,0,0,8,0,0
+#define LGW_SPI_RADIO_B__CS_DESC 2,42,0,0,1,0,0
+#define LGW_RADIO_A_EN_DESC 2,43,0,0,1,0,0
+#define LGW_RADIO_B_EN_DESC 2,43,1,0,1,0,0
+#define LGW_RADIO_RST_DESC 2,43,2,0,1,0,1
+#define LGW_LNA_A_EN_DESC 2,43,3,0,1,0,0
+#define LGW_PA_A_EN_DESC 2,43,4,0,1,0,0
+#define LGW_LNA_B_EN_DESC 2,43,5,0,1,0,0
+#define LGW_PA_B_EN_DESC 2,43,6,0,1,0,0
+#define LGW_PA_GAIN_DESC 2,44,0,0,2,0,0
+#define LGW_LNA_A_CTRL_LUT_DESC 2,45,0,0,4,0,2
+#define LGW_PA_A_CTRL_LUT_DESC 2,45,4,0,4,0,4
+#define LGW_LNA_B_CTRL_LUT_DESC 2,46,0,0,4,0,2
+#define LGW_PA_B_CTRL_LUT_DESC 2,46,4,0,4,0,4
+#define LGW_CAPTURE_SOURCE_DESC 2,47,0,0,5,0,0
+#define LGW_CAPTURE_START_DESC 2,47,5,0,1,0,0
+#define LGW_CAPTURE_FORCE_TRIGGER_DESC 2,47,6,0,1,0,0
+#define LGW_CAPTURE_WRAP_DESC 2,47,7,0,1,0,0
+#define LGW_CAPTURE_PERIOD_DESC 2,48,0,0,16,0,0
+#define LGW_MODEM_STATUS_DESC 2,51,0,0,8,1,0
+#define LGW_VALID_HEADER_COUNTER_0_DESC 2,52,0,0,8,1,0
+#define LGW_VALID_PACKET_COUNTER_0_DESC 2,54,0,0,8,1,0
+#define LGW_VALID_HEADER_COUNTER_MBWSSF_DESC 2,56,0,0,8,1,0
+#define LGW_VALID_HEADER_COUNTER_FSK_DESC 2,57,0,0,8,1,0
+#define LGW_VALID_PACKET_COUNTER_MBWSSF_DESC 2,58,0,0,8,1,0
+#define LGW_VALID_PACKET_COUNTER_FSK_DESC 2,59,0,0,8,1,0
+#define LGW_CHANN_RSSI_DESC 2,60,0,0,8,1,0
+#define LGW_BB_RSSI_DESC 2,61,0,0,8,1,0
+#define LGW_DEC_RSSI_DESC 2,62,0,0,8,1,0
+#define LGW_DBG_MCU_DATA_DESC 2,63,0,0,8,1,0
+#define LGW_DBG_ARB_MCU_RAM_DATA_DESC 2,64,0,0,8,1,0
+#define LGW_DBG_AGC_MCU_RAM_DATA_DESC 2,65,0,0,8,1,0
+#define LGW_NEXT_PACKET_CNT_DESC 2,66,0,0,16,1,0
+#define LGW_ADDR_CAPTURE_COUNT_DESC 2,68,0,0,16,1,0
+#define LGW_TIMESTAMP_DESC 2,70,0,0,32,1,0
+#define LGW_DBG_CHANN0_GAIN_DESC 2,74,0,0,4,1,0
+#define LGW_DBG_CHANN1_GAIN_DESC 2,74,4,0,4,1,0
+#define LGW_DBG_CHANN2_GAIN_DESC 2,75,0,0,4,1,0
+#define LGW_DBG_CHANN3_GAIN_DESC 2,75,4,0,4,1,0
+#define LGW_DBG_CHANN4_GAIN_DESC 2,76,0,0,4,1,0
+#define LGW_DBG_CHANN5_GAIN_DESC 2,76,4,0,4,1,0
+#define LGW_DBG_CHANN6_GAIN_DESC 2,77,0,0,4,1,0
+#define LGW_DBG_CHANN7_GAIN_DESC 2,77,4,0,4,1,0
+#define LGW_DBG_DEC_FILT_GAIN_DESC 2,78,0,0,4,1,0
+#define LGW_SPI_DATA_FIFO_PTR_DESC 2,79,0,0,3,1,0
+#define LGW_PACKET_DATA_FIFO_PTR_DESC 2,79,3,0,3,1,0
+#define LGW_DBG_ARB_MCU_RAM_ADDR_DESC 2,80,0,0,8,0,0
+#define LGW_DBG_AGC_MCU_RAM_ADDR_DESC 2,81,0,0,8,0,0
+#define LGW_SPI_MASTER_CHIP_SELECT_POLARITY_DESC 2,82,0,0,1,0,0
+#define LGW_SPI_MASTER_CPOL_DESC 2,82,1,0,1,0,0
+#define LGW_SPI_MASTER_CPHA_DESC 2,82,2,0,1,0,0
+#define LGW_SIG_GEN_ANALYSER_MUX_SEL_DESC 2,83,0,0,1,0,0
+#define LGW_SIG_GEN_EN_DESC 2,84,0,0,1,0,0
+#define LGW_SIG_ANALYSER_EN_DESC 2,84,1,0,1,0,0
+#define LGW_SIG_ANALYSER_AVG_LEN_DESC 2,84,2,0,2,0,0
+#define LGW_SIG_ANALYSER_PRECISION_DESC 2,84,4,0,3,0,0
+#define LGW_SIG_ANALYSER_VALID_OUT_DESC 2,84,7,0,1,1,0
+#define LGW_SIG_GEN_FREQ_DESC 2,85,0,0,8,0,0
+#define LGW_SIG_ANALYSER_FREQ_DESC 2,86,0,0,8,0,0
+#define LGW_SIG_ANALYSER_I_OUT_DESC 2,87,0,0,8,1,0
+#define LGW_SIG_ANALYSER_Q_OUT_DESC 2,88,0,0,8,1,0
+#define LGW_GPS_EN_DESC 2,89,0,0,1,0,0
+#define LGW_GPS_POL_DESC 2,89,1,0,1,0,1
+#define LGW_SW_TEST_REG1_DESC 2,90,0,1,8,0,0
+#define LGW_SW_TEST_REG2_DESC 2,91,2,1,6,0,0
+#define LGW_SW_TEST_REG3_DESC 2,92,0,1,16,0,0
+#define LGW_DATA_MNGT_STATUS_DESC 2,94,0,0,4,1,0
+#define LGW_DATA_MNGT_CPT_FRAME_ALLOCATED_DESC 2,95,0,0,5,1,0
+#define LGW_DATA_MNGT_CPT_FRAME_FINISHED_DESC 2,96,0,0,5,1,0
+#define LGW_DATA_MNGT_CPT_FRAME_READEN_DESC 2,97,0,0,5,1,0
+#define LGW_TX_TRIG_ALL_DESC 1,33,0,0,8,0,0
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC TYPES --------------------------------------------------------- */
+
+/**
+@struct lgw_reg_val_s
+@brief Register number and value, for multiple registers accesses
+*/
+struct lgw_reg_val_s {
+    uint16_t    register_id;    /*!> register number in the data structure describing registers */
+    int32_t     value;          /*!> value to write, or value read */
+};
+
+/**
+@struct lgw_reg_burst_s
+@brief Burst access to a register, for sequences of bursts
+*/
+struct lgw_reg_burst_s {
+    uint16_t    register_id;    /*!> register number in the data structure describing registers */
+    bool        read;           /*!> true for a burst read, false for a burst write */
+    uint8_t     *data;          /*!> bytes to write, or buffer filled by the read */
+    uint16_t    size;           /*!> size of the burst, in byte(s) */
+};
+
+/**
+@struct lgw_reg_stat_s
+@brief Counters of register accesses, for a register or a phase
+*/
+struct lgw_reg_stat_s {
+    uint32_t    nb_call;        /*!> number of register accesses */
+    uint32_t    nb_page_switch; /*!> number of page switches needed by the accesses */
+    uint64_t    nb_byte;        /*!> number of bytes transferred (read-modify-write included) */
+};
+
+/**
+@struct lgw_reg_snapshot_s
+@brief Image of the register space of the concentrator, captured by lgw_reg_snapshot
+*/
+struct lgw_reg_snapshot_s {
+    uint8_t     page[LGW_REG_SNAPSHOT_PAGES][128];  /*!> content of each register page, page-global registers included */
+    uint8_t     fpga[LGW_REG_SNAPSHOT_FPGA_SIZE];   /*!> content of the FPGA registers */
+    bool        fpga_valid;                         /*!> FPGA registers were captured (FPGA present) */
+};
+
+/**
+@struct lgw_reg_script_s
+@brief Registers writes compiled by lgw_reg_script_compile, sorted by page and
+coalesced in bursts, each burst stored as page (0xFF if none), address, size
+and content
+*/
+struct lgw_reg_script_s {
+    uint32_t    key;                        /*!> identifier of the configuration compiled, free for the caller */
+    uint16_t    size;                       /*!> number of bytes of data used */
+    uint16_t    nb_burst;                   /*!> number of bursts */
+    uint8_t     data[LGW_REG_SCRIPT_SIZE];  /*!> bursts */
+};
+
+/**
+@struct lgw_reg_diff_s
+@brief Register found different between two snapshots
+*/
+struct lgw_reg_diff_s {
+    bool        fpga;           /*!> true for a FPGA register, false for a LoRa register */
+    uint16_t    register_id;    /*!> register number in the data structure describing registers */
+    int32_t     value_a;        /*!> value in the first snapshot */
+    int32_t     value_b;        /*!> value in the second snapshot */
+};
+
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC FUNCTIONS PROTOTYPES ------------------------------------------ */
 
@@ -421,6 +843,108 @@ int lgw_soft_reset(void);
 */
 int lgw_reg_check(FILE *f);
 
+/**
+@brief Select the phase to which the next register accesses are accounted
+@param phase phase of the caller (LGW_REG_PHASE_xxx)
+@return previous phase, to be restored by the caller
+*/
+uint8_t lgw_reg_phase_set(uint8_t phase);
+
+/**
+@brief Get the access counters of a register, since last reset
+Accesses done by the multiple registers functions are counted for each
+register, bursts are counted for the first register of the burst.
+@param register_id register number in the data structure describing registers
+@param stat pointer to the structure to fill
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_stat_get(uint16_t register_id, struct lgw_reg_stat_s *stat);
+
+/**
+@brief Get the access counters of a phase, since last reset
+FPGA register accesses are counted in the phases only.
+@param phase phase (LGW_REG_PHASE_xxx)
+@param stat pointer to the structure to fill
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_stat_get_phase(uint8_t phase, struct lgw_reg_stat_s *stat);
+
+/**
+@brief Reset the access counters of all registers and phases
+*/
+void lgw_reg_stat_reset(void);
+
+/**
+@brief Capture all the registers of the concentrator in a snapshot
+Each register page (and the FPGA register space) is burst read, all in a single
+SPI transaction. Data ports (RX/TX buffers, RAM data registers) are not read,
+to avoid their address auto-increment side effect.
+@param snap pointer to the snapshot to fill
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_snapshot(struct lgw_reg_snapshot_s *snap);
+
+/**
+@brief Decode a register value from a snapshot, without SPI access
+@param snap pointer to a snapshot captured by lgw_reg_snapshot
+@param register_id register number in the data structure describing registers
+@param reg_value pointer to a variable where to write register value
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR, for a data port)
+*/
+int lgw_reg_snapshot_get(const struct lgw_reg_snapshot_s *snap, uint16_t register_id, int32_t *reg_value);
+
+/**
+@brief Decode a FPGA register value from a snapshot, without SPI access
+@param snap pointer to a snapshot captured by lgw_reg_snapshot
+@param register_id FPGA register number (LGW_FPGA_xxx)
+@param reg_value pointer to a variable where to write register value
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR, if no FPGA)
+*/
+int lgw_reg_snapshot_get_fpga(const struct lgw_reg_snapshot_s *snap, uint16_t register_id, int32_t *reg_value);
+
+/**
+@brief Compare the registers of two snapshots
+@param snap_a pointer to the first snapshot
+@param snap_b pointer to the second snapshot
+@param diff array filled with the first differences found (can be NULL if max_diff is 0)
+@param max_diff size of the diff array
+@return number of registers with a different value (can be more than max_diff), LGW_REG_ERROR on error
+*/
+int lgw_reg_snapshot_diff(const struct lgw_reg_snapshot_s *snap_a, const struct lgw_reg_snapshot_s *snap_b, struct lgw_reg_diff_s *diff, int max_diff);
+
+/**
+@brief Restore the registers of the concentrator from a snapshot
+The current content of the registers is captured first, and only the writable
+registers with a different value are written, merged in bursts
+(lgw_reg_w_multi), in page and address order. Registers with side effects
+(page, reset, triggers, data ports, ...) and the content of the RAMs (firmware,
+buffers) are not restored.
+@param snap pointer to the snapshot to restore
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_snapshot_restore(const struct lgw_reg_snapshot_s *snap);
+
+/**
+@brief Enable or disable the host-side shadow of the concentrator registers
+When enabled, writes to bit fields do not need to read the register first, and
+writes that do not change the content of a register are skipped. Read-only and
+volatile registers (FIFO, data ports, triggers, MCU mailbox, IQ mismatch
+coefficients set by the calibration) are never cached.
+The shadow is seeded with the registers default values by lgw_soft_reset.
+@param enable true to enable the shadow, false to disable it
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_shadow_enable(bool enable);
+
+/**
+@brief Forget the content of the register shadow, if enabled
+To be called when the host takes back the control of the registers from the
+MCUs, which may have written them. The shadow stays enabled, the bytes are
+cached again as they are read or written.
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_shadow_invalidate(void);
+
 /**
 @brief LoRa concentrator register write
 @param register_id register number in the data structure describing registers
@@ -437,6 +961,88 @@ int lgw_reg_w(uint16_t register_id, int32_t reg_value);
 */
 int lgw_reg_r(uint16_t register_id, int32_t *reg_value);
 
+/**
+@brief LoRa concentrator multiple registers write
+Registers are sorted by page and address, and registers on consecutive
+addresses are written in a single burst, with one page switch per page.
+The order of the writes is not preserved: registers with side effects (data
+ports, FIFO, triggers, ...) are written individually, but they should rather be
+written with lgw_reg_w when the order matters.
+@param regs array of registers numbers and values to write
+@param nb_regs number of elements in the array (max LGW_REG_MULTI_MAX)
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_w_multi(const struct lgw_reg_val_s *regs, int nb_regs);
+
+/**
+@brief LoRa concentrator multiple registers write, in a given order
+Unlike lgw_reg_w_multi, the registers are written one by one in the order of
+the array, and every write is sent even if the value does not change, so that
+sequences with side effects (eg. SPI bridge chip select toggles) are kept. All
+the writes and page switches are sent in a single SPI batch (or a few for long
+sequences). Only registers contained in a single byte are supported, the other
+bits of the bytes holding bit fields are read once (or taken from the shadow).
+@param regs array of registers numbers and values to write, in write order
+@param nb_regs number of elements in the array (max LGW_REG_MULTI_MAX)
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_w_seq(const struct lgw_reg_val_s *regs, int nb_regs);
+
+/**
+@brief LoRa concentrator multiple registers write and read, in a given order
+Same as lgw_reg_w_seq, except that the read-only registers of the array are
+read at their position in the sequence (eg. to get the result of an SPI bridge
+transaction triggered by the previous writes), in the same SPI batch.
+@param regs array of registers numbers and values, values of read-only registers are filled by the function
+@param nb_regs number of elements in the array (max LGW_REG_MULTI_MAX)
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_seq(struct lgw_reg_val_s *regs, int nb_regs);
+
+/**
+@brief LoRa concentrator burst accesses, in a given order, in one SPI transaction
+The bursts (and the page switches between them) are always sent in a single
+SPI batch, so that eg. a data port can be read, a FIFO advanced and its next
+entry read in one SPI round-trip.
+@param bursts array of burst accesses, in access order
+@param nb_bursts number of elements in the array (max LGW_REG_BURST_SEQ_MAX)
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_burst_seq(const struct lgw_reg_burst_s *bursts, int nb_bursts);
+
+/**
+@brief LoRa concentrator multiple registers read
+Registers are sorted by page and address, and registers on consecutive
+addresses are read in a single burst, with one page switch per page.
+@param regs array of registers numbers, values are filled by the function
+@param nb_regs number of elements in the array (max LGW_REG_MULTI_MAX)
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_r_multi(struct lgw_reg_val_s *regs, int nb_regs);
+
+/**
+@brief Compile multiple registers writes into a script, for later replays
+Registers are sorted and coalesced in bursts like lgw_reg_w_multi, but nothing
+is written: the bits of the bytes of the bursts not set by the registers are
+read now, so the script must be compiled at the point of a sequence where it
+will be replayed (eg. after a soft reset). Registers with side effects are not
+supported.
+@param regs array of registers numbers and values to write
+@param nb_regs number of elements in the array (max LGW_REG_MULTI_MAX)
+@param script pointer to the script to fill, key is left untouched
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_script_compile(const struct lgw_reg_val_s *regs, int nb_regs, struct lgw_reg_script_s *script);
+
+/**
+@brief Replay a script compiled by lgw_reg_script_compile
+All the bursts and page switches are sent in a single SPI batch (or a few for
+large scripts), without any read.
+@param script pointer to the script to replay
+@return status of register operation (LGW_REG_SUCCESS/LGW_REG_ERROR)
+*/
+int lgw_reg_script_run(const struct lgw_reg_script_s *script);
+
 /**
 @brief LoRa concentrator register burst write
 @param register_id register number in the data structure describing registers
@@ -455,6 +1061,69 @@ int lgw_reg_wb(uint16_t register_id, uint8_t *data, uint16_t size);
 */
 int lgw_reg_rb(uint16_t register_id, uint8_t *data, uint16_t size);
 
+/* -------------------------------------------------------------------------- */
+/* --- INTERNAL SHARED ACCESSORS -------------------------------------------- */
+
+/*
+Register accessors specialised at compile time: the register descriptor is
+expanded as constant arguments, so that the masks, shifts and sizes are folded
+by the compiler and no table lookup is done at run time.
+Register value format and return codes are the same as lgw_reg_w/lgw_reg_r.
+PAGE_REG and SOFT_RESET must still be accessed with lgw_reg_w.
+*/
+
+#define LGW_REG_W(reg, value)   reg_w_desc(LGW_SPI_MUX_TARGET_SX1301, reg, reg##_DESC, (value))
+#define LGW_REG_R(reg, value)   reg_r_desc(LGW_SPI_MUX_TARGET_SX1301, reg, reg##_DESC, (value))
+
+static inline int reg_w_desc(uint8_t spi_mux_target, int register_id, int8_t page, uint8_t addr, uint8_t offs, bool sign, uint8_t leng, bool rdon, int32_t dflt, int32_t reg_value) {
+    uint8_t buf[4];
+    uint8_t mask;
+    int i;
+
+    (void)sign;
+    (void)dflt;
+    if (rdon == true) {
+        return LGW_REG_ERROR; /* read-only register */
+    }
+    if ((offs + leng) <= 8) {
+        mask = (uint8_t)(((1U << leng) - 1) << offs);
+        return reg_w_bits(spi_mux_target, register_id, page, addr, mask, (uint8_t)((uint32_t)reg_value << offs) & mask);
+    } else if ((offs == 0) && (leng <= 32)) {
+        for (i = 0; i < ((leng + 7) / 8); ++i) {
+            buf[i] = (uint8_t)((uint32_t)reg_value >> (8 * i)); /* LSB first */
+        }
+        return reg_w_bytes(spi_mux_target, register_id, page, addr, buf, (leng + 7) / 8);
+    } else {
+        return LGW_REG_ERROR; /* register spanning multiple bytes with an offset */
+    }
+}
+
+static inline int reg_r_desc(uint8_t spi_mux_target, int register_id, int8_t page, uint8_t addr, uint8_t offs, bool sign, uint8_t leng, bool rdon, int32_t dflt, int32_t *reg_value) {
+    uint8_t buf[4] = {0, 0, 0, 0};
+    uint32_t u = 0;
+    int i;
+
+    (void)rdon;
+    (void)dflt;
+    if ((reg_value == NULL) || (((offs + leng) > 8) && ((offs != 0) || (leng > 32)))) {
+        return LGW_REG_ERROR;
+    }
+    if (reg_r_bytes(spi_mux_target, register_id, page, addr, buf, (offs + leng + 7) / 8) != LGW_REG_SUCCESS) {
+        return LGW_REG_ERROR;
+    }
+    for (i = ((offs + leng + 7) / 8) - 1; i >= 0; --i) {
+        u = (u << 8) | buf[i];
+    }
+    u = u >> offs;
+    if (leng < 32) {
+        u &= (1U << leng) - 1;
+        if ((sign == true) && ((u >> (leng - 1)) != 0)) {
+            u |= ~((1U << leng) - 1); /* sign extension */
+        }
+    }
+    *reg_value = (int32_t)u;
+    return LGW_REG_SUCCESS;
+}
 
 #endif
 
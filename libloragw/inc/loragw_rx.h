@@ -0,0 +1,98 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+  (C)2013 Semtech-Cycleo
+
+Description:
+    Optional background RX engine: a thread drains the concentrator RX FIFO
+    into a preallocated single-producer/single-consumer ring of packets, and
+    notifies the consumer through an eventfd (usable with poll/epoll).
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+Maintainer: Sylvain Miermont
+*/
+
+
+#ifndef _LORAGW_RX_H
+#define _LORAGW_RX_H
+
+/* -------------------------------------------------------------------------- */
+/* --- DEPENDANCIES --------------------------------------------------------- */
+
+#include <stdint.h>     /* C99 types */
+#include <stdbool.h>    /* bool type */
+
+#include "loragw_hal.h"
+
+#include "config.h"     /* library configuration options (dynamically generated) */
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC CONSTANTS ----------------------------------------------------- */
+
+#define LGW_RX_SUCCESS      0
+#define LGW_RX_ERROR        -1
+
+#define LGW_RX_RING_SIZE    256     /* number of packets in the ring, power of 2 */
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC TYPES --------------------------------------------------------- */
+
+/**
+@struct lgw_rx_stat_s
+@brief Counters of the RX engine, since it was started
+*/
+struct lgw_rx_stat_s {
+    uint32_t    nb_pkt;     /*!> number of packets queued in the ring */
+    uint32_t    nb_drop;    /*!> number of packets dropped because the ring was full */
+    uint32_t    nb_error;   /*!> number of lgw_receive calls that failed */
+    uint32_t    max_fill;   /*!> maximum number of packets waiting in the ring */
+};
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC FUNCTIONS PROTOTYPES ------------------------------------------ */
+
+/**
+@brief Start the RX engine thread, once the concentrator is started
+The SPI worker is started as well if it is not running, so that the other
+threads can keep calling the HAL (lgw_send, ...) while packets are received.
+@param poll_us time between two lgw_receive calls when the RX FIFO is empty, in microseconds
+@return LGW_RX_ERROR if the engine could not be started, LGW_RX_SUCCESS otherwise
+*/
+int lgw_rx_start(unsigned long poll_us);
+
+/**
+@brief Stop the RX engine thread, the packets not dequeued yet are discarded
+If the SPI worker was started by lgw_rx_start, it is stopped as well.
+@return LGW_RX_ERROR if the engine is not running, LGW_RX_SUCCESS otherwise
+*/
+int lgw_rx_stop(void);
+
+/**
+@brief Get the file descriptor signaling the packets available in the ring
+The descriptor is readable (POLLIN/EPOLLIN) while packets are waiting, it is
+reset by lgw_rx_dequeue and must not be read or closed by the application.
+@return eventfd descriptor, -1 if the engine is not running
+*/
+int lgw_rx_fd(void);
+
+/**
+@brief Dequeue the packets received by the engine (non-blocking, single consumer)
+@param pkt_data array of structures receiving the packets, in reception order
+@param max_pkt maximum number of packets to dequeue
+@return number of packets dequeued, LGW_RX_ERROR on error
+*/
+int lgw_rx_dequeue(struct lgw_pkt_rx_s *pkt_data, int max_pkt);
+
+/**
+@brief Get the counters of the RX engine
+@param stat structure receiving the counters
+@return LGW_RX_ERROR if stat is NULL, LGW_RX_SUCCESS otherwise
+*/
+int lgw_rx_stat_get(struct lgw_rx_stat_s *stat);
+
+#endif
+
+/* --- EOF ------------------------------------------------------------------ */
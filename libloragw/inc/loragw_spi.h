@@ -10,8 +10,11 @@ Description:
     Host specific functions to address the LoRa concentrator registers through a
     SPI interface.
     Single-byte read/write and burst read/write.
+    Batches of read/write operations sent in a single transaction.
     Does not handle pagination.
     Could be used with multiple SPI ports in parallel (explicit file descriptor)
+    Accesses are dispatched to a backend: native Linux spidev, or an in-memory
+    simulation of the concentrator for tests and benchmarks without hardware.
 
 License: Revised BSD License, see LICENSE.TXT file include in the project
 Maintainer: Sylvain Miermont
@@ -25,6 +28,7 @@ Maintainer: Sylvain Miermont
 /* --- DEPENDANCIES --------------------------------------------------------- */
 
 #include <stdint.h>        /* C99 types*/
+#include <stdbool.h>       /* bool type */
 
 #include "config.h"    /* library configuration options (dynamically generated) */
 
@@ -43,9 +47,121 @@ Maintainer: Sylvain Miermont
 #define LGW_SPI_MUX_TARGET_EEPROM   0x2
 #define LGW_SPI_MUX_TARGET_SX127X   0x3
 
+#define LGW_SPI_BATCH_MAX_OP    64  /* number of operations of a full batch (multiple accesses) */
+
+#define LGW_SPI_DEV_PATH_MAX    64  /* maximum length of the SPI device path, including terminating null */
+
+#define LGW_SPI_STAT_W          0   /* statistics of simple writes */
+#define LGW_SPI_STAT_R          1   /* statistics of simple reads */
+#define LGW_SPI_STAT_WB         2   /* statistics of burst writes */
+#define LGW_SPI_STAT_RB         3   /* statistics of burst reads */
+#define LGW_SPI_STAT_BATCH      4   /* statistics of batches */
+#define LGW_SPI_STAT_NB         5   /* number of access types with statistics */
+
+#define LGW_SPI_STAT_HISTO_NB   16  /* number of latency histogram bins (log2 scale, in us) */
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC TYPES --------------------------------------------------------- */
+
+/**
+@struct lgw_spi_op_s
+@brief Single SPI operation queued in a batch
+*/
+struct lgw_spi_op_s {
+    uint8_t     command[2];     /*!> command bytes (mux target and/or R/W bit + address) */
+    uint8_t     command_size;   /*!> number of command bytes to send */
+    uint8_t     read;           /*!> 1 if data is read from the concentrator, 0 if written */
+    uint8_t     byte;           /*!> storage for the data byte of a single-byte write */
+    uint8_t     *data;          /*!> caller buffer, must remain valid until batch is submitted */
+    uint16_t    size;           /*!> size of the data phase, in byte(s) */
+};
+
+/**
+@struct lgw_spi_batch_s
+@brief Queue of SPI operations sent to the concentrator in a single transaction
+The operations are stored in an array given by the caller to lgw_spi_batch_init,
+so that a single access does not need a full batch.
+*/
+struct lgw_spi_batch_s {
+    int                 nb_op;      /*!> number of queued operations */
+    int                 max_op;     /*!> size of the operations array */
+    struct lgw_spi_op_s *op;        /*!> queued operations, in execution order */
+};
+
+/**
+@struct lgw_spi_stat_s
+@brief Counters of one type of SPI access
+histo[0] counts accesses shorter than 1 us, histo[i] accesses between 2^(i-1)
+and 2^i us, the last bin all the longer accesses.
+*/
+struct lgw_spi_stat_s {
+    uint32_t    nb_call;                        /*!> number of accesses */
+    uint32_t    nb_error;                       /*!> number of accesses that failed */
+    uint64_t    nb_byte;                        /*!> number of data bytes transferred (command bytes excluded) */
+    uint64_t    time_ns;                        /*!> total duration of the accesses, in ns */
+    uint32_t    histo[LGW_SPI_STAT_HISTO_NB];   /*!> latency histogram */
+};
+
+/**
+@struct lgw_spi_backend_s
+@brief Set of functions implementing the SPI accesses for a given host platform
+*/
+struct lgw_spi_backend_s {
+    const char  *name;  /*!> name of the backend, for information */
+    int (*open)(void **spi_target_ptr);
+    int (*close)(void *spi_target);
+    int (*w)(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t data);
+    int (*r)(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data);
+    int (*wb)(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size);
+    int (*rb)(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size);
+    int (*batch)(void *spi_target, struct lgw_spi_batch_s *batch); /*!> optional, NULL: operations are sent one by one */
+};
+
+/**
+@struct lgw_spi_native_conf_s
+@brief Configuration of the Linux spidev backend, applied when the link is opened
+*/
+struct lgw_spi_native_conf_s {
+    char        dev_path[LGW_SPI_DEV_PATH_MAX]; /*!> SPI device to open (eg. /dev/spidev0.0) */
+    uint32_t    speed_hz;       /*!> requested max SPI clock, in Hz */
+    uint16_t    chunk_size;     /*!> max size of the data phase of a burst transfer, in byte(s) */
+    uint32_t    speed_applied;  /*!> read-only, SPI clock applied by the driver when the link was last opened, 0 if never opened */
+};
+
+/**
+@struct lgw_spi_sim_conf_s
+@brief Configuration of the simulated concentrator board
+*/
+struct lgw_spi_sim_conf_s {
+    bool        fpga;           /*!> simulate an SX1301AP2 board, with FPGA (LBT, spectral scan) and SX127x */
+    uint8_t     sx127x_version; /*!> content of the SX127x version register (0x12: SX1276, 0x22: SX1272) */
+};
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC VARIABLES ----------------------------------------------------- */
+
+extern const struct lgw_spi_backend_s lgw_spi_native_backend;   /* Linux spidev */
+extern const struct lgw_spi_backend_s lgw_spi_sim_backend;      /* in-memory concentrator simulation */
+
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC FUNCTIONS PROTOTYPES ------------------------------------------ */
 
+/**
+@brief Select the backend used for all subsequent SPI accesses
+Must be called before the SPI link is opened (ie. before lgw_start/lgw_connect).
+If no backend is selected, the LGW_SPI_BACKEND environment variable is checked
+when the link is opened ("sim" for the simulation), defaulting to native.
+@param backend pointer to the backend to use, NULL to restore default selection
+@return status of operation (LGW_SPI_SUCCESS/LGW_SPI_ERROR if link is already open)
+*/
+int lgw_spi_set_backend(const struct lgw_spi_backend_s *backend);
+
+/**
+@brief Get the backend used for SPI accesses
+@return pointer to the backend in use, NULL if none is selected yet
+*/
+const struct lgw_spi_backend_s *lgw_spi_get_backend(void);
+
 /**
 @brief LoRa concentrator SPI setup (configure I/O and peripherals)
 @param spi_target_ptr pointer on a generic pointer to SPI target (implementation dependant)
@@ -100,6 +216,137 @@ int lgw_spi_wb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, u
 */
 int lgw_spi_rb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size);
 
+/**
+@brief Give its operations array to a batch of SPI operations, and empty it
+@param batch pointer to the batch to be initialized
+@param op array storing the queued operations, must remain valid while the batch is used
+@param max_op size of the array, LGW_SPI_BATCH_MAX_OP for a full batch
+*/
+void lgw_spi_batch_init(struct lgw_spi_batch_s *batch, struct lgw_spi_op_s *op, int max_op);
+
+/**
+@brief Empty a batch of SPI operations, keeping its operations array
+@param batch pointer to the batch to be emptied
+*/
+void lgw_spi_batch_clear(struct lgw_spi_batch_s *batch);
+
+/**
+@brief Queue a single-byte write in a batch
+@param batch pointer to the batch
+@param address 7-bit register address
+@param data data byte to write
+@return status of queueing (LGW_SPI_SUCCESS/LGW_SPI_ERROR if batch is full)
+*/
+int lgw_spi_batch_w(struct lgw_spi_batch_s *batch, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t data);
+
+/**
+@brief Queue a single-byte read in a batch
+@param batch pointer to the batch
+@param address 7-bit register address
+@param data pointer to byte that will be written when the batch is submitted
+@return status of queueing (LGW_SPI_SUCCESS/LGW_SPI_ERROR if batch is full)
+*/
+int lgw_spi_batch_r(struct lgw_spi_batch_s *batch, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data);
+
+/**
+@brief Queue a burst (multiple-byte) write in a batch
+@param batch pointer to the batch
+@param address 7-bit register address
+@param data pointer to byte array to send, NOT copied, must remain valid until submission
+@param size size of the transfer, in byte(s)
+@return status of queueing (LGW_SPI_SUCCESS/LGW_SPI_ERROR if batch is full)
+*/
+int lgw_spi_batch_wb(struct lgw_spi_batch_s *batch, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size);
+
+/**
+@brief Queue a burst (multiple-byte) read in a batch
+@param batch pointer to the batch
+@param address 7-bit register address
+@param data pointer to byte array that will be written when the batch is submitted
+@param size size of the transfer, in byte(s)
+@return status of queueing (LGW_SPI_SUCCESS/LGW_SPI_ERROR if batch is full)
+*/
+int lgw_spi_batch_rb(struct lgw_spi_batch_s *batch, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size);
+
+/**
+@brief Send all the operations of a batch to the concentrator
+Chip select is released between operations, so each operation behaves exactly
+like the equivalent individual function call. The batch is not emptied.
+@param spi_target generic pointer to SPI target (implementation dependant)
+@param batch pointer to the batch to be executed
+@return status of register operation (LGW_SPI_SUCCESS/LGW_SPI_ERROR)
+*/
+int lgw_spi_batch_submit(void *spi_target, struct lgw_spi_batch_s *batch);
+
+/**
+@brief Get the counters of a type of SPI access, since last reset
+Counters are kept for all the backends, batches are counted as a single access.
+@param type type of access (LGW_SPI_STAT_W/R/WB/RB/BATCH)
+@param stat pointer to the structure to fill
+@return status of operation (LGW_SPI_SUCCESS/LGW_SPI_ERROR)
+*/
+int lgw_spi_stat_get(uint8_t type, struct lgw_spi_stat_s *stat);
+
+/**
+@brief Reset the counters of all types of SPI access
+*/
+void lgw_spi_stat_reset(void);
+
+/**
+@brief Configure the Linux spidev backend
+The environment variables LGW_SPI_DEV, LGW_SPI_SPEED and LGW_SPI_CHUNK, if set,
+override the corresponding fields when the link is opened.
+@param conf structure containing the configuration (speed_applied is ignored)
+@return status of operation (LGW_SPI_SUCCESS/LGW_SPI_ERROR)
+*/
+int lgw_spi_native_setconf(struct lgw_spi_native_conf_s conf);
+
+/**
+@brief Get the configuration of the Linux spidev backend
+@param conf pointer to a structure to be filled with the current configuration and applied SPI clock
+@return status of operation (LGW_SPI_SUCCESS/LGW_SPI_ERROR)
+*/
+int lgw_spi_native_getconf(struct lgw_spi_native_conf_s *conf);
+
+/**
+@brief Configure the simulated board, (re)powering the simulated concentrator
+@param conf structure containing the simulation configuration
+@return status of operation (LGW_SPI_SUCCESS/LGW_SPI_ERROR)
+*/
+int lgw_spi_sim_setconf(struct lgw_spi_sim_conf_s conf);
+
+/**
+@brief Put a received packet in the simulated RX data buffer and packet FIFO
+@param status CRC status of the packet, as reported in the FIFO
+@param payload pointer to the packet payload
+@param size size of the payload, in byte(s)
+@param metadata pointer to the 16 bytes of metadata following the payload
+@return status of operation (LGW_SPI_SUCCESS/LGW_SPI_ERROR if FIFO is full)
+*/
+int lgw_spi_sim_rx_push(uint8_t status, const uint8_t *payload, uint8_t size, const uint8_t *metadata);
+
+/**
+@brief Make one of the next simulated SPI frames fail, once
+@param nb_frame rank of the failing frame, counting from 1, 0 to cancel
+@return status of operation (LGW_SPI_SUCCESS/LGW_SPI_ERROR)
+*/
+int lgw_spi_sim_fault(uint32_t nb_frame);
+
+/**
+@brief Make the simulated LBT channels busy, their FPGA timestamps are not updated anymore
+@param busy true to freeze the LBT timestamps, false to find the channels free again
+@return status of operation (LGW_SPI_SUCCESS/LGW_SPI_ERROR)
+*/
+int lgw_spi_sim_lbt_busy(bool busy);
+
+/**
+@brief Get the content of the simulated TX data buffer and number of TX triggers
+@param data pointer to byte array to store TX buffer content (can be NULL)
+@param size number of bytes to copy, from address 0
+@return number of TX triggered since simulation power-up
+*/
+uint32_t lgw_spi_sim_tx_get(uint8_t *data, uint16_t size);
+
 #endif
 
 /* --- EOF ------------------------------------------------------------------ */
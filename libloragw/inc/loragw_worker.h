@@ -0,0 +1,79 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+  (C)2013 Semtech-Cycleo
+
+Description:
+    Optional SPI owner thread: HAL calls made by several application threads
+    are queued (lock-free, by priority) and executed one at a time by the
+    worker thread, so that the register layer state stays consistent.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+Maintainer: Sylvain Miermont
+*/
+
+
+#ifndef _LORAGW_WORKER_H
+#define _LORAGW_WORKER_H
+
+/* -------------------------------------------------------------------------- */
+/* --- DEPENDANCIES --------------------------------------------------------- */
+
+#include <stdint.h>     /* C99 types */
+#include <stdbool.h>    /* bool type */
+
+#include "config.h"     /* library configuration options (dynamically generated) */
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC CONSTANTS ----------------------------------------------------- */
+
+#define LGW_WORKER_SUCCESS      0
+#define LGW_WORKER_ERROR        -1
+
+#define LGW_WORKER_PRIO_HIGH    0   /* time-critical transactions (TX programming, abort, status) */
+#define LGW_WORKER_PRIO_NORMAL  1   /* default priority (RX, timestamp counter, ...) */
+#define LGW_WORKER_PRIO_LOW     2   /* bulk transfers (spectral scan histogram, ...) */
+#define LGW_WORKER_PRIO_NB      3   /* number of priority levels */
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC FUNCTIONS PROTOTYPES ------------------------------------------ */
+
+/**
+@brief Start the SPI worker thread
+Once started, the HAL functions called from any other thread are executed by
+the worker. Can be called before or after lgw_start.
+@return LGW_WORKER_ERROR if the thread could not be created, LGW_WORKER_SUCCESS otherwise
+*/
+int lgw_worker_start(void);
+
+/**
+@brief Stop the SPI worker thread, after the transactions already queued
+No other thread must call the HAL while the worker is being stopped.
+@return LGW_WORKER_ERROR if the worker is not running, LGW_WORKER_SUCCESS otherwise
+*/
+int lgw_worker_stop(void);
+
+/**
+@brief Tell if a call must be delegated to the worker thread
+@return true if the worker is running and the caller is not the worker thread
+*/
+bool lgw_worker_delegate(void);
+
+/**
+@brief Execute a transaction in the worker thread, and wait for its completion
+Transactions are executed by order of priority, then in submission order.
+If the worker is not running, or if called from the worker thread, the
+transaction is executed directly by the caller.
+@param job function executed by the worker thread
+@param arg argument passed to the function
+@param prio priority of the transaction (LGW_WORKER_PRIO_xxx)
+@return value returned by the function, LGW_WORKER_ERROR on error
+*/
+int lgw_worker_call(int (*job)(void *arg), void *arg, uint8_t prio);
+
+#endif
+
+/* --- EOF ------------------------------------------------------------------ */
@@ -25,7 +25,9 @@ Maintainer: Sylvain Miermont
 #endif
 
 #include <stdio.h>  /* printf fprintf */
-#include <time.h>   /* clock_nanosleep */
+#include <time.h>   /* clock_nanosleep, clock_gettime */
+
+#include "loragw_aux.h"
 
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE MACROS ------------------------------------------------------- */
@@ -58,4 +60,43 @@ void wait_ms(unsigned long a) {
     return;
 }
 
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+void wait_us(unsigned long a) {
+    struct timespec dly;
+
+    dly.tv_sec = a / 1000000;
+    dly.tv_nsec = ((long)a % 1000000) * 1000;
+
+    if ((dly.tv_sec > 0) || (dly.tv_nsec > 0)) {
+        clock_nanosleep(CLOCK_MONOTONIC, 0, &dly, NULL);
+    }
+    return;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+bool wait_cond(bool (*cond)(void *arg), void *arg, unsigned long timeout_ms, unsigned long period_us) {
+    struct timespec deadline;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += ((long)timeout_ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    while (cond(arg) == false) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if ((now.tv_sec > deadline.tv_sec) || ((now.tv_sec == deadline.tv_sec) && (now.tv_nsec >= deadline.tv_nsec))) {
+            DEBUG_PRINTF("NOTE: condition not met after %lu ms\n", timeout_ms);
+            return cond(arg); /* last chance */
+        }
+        wait_us(period_us);
+    }
+    return true;
+}
+
 /* --- EOF ------------------------------------------------------------------ */
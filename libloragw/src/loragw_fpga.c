@@ -28,6 +28,7 @@ Maintainer: Michael Coracin
 #include "loragw_hal.h"
 #include "loragw_reg.h"
 #include "loragw_fpga.h"
+#include "loragw_worker.h"
 
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE MACROS ------------------------------------------------------- */
@@ -53,44 +54,70 @@ this file is autogenerated from registers description
 293 registers are defined
 */
 const struct lgw_reg_s fpga_regs[LGW_FPGA_TOTALREGS] = {
-    {-1,0,0,0,1,0,0}, /* SOFT_RESET */
-    {-1,0,1,0,4,1,0}, /* FPGA_FEATURE */
-    {-1,0,5,0,3,1,0}, /* LBT_INITIAL_FREQ */
-    {-1,1,0,0,8,1,0}, /* VERSION */
-    {-1,2,0,0,8,1,0}, /* FPGA_STATUS */
-    {-1,3,0,0,1,0,0}, /* FPGA_CTRL_FEATURE_START */
-    {-1,3,1,0,1,0,0}, /* FPGA_CTRL_RADIO_RESET */
-    {-1,3,2,0,1,0,0}, /* FPGA_CTRL_INPUT_SYNC_I */
-    {-1,3,3,0,1,0,0}, /* FPGA_CTRL_INPUT_SYNC_Q */
-    {-1,3,4,0,1,0,0}, /* FPGA_CTRL_OUTPUT_SYNC */
-    {-1,3,5,0,1,0,0}, /* FPGA_CTRL_INVERT_IQ */
-    {-1,3,6,0,1,0,0}, /* FPGA_CTRL_ACCESS_HISTO_MEM */
-    {-1,3,7,0,1,0,0}, /* FPGA_CTRL_CLEAR_HISTO_MEM */
-    {-1,4,0,0,8,0,0}, /* HISTO_RAM_ADDR */
-    {-1,5,0,0,8,1,0}, /* HISTO_RAM_DATA */
-    {-1,8,0,0,16,0,1000}, /* HISTO_NB_READ */
-    {-1,14,0,0,16,1,0}, /* LBT_TIMESTAMP_CH */
-    {-1,17,0,0,4,0,0}, /* LBT_TIMESTAMP_SELECT_CH */
-    {-1,18,0,0,8,0,0}, /* LBT_CH0_FREQ_OFFSET */
-    {-1,19,0,0,8,0,0}, /* LBT_CH1_FREQ_OFFSET */
-    {-1,20,0,0,8,0,0}, /* LBT_CH2_FREQ_OFFSET */
-    {-1,21,0,0,8,0,0}, /* LBT_CH3_FREQ_OFFSET */
-    {-1,22,0,0,8,0,0}, /* LBT_CH4_FREQ_OFFSET */
-    {-1,23,0,0,8,0,0}, /* LBT_CH5_FREQ_OFFSET */
-    {-1,24,0,0,8,0,0}, /* LBT_CH6_FREQ_OFFSET */
-    {-1,25,0,0,8,0,0}, /* LBT_CH7_FREQ_OFFSET */
-    {-1,26,0,0,8,0,0}, /* SCAN_FREQ_OFFSET */
-    {-1,28,0,0,1,0,0}, /* LBT_SCAN_TIME_CH0 */
-    {-1,28,1,0,1,0,0}, /* LBT_SCAN_TIME_CH1 */
-    {-1,28,2,0,1,0,0}, /* LBT_SCAN_TIME_CH2 */
-    {-1,28,3,0,1,0,0}, /* LBT_SCAN_TIME_CH3 */
-    {-1,28,4,0,1,0,0}, /* LBT_SCAN_TIME_CH4 */
-    {-1,28,5,0,1,0,0}, /* LBT_SCAN_TIME_CH5 */
-    {-1,28,6,0,1,0,0}, /* LBT_SCAN_TIME_CH6 */
-    {-1,28,7,0,1,0,0}, /* LBT_SCAN_TIME_CH7 */
-    {-1,30,0,0,8,0,160}, /* RSSI_TARGET */
-    {-1,31,0,0,24,0,0}, /* HISTO_SCAN_FREQ */
-    {-1,34,0,0,6,0,0} /* NOTCH_FREQ_OFFSET */
+    {LGW_FPGA_SOFT_RESET_DESC},
+    {LGW_FPGA_FEATURE_DESC},
+    {LGW_FPGA_LBT_INITIAL_FREQ_DESC},
+    {LGW_FPGA_VERSION_DESC},
+    {LGW_FPGA_STATUS_DESC},
+    {LGW_FPGA_CTRL_FEATURE_START_DESC},
+    {LGW_FPGA_CTRL_RADIO_RESET_DESC},
+    {LGW_FPGA_CTRL_INPUT_SYNC_I_DESC},
+    {LGW_FPGA_CTRL_INPUT_SYNC_Q_DESC},
+    {LGW_FPGA_CTRL_OUTPUT_SYNC_DESC},
+    {LGW_FPGA_CTRL_INVERT_IQ_DESC},
+    {LGW_FPGA_CTRL_ACCESS_HISTO_MEM_DESC},
+    {LGW_FPGA_CTRL_CLEAR_HISTO_MEM_DESC},
+    {LGW_FPGA_HISTO_RAM_ADDR_DESC},
+    {LGW_FPGA_HISTO_RAM_DATA_DESC},
+    {LGW_FPGA_HISTO_NB_READ_DESC},
+    {LGW_FPGA_LBT_TIMESTAMP_CH_DESC},
+    {LGW_FPGA_LBT_TIMESTAMP_SELECT_CH_DESC},
+    {LGW_FPGA_LBT_CH0_FREQ_OFFSET_DESC},
+    {LGW_FPGA_LBT_CH1_FREQ_OFFSET_DESC},
+    {LGW_FPGA_LBT_CH2_FREQ_OFFSET_DESC},
+    {LGW_FPGA_LBT_CH3_FREQ_OFFSET_DESC},
+    {LGW_FPGA_LBT_CH4_FREQ_OFFSET_DESC},
+    {LGW_FPGA_LBT_CH5_FREQ_OFFSET_DESC},
+    {LGW_FPGA_LBT_CH6_FREQ_OFFSET_DESC},
+    {LGW_FPGA_LBT_CH7_FREQ_OFFSET_DESC},
+    {LGW_FPGA_SCAN_FREQ_OFFSET_DESC},
+    {LGW_FPGA_LBT_SCAN_TIME_CH0_DESC},
+    {LGW_FPGA_LBT_SCAN_TIME_CH1_DESC},
+    {LGW_FPGA_LBT_SCAN_TIME_CH2_DESC},
+    {LGW_FPGA_LBT_SCAN_TIME_CH3_DESC},
+    {LGW_FPGA_LBT_SCAN_TIME_CH4_DESC},
+    {LGW_FPGA_LBT_SCAN_TIME_CH5_DESC},
+    {LGW_FPGA_LBT_SCAN_TIME_CH6_DESC},
+    {LGW_FPGA_LBT_SCAN_TIME_CH7_DESC},
+    {LGW_FPGA_RSSI_TARGET_DESC},
+    {LGW_FPGA_HISTO_SCAN_FREQ_DESC},
+    {LGW_FPGA_NOTCH_FREQ_OFFSET_DESC}
+};
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE TYPES -------------------------------------------------------- */
+
+/* arguments of the calls executed by the SPI worker thread */
+struct fpga_w_args_s {
+    uint16_t register_id;
+    int32_t reg_value;
+};
+
+struct fpga_r_args_s {
+    uint16_t register_id;
+    int32_t *reg_value;
+};
+
+struct fpga_wb_args_s {
+    uint16_t register_id;
+    uint8_t *data;
+    uint16_t size;
+};
+
+struct fpga_rb_args_s {
+    uint16_t register_id;
+    uint8_t *data;
+    uint16_t size;
 };
 
 /* -------------------------------------------------------------------------- */
@@ -110,6 +137,34 @@ static uint8_t tx_notch_offset;
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE FUNCTIONS DEFINITION ----------------------------------------- */
 
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int fpga_w_job(void *arg) {
+    struct fpga_w_args_s *a = arg;
+    return lgw_fpga_reg_w(a->register_id, a->reg_value);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int fpga_r_job(void *arg) {
+    struct fpga_r_args_s *a = arg;
+    return lgw_fpga_reg_r(a->register_id, a->reg_value);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int fpga_wb_job(void *arg) {
+    struct fpga_wb_args_s *a = arg;
+    return lgw_fpga_reg_wb(a->register_id, a->data, a->size);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int fpga_rb_job(void *arg) {
+    struct fpga_rb_args_s *a = arg;
+    return lgw_fpga_reg_rb(a->register_id, a->data, a->size);
+}
+
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC FUNCTIONS DEFINITION ------------------------------------------ */
 
@@ -203,6 +258,12 @@ int lgw_fpga_reg_w(uint16_t register_id, int32_t reg_value) {
     int spi_stat = LGW_SPI_SUCCESS;
     struct lgw_reg_s r;
 
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct fpga_w_args_s args = {register_id, reg_value};
+        return lgw_worker_call(fpga_w_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
     /* check input parameters */
     if (register_id >= LGW_FPGA_TOTALREGS) {
         DEBUG_MSG("ERROR: REGISTER NUMBER OUT OF DEFINED RANGE\n");
@@ -241,6 +302,12 @@ int lgw_fpga_reg_r(uint16_t register_id, int32_t *reg_value) {
     int spi_stat = LGW_SPI_SUCCESS;
     struct lgw_reg_s r;
 
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct fpga_r_args_s args = {register_id, reg_value};
+        return lgw_worker_call(fpga_r_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
     /* check input parameters */
     CHECK_NULL(reg_value);
     if (register_id >= LGW_FPGA_TOTALREGS) {
@@ -274,6 +341,12 @@ int lgw_fpga_reg_wb(uint16_t register_id, uint8_t *data, uint16_t size) {
     int spi_stat = LGW_SPI_SUCCESS;
     struct lgw_reg_s r;
 
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct fpga_wb_args_s args = {register_id, data, size};
+        return lgw_worker_call(fpga_wb_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
     /* check input parameters */
     CHECK_NULL(data);
     if (size == 0) {
@@ -318,6 +391,12 @@ int lgw_fpga_reg_rb(uint16_t register_id, uint8_t *data, uint16_t size) {
     int spi_stat = LGW_SPI_SUCCESS;
     struct lgw_reg_s r;
 
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct fpga_rb_args_s args = {register_id, data, size};
+        return lgw_worker_call(fpga_rb_job, &args, LGW_WORKER_PRIO_LOW);
+    }
+
     /* check input parameters */
     CHECK_NULL(data);
     if (size == 0) {
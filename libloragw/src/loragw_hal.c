@@ -17,11 +17,21 @@ Maintainer: Sylvain Miermont
 /* -------------------------------------------------------------------------- */
 /* --- DEPENDANCIES --------------------------------------------------------- */
 
+/* fix an issue between POSIX and C99 */
+#if __STDC_VERSION__ >= 199901L
+    #define _XOPEN_SOURCE 600
+#else
+    #define _XOPEN_SOURCE 500
+#endif
+
 #include <stdint.h>     /* C99 types */
 #include <stdbool.h>    /* bool type */
+#include <stddef.h>     /* offsetof */
 #include <stdio.h>      /* printf fprintf */
 #include <string.h>     /* memcpy */
 #include <math.h>       /* pow, cell */
+#include <time.h>       /* time, clock_gettime */
+#include <pthread.h>    /* pthread_mutex_lock, pthread_self */
 
 #include "loragw_reg.h"
 #include "loragw_hal.h"
@@ -30,6 +40,7 @@ Maintainer: Sylvain Miermont
 #include "loragw_radio.h"
 #include "loragw_fpga.h"
 #include "loragw_lbt.h"
+#include "loragw_worker.h"
 
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE MACROS ------------------------------------------------------- */
@@ -51,6 +62,12 @@ Maintainer: Sylvain Miermont
 #define SET_PPM_ON(bw,dr)   (((bw == BW_125KHZ) && ((dr == DR_LORA_SF11) || (dr == DR_LORA_SF12))) || ((bw == BW_250KHZ) && (dr == DR_LORA_SF12)))
 #define TRACE()             fprintf(stderr, "@ %s %d\n", __FUNCTION__, __LINE__);
 
+/* refuse a HAL call made while lgw_start runs in another thread */
+#define CHECK_START_BUSY()  if(start_in_progress()==true){DEBUG_MSG("ERROR: CONCENTRATOR START IN PROGRESS\n");return LGW_HAL_ERROR;}
+
+/* append a register value to an array of max elements, return an error if it is full */
+#define REG_VAL_ADD(regs,nb,max,id,val) do { if ((nb) >= (max)) { DEBUG_PRINTF("ERROR: MORE THAN %d REGISTERS\n", (max)); return LGW_HAL_ERROR; } (regs)[(nb)++] = (struct lgw_reg_val_s){(id), (val)}; } while (0)
+
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE CONSTANTS & TYPES -------------------------------------------- */
 
@@ -62,12 +79,30 @@ Maintainer: Sylvain Miermont
 #define FW_VERSION_CAL      2 /* Expected version of calibration firmware */
 #define FW_VERSION_AGC      4 /* Expected version of AGC firmware */
 #define FW_VERSION_ARB      1 /* Expected version of arbiter firmware */
+#define FW_CHECK_CHUNK      1024 /* firmware read back and compared by chunks */
 
 #define TX_METADATA_NB      16
 #define RX_METADATA_NB      16
 
 #define AGC_CMD_WAIT        16
 #define AGC_CMD_ABORT       17
+#define AGC_CMD_WAIT_MS     1 /* time for the AGC firmware to enter the mailbox wait state */
+#define AGC_STATUS_TIMEOUT_MS   100 /* AGC firmware acknowledge of a mailbox command, normally a few us */
+#define AGC_STATUS_POLL_US      50
+
+#define CAL_TIMEOUT_MS      2300 /* measured between 2.1 and 2.2 sec, because 1 TX only */
+#define CAL_POLL_US         10000
+
+#define XTAL_STARTUP_MS     500 /* worst case 32 MHz XTAL start-up time, before the radios reset */
+
+#define CALCACHE_MAGIC      0x4C43414CUL /* "LACL" */
+#define CALCACHE_VERSION    1
+#define CALCACHE_IQ_NB      5 /* IQ mismatch compensation registers set by the calibration */
+#define LBT_READY_TIMEOUT_MS    8400 /* worst case time for the LBT FSM to scan all its channels once */
+
+#define TSTAMP_SF_MIN       6 /* LoRa timestamp correction table, valid spreading factors */
+#define TSTAMP_SF_NB        7
+#define TSTAMP_CR_NB        8 /* raw coding rate field of the metadata, 3 bits */
 
 #define MIN_LORA_PREAMBLE   6
 #define STD_LORA_PREAMBLE   8
@@ -87,12 +122,92 @@ Maintainer: Sylvain Miermont
 
 #define TX_START_DELAY_DEFAULT  1497 /* Calibrated value for 500KHz BW and notch filter disabled */
 
+#define IF_REGS_MAX         32  /* registers of the IF chains configuration, see if_regs_get */
+#define CONSTANT_REGS_MAX   32  /* registers set by lgw_constant_adjust */
+#define MODEM_REGS_MAX      (CONSTANT_REGS_MAX + 4 + IF_REGS_MAX) /* registers of the modems configuration written by lgw_start */
+
 /* constant arrays defining hardware capability */
 const uint8_t ifmod_config[LGW_IF_CHAIN_NB] = LGW_IFMODEM_CONFIG;
 
 /* Version string, used to identify the library version/options once compiled */
 const char lgw_version_string[] = "Version: " LIBLORAGW_VERSION ";";
 
+/* arguments of the HAL calls executed by the SPI worker thread */
+struct hal_receive_args_s {
+    uint8_t max_pkt;
+    struct lgw_pkt_rx_s *pkt_data;
+};
+
+struct hal_send_args_s {
+    struct lgw_pkt_tx_s *pkt_data;
+};
+
+struct hal_status_args_s {
+    uint8_t select;
+    uint8_t *code;
+};
+
+struct hal_get_trigcnt_args_s {
+    uint32_t *trig_cnt_us;
+};
+
+struct hal_reconfigure_args_s {
+    const struct lgw_conf_rxif_s *if_conf;
+    const float *rssi_offset;
+};
+
+struct hal_rxfilter_setconf_args_s {
+    struct lgw_conf_rxfilter_s *conf;
+};
+
+/* IF chains configuration, saved to roll back a rejected reconfiguration */
+struct if_conf_s {
+    bool if_enable[LGW_IF_CHAIN_NB];
+    bool if_rf_chain[LGW_IF_CHAIN_NB];
+    int32_t if_freq[LGW_IF_CHAIN_NB];
+    uint8_t lora_multi_sfmask[LGW_MULTI_NB];
+    uint8_t lora_rx_bw;
+    uint8_t lora_rx_sf;
+    bool lora_rx_ppm_offset;
+    uint8_t fsk_rx_bw;
+    uint32_t fsk_rx_dr;
+    uint8_t fsk_sync_word_size;
+    uint64_t fsk_sync_word;
+};
+
+/* calibration cache, identifies a calibration (zero-filled, compared with memcmp) */
+struct calcache_key_s {
+    uint64_t    board_id;
+    uint8_t     chip_version;   /* SX1301 version */
+    uint8_t     clksrc;
+    uint8_t     cal_cmd;        /* radios enabled, TX enabled, radio type */
+    uint8_t     radio_type[LGW_RF_CHAIN_NB];
+    uint32_t    rf_rx_freq[LGW_RF_CHAIN_NB];
+};
+
+/* calibration cache, file content */
+struct calcache_rec_s {
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    nb_reuse;       /* number of warm restarts using this calibration */
+    int64_t     time;           /* time of the calibration, in seconds since the Epoch */
+    struct calcache_key_s key;
+    uint8_t     cal_status;
+    int8_t      offset_a_i[8];
+    int8_t      offset_a_q[8];
+    int8_t      offset_b_i[8];
+    int8_t      offset_b_q[8];
+    int32_t     iq_coeff[CALCACHE_IQ_NB];
+    uint32_t    checksum;       /* of all the previous bytes */
+};
+
+/* polling condition on the AGC MCU status register */
+struct agc_status_cond_s {
+    uint8_t mask;
+    uint8_t expected;
+    int32_t read_val;
+};
+
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE VARIABLES ---------------------------------------------------- */
 
@@ -159,25 +274,117 @@ static int8_t cal_offset_a_q[8]; /* TX Q offset for radio A */
 static int8_t cal_offset_b_i[8]; /* TX I offset for radio B */
 static int8_t cal_offset_b_q[8]; /* TX Q offset for radio B */
 
+static struct lgw_conf_fw_s fw_conf = {LGW_FW_CHECK_FULL, false};
+static struct lgw_conf_calcache_s calcache_conf; /* disabled by default */
+
+/* start-up script, modems configuration compiled once and replayed by the next starts */
+static bool start_script_en = false;
+static bool start_script_valid = false;
+static struct lgw_reg_script_s start_script;
+
+/* RX packet filters, see lgw_rxfilter_setconf */
+static struct lgw_conf_rxfilter_s rx_filter; /* disabled by default */
+static bool rx_filter_meta = false; /* metadata read before the payload */
+
+/* RX timestamp correction, built from the modems configuration by tstamp_corr_build */
+static uint16_t lora_tstamp_corr[2][TSTAMP_SF_NB][TSTAMP_CR_NB][2][256]; /* [std modem][sf][cr][crc][size], in us */
+static uint32_t fsk_tstamp_corr; /* in us */
+
+/* lgw_start in progress, see start_in_progress (its steps are not overlapped, the start is not asynchronous) */
+static pthread_mutex_t start_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool start_busy = false;
+static pthread_t start_owner; /* thread running lgw_start */
+
+/* profile of the last lgw_start */
+static const char *start_phase_name[LGW_START_PHASE_NB] = {"connect", "radio", "lbt", "calibration", "modem", "firmware", "agc"};
+static struct lgw_start_profile_s start_prof;
+static bool start_prof_valid = false;
+static bool start_prof_entered[LGW_START_PHASE_NB];
+static uint8_t start_prof_cur; /* current phase, LGW_START_PHASE_NB if none */
+static uint64_t start_prof_enter_ns; /* entry in the current phase */
+static uint32_t start_prof_enter_call; /* SPI counters at the entry in the current phase */
+static uint64_t start_prof_enter_byte;
+
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE FUNCTIONS DECLARATION ---------------------------------------- */
 
+static bool fw_check(const uint8_t *firmware, uint16_t size);
 int load_firmware(uint8_t target, uint8_t *firmware, uint16_t size);
 
-void lgw_constant_adjust(void);
+static int lgw_constant_adjust(struct lgw_reg_val_s *regs, int max_regs);
 
 int32_t lgw_sf_getval(int x);
 int32_t lgw_bw_getval(int x);
 
+static bool agc_status_cond(void *arg);
+static int agc_status_poll(uint8_t mask, uint8_t expected, unsigned long timeout_ms, unsigned long period_us, int32_t *read_val);
+
+static int lgw_calibrate(uint8_t cal_cmd, uint8_t *status);
+
+static void calcache_key(uint8_t cal_cmd, struct calcache_key_s *key);
+static uint32_t calcache_checksum(const struct calcache_rec_s *rec);
+static int calcache_write(const struct calcache_rec_s *rec);
+static bool calcache_load(uint8_t cal_cmd);
+static void calcache_save(uint8_t cal_cmd, uint8_t cal_status);
+
+static int rxif_setconf(uint8_t if_chain, struct lgw_conf_rxif_s conf);
+static void if_conf_save(struct if_conf_s *c);
+static void if_conf_restore(const struct if_conf_s *c);
+static int if_regs_get(struct lgw_reg_val_s *regs);
+
+static uint32_t modem_regs_key(const struct lgw_reg_val_s *regs, int nb_regs);
+static int modem_regs_write(const struct lgw_reg_val_s *regs, int nb_regs);
+
+static uint64_t start_prof_now(void);
+static void start_prof_spi(uint32_t *nb_call, uint64_t *nb_byte);
+static void start_prof_begin(void);
+static void start_prof_phase(uint8_t phase);
+static void start_prof_end(void);
+
+static bool start_acquire(void);
+static void start_release(void);
+static bool start_in_progress(void);
+
+static bool rx_filter_status(int stat_fifo);
+static bool rx_filter_accept(const struct lgw_pkt_rx_s *p);
+static void rx_burst_set(struct lgw_reg_burst_s *b, uint16_t register_id, bool read, uint8_t *data, uint16_t size);
+static uint32_t rxpoll_toa_us(uint8_t modulation, uint8_t bandwidth, uint32_t datarate, uint8_t coderate, uint16_t size);
+
+static uint32_t lora_tstamp_corr_calc(int ifmod, uint32_t sf, uint32_t cr, uint32_t crc_en, unsigned sz);
+static void tstamp_corr_build(void);
+
+static int hal_start_impl(void);
+static int hal_receive_impl(uint8_t max_pkt, struct lgw_pkt_rx_s *pkt_data);
+static int hal_send_impl(struct lgw_pkt_tx_s pkt_data);
+
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE FUNCTIONS DEFINITION ----------------------------------------- */
 
+/* compare the program RAM with the firmware, from the current program RAM address */
+static bool fw_check(const uint8_t *firmware, uint16_t size) {
+    uint8_t buf[FW_CHECK_CHUNK];
+    uint16_t chunk;
+    int32_t dummy;
+    int i;
+
+    lgw_reg_r(LGW_MCU_PROM_DATA, &dummy); /* bug workaround */
+    for (i = 0; i < size; i += chunk) {
+        chunk = ((size - i) < FW_CHECK_CHUNK) ? (size - i) : FW_CHECK_CHUNK;
+        lgw_reg_rb(LGW_MCU_PROM_DATA, buf, chunk);
+        if (memcmp(firmware + i, buf, chunk) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
 /* size is the firmware size in bytes (not 14b words) */
 int load_firmware(uint8_t target, uint8_t *firmware, uint16_t size) {
     int reg_rst;
     int reg_sel;
-    uint8_t fw_check[8192];
-    int32_t dummy;
+    uint16_t check_size;
 
     /* check parameters */
     CHECK_NULL(firmware);
@@ -203,17 +410,26 @@ int load_firmware(uint8_t target, uint8_t *firmware, uint16_t size) {
     /* reset the targeted MCU */
     lgw_reg_w(reg_rst, 1);
 
-    /* set mux to access MCU program RAM and set address to 0 */
+    /* set mux to access MCU program RAM */
     lgw_reg_w(reg_sel, 0);
-    lgw_reg_w(LGW_MCU_PROM_ADDR, 0);
+    check_size = (fw_conf.check == LGW_FW_CHECK_SAMPLE) ? LGW_FW_CHECK_SAMPLE_SIZE : size;
+
+    /* program RAM is kept through a soft reset, skip the loading if the firmware is still there */
+    if (fw_conf.keep_resident == true) {
+        lgw_reg_w(LGW_MCU_PROM_ADDR, 0);
+        if (fw_check(firmware, check_size) == true) {
+            DEBUG_PRINTF("Note: firmware already loaded in MCU %d\n", (int)target);
+            lgw_reg_w(reg_sel, 1);
+            return 0;
+        }
+    }
 
-    /* write the program in one burst */
+    /* write the program in one burst, from address 0 */
+    lgw_reg_w(LGW_MCU_PROM_ADDR, 0);
     lgw_reg_wb(LGW_MCU_PROM_DATA, firmware, size);
 
-    /* Read back firmware code for check */
-    lgw_reg_r( LGW_MCU_PROM_DATA, &dummy ); /* bug workaround */
-    lgw_reg_rb( LGW_MCU_PROM_DATA, fw_check, size );
-    if (memcmp(firmware, fw_check, size) != 0) {
+    /* Read back firmware code for check (address wrapped back to 0) */
+    if (fw_check(firmware, check_size) == false) {
         printf ("ERROR: Failed to load fw %d\n", (int)target);
         return -1;
     }
@@ -226,7 +442,9 @@ int load_firmware(uint8_t target, uint8_t *firmware, uint16_t size) {
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-void lgw_constant_adjust(void) {
+/* registers that differ from their default value, whatever the configuration, returns the number of registers (LGW_HAL_ERROR if more than max_regs) */
+static int lgw_constant_adjust(struct lgw_reg_val_s *regs, int max_regs) {
+    int nb_regs = 0;
 
     /* I/Q path setup */
     // lgw_reg_w(LGW_RX_INVERT_IQ,0); /* default 0 */
@@ -235,14 +453,14 @@ void lgw_constant_adjust(void) {
     // lgw_reg_w(LGW_RX_EDGE_SELECT,0); /* default 0 */
     // lgw_reg_w(LGW_MBWSSF_MODEM_INVERT_IQ,0); /* default 0 */
     // lgw_reg_w(LGW_DC_NOTCH_EN,1); /* default 1 */
-    lgw_reg_w(LGW_RSSI_BB_FILTER_ALPHA,6); /* default 7 */
-    lgw_reg_w(LGW_RSSI_DEC_FILTER_ALPHA,7); /* default 5 */
-    lgw_reg_w(LGW_RSSI_CHANN_FILTER_ALPHA,7); /* default 8 */
-    lgw_reg_w(LGW_RSSI_BB_DEFAULT_VALUE,23); /* default 32 */
-    lgw_reg_w(LGW_RSSI_CHANN_DEFAULT_VALUE,85); /* default 100 */
-    lgw_reg_w(LGW_RSSI_DEC_DEFAULT_VALUE,66); /* default 100 */
-    lgw_reg_w(LGW_DEC_GAIN_OFFSET,7); /* default 8 */
-    lgw_reg_w(LGW_CHAN_GAIN_OFFSET,6); /* default 7 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_RSSI_BB_FILTER_ALPHA, 6); /* default 7 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_RSSI_DEC_FILTER_ALPHA, 7); /* default 5 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_RSSI_CHANN_FILTER_ALPHA, 7); /* default 8 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_RSSI_BB_DEFAULT_VALUE, 23); /* default 32 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_RSSI_CHANN_DEFAULT_VALUE, 85); /* default 100 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_RSSI_DEC_DEFAULT_VALUE, 66); /* default 100 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_DEC_GAIN_OFFSET, 7); /* default 8 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_CHAN_GAIN_OFFSET, 6); /* default 7 */
 
     /* Correlator setup */
     // lgw_reg_w(LGW_CORR_DETECT_EN,126); /* default 126 */
@@ -269,13 +487,13 @@ void lgw_constant_adjust(void) {
     // lgw_reg_w(LGW_FRAME_SYNCH_GAIN,1); /* default 1 */
     // lgw_reg_w(LGW_SYNCH_DETECT_TH,1); /* default 1 */
     // lgw_reg_w(LGW_ZERO_PAD,0); /* default 0 */
-    lgw_reg_w(LGW_SNR_AVG_CST,3); /* default 2 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_SNR_AVG_CST, 3); /* default 2 */
     if (lorawan_public) { /* LoRa network */
-        lgw_reg_w(LGW_FRAME_SYNCH_PEAK1_POS,3); /* default 1 */
-        lgw_reg_w(LGW_FRAME_SYNCH_PEAK2_POS,4); /* default 2 */
+        REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FRAME_SYNCH_PEAK1_POS, 3); /* default 1 */
+        REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FRAME_SYNCH_PEAK2_POS, 4); /* default 2 */
     } else { /* private network */
-        lgw_reg_w(LGW_FRAME_SYNCH_PEAK1_POS,1); /* default 1 */
-        lgw_reg_w(LGW_FRAME_SYNCH_PEAK2_POS,2); /* default 2 */
+        REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FRAME_SYNCH_PEAK1_POS, 1); /* default 1 */
+        REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FRAME_SYNCH_PEAK2_POS, 2); /* default 2 */
     }
 
     // lgw_reg_w(LGW_PREAMBLE_FINE_TIMING_GAIN,1); /* default 1 */
@@ -293,11 +511,11 @@ void lgw_constant_adjust(void) {
     // lgw_reg_w(LGW_MBWSSF_SYNCH_DETECT_TH,1); /* default 1 */
     // lgw_reg_w(LGW_MBWSSF_ZERO_PAD,0); /* default 0 */
     if (lorawan_public) { /* LoRa network */
-        lgw_reg_w(LGW_MBWSSF_FRAME_SYNCH_PEAK1_POS,3); /* default 1 */
-        lgw_reg_w(LGW_MBWSSF_FRAME_SYNCH_PEAK2_POS,4); /* default 2 */
+        REG_VAL_ADD(regs, nb_regs, max_regs, LGW_MBWSSF_FRAME_SYNCH_PEAK1_POS, 3); /* default 1 */
+        REG_VAL_ADD(regs, nb_regs, max_regs, LGW_MBWSSF_FRAME_SYNCH_PEAK2_POS, 4); /* default 2 */
     } else {
-        lgw_reg_w(LGW_MBWSSF_FRAME_SYNCH_PEAK1_POS,1); /* default 1 */
-        lgw_reg_w(LGW_MBWSSF_FRAME_SYNCH_PEAK2_POS,2); /* default 2 */
+        REG_VAL_ADD(regs, nb_regs, max_regs, LGW_MBWSSF_FRAME_SYNCH_PEAK1_POS, 1); /* default 1 */
+        REG_VAL_ADD(regs, nb_regs, max_regs, LGW_MBWSSF_FRAME_SYNCH_PEAK2_POS, 2); /* default 2 */
     }
     // lgw_reg_w(LGW_MBWSSF_ONLY_CRC_EN,1); /* default 1 */
     // lgw_reg_w(LGW_MBWSSF_PAYLOAD_FINE_TIMING_GAIN,2); /* default 2 */
@@ -306,48 +524,48 @@ void lgw_constant_adjust(void) {
     // lgw_reg_w(LGW_MBWSSF_AGC_FREEZE_ON_DETECT,1); /* default 1 */
 
     /* Improvement of reference clock frequency error tolerance */
-    lgw_reg_w(LGW_ADJUST_MODEM_START_OFFSET_RDX4, 1); /* default 0 */
-    lgw_reg_w(LGW_ADJUST_MODEM_START_OFFSET_SF12_RDX4, 4094); /* default 4092 */
-    lgw_reg_w(LGW_CORR_MAC_GAIN, 7); /* default 5 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_ADJUST_MODEM_START_OFFSET_RDX4, 1); /* default 0 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_ADJUST_MODEM_START_OFFSET_SF12_RDX4, 4094); /* default 4092 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_CORR_MAC_GAIN, 7); /* default 5 */
 
     /* FSK datapath setup */
-    lgw_reg_w(LGW_FSK_RX_INVERT,1); /* default 0 */
-    lgw_reg_w(LGW_FSK_MODEM_INVERT_IQ,1); /* default 0 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FSK_RX_INVERT, 1); /* default 0 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FSK_MODEM_INVERT_IQ, 1); /* default 0 */
 
     /* FSK demodulator setup */
-    lgw_reg_w(LGW_FSK_RSSI_LENGTH,4); /* default 0 */
-    lgw_reg_w(LGW_FSK_PKT_MODE,1); /* variable length, default 0 */
-    lgw_reg_w(LGW_FSK_CRC_EN,1); /* default 0 */
-    lgw_reg_w(LGW_FSK_DCFREE_ENC,2); /* default 0 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FSK_RSSI_LENGTH, 4); /* default 0 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FSK_PKT_MODE, 1); /* variable length, default 0 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FSK_CRC_EN, 1); /* default 0 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FSK_DCFREE_ENC, 2); /* default 0 */
     // lgw_reg_w(LGW_FSK_CRC_IBM,0); /* default 0 */
-    lgw_reg_w(LGW_FSK_ERROR_OSR_TOL,10); /* default 0 */
-    lgw_reg_w(LGW_FSK_PKT_LENGTH,255); /* max packet length in variable length mode */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FSK_ERROR_OSR_TOL, 10); /* default 0 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FSK_PKT_LENGTH, 255); /* max packet length in variable length mode */
     // lgw_reg_w(LGW_FSK_NODE_ADRS,0); /* default 0 */
     // lgw_reg_w(LGW_FSK_BROADCAST,0); /* default 0 */
     // lgw_reg_w(LGW_FSK_AUTO_AFC_ON,0); /* default 0 */
-    lgw_reg_w(LGW_FSK_PATTERN_TIMEOUT_CFG,128); /* sync timeout (allow 8 bytes preamble + 8 bytes sync word, default 0 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FSK_PATTERN_TIMEOUT_CFG, 128); /* sync timeout (allow 8 bytes preamble + 8 bytes sync word, default 0 */
 
     /* TX general parameters */
-    lgw_reg_w(LGW_TX_START_DELAY, TX_START_DELAY_DEFAULT); /* default 0 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_TX_START_DELAY, TX_START_DELAY_DEFAULT); /* default 0 */
 
     /* TX LoRa */
     // lgw_reg_w(LGW_TX_MODE,0); /* default 0 */
-    lgw_reg_w(LGW_TX_SWAP_IQ,1); /* "normal" polarity; default 0 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_TX_SWAP_IQ, 1); /* "normal" polarity; default 0 */
     if (lorawan_public) { /* LoRa network */
-        lgw_reg_w(LGW_TX_FRAME_SYNCH_PEAK1_POS,3); /* default 1 */
-        lgw_reg_w(LGW_TX_FRAME_SYNCH_PEAK2_POS,4); /* default 2 */
+        REG_VAL_ADD(regs, nb_regs, max_regs, LGW_TX_FRAME_SYNCH_PEAK1_POS, 3); /* default 1 */
+        REG_VAL_ADD(regs, nb_regs, max_regs, LGW_TX_FRAME_SYNCH_PEAK2_POS, 4); /* default 2 */
     } else { /* Private network */
-        lgw_reg_w(LGW_TX_FRAME_SYNCH_PEAK1_POS,1); /* default 1 */
-        lgw_reg_w(LGW_TX_FRAME_SYNCH_PEAK2_POS,2); /* default 2 */
+        REG_VAL_ADD(regs, nb_regs, max_regs, LGW_TX_FRAME_SYNCH_PEAK1_POS, 1); /* default 1 */
+        REG_VAL_ADD(regs, nb_regs, max_regs, LGW_TX_FRAME_SYNCH_PEAK2_POS, 2); /* default 2 */
     }
 
     /* TX FSK */
     // lgw_reg_w(LGW_FSK_TX_GAUSSIAN_EN,1); /* default 1 */
-    lgw_reg_w(LGW_FSK_TX_GAUSSIAN_SELECT_BT,2); /* Gaussian filter always on TX, default 0 */
+    REG_VAL_ADD(regs, nb_regs, max_regs, LGW_FSK_TX_GAUSSIAN_SELECT_BT, 2); /* Gaussian filter always on TX, default 0 */
     // lgw_reg_w(LGW_FSK_TX_PATTERN_EN,1); /* default 1 */
     // lgw_reg_w(LGW_FSK_TX_PREAMBLE_SEQ,0); /* default 0 */
 
-    return;
+    return nb_regs;
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
@@ -409,10 +627,778 @@ uint16_t lgw_get_tx_start_delay(bool tx_notch_enable, uint8_t bw) {
     return (uint16_t)tx_start_delay; /* keep truncating instead of rounding: better behaviour measured */
 }
 
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static bool agc_status_cond(void *arg) {
+    struct agc_status_cond_s *c = arg;
+
+    lgw_reg_r(LGW_MCU_AGC_STATUS, &(c->read_val));
+    return ((c->read_val & c->mask) == c->expected);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* wait until (AGC status & mask) == expected, the last status read is returned in read_val */
+static int agc_status_poll(uint8_t mask, uint8_t expected, unsigned long timeout_ms, unsigned long period_us, int32_t *read_val) {
+    struct agc_status_cond_s c = {mask, expected, 0};
+    bool met;
+
+    met = wait_cond(agc_status_cond, &c, timeout_ms, period_us);
+    *read_val = c.read_val;
+    return (met == true) ? LGW_HAL_SUCCESS : LGW_HAL_ERROR;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* run the calibration firmware, get its status and the TX DC offsets */
+static int lgw_calibrate(uint8_t cal_cmd, uint8_t *status) {
+    int i;
+    int err;
+    int32_t read_val;
+    uint8_t fw_version;
+    uint8_t cal_status;
+
+    /* Load the calibration firmware  */
+    if (load_firmware(MCU_AGC, cal_firmware, MCU_AGC_FW_BYTE) != 0) {
+        return LGW_HAL_ERROR;
+    }
+    lgw_reg_w(LGW_FORCE_HOST_RADIO_CTRL, 0); /* gives to AGC MCU the control of the radios */
+    lgw_reg_w(LGW_RADIO_SELECT, cal_cmd); /* send calibration configuration word */
+    lgw_reg_w(LGW_MCU_RST_1, 0);
+
+    /* Check firmware version */
+    lgw_reg_w(LGW_DBG_AGC_MCU_RAM_ADDR, FW_VERSION_ADDR);
+    lgw_reg_r(LGW_DBG_AGC_MCU_RAM_DATA, &read_val);
+    fw_version = (uint8_t)read_val;
+    if (fw_version != FW_VERSION_CAL) {
+        printf("ERROR: Version of calibration firmware not expected, actual:%d expected:%d\n", fw_version, FW_VERSION_CAL);
+        return LGW_HAL_ERROR;
+    }
+
+    lgw_reg_w(LGW_PAGE_REG, 3); /* Calibration will start on this condition as soon as MCU can talk to concentrator registers */
+    lgw_reg_w(LGW_EMERGENCY_FORCE_HOST_CTRL, 0); /* Give control of concentrator registers to MCU */
+
+    /* Wait for calibration to end (bit 7 of the status), the status register is page-independent */
+    DEBUG_PRINTF("Note: calibration started (timeout: %u ms)\n", CAL_TIMEOUT_MS);
+    err = agc_status_poll(0x80, 0x80, CAL_TIMEOUT_MS, CAL_POLL_US, &read_val);
+    lgw_reg_w(LGW_EMERGENCY_FORCE_HOST_CTRL, 1); /* Take back control */
+    lgw_reg_shadow_invalidate(); /* registers written by the calibration firmware */
+    if (err != LGW_HAL_SUCCESS) {
+        DEBUG_PRINTF("ERROR: CALIBRATION NOT FINISHED AFTER %u ms (STATUS = %u)\n", CAL_TIMEOUT_MS, (uint8_t)read_val);
+        return LGW_HAL_ERROR;
+    }
+
+    /* Get calibration status */
+    lgw_reg_r(LGW_MCU_AGC_STATUS, &read_val);
+    cal_status = (uint8_t)read_val;
+    /*
+        bit 7: calibration finished
+        bit 0: could access SX1301 registers
+        bit 1: could access radio A registers
+        bit 2: could access radio B registers
+        bit 3: radio A RX image rejection successful
+        bit 4: radio B RX image rejection successful
+        bit 5: radio A TX DC Offset correction successful
+        bit 6: radio B TX DC Offset correction successful
+    */
+    if ((cal_status & 0x81) != 0x81) {
+        DEBUG_PRINTF("ERROR: CALIBRATION FAILURE (STATUS = %u)\n", cal_status);
+        return LGW_HAL_ERROR;
+    } else {
+        DEBUG_PRINTF("Note: calibration finished (status = %u)\n", cal_status);
+    }
+    if (rf_enable[0] && ((cal_status & 0x02) == 0)) {
+        DEBUG_MSG("WARNING: calibration could not access radio A\n");
+    }
+    if (rf_enable[1] && ((cal_status & 0x04) == 0)) {
+        DEBUG_MSG("WARNING: calibration could not access radio B\n");
+    }
+    if (rf_enable[0] && ((cal_status & 0x08) == 0)) {
+        DEBUG_MSG("WARNING: problem in calibration of radio A for image rejection\n");
+    }
+    if (rf_enable[1] && ((cal_status & 0x10) == 0)) {
+        DEBUG_MSG("WARNING: problem in calibration of radio B for image rejection\n");
+    }
+    if (rf_enable[0] && rf_tx_enable[0] && ((cal_status & 0x20) == 0)) {
+        DEBUG_MSG("WARNING: problem in calibration of radio A for TX DC offset\n");
+    }
+    if (rf_enable[1] && rf_tx_enable[1] && ((cal_status & 0x40) == 0)) {
+        DEBUG_MSG("WARNING: problem in calibration of radio B for TX DC offset\n");
+    }
+
+    /* Get TX DC offset values */
+    for(i=0; i<=7; ++i) {
+        lgw_reg_w(LGW_DBG_AGC_MCU_RAM_ADDR, 0xA0+i);
+        lgw_reg_r(LGW_DBG_AGC_MCU_RAM_DATA, &read_val);
+        cal_offset_a_i[i] = (int8_t)read_val;
+        lgw_reg_w(LGW_DBG_AGC_MCU_RAM_ADDR, 0xA8+i);
+        lgw_reg_r(LGW_DBG_AGC_MCU_RAM_DATA, &read_val);
+        cal_offset_a_q[i] = (int8_t)read_val;
+        lgw_reg_w(LGW_DBG_AGC_MCU_RAM_ADDR, 0xB0+i);
+        lgw_reg_r(LGW_DBG_AGC_MCU_RAM_DATA, &read_val);
+        cal_offset_b_i[i] = (int8_t)read_val;
+        lgw_reg_w(LGW_DBG_AGC_MCU_RAM_ADDR, 0xB8+i);
+        lgw_reg_r(LGW_DBG_AGC_MCU_RAM_DATA, &read_val);
+        cal_offset_b_q[i] = (int8_t)read_val;
+    }
+
+    *status = cal_status;
+    return LGW_HAL_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void calcache_key(uint8_t cal_cmd, struct calcache_key_s *key) {
+    int i;
+    int32_t read_val = 0;
+
+    memset(key, 0, sizeof *key); /* padding bytes included */
+    lgw_reg_r(LGW_VERSION, &read_val);
+    key->board_id = calcache_conf.board_id;
+    key->chip_version = (uint8_t)read_val;
+    key->clksrc = rf_clkout;
+    key->cal_cmd = cal_cmd;
+    for (i = 0; i < LGW_RF_CHAIN_NB; ++i) {
+        key->radio_type[i] = (uint8_t)rf_radio_type[i];
+        key->rf_rx_freq[i] = rf_rx_freq[i];
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* FNV-1a hash of the record, checksum excluded */
+static uint32_t calcache_checksum(const struct calcache_rec_s *rec) {
+    const uint8_t *p = (const uint8_t *)rec;
+    uint32_t h = 2166136261UL;
+    size_t i;
+
+    for (i = 0; i < offsetof(struct calcache_rec_s, checksum); ++i) {
+        h = (h ^ p[i]) * 16777619UL;
+    }
+    return h;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* write in a temporary file then rename it, a power cut never leaves a truncated cache */
+static int calcache_write(const struct calcache_rec_s *rec) {
+    char tmp_path[LGW_CALCACHE_PATH_SIZE + 4];
+    FILE *f;
+    size_t n;
+
+    snprintf(tmp_path, sizeof tmp_path, "%s.tmp", calcache_conf.path);
+    f = fopen(tmp_path, "wb");
+    if (f == NULL) {
+        DEBUG_PRINTF("WARNING: failed to create calibration cache %s\n", tmp_path);
+        return LGW_HAL_ERROR;
+    }
+    n = fwrite(rec, sizeof *rec, 1, f);
+    if ((fclose(f) != 0) || (n != 1) || (rename(tmp_path, calcache_conf.path) != 0)) {
+        DEBUG_PRINTF("WARNING: failed to write calibration cache %s\n", calcache_conf.path);
+        remove(tmp_path);
+        return LGW_HAL_ERROR;
+    }
+    return LGW_HAL_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* restore the results of a previous calibration, if cached and still valid */
+static bool calcache_load(uint8_t cal_cmd) {
+    struct calcache_key_s key;
+    struct calcache_rec_s rec;
+    struct lgw_reg_val_s iq_regs[CALCACHE_IQ_NB];
+    int64_t now;
+    FILE *f;
+    size_t n;
+    int i;
+
+    if (calcache_conf.enable == false) {
+        return false;
+    }
+
+    f = fopen(calcache_conf.path, "rb");
+    if (f == NULL) {
+        DEBUG_PRINTF("Note: no calibration cache %s\n", calcache_conf.path);
+        return false;
+    }
+    n = fread(&rec, sizeof rec, 1, f);
+    fclose(f);
+
+    /* check the cache validity */
+    calcache_key(cal_cmd, &key);
+    now = (int64_t)time(NULL);
+    if ((n != 1) || (rec.magic != CALCACHE_MAGIC) || (rec.version != CALCACHE_VERSION) || (rec.checksum != calcache_checksum(&rec))) {
+        DEBUG_MSG("WARNING: calibration cache corrupted, ignored\n");
+        return false;
+    }
+    if (memcmp(&rec.key, &key, sizeof key) != 0) {
+        DEBUG_MSG("Note: calibration cache does not match the configuration\n");
+        return false;
+    }
+    if ((now < rec.time) || ((calcache_conf.max_age_s != 0) && ((now - rec.time) > (int64_t)calcache_conf.max_age_s))) {
+        DEBUG_PRINTF("Note: calibration cache expired (age %lld s)\n", (long long)(now - rec.time));
+        return false;
+    }
+    if ((calcache_conf.max_reuse != 0) && (rec.nb_reuse >= calcache_conf.max_reuse)) {
+        DEBUG_PRINTF("Note: calibration cache already used %u times\n", rec.nb_reuse);
+        return false;
+    }
+
+    /* count the warm restarts, only when limited (the file is not rewritten on each start otherwise) */
+    if (calcache_conf.max_reuse != 0) {
+        rec.nb_reuse += 1;
+        rec.checksum = calcache_checksum(&rec);
+        if (calcache_write(&rec) != LGW_HAL_SUCCESS) {
+            DEBUG_MSG("WARNING: calibration cache reuse count not updated, cache ignored\n");
+            return false;
+        }
+    }
+
+    /* restore TX DC offsets and RX IQ mismatch compensation */
+    memcpy(cal_offset_a_i, rec.offset_a_i, sizeof cal_offset_a_i);
+    memcpy(cal_offset_a_q, rec.offset_a_q, sizeof cal_offset_a_q);
+    memcpy(cal_offset_b_i, rec.offset_b_i, sizeof cal_offset_b_i);
+    memcpy(cal_offset_b_q, rec.offset_b_q, sizeof cal_offset_b_q);
+    for (i = 0; i < CALCACHE_IQ_NB; ++i) {
+        iq_regs[i].register_id = LGW_IQ_MISMATCH_A_AMP_COEFF + i;
+        iq_regs[i].value = rec.iq_coeff[i];
+    }
+    if (lgw_reg_w_multi(iq_regs, CALCACHE_IQ_NB) != LGW_REG_SUCCESS) {
+        return false;
+    }
+    DEBUG_PRINTF("Note: calibration status %u restored from cache (age %lld s)\n", rec.cal_status, (long long)(now - rec.time));
+
+    return true;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* store the results of the calibration that just completed */
+static void calcache_save(uint8_t cal_cmd, uint8_t cal_status) {
+    struct calcache_rec_s rec;
+    struct lgw_reg_val_s iq_regs[CALCACHE_IQ_NB];
+    int i;
+
+    if (calcache_conf.enable == false) {
+        return;
+    }
+
+    for (i = 0; i < CALCACHE_IQ_NB; ++i) {
+        iq_regs[i].register_id = LGW_IQ_MISMATCH_A_AMP_COEFF + i;
+    }
+    if (lgw_reg_r_multi(iq_regs, CALCACHE_IQ_NB) != LGW_REG_SUCCESS) {
+        return;
+    }
+
+    memset(&rec, 0, sizeof rec); /* padding bytes included */
+    rec.magic = CALCACHE_MAGIC;
+    rec.version = CALCACHE_VERSION;
+    rec.nb_reuse = 0;
+    rec.time = (int64_t)time(NULL);
+    calcache_key(cal_cmd, &rec.key);
+    rec.cal_status = cal_status;
+    memcpy(rec.offset_a_i, cal_offset_a_i, sizeof rec.offset_a_i);
+    memcpy(rec.offset_a_q, cal_offset_a_q, sizeof rec.offset_a_q);
+    memcpy(rec.offset_b_i, cal_offset_b_i, sizeof rec.offset_b_i);
+    memcpy(rec.offset_b_q, cal_offset_b_q, sizeof rec.offset_b_q);
+    for (i = 0; i < CALCACHE_IQ_NB; ++i) {
+        rec.iq_coeff[i] = iq_regs[i].value;
+    }
+    rec.checksum = calcache_checksum(&rec);
+    if (calcache_write(&rec) != LGW_HAL_SUCCESS) {
+        DEBUG_MSG("WARNING: calibration results not cached, next start calibrates again\n");
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void if_conf_save(struct if_conf_s *c) {
+    memcpy(c->if_enable, if_enable, sizeof if_enable);
+    memcpy(c->if_rf_chain, if_rf_chain, sizeof if_rf_chain);
+    memcpy(c->if_freq, if_freq, sizeof if_freq);
+    memcpy(c->lora_multi_sfmask, lora_multi_sfmask, sizeof lora_multi_sfmask);
+    c->lora_rx_bw = lora_rx_bw;
+    c->lora_rx_sf = lora_rx_sf;
+    c->lora_rx_ppm_offset = lora_rx_ppm_offset;
+    c->fsk_rx_bw = fsk_rx_bw;
+    c->fsk_rx_dr = fsk_rx_dr;
+    c->fsk_sync_word_size = fsk_sync_word_size;
+    c->fsk_sync_word = fsk_sync_word;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void if_conf_restore(const struct if_conf_s *c) {
+    memcpy(if_enable, c->if_enable, sizeof if_enable);
+    memcpy(if_rf_chain, c->if_rf_chain, sizeof if_rf_chain);
+    memcpy(if_freq, c->if_freq, sizeof if_freq);
+    memcpy(lora_multi_sfmask, c->lora_multi_sfmask, sizeof lora_multi_sfmask);
+    lora_rx_bw = c->lora_rx_bw;
+    lora_rx_sf = c->lora_rx_sf;
+    lora_rx_ppm_offset = c->lora_rx_ppm_offset;
+    fsk_rx_bw = c->fsk_rx_bw;
+    fsk_rx_dr = c->fsk_rx_dr;
+    fsk_sync_word_size = c->fsk_sync_word_size;
+    fsk_sync_word = c->fsk_sync_word;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* register values of the IF chains configuration (IF0-9), returns the number of registers or -1 */
+static int if_regs_get(struct lgw_reg_val_s *regs) {
+    int i, n = 0;
+    int32_t sf;
+    uint64_t fsk_sync_word_reg;
+
+    /* IF frequencies (default -384, -128, 128, 384) and correlators (default 0) of the LoRa 'multi' channels */
+    for (i = 0; i < LGW_MULTI_NB; ++i) {
+        regs[n].register_id = LGW_IF_FREQ_0 + i;
+        regs[n++].value = IF_HZ_TO_REG(if_freq[i]);
+    }
+    for (i = 0; i < LGW_MULTI_NB; ++i) {
+        regs[n].register_id = LGW_CORR0_DETECT_EN + i;
+        regs[n++].value = (if_enable[i] == true) ? lora_multi_sfmask[i] : 0;
+    }
+
+    /* LoRa 'stand-alone' modem (IF8) */
+    regs[n].register_id = LGW_IF_FREQ_8; /* MBWSSF modem (default 0) */
+    regs[n++].value = IF_HZ_TO_REG(if_freq[8]);
+    if (if_enable[8] == true) {
+        regs[n].register_id = LGW_MBWSSF_RADIO_SELECT;
+        regs[n++].value = if_rf_chain[8];
+        regs[n].register_id = LGW_MBWSSF_MODEM_BW;
+        switch(lora_rx_bw) {
+            case BW_125KHZ: regs[n++].value = 0; break;
+            case BW_250KHZ: regs[n++].value = 1; break;
+            case BW_500KHZ: regs[n++].value = 2; break;
+            default:
+                DEBUG_PRINTF("ERROR: UNEXPECTED VALUE %d IN SWITCH STATEMENT\n", lora_rx_bw);
+                return -1;
+        }
+        sf = lgw_sf_getval(lora_rx_sf);
+        if (sf == -1) {
+            DEBUG_PRINTF("ERROR: UNEXPECTED VALUE %d IN SWITCH STATEMENT\n", lora_rx_sf);
+            return -1;
+        }
+        regs[n].register_id = LGW_MBWSSF_RATE_SF;
+        regs[n++].value = sf;
+        regs[n].register_id = LGW_MBWSSF_PPM_OFFSET; /* default 0 */
+        regs[n++].value = lora_rx_ppm_offset;
+        regs[n].register_id = LGW_MBWSSF_MODEM_ENABLE; /* default 0 */
+        regs[n++].value = 1;
+    } else {
+        regs[n].register_id = LGW_MBWSSF_MODEM_ENABLE;
+        regs[n++].value = 0;
+    }
+
+    /* FSK modem (IF9) */
+    regs[n].register_id = LGW_IF_FREQ_9; /* FSK modem, default 0 */
+    regs[n++].value = IF_HZ_TO_REG(if_freq[9]);
+    regs[n].register_id = LGW_FSK_PSIZE;
+    regs[n++].value = fsk_sync_word_size-1;
+    regs[n].register_id = LGW_FSK_TX_PSIZE;
+    regs[n++].value = fsk_sync_word_size-1;
+    fsk_sync_word_reg = fsk_sync_word << (8 * (8 - fsk_sync_word_size));
+    regs[n].register_id = LGW_FSK_REF_PATTERN_LSB;
+    regs[n++].value = (uint32_t)(0xFFFFFFFF & fsk_sync_word_reg);
+    regs[n].register_id = LGW_FSK_REF_PATTERN_MSB;
+    regs[n++].value = (uint32_t)(0xFFFFFFFF & (fsk_sync_word_reg >> 32));
+    if (if_enable[9] == true) {
+        regs[n].register_id = LGW_FSK_RADIO_SELECT;
+        regs[n++].value = if_rf_chain[9];
+        regs[n].register_id = LGW_FSK_BR_RATIO; /* setting the dividing ratio for datarate */
+        regs[n++].value = LGW_XTAL_FREQU/fsk_rx_dr;
+        regs[n].register_id = LGW_FSK_CH_BW_EXPO;
+        regs[n++].value = fsk_rx_bw;
+        regs[n].register_id = LGW_FSK_MODEM_ENABLE; /* default 0 */
+        regs[n++].value = 1;
+    } else {
+        regs[n].register_id = LGW_FSK_MODEM_ENABLE;
+        regs[n++].value = 0;
+    }
+
+    return n;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* FNV-1a hash of the registers and values, identifies the configuration of a start-up script */
+static uint32_t modem_regs_key(const struct lgw_reg_val_s *regs, int nb_regs) {
+    uint32_t h = 2166136261UL;
+    uint8_t b[6];
+    int i, j;
+
+    for (i = 0; i < nb_regs; ++i) {
+        b[0] = (uint8_t)regs[i].register_id;
+        b[1] = (uint8_t)(regs[i].register_id >> 8);
+        for (j = 0; j < 4; ++j) {
+            b[2 + j] = (uint8_t)((uint32_t)regs[i].value >> (8 * j));
+        }
+        for (j = 0; j < 6; ++j) {
+            h = (h ^ b[j]) * 16777619UL;
+        }
+    }
+    return h;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* write the modems configuration, replaying the start-up script if it was compiled for the same registers */
+static int modem_regs_write(const struct lgw_reg_val_s *regs, int nb_regs) {
+    uint32_t key;
+
+    if (start_script_en == false) {
+        /* sorted by page and address, and written in a few bursts */
+        return (lgw_reg_w_multi(regs, nb_regs) == LGW_REG_SUCCESS) ? LGW_HAL_SUCCESS : LGW_HAL_ERROR;
+    }
+
+    key = modem_regs_key(regs, nb_regs);
+    if ((start_script_valid == false) || (start_script.key != key)) {
+        /* compiled at the same point of the start sequence as the replays (after soft reset and calibration) */
+        start_script_valid = false;
+        if (lgw_reg_script_compile(regs, nb_regs, &start_script) != LGW_REG_SUCCESS) {
+            DEBUG_MSG("WARNING: FAILED TO COMPILE START-UP SCRIPT, REGISTERS WRITTEN ONE BY ONE\n");
+            return (lgw_reg_w_multi(regs, nb_regs) == LGW_REG_SUCCESS) ? LGW_HAL_SUCCESS : LGW_HAL_ERROR;
+        }
+        start_script.key = key;
+        start_script_valid = true;
+        DEBUG_PRINTF("Note: start-up script compiled, %u bursts, %u bytes\n", start_script.nb_burst, start_script.size);
+    }
+    return (lgw_reg_script_run(&start_script) == LGW_REG_SUCCESS) ? LGW_HAL_SUCCESS : LGW_HAL_ERROR;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static uint64_t start_prof_now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ULL + (uint64_t)t.tv_nsec;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* SPI traffic since the last reset of the SPI statistics, all types of access */
+static void start_prof_spi(uint32_t *nb_call, uint64_t *nb_byte) {
+    struct lgw_spi_stat_s st;
+    int i;
+
+    *nb_call = 0;
+    *nb_byte = 0;
+    for (i = 0; i < LGW_SPI_STAT_NB; ++i) {
+        lgw_spi_stat_get(i, &st);
+        *nb_call += st.nb_call;
+        *nb_byte += st.nb_byte;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* mark lgw_start as running in the calling thread, false if it already runs */
+static bool start_acquire(void) {
+    bool ok;
+
+    pthread_mutex_lock(&start_mutex);
+    ok = (start_busy == false);
+    if (ok == true) {
+        start_owner = pthread_self();
+        __atomic_store_n(&start_busy, true, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&start_mutex);
+    return ok;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void start_release(void) {
+    pthread_mutex_lock(&start_mutex);
+    __atomic_store_n(&start_busy, false, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&start_mutex);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* true if lgw_start runs in another thread than the caller */
+static bool start_in_progress(void) {
+    bool busy;
+
+    if (__atomic_load_n(&start_busy, __ATOMIC_ACQUIRE) == false) {
+        return false; /* no lock on the usual path */
+    }
+    pthread_mutex_lock(&start_mutex);
+    busy = (start_busy == true) && (pthread_equal(pthread_self(), start_owner) == 0);
+    pthread_mutex_unlock(&start_mutex);
+    return busy;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* clear the profile and enter the first phase of lgw_start */
+static void start_prof_begin(void) {
+    int i;
+
+    memset(&start_prof, 0, sizeof start_prof);
+    memset(start_prof_entered, 0, sizeof start_prof_entered);
+    for (i = 0; i < LGW_START_PHASE_NB; ++i) {
+        start_prof.phase[i].name = start_phase_name[i];
+    }
+    start_prof.status = LGW_HAL_ERROR; /* until lgw_start succeeds */
+    start_prof.timestamp_ns = start_prof_now();
+    start_prof_cur = LGW_START_PHASE_NB;
+    start_prof_valid = true;
+    start_prof_phase(LGW_START_PHASE_CONNECT);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* account the time and SPI traffic since the previous call to the current phase, then enter a new one */
+static void start_prof_phase(uint8_t phase) {
+    struct lgw_start_phase_s *p;
+    uint64_t now = start_prof_now();
+    uint32_t nb_call;
+    uint64_t nb_byte;
+
+    start_prof_spi(&nb_call, &nb_byte);
+    if (start_prof_cur < LGW_START_PHASE_NB) {
+        p = &start_prof.phase[start_prof_cur];
+        p->duration_ns += now - start_prof_enter_ns;
+        p->nb_spi_call += nb_call - start_prof_enter_call;
+        p->nb_spi_byte += nb_byte - start_prof_enter_byte;
+    }
+    if ((phase < LGW_START_PHASE_NB) && (start_prof_entered[phase] == false)) {
+        start_prof.phase[phase].start_ns = now - start_prof.timestamp_ns;
+        start_prof_entered[phase] = true;
+    }
+    start_prof_cur = phase;
+    start_prof_enter_ns = now;
+    start_prof_enter_call = nb_call;
+    start_prof_enter_byte = nb_byte;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* close the profile when leaving lgw_start */
+static void start_prof_end(void) {
+    start_prof.last_phase = start_prof_cur;
+    start_prof_phase(LGW_START_PHASE_NB);
+    start_prof.total_ns = start_prof_enter_ns - start_prof.timestamp_ns;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* filters using the FIFO status only, false if the packet must be dropped */
+static bool rx_filter_status(int stat_fifo) {
+    if (rx_filter.enable == false) {
+        return true;
+    }
+    if ((rx_filter.drop_crc_bad == true) && ((stat_fifo & 0x07) == 7)) {
+        return false;
+    }
+    if ((rx_filter.drop_no_crc == true) && ((stat_fifo & 0x07) == 1)) {
+        return false;
+    }
+    return true;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* filters using the metadata, false if the packet must be dropped */
+static bool rx_filter_accept(const struct lgw_pkt_rx_s *p) {
+    if (rx_filter.enable == false) {
+        return true;
+    }
+    if ((rx_filter.if_chain_mask != 0) && ((rx_filter.if_chain_mask & (1 << p->if_chain)) == 0)) {
+        return false;
+    }
+    if ((rx_filter.rssi_check == true) && (p->rssi < rx_filter.rssi_min)) {
+        return false;
+    }
+    if ((rx_filter.snr_check == true) && (p->modulation == MOD_LORA) && (p->snr < rx_filter.snr_min)) {
+        return false;
+    }
+    if ((rx_filter.accept != NULL) && (rx_filter.accept(p, rx_filter.accept_arg) == false)) {
+        return false;
+    }
+    return true;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void rx_burst_set(struct lgw_reg_burst_s *b, uint16_t register_id, bool read, uint8_t *data, uint16_t size) {
+    b->register_id = register_id;
+    b->read = read;
+    b->data = data;
+    b->size = size;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* time on air of a received packet (default preamble, with CRC), in microseconds */
+static uint32_t rxpoll_toa_us(uint8_t modulation, uint8_t bandwidth, uint32_t datarate, uint8_t coderate, uint16_t size) {
+    struct lgw_pkt_tx_s pkt;
+    uint32_t toa_ms;
+
+    memset(&pkt, 0, sizeof pkt);
+    pkt.modulation = modulation;
+    pkt.bandwidth = bandwidth;
+    pkt.datarate = datarate;
+    pkt.coderate = coderate;
+    pkt.size = size;
+    pkt.preamble = (modulation == MOD_LORA) ? STD_LORA_PREAMBLE : STD_FSK_PREAMBLE;
+    toa_ms = lgw_time_on_air(&pkt);
+
+    return (toa_ms > 0) ? (toa_ms * 1000) : 1000; /* millisecond resolution */
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* processing delay of a LoRa packet, between the end of the packet and the 'RX finished' timestamp */
+static uint32_t lora_tstamp_corr_calc(int ifmod, uint32_t sf, uint32_t cr, uint32_t crc_en, unsigned sz) {
+    uint32_t delay_x, delay_y, delay_z; /* temporary variable for timestamp offset calculation */
+    uint32_t bw_pow, ppm;
+    uint8_t bw;
+    uint32_t dr;
+
+    /* determine if 'PPM mode' is on */
+    bw = (ifmod == IF_LORA_MULTI) ? BW_125KHZ : lora_rx_bw;
+    dr = ((sf >= 7) && (sf <= 12)) ? (DR_LORA_SF7 << (sf - 7)) : DR_UNDEFINED;
+    if (SET_PPM_ON(bw, dr)) {
+        ppm = 1;
+    } else {
+        ppm = 0;
+    }
+
+    /* base delay */
+    if (ifmod == IF_LORA_STD) { /* if packet was received on the stand-alone LoRa modem */
+        switch (lora_rx_bw) {
+            case BW_125KHZ:
+                delay_x = 64;
+                bw_pow = 1;
+                break;
+            case BW_250KHZ:
+                delay_x = 32;
+                bw_pow = 2;
+                break;
+            case BW_500KHZ:
+                delay_x = 16;
+                bw_pow = 4;
+                break;
+            default:
+                delay_x = 0;
+                bw_pow = 0;
+        }
+    } else { /* packet was received on one of the sensor channels = 125kHz */
+        delay_x = 114;
+        bw_pow = 1;
+    }
+
+    /* variable delay */
+    if ((sf >= 6) && (sf <= 12) && (bw_pow > 0)) {
+        if ((2*(sz + 2*crc_en) - (sf-7)) <= 0) { /* payload fits entirely in first 8 symbols */
+            delay_y = ( ((1<<(sf-1)) * (sf+1)) + (3 * (1<<(sf-4))) ) / bw_pow;
+            delay_z = 32 * (2*(sz+2*crc_en) + 5) / bw_pow;
+        } else {
+            delay_y = ( ((1<<(sf-1)) * (sf+1)) + ((4 - ppm) * (1<<(sf-4))) ) / bw_pow;
+            delay_z = (16 + 4*cr) * (((2*(sz+2*crc_en)-sf+6) % (sf - 2*ppm)) + 1) / bw_pow;
+        }
+        return delay_x + delay_y + delay_z;
+    } else {
+        return 0;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* precompute the timestamp corrections of all the packets the modems can receive */
+static void tstamp_corr_build(void) {
+    int m;
+    uint32_t sf, cr, crc_en;
+    unsigned sz;
+
+    for (m = 0; m < 2; ++m) {
+        for (sf = 0; sf < TSTAMP_SF_NB; ++sf) {
+            for (cr = 0; cr < TSTAMP_CR_NB; ++cr) {
+                for (crc_en = 0; crc_en < 2; ++crc_en) {
+                    for (sz = 0; sz < 256; ++sz) {
+                        lora_tstamp_corr[m][sf][cr][crc_en][sz] = (uint16_t)lora_tstamp_corr_calc((m == 1) ? IF_LORA_STD : IF_LORA_MULTI, sf + TSTAMP_SF_MIN, cr, crc_en, sz);
+                    }
+                }
+            }
+        }
+    }
+
+    fsk_tstamp_corr = (fsk_rx_dr > 0) ? (((uint32_t)680000 / fsk_rx_dr) - 20) : 0;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int hal_start_job(void *arg) {
+    (void)arg;
+    return lgw_start();
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int hal_stop_job(void *arg) {
+    (void)arg;
+    return lgw_stop();
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int hal_receive_job(void *arg) {
+    struct hal_receive_args_s *a = arg;
+    return lgw_receive(a->max_pkt, a->pkt_data);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int hal_send_job(void *arg) {
+    struct hal_send_args_s *a = arg;
+    return lgw_send(*(a->pkt_data));
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int hal_status_job(void *arg) {
+    struct hal_status_args_s *a = arg;
+    return lgw_status(a->select, a->code);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int hal_abort_tx_job(void *arg) {
+    (void)arg;
+    return lgw_abort_tx();
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int hal_get_trigcnt_job(void *arg) {
+    struct hal_get_trigcnt_args_s *a = arg;
+    return lgw_get_trigcnt(a->trig_cnt_us);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int hal_reconfigure_job(void *arg) {
+    struct hal_reconfigure_args_s *a = arg;
+    return lgw_reconfigure(a->if_conf, a->rssi_offset);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int hal_rxfilter_setconf_job(void *arg) {
+    struct hal_rxfilter_setconf_args_s *a = arg;
+    return lgw_rxfilter_setconf(*(a->conf));
+}
+
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC FUNCTIONS DEFINITION ------------------------------------------ */
 
 int lgw_board_setconf(struct lgw_conf_board_s conf) {
+    CHECK_START_BUSY();
 
     /* check if the concentrator is running */
     if (lgw_is_started == true) {
@@ -431,9 +1417,70 @@ int lgw_board_setconf(struct lgw_conf_board_s conf) {
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+int lgw_fw_setconf(struct lgw_conf_fw_s conf) {
+    CHECK_START_BUSY();
+
+    /* check if the concentrator is running */
+    if (lgw_is_started == true) {
+        DEBUG_MSG("ERROR: CONCENTRATOR IS RUNNING, STOP IT BEFORE TOUCHING CONFIGURATION\n");
+        return LGW_HAL_ERROR;
+    }
+
+    /* check input parameters */
+    if ((conf.check != LGW_FW_CHECK_FULL) && (conf.check != LGW_FW_CHECK_SAMPLE)) {
+        DEBUG_MSG("ERROR: INVALID FIRMWARE CHECK MODE\n");
+        return LGW_HAL_ERROR;
+    }
+
+    fw_conf = conf;
+
+    DEBUG_PRINTF("Note: firmware loading configuration; check:%u, keep_resident:%d\n", fw_conf.check, fw_conf.keep_resident);
+
+    return LGW_HAL_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_calcache_setconf(struct lgw_conf_calcache_s conf) {
+    CHECK_START_BUSY();
+
+    /* check if the concentrator is running */
+    if (lgw_is_started == true) {
+        DEBUG_MSG("ERROR: CONCENTRATOR IS RUNNING, STOP IT BEFORE TOUCHING CONFIGURATION\n");
+        return LGW_HAL_ERROR;
+    }
+
+    /* check input parameters */
+    if ((conf.enable == true) && ((conf.path[0] == '\0') || (memchr(conf.path, '\0', sizeof conf.path) == NULL))) {
+        DEBUG_MSG("ERROR: INVALID CALIBRATION CACHE PATH\n");
+        return LGW_HAL_ERROR;
+    }
+
+    calcache_conf = conf;
+    calcache_conf.path[LGW_CALCACHE_PATH_SIZE - 1] = '\0';
+
+    DEBUG_PRINTF("Note: calibration cache configuration; enable:%d, path:%s, max_age_s:%u, max_reuse:%u\n", calcache_conf.enable, calcache_conf.path, calcache_conf.max_age_s, calcache_conf.max_reuse);
+
+    return LGW_HAL_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_start_script_enable(bool enable) {
+    CHECK_START_BUSY();
+
+    start_script_en = enable;
+    start_script_valid = false; /* compiled again by the next start */
+    return LGW_HAL_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
 int lgw_lbt_setconf(struct lgw_conf_lbt_s conf) {
     int x;
 
+    CHECK_START_BUSY();
+
     /* check if the concentrator is running */
     if (lgw_is_started == true) {
         DEBUG_MSG("ERROR: CONCENTRATOR IS RUNNING, STOP IT BEFORE TOUCHING CONFIGURATION\n");
@@ -452,6 +1499,7 @@ int lgw_lbt_setconf(struct lgw_conf_lbt_s conf) {
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 int lgw_rxrf_setconf(uint8_t rf_chain, struct lgw_conf_rxrf_s conf) {
+    CHECK_START_BUSY();
 
     /* check if the concentrator is running */
     if (lgw_is_started == true) {
@@ -485,23 +1533,144 @@ int lgw_rxrf_setconf(uint8_t rf_chain, struct lgw_conf_rxrf_s conf) {
     rf_tx_enable[rf_chain] = conf.tx_enable;
     rf_tx_notch_freq[rf_chain] = conf.tx_notch_freq;
 
-    DEBUG_PRINTF("Note: rf_chain %d configuration; en:%d freq:%d rssi_offset:%f radio_type:%d tx_enable:%d tx_notch_freq:%u\n", rf_chain, rf_enable[rf_chain], rf_rx_freq[rf_chain], rf_rssi_offset[rf_chain], rf_radio_type[rf_chain], rf_tx_enable[rf_chain], rf_tx_notch_freq[rf_chain]);
+    DEBUG_PRINTF("Note: rf_chain %d configuration; en:%d freq:%d rssi_offset:%f radio_type:%d tx_enable:%d tx_notch_freq:%u\n", rf_chain, rf_enable[rf_chain], rf_rx_freq[rf_chain], rf_rssi_offset[rf_chain], rf_radio_type[rf_chain], rf_tx_enable[rf_chain], rf_tx_notch_freq[rf_chain]);
+
+    return LGW_HAL_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_rxif_setconf(uint8_t if_chain, struct lgw_conf_rxif_s conf) {
+    CHECK_START_BUSY();
+
+    /* check if the concentrator is running */
+    if (lgw_is_started == true) {
+        DEBUG_MSG("ERROR: CONCENTRATOR IS RUNNING, STOP IT BEFORE TOUCHING CONFIGURATION\n");
+        return LGW_HAL_ERROR;
+    }
+
+    return rxif_setconf(if_chain, conf);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_reconfigure(const struct lgw_conf_rxif_s *if_conf, const float *rssi_offset) {
+    struct if_conf_s saved;
+    struct lgw_reg_val_s regs_old[IF_REGS_MAX];
+    struct lgw_reg_val_s regs_new[IF_REGS_MAX];
+    struct lgw_reg_val_s regs_diff[IF_REGS_MAX];
+    int nb_old, nb_new, nb_diff;
+    int i, j;
+
+    CHECK_START_BUSY();
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct hal_reconfigure_args_s args = {if_conf, rssi_offset};
+        return lgw_worker_call(hal_reconfigure_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
+    /* check if the concentrator is running */
+    if (lgw_is_started == false) {
+        DEBUG_MSG("ERROR: CONCENTRATOR IS NOT RUNNING, USE lgw_rxif_setconf INSTEAD\n");
+        return LGW_HAL_ERROR;
+    }
+
+    if (if_conf != NULL) {
+        if_conf_save(&saved);
+        nb_old = if_regs_get(regs_old);
+
+        /* validate and commit the new configuration of all IF chains, or none */
+        for (i = 0; i < LGW_IF_CHAIN_NB; ++i) {
+            if (rxif_setconf(i, if_conf[i]) != LGW_HAL_SUCCESS) {
+                DEBUG_PRINTF("ERROR: INVALID CONFIGURATION FOR IF CHAIN %d, NOTHING CHANGED\n", i);
+                if_conf_restore(&saved);
+                return LGW_HAL_ERROR;
+            }
+            /* radio mapping of the LoRa 'multi' chains was handed to the AGC firmware by lgw_start */
+            if ((i < LGW_MULTI_NB) && (if_rf_chain[i] != saved.if_rf_chain[i])) {
+                DEBUG_PRINTF("ERROR: RF CHAIN OF IF CHAIN %d CANNOT BE CHANGED WHILE RUNNING, NOTHING CHANGED\n", i);
+                if_conf_restore(&saved);
+                return LGW_HAL_ERROR;
+            }
+        }
+        nb_new = if_regs_get(regs_new);
+        if ((nb_old < 0) || (nb_new < 0)) {
+            if_conf_restore(&saved);
+            return LGW_HAL_ERROR;
+        }
+
+        /* only write the registers whose value changed, in a single burst */
+        nb_diff = 0;
+        for (i = 0; i < nb_new; ++i) {
+            for (j = 0; (j < nb_old) && (regs_old[j].register_id != regs_new[i].register_id); ++j);
+            if ((j == nb_old) || (regs_old[j].value != regs_new[i].value)) {
+                regs_diff[nb_diff++] = regs_new[i];
+            }
+        }
+        if (nb_diff > 0) {
+            if (lgw_reg_w_multi(regs_diff, nb_diff) != LGW_REG_SUCCESS) {
+                DEBUG_MSG("ERROR: FAILED TO WRITE IF CHAINS CONFIGURATION\n");
+                if_conf_restore(&saved);
+                /* the burst may be partially written, put back the previous values */
+                nb_new = 0;
+                for (i = 0; i < nb_diff; ++i) {
+                    for (j = 0; (j < nb_old) && (regs_old[j].register_id != regs_diff[i].register_id); ++j);
+                    if (j < nb_old) {
+                        regs_new[nb_new++] = regs_old[j];
+                    }
+                }
+                if (lgw_reg_w_multi(regs_new, nb_new) != LGW_REG_SUCCESS) {
+                    DEBUG_MSG("ERROR: FAILED TO RESTORE IF CHAINS CONFIGURATION, MODEM STATE UNDEFINED\n");
+                }
+                return LGW_HAL_ERROR;
+            }
+        }
+        DEBUG_PRINTF("Note: IF chains reconfigured, %d registers written\n", nb_diff);
+        tstamp_corr_build();
+    }
+
+    /* RSSI offsets are only applied by software, in lgw_receive */
+    if (rssi_offset != NULL) {
+        for (i = 0; i < LGW_RF_CHAIN_NB; ++i) {
+            rf_rssi_offset[i] = rssi_offset[i];
+        }
+    }
+
+    return LGW_HAL_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_rxfilter_setconf(struct lgw_conf_rxfilter_s conf) {
+    CHECK_START_BUSY();
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct hal_rxfilter_setconf_args_s args = {&conf};
+        return lgw_worker_call(hal_rxfilter_setconf_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
+    /* check input parameters */
+    if ((conf.if_chain_mask >> LGW_IF_CHAIN_NB) != 0) {
+        DEBUG_PRINTF("ERROR: 0x%04X NOT A VALID IF CHAIN MASK\n", conf.if_chain_mask);
+        return LGW_HAL_ERROR;
+    }
+
+    rx_filter = conf;
+    /* the payload is fetched after the metadata only if a filter needs them */
+    rx_filter_meta = (conf.enable == true) && ((conf.if_chain_mask != 0) || (conf.rssi_check == true) || (conf.snr_check == true) || (conf.accept != NULL));
 
     return LGW_HAL_SUCCESS;
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-int lgw_rxif_setconf(uint8_t if_chain, struct lgw_conf_rxif_s conf) {
+/* validate an IF chain configuration and commit it to the static variables */
+static int rxif_setconf(uint8_t if_chain, struct lgw_conf_rxif_s conf) {
     int32_t bw_hz;
     uint32_t rf_rx_bandwidth;
 
-    /* check if the concentrator is running */
-    if (lgw_is_started == true) {
-        DEBUG_MSG("ERROR: CONCENTRATOR IS RUNNING, STOP IT BEFORE TOUCHING CONFIGURATION\n");
-        return LGW_HAL_ERROR;
-    }
-
     /* check input range (segfault prevention) */
     if (if_chain >= LGW_IF_CHAIN_NB) {
         DEBUG_PRINTF("ERROR: %d NOT A VALID IF_CHAIN NUMBER\n", if_chain);
@@ -650,6 +1819,8 @@ int lgw_rxif_setconf(uint8_t if_chain, struct lgw_conf_rxif_s conf) {
 int lgw_txgain_setconf(struct lgw_tx_gain_lut_s *conf) {
     int i;
 
+    CHECK_START_BUSY();
+
     /* Check LUT size */
     if ((conf->size < 1) || (conf->size > TX_GAIN_LUT_SIZE_MAX)) {
         DEBUG_PRINTF("ERROR: TX gain LUT must have at least one entry and  maximum %d entries\n", TX_GAIN_LUT_SIZE_MAX);
@@ -694,6 +1865,34 @@ int lgw_txgain_setconf(struct lgw_tx_gain_lut_s *conf) {
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 int lgw_start(void) {
+    uint8_t phase;
+    int x;
+
+    CHECK_START_BUSY();
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        return lgw_worker_call(hal_start_job, NULL, LGW_WORKER_PRIO_NORMAL);
+    }
+
+    /* the other threads are refused HAL calls until the end of the start */
+    if (start_acquire() == false) {
+        DEBUG_MSG("ERROR: CONCENTRATOR START IN PROGRESS\n");
+        return LGW_HAL_ERROR;
+    }
+    phase = lgw_reg_phase_set(LGW_REG_PHASE_START); /* register access statistics */
+    start_prof_begin(); /* time & SPI traffic of each phase */
+    x = hal_start_impl();
+    start_prof_end();
+    lgw_reg_phase_set(phase);
+    start_release();
+
+    return x;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int hal_start_impl(void) {
     int i, err;
     int reg_stat;
     unsigned x;
@@ -702,10 +1901,9 @@ int lgw_start(void) {
     uint8_t load_val;
     uint8_t fw_version;
     uint8_t cal_cmd;
-    uint16_t cal_time;
     uint8_t cal_status;
-
-    uint64_t fsk_sync_word_reg;
+    struct lgw_reg_val_s modem_regs[MODEM_REGS_MAX];
+    int nb_modem_regs, nb_if_regs;
 
     if (lgw_is_started == true) {
         DEBUG_MSG("Note: LoRa concentrator already started, restarting it now\n");
@@ -720,6 +1918,8 @@ int lgw_start(void) {
     /* reset the registers (also shuts the radios down) */
     lgw_soft_reset();
 
+    start_prof_phase(LGW_START_PHASE_RADIO);
+
     /* gate clocks */
     lgw_reg_w(LGW_GLOBAL_EN, 0);
     lgw_reg_w(LGW_CLK32M_EN, 0);
@@ -727,20 +1927,15 @@ int lgw_start(void) {
     /* switch on and reset the radios (also starts the 32 MHz XTAL) */
     lgw_reg_w(LGW_RADIO_A_EN,1);
     lgw_reg_w(LGW_RADIO_B_EN,1);
-    wait_ms(500); /* TODO: optimize */
+    wait_ms(XTAL_STARTUP_MS); /* no XTAL ready indication, the reset needs a stable clock */
     lgw_reg_w(LGW_RADIO_RST,1);
     wait_ms(5);
     lgw_reg_w(LGW_RADIO_RST,0);
 
-    /* setup the radios */
-    err = lgw_setup_sx125x(0, rf_clkout, rf_enable[0], rf_radio_type[0], rf_rx_freq[0]);
+    /* setup the radios, both PLLs locking in parallel */
+    err = lgw_setup_sx125x_all(rf_clkout, rf_enable, rf_radio_type, rf_rx_freq);
     if (err != 0) {
-        DEBUG_MSG("ERROR: Failed to setup sx125x radio for RF chain 0\n");
-        return LGW_HAL_ERROR;
-    }
-    err = lgw_setup_sx125x(1, rf_clkout, rf_enable[1], rf_radio_type[1], rf_rx_freq[1]);
-    if (err != 0) {
-        DEBUG_MSG("ERROR: Failed to setup sx125x radio for RF chain 0\n");
+        DEBUG_MSG("ERROR: Failed to setup sx125x radios\n");
         return LGW_HAL_ERROR;
     }
 
@@ -750,6 +1945,7 @@ int lgw_start(void) {
 
     /* Configure LBT */
     if (lbt_is_enabled() == true) {
+        start_prof_phase(LGW_START_PHASE_LBT);
         lgw_reg_w(LGW_CLK32M_EN, 1);
         i = lbt_setup();
         if (i != LGW_LBT_SUCCESS) {
@@ -766,6 +1962,8 @@ int lgw_start(void) {
         }
     }
 
+    start_prof_phase(LGW_START_PHASE_CAL);
+
     /* Enable clocks */
     lgw_reg_w(LGW_GLOBAL_EN, 1);
     lgw_reg_w(LGW_CLK32M_EN, 1);
@@ -799,87 +1997,19 @@ int lgw_start(void) {
     }
 
     cal_cmd |= 0x00; /* Bit 6-7: Board type 0: ref, 1: FPGA, 3: board X */
-    cal_time = 2300; /* measured between 2.1 and 2.2 sec, because 1 TX only */
 
-    /* Load the calibration firmware  */
-    load_firmware(MCU_AGC, cal_firmware, MCU_AGC_FW_BYTE);
-    lgw_reg_w(LGW_FORCE_HOST_RADIO_CTRL, 0); /* gives to AGC MCU the control of the radios */
-    lgw_reg_w(LGW_RADIO_SELECT, cal_cmd); /* send calibration configuration word */
-    lgw_reg_w(LGW_MCU_RST_1, 0);
-
-    /* Check firmware version */
-    lgw_reg_w(LGW_DBG_AGC_MCU_RAM_ADDR, FW_VERSION_ADDR);
-    lgw_reg_r(LGW_DBG_AGC_MCU_RAM_DATA, &read_val);
-    fw_version = (uint8_t)read_val;
-    if (fw_version != FW_VERSION_CAL) {
-        printf("ERROR: Version of calibration firmware not expected, actual:%d expected:%d\n", fw_version, FW_VERSION_CAL);
-        return -1;
-    }
-
-    lgw_reg_w(LGW_PAGE_REG, 3); /* Calibration will start on this condition as soon as MCU can talk to concentrator registers */
-    lgw_reg_w(LGW_EMERGENCY_FORCE_HOST_CTRL, 0); /* Give control of concentrator registers to MCU */
-
-    /* Wait for calibration to end */
-    DEBUG_PRINTF("Note: calibration started (time: %u ms)\n", cal_time);
-    wait_ms(cal_time); /* Wait for end of calibration */
-    lgw_reg_w(LGW_EMERGENCY_FORCE_HOST_CTRL, 1); /* Take back control */
-
-    /* Get calibration status */
-    lgw_reg_r(LGW_MCU_AGC_STATUS, &read_val);
-    cal_status = (uint8_t)read_val;
-    /*
-        bit 7: calibration finished
-        bit 0: could access SX1301 registers
-        bit 1: could access radio A registers
-        bit 2: could access radio B registers
-        bit 3: radio A RX image rejection successful
-        bit 4: radio B RX image rejection successful
-        bit 5: radio A TX DC Offset correction successful
-        bit 6: radio B TX DC Offset correction successful
-    */
-    if ((cal_status & 0x81) != 0x81) {
-        DEBUG_PRINTF("ERROR: CALIBRATION FAILURE (STATUS = %u)\n", cal_status);
-        return LGW_HAL_ERROR;
+    /* calibrate the radios, or restore the results of a previous calibration */
+    if (calcache_load(cal_cmd) == true) {
+        DEBUG_MSG("Note: calibration results restored from cache, calibration skipped\n");
     } else {
-        DEBUG_PRINTF("Note: calibration finished (status = %u)\n", cal_status);
-    }
-    if (rf_enable[0] && ((cal_status & 0x02) == 0)) {
-        DEBUG_MSG("WARNING: calibration could not access radio A\n");
-    }
-    if (rf_enable[1] && ((cal_status & 0x04) == 0)) {
-        DEBUG_MSG("WARNING: calibration could not access radio B\n");
-    }
-    if (rf_enable[0] && ((cal_status & 0x08) == 0)) {
-        DEBUG_MSG("WARNING: problem in calibration of radio A for image rejection\n");
-    }
-    if (rf_enable[1] && ((cal_status & 0x10) == 0)) {
-        DEBUG_MSG("WARNING: problem in calibration of radio B for image rejection\n");
-    }
-    if (rf_enable[0] && rf_tx_enable[0] && ((cal_status & 0x20) == 0)) {
-        DEBUG_MSG("WARNING: problem in calibration of radio A for TX DC offset\n");
-    }
-    if (rf_enable[1] && rf_tx_enable[1] && ((cal_status & 0x40) == 0)) {
-        DEBUG_MSG("WARNING: problem in calibration of radio B for TX DC offset\n");
-    }
-
-    /* Get TX DC offset values */
-    for(i=0; i<=7; ++i) {
-        lgw_reg_w(LGW_DBG_AGC_MCU_RAM_ADDR, 0xA0+i);
-        lgw_reg_r(LGW_DBG_AGC_MCU_RAM_DATA, &read_val);
-        cal_offset_a_i[i] = (int8_t)read_val;
-        lgw_reg_w(LGW_DBG_AGC_MCU_RAM_ADDR, 0xA8+i);
-        lgw_reg_r(LGW_DBG_AGC_MCU_RAM_DATA, &read_val);
-        cal_offset_a_q[i] = (int8_t)read_val;
-        lgw_reg_w(LGW_DBG_AGC_MCU_RAM_ADDR, 0xB0+i);
-        lgw_reg_r(LGW_DBG_AGC_MCU_RAM_DATA, &read_val);
-        cal_offset_b_i[i] = (int8_t)read_val;
-        lgw_reg_w(LGW_DBG_AGC_MCU_RAM_ADDR, 0xB8+i);
-        lgw_reg_r(LGW_DBG_AGC_MCU_RAM_DATA, &read_val);
-        cal_offset_b_q[i] = (int8_t)read_val;
+        err = lgw_calibrate(cal_cmd, &cal_status);
+        if (err != LGW_HAL_SUCCESS) {
+            return LGW_HAL_ERROR;
+        }
+        calcache_save(cal_cmd, cal_status);
     }
 
-    /* load adjusted parameters */
-    lgw_constant_adjust();
+    start_prof_phase(LGW_START_PHASE_MODEM);
 
     /* Sanity check for RX frequency */
     if (rf_rx_freq[0] == 0) {
@@ -887,14 +2017,20 @@ int lgw_start(void) {
         return LGW_HAL_ERROR;
     }
 
+    /* load adjusted parameters */
+    nb_modem_regs = lgw_constant_adjust(modem_regs, CONSTANT_REGS_MAX);
+    if (nb_modem_regs < 0) {
+        return LGW_HAL_ERROR;
+    }
+
     /* Freq-to-time-drift calculation */
     x = 4096000000 / (rf_rx_freq[0] >> 1); /* dividend: (4*2048*1000000) >> 1, rescaled to avoid 32b overflow */
     x = ( x > 63 ) ? 63 : x; /* saturation */
-    lgw_reg_w(LGW_FREQ_TO_TIME_DRIFT, x); /* default 9 */
+    modem_regs[nb_modem_regs++] = (struct lgw_reg_val_s){LGW_FREQ_TO_TIME_DRIFT, x}; /* default 9 */
 
     x = 4096000000 / (rf_rx_freq[0] >> 3); /* dividend: (16*2048*1000000) >> 3, rescaled to avoid 32b overflow */
     x = ( x > 63 ) ? 63 : x; /* saturation */
-    lgw_reg_w(LGW_MBWSSF_FREQ_TO_TIME_DRIFT, x); /* default 36 */
+    modem_regs[nb_modem_regs++] = (struct lgw_reg_val_s){LGW_MBWSSF_FREQ_TO_TIME_DRIFT, x}; /* default 36 */
 
     /* configure LoRa 'multi' demodulators aka. LoRa 'sensor' channels (IF0-3) */
     radio_select = 0; /* IF mapping to radio A/B (per bit, 0=A, 1=B) */
@@ -908,76 +2044,29 @@ int lgw_start(void) {
     will be loaded in LGW_RADIO_SELECT at the end of start procedure.
     */
 
-    lgw_reg_w(LGW_IF_FREQ_0, IF_HZ_TO_REG(if_freq[0])); /* default -384 */
-    lgw_reg_w(LGW_IF_FREQ_1, IF_HZ_TO_REG(if_freq[1])); /* default -128 */
-    lgw_reg_w(LGW_IF_FREQ_2, IF_HZ_TO_REG(if_freq[2])); /* default 128 */
-    lgw_reg_w(LGW_IF_FREQ_3, IF_HZ_TO_REG(if_freq[3])); /* default 384 */
-    lgw_reg_w(LGW_IF_FREQ_4, IF_HZ_TO_REG(if_freq[4])); /* default -384 */
-    lgw_reg_w(LGW_IF_FREQ_5, IF_HZ_TO_REG(if_freq[5])); /* default -128 */
-    lgw_reg_w(LGW_IF_FREQ_6, IF_HZ_TO_REG(if_freq[6])); /* default 128 */
-    lgw_reg_w(LGW_IF_FREQ_7, IF_HZ_TO_REG(if_freq[7])); /* default 384 */
-
-    lgw_reg_w(LGW_CORR0_DETECT_EN, (if_enable[0] == true) ? lora_multi_sfmask[0] : 0); /* default 0 */
-    lgw_reg_w(LGW_CORR1_DETECT_EN, (if_enable[1] == true) ? lora_multi_sfmask[1] : 0); /* default 0 */
-    lgw_reg_w(LGW_CORR2_DETECT_EN, (if_enable[2] == true) ? lora_multi_sfmask[2] : 0); /* default 0 */
-    lgw_reg_w(LGW_CORR3_DETECT_EN, (if_enable[3] == true) ? lora_multi_sfmask[3] : 0); /* default 0 */
-    lgw_reg_w(LGW_CORR4_DETECT_EN, (if_enable[4] == true) ? lora_multi_sfmask[4] : 0); /* default 0 */
-    lgw_reg_w(LGW_CORR5_DETECT_EN, (if_enable[5] == true) ? lora_multi_sfmask[5] : 0); /* default 0 */
-    lgw_reg_w(LGW_CORR6_DETECT_EN, (if_enable[6] == true) ? lora_multi_sfmask[6] : 0); /* default 0 */
-    lgw_reg_w(LGW_CORR7_DETECT_EN, (if_enable[7] == true) ? lora_multi_sfmask[7] : 0); /* default 0 */
-
-    lgw_reg_w(LGW_PPM_OFFSET, 0x60); /* as the threshold is 16ms, use 0x60 to enable ppm_offset for SF12 and SF11 @125kHz*/
-
-    lgw_reg_w(LGW_CONCENTRATOR_MODEM_ENABLE, 1); /* default 0 */
-
-    /* configure LoRa 'stand-alone' modem (IF8) */
-    lgw_reg_w(LGW_IF_FREQ_8, IF_HZ_TO_REG(if_freq[8])); /* MBWSSF modem (default 0) */
-    if (if_enable[8] == true) {
-        lgw_reg_w(LGW_MBWSSF_RADIO_SELECT, if_rf_chain[8]);
-        switch(lora_rx_bw) {
-            case BW_125KHZ: lgw_reg_w(LGW_MBWSSF_MODEM_BW, 0); break;
-            case BW_250KHZ: lgw_reg_w(LGW_MBWSSF_MODEM_BW, 1); break;
-            case BW_500KHZ: lgw_reg_w(LGW_MBWSSF_MODEM_BW, 2); break;
-            default:
-                DEBUG_PRINTF("ERROR: UNEXPECTED VALUE %d IN SWITCH STATEMENT\n", lora_rx_bw);
-                return LGW_HAL_ERROR;
-        }
-        switch(lora_rx_sf) {
-            case DR_LORA_SF7: lgw_reg_w(LGW_MBWSSF_RATE_SF, 7); break;
-            case DR_LORA_SF8: lgw_reg_w(LGW_MBWSSF_RATE_SF, 8); break;
-            case DR_LORA_SF9: lgw_reg_w(LGW_MBWSSF_RATE_SF, 9); break;
-            case DR_LORA_SF10: lgw_reg_w(LGW_MBWSSF_RATE_SF, 10); break;
-            case DR_LORA_SF11: lgw_reg_w(LGW_MBWSSF_RATE_SF, 11); break;
-            case DR_LORA_SF12: lgw_reg_w(LGW_MBWSSF_RATE_SF, 12); break;
-            default:
-                DEBUG_PRINTF("ERROR: UNEXPECTED VALUE %d IN SWITCH STATEMENT\n", lora_rx_sf);
-                return LGW_HAL_ERROR;
-        }
-        lgw_reg_w(LGW_MBWSSF_PPM_OFFSET, lora_rx_ppm_offset); /* default 0 */
-        lgw_reg_w(LGW_MBWSSF_MODEM_ENABLE, 1); /* default 0 */
-    } else {
-        lgw_reg_w(LGW_MBWSSF_MODEM_ENABLE, 0);
+    modem_regs[nb_modem_regs++] = (struct lgw_reg_val_s){LGW_PPM_OFFSET, 0x60}; /* as the threshold is 16ms, use 0x60 to enable ppm_offset for SF12 and SF11 @125kHz*/
+
+    modem_regs[nb_modem_regs++] = (struct lgw_reg_val_s){LGW_CONCENTRATOR_MODEM_ENABLE, 1}; /* default 0 */
+
+    /* configure IF frequencies, LoRa 'multi' correlators, LoRa 'stand-alone' modem (IF8) and FSK modem (IF9) */
+    nb_if_regs = if_regs_get(&modem_regs[nb_modem_regs]);
+    if (nb_if_regs < 0) {
+        return LGW_HAL_ERROR;
     }
+    nb_modem_regs += nb_if_regs;
 
-    /* configure FSK modem (IF9) */
-    lgw_reg_w(LGW_IF_FREQ_9, IF_HZ_TO_REG(if_freq[9])); /* FSK modem, default 0 */
-    lgw_reg_w(LGW_FSK_PSIZE, fsk_sync_word_size-1);
-    lgw_reg_w(LGW_FSK_TX_PSIZE, fsk_sync_word_size-1);
-    fsk_sync_word_reg = fsk_sync_word << (8 * (8 - fsk_sync_word_size));
-    lgw_reg_w(LGW_FSK_REF_PATTERN_LSB, (uint32_t)(0xFFFFFFFF & fsk_sync_word_reg));
-    lgw_reg_w(LGW_FSK_REF_PATTERN_MSB, (uint32_t)(0xFFFFFFFF & (fsk_sync_word_reg >> 32)));
-    if (if_enable[9] == true) {
-        lgw_reg_w(LGW_FSK_RADIO_SELECT, if_rf_chain[9]);
-        lgw_reg_w(LGW_FSK_BR_RATIO, LGW_XTAL_FREQU/fsk_rx_dr); /* setting the dividing ratio for datarate */
-        lgw_reg_w(LGW_FSK_CH_BW_EXPO, fsk_rx_bw);
-        lgw_reg_w(LGW_FSK_MODEM_ENABLE, 1); /* default 0 */
-    } else {
-        lgw_reg_w(LGW_FSK_MODEM_ENABLE, 0);
+    /* the modems configuration only depends on the configuration set: written in a few bursts, or replayed */
+    if (modem_regs_write(modem_regs, nb_modem_regs) != LGW_HAL_SUCCESS) {
+        DEBUG_MSG("ERROR: FAILED TO CONFIGURE THE MODEMS\n");
+        return LGW_HAL_ERROR;
     }
 
+    start_prof_phase(LGW_START_PHASE_FW);
+
     /* Load firmware */
-    load_firmware(MCU_ARB, arb_firmware, MCU_ARB_FW_BYTE);
-    load_firmware(MCU_AGC, agc_firmware, MCU_AGC_FW_BYTE);
+    if ((load_firmware(MCU_ARB, arb_firmware, MCU_ARB_FW_BYTE) != 0) || (load_firmware(MCU_AGC, agc_firmware, MCU_AGC_FW_BYTE) != 0)) {
+        return LGW_HAL_ERROR;
+    }
 
     /* gives the AGC MCU control over radio, RF front-end and filter gain */
     lgw_reg_w(LGW_FORCE_HOST_RADIO_CTRL, 0);
@@ -1005,11 +2094,11 @@ int lgw_start(void) {
         return LGW_HAL_ERROR;
     }
 
-    DEBUG_MSG("Info: Initialising AGC firmware...\n");
-    wait_ms(1);
+    start_prof_phase(LGW_START_PHASE_AGC);
 
-    lgw_reg_r(LGW_MCU_AGC_STATUS, &read_val);
-    if (read_val != 0x10) {
+    DEBUG_MSG("Info: Initialising AGC firmware...\n");
+    err = agc_status_poll(0xFF, 0x10, AGC_STATUS_TIMEOUT_MS, AGC_STATUS_POLL_US, &read_val);
+    if (err != LGW_HAL_SUCCESS) {
         DEBUG_PRINTF("ERROR: AGC FIRMWARE INITIALIZATION FAILURE, STATUS 0x%02X\n", (uint8_t)read_val);
         return LGW_HAL_ERROR;
     }
@@ -1017,12 +2106,11 @@ int lgw_start(void) {
     /* Update Tx gain LUT and start AGC */
     for (i = 0; i < txgain_lut.size; ++i) {
         lgw_reg_w(LGW_RADIO_SELECT, AGC_CMD_WAIT); /* start a transaction */
-        wait_ms(1);
+        wait_ms(AGC_CMD_WAIT_MS); /* no acknowledge for this command */
         load_val = txgain_lut.lut[i].mix_gain + (16 * txgain_lut.lut[i].dac_gain) + (64 * txgain_lut.lut[i].pa_gain);
         lgw_reg_w(LGW_RADIO_SELECT, load_val);
-        wait_ms(1);
-        lgw_reg_r(LGW_MCU_AGC_STATUS, &read_val);
-        if (read_val != (0x30 + i)) {
+        err = agc_status_poll(0xFF, 0x30 + i, AGC_STATUS_TIMEOUT_MS, AGC_STATUS_POLL_US, &read_val);
+        if (err != LGW_HAL_SUCCESS) {
             DEBUG_PRINTF("ERROR: AGC FIRMWARE INITIALIZATION FAILURE, STATUS 0x%02X\n", (uint8_t)read_val);
             return LGW_HAL_ERROR;
         }
@@ -1030,12 +2118,11 @@ int lgw_start(void) {
     /* As the AGC fw is waiting for 16 entries, we need to abort the transaction if we get less entries */
     if (txgain_lut.size < TX_GAIN_LUT_SIZE_MAX) {
         lgw_reg_w(LGW_RADIO_SELECT, AGC_CMD_WAIT);
-        wait_ms(1);
+        wait_ms(AGC_CMD_WAIT_MS); /* no acknowledge for this command */
         load_val = AGC_CMD_ABORT;
         lgw_reg_w(LGW_RADIO_SELECT, load_val);
-        wait_ms(1);
-        lgw_reg_r(LGW_MCU_AGC_STATUS, &read_val);
-        if (read_val != 0x30) {
+        err = agc_status_poll(0xFF, 0x30, AGC_STATUS_TIMEOUT_MS, AGC_STATUS_POLL_US, &read_val);
+        if (err != LGW_HAL_SUCCESS) {
             DEBUG_PRINTF("ERROR: AGC FIRMWARE INITIALIZATION FAILURE, STATUS 0x%02X\n", (uint8_t)read_val);
             return LGW_HAL_ERROR;
         }
@@ -1043,54 +2130,81 @@ int lgw_start(void) {
 
     /* Load Tx freq MSBs (always 3 if f > 768 for SX1257 or f > 384 for SX1255 */
     lgw_reg_w(LGW_RADIO_SELECT, AGC_CMD_WAIT);
-    wait_ms(1);
+    wait_ms(AGC_CMD_WAIT_MS); /* no acknowledge for this command */
     lgw_reg_w(LGW_RADIO_SELECT, 3);
-    wait_ms(1);
-    lgw_reg_r(LGW_MCU_AGC_STATUS, &read_val);
-    if (read_val != 0x33) {
+    err = agc_status_poll(0xFF, 0x33, AGC_STATUS_TIMEOUT_MS, AGC_STATUS_POLL_US, &read_val);
+    if (err != LGW_HAL_SUCCESS) {
         DEBUG_PRINTF("ERROR: AGC FIRMWARE INITIALIZATION FAILURE, STATUS 0x%02X\n", (uint8_t)read_val);
         return LGW_HAL_ERROR;
     }
 
     /* Load chan_select firmware option */
     lgw_reg_w(LGW_RADIO_SELECT, AGC_CMD_WAIT);
-    wait_ms(1);
+    wait_ms(AGC_CMD_WAIT_MS); /* no acknowledge for this command */
     lgw_reg_w(LGW_RADIO_SELECT, 0);
-    wait_ms(1);
-    lgw_reg_r(LGW_MCU_AGC_STATUS, &read_val);
-    if (read_val != 0x30) {
+    err = agc_status_poll(0xFF, 0x30, AGC_STATUS_TIMEOUT_MS, AGC_STATUS_POLL_US, &read_val);
+    if (err != LGW_HAL_SUCCESS) {
         DEBUG_PRINTF("ERROR: AGC FIRMWARE INITIALIZATION FAILURE, STATUS 0x%02X\n", (uint8_t)read_val);
         return LGW_HAL_ERROR;
     }
 
     /* End AGC firmware init and check status */
     lgw_reg_w(LGW_RADIO_SELECT, AGC_CMD_WAIT);
-    wait_ms(1);
+    wait_ms(AGC_CMD_WAIT_MS); /* no acknowledge for this command */
     lgw_reg_w(LGW_RADIO_SELECT, radio_select); /* Load intended value of RADIO_SELECT */
-    wait_ms(1);
     DEBUG_MSG("Info: putting back original RADIO_SELECT value\n");
-    lgw_reg_r(LGW_MCU_AGC_STATUS, &read_val);
-    if (read_val != 0x40) {
+    err = agc_status_poll(0xFF, 0x40, AGC_STATUS_TIMEOUT_MS, AGC_STATUS_POLL_US, &read_val);
+    if (err != LGW_HAL_SUCCESS) {
         DEBUG_PRINTF("ERROR: AGC FIRMWARE INITIALIZATION FAILURE, STATUS 0x%02X\n", (uint8_t)read_val);
         return LGW_HAL_ERROR;
     }
+    lgw_reg_shadow_invalidate(); /* registers written by the MCUs during their initialization */
 
     /* enable GPS event capture */
     lgw_reg_w(LGW_GPS_EN, 1);
 
     /* */
     if (lbt_is_enabled() == true) {
+        start_prof_phase(LGW_START_PHASE_LBT);
         printf("INFO: Configuring LBT, this may take few seconds, please wait...\n");
-        wait_ms(8400);
+        if (lbt_wait_ready(LBT_READY_TIMEOUT_MS) != LGW_LBT_SUCCESS) {
+            DEBUG_MSG("WARNING: LBT channels not all scanned yet\n");
+        }
     }
 
+    /* timestamp correction of the received packets, for the modems configuration */
+    tstamp_corr_build();
+
+    start_prof.status = LGW_HAL_SUCCESS;
     lgw_is_started = true;
     return LGW_HAL_SUCCESS;
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+int lgw_start_profile(struct lgw_start_profile_s *profile) {
+    CHECK_START_BUSY();
+
+    CHECK_NULL(profile);
+    if (start_prof_valid == false) {
+        DEBUG_MSG("ERROR: NO PROFILE, lgw_start WAS NEVER CALLED\n");
+        return LGW_HAL_ERROR;
+    }
+
+    *profile = start_prof;
+    return LGW_HAL_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
 int lgw_stop(void) {
+    CHECK_START_BUSY();
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        return lgw_worker_call(hal_stop_job, NULL, LGW_WORKER_PRIO_NORMAL);
+    }
+
     lgw_soft_reset();
     lgw_disconnect();
 
@@ -1101,16 +2215,43 @@ int lgw_stop(void) {
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 int lgw_receive(uint8_t max_pkt, struct lgw_pkt_rx_s *pkt_data) {
+    uint8_t phase;
+    int x;
+
+    CHECK_START_BUSY();
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct hal_receive_args_s args = {max_pkt, pkt_data};
+        return lgw_worker_call(hal_receive_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
+    phase = lgw_reg_phase_set(LGW_REG_PHASE_RECEIVE); /* register access statistics */
+    x = hal_receive_impl(max_pkt, pkt_data);
+    lgw_reg_phase_set(phase);
+
+    return x;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int hal_receive_impl(uint8_t max_pkt, struct lgw_pkt_rx_s *pkt_data) {
     int nb_pkt_fetch; /* loop variable and return value */
     struct lgw_pkt_rx_s *p; /* pointer to the current structure in the struct array */
     uint8_t buff[255+RX_METADATA_NB]; /* buffer to store the result of SPI read bursts */
+    uint8_t fifo[5]; /* RX FIFO status of the current packet */
+    uint8_t fifo_next = 0; /* value written to advance the RX FIFO */
+    struct lgw_reg_burst_s fetch[4]; /* bursts of the SPI transaction fetching a packet */
+    int nb_fetch; /* number of bursts in the transaction */
+    uint16_t pkt_addr; /* start address of the current packet in RX data buffer */
+    uint8_t buf_addr[2]; /* RX data buffer read address, LSB first */
+    bool drop; /* packet rejected by the RX filters */
     unsigned sz; /* size of the payload, uses to address metadata */
     int ifmod; /* type of if_chain/modem a packet was received by */
     int stat_fifo; /* the packet status as indicated in the FIFO */
     uint32_t raw_timestamp; /* timestamp when internal 'RX finished' was triggered */
-    uint32_t delay_x, delay_y, delay_z; /* temporary variable for timestamp offset calculation */
     uint32_t timestamp_correction; /* correction to account for processing delay */
-    uint32_t sf, cr, bw_pow, crc_en, ppm; /* used to calculate timestamp correction */
+    uint32_t sf, cr, crc_en; /* used to look up timestamp correction */
 
     /* check if the concentrator is running */
     if (lgw_is_started == false) {
@@ -1128,46 +2269,86 @@ int lgw_receive(uint8_t max_pkt, struct lgw_pkt_rx_s *pkt_data) {
     /* Initialize buffer */
     memset (buff, 0, sizeof buff);
 
-    /* iterate max_pkt times at most */
-    for (nb_pkt_fetch = 0; nb_pkt_fetch < max_pkt; ++nb_pkt_fetch) {
+    /* fetch the RX FIFO data of the first packet */
+    lgw_reg_rb(LGW_RX_PACKET_DATA_FIFO_NUM_STORED, fifo, 5);
+    /* 0:   number of packets available in RX data buffer */
+    /* 1,2: start address of the current packet in RX data buffer */
+    /* 3:   CRC status of the current packet */
+    /* 4:   size of the current packet payload in byte */
+
+    /* per packet, a single SPI transaction reads the payload + metadata,
+    advances the packet FIFO and fetches the FIFO status of the next packet.
+    With RX filters on the metadata, those are read first, and the payload
+    of accepted packets is read in a second transaction */
+
+    /* iterate until max_pkt packets are fetched, dropped packets are not counted */
+    nb_pkt_fetch = 0;
+    while (nb_pkt_fetch < max_pkt) {
 
         /* point to the proper struct in the struct array */
         p = &pkt_data[nb_pkt_fetch];
 
-        /* fetch all the RX FIFO data */
-        lgw_reg_rb(LGW_RX_PACKET_DATA_FIFO_NUM_STORED, buff, 5);
-        /* 0:   number of packets available in RX data buffer */
-        /* 1,2: start address of the current packet in RX data buffer */
-        /* 3:   CRC status of the current packet */
-        /* 4:   size of the current packet payload in byte */
-
         /* how many packets are in the RX buffer ? Break if zero */
-        if (buff[0] == 0) {
+        if (fifo[0] == 0) {
             break; /* no more packets to fetch, exit out of FOR loop */
         }
 
         /* sanity check */
-        if (buff[0] > LGW_PKT_FIFO_SIZE) {
-            DEBUG_PRINTF("WARNING: %u = INVALID NUMBER OF PACKETS TO FETCH, ABORTING\n", buff[0]);
+        if (fifo[0] > LGW_PKT_FIFO_SIZE) {
+            DEBUG_PRINTF("WARNING: %u = INVALID NUMBER OF PACKETS TO FETCH, ABORTING\n", fifo[0]);
             break;
         }
 
-        DEBUG_PRINTF("FIFO content: %x %x %x %x %x\n", buff[0], buff[1], buff[2], buff[3], buff[4]);
+        DEBUG_PRINTF("FIFO content: %x %x %x %x %x\n", fifo[0], fifo[1], fifo[2], fifo[3], fifo[4]);
 
-        p->size = buff[4];
+        p->size = fifo[4];
         sz = p->size;
-        stat_fifo = buff[3]; /* will be used later, need to save it before overwriting buff */
+        stat_fifo = fifo[3]; /* will be used later, need to save it before overwriting fifo */
+        pkt_addr = (uint16_t)fifo[1] | ((uint16_t)fifo[2] << 8);
+
+        /* packet dropped on its CRC status: only advance packet FIFO and fetch the next FIFO status */
+        if (rx_filter_status(stat_fifo) == false) {
+            rx_burst_set(&fetch[0], LGW_RX_PACKET_DATA_FIFO_NUM_STORED, false, &fifo_next, 1);
+            rx_burst_set(&fetch[1], LGW_RX_PACKET_DATA_FIFO_NUM_STORED, true, fifo, 5);
+            if (lgw_reg_burst_seq(fetch, 2) != LGW_REG_SUCCESS) {
+                DEBUG_MSG("ERROR: FAILED TO DROP PACKET, ABORTING\n");
+                break;
+            }
+            continue;
+        }
 
-        /* get payload + metadata */
-        lgw_reg_rb(LGW_RX_DATA_BUF_DATA, buff, sz+RX_METADATA_NB);
+        nb_fetch = 0;
+        if (rx_filter_meta == true) {
+            /* get metadata only, stored after the payload in RX data buffer */
+            buf_addr[0] = (uint8_t)(pkt_addr + sz);
+            buf_addr[1] = (uint8_t)((pkt_addr + sz) >> 8);
+            rx_burst_set(&fetch[nb_fetch++], LGW_RX_DATA_BUF_ADDR, false, buf_addr, 2);
+            rx_burst_set(&fetch[nb_fetch++], LGW_RX_DATA_BUF_DATA, true, buff + sz, RX_METADATA_NB);
+        } else {
+            /* get payload + metadata and advance packet FIFO, next FIFO status not needed for the last packet */
+            rx_burst_set(&fetch[nb_fetch++], LGW_RX_DATA_BUF_DATA, true, buff, sz + RX_METADATA_NB);
+            rx_burst_set(&fetch[nb_fetch++], LGW_RX_PACKET_DATA_FIFO_NUM_STORED, false, &fifo_next, 1);
+            if (nb_pkt_fetch + 1 < max_pkt) {
+                rx_burst_set(&fetch[nb_fetch++], LGW_RX_PACKET_DATA_FIFO_NUM_STORED, true, fifo, 5);
+            }
+        }
+        if (lgw_reg_burst_seq(fetch, nb_fetch) != LGW_REG_SUCCESS) {
+            DEBUG_MSG("ERROR: FAILED TO FETCH PACKET, ABORTING\n");
+            break;
+        }
 
         /* copy payload to result struct */
-        memcpy((void *)p->payload, (void *)buff, sz);
+        if (rx_filter_meta == false) {
+            memcpy((void *)p->payload, (void *)buff, sz);
+        }
 
         /* process metadata */
         p->if_chain = buff[sz+0];
         if (p->if_chain >= LGW_IF_CHAIN_NB) {
             DEBUG_PRINTF("WARNING: %u NOT A VALID IF_CHAIN NUMBER, ABORTING\n", p->if_chain);
+            if (rx_filter_meta == true) {
+                LGW_REG_W(LGW_RX_PACKET_DATA_FIFO_NUM_STORED, 0); /* advance packet FIFO */
+            }
             break;
         }
         ifmod = ifmod_config[p->if_chain];
@@ -1224,48 +2405,9 @@ int lgw_receive(uint8_t max_pkt, struct lgw_pkt_rx_s *pkt_data) {
                 default: p->coderate = CR_UNDEFINED;
             }
 
-            /* determine if 'PPM mode' is on, needed for timestamp correction */
-            if (SET_PPM_ON(p->bandwidth,p->datarate)) {
-                ppm = 1;
-            } else {
-                ppm = 0;
-            }
-
-            /* timestamp correction code, base delay */
-            if (ifmod == IF_LORA_STD) { /* if packet was received on the stand-alone LoRa modem */
-                switch (lora_rx_bw) {
-                    case BW_125KHZ:
-                        delay_x = 64;
-                        bw_pow = 1;
-                        break;
-                    case BW_250KHZ:
-                        delay_x = 32;
-                        bw_pow = 2;
-                        break;
-                    case BW_500KHZ:
-                        delay_x = 16;
-                        bw_pow = 4;
-                        break;
-                    default:
-                        DEBUG_PRINTF("ERROR: UNEXPECTED VALUE %d IN SWITCH STATEMENT\n", p->bandwidth);
-                        delay_x = 0;
-                        bw_pow = 0;
-                }
-            } else { /* packet was received on one of the sensor channels = 125kHz */
-                delay_x = 114;
-                bw_pow = 1;
-            }
-
-            /* timestamp correction code, variable delay */
-            if ((sf >= 6) && (sf <= 12) && (bw_pow > 0)) {
-                if ((2*(sz + 2*crc_en) - (sf-7)) <= 0) { /* payload fits entirely in first 8 symbols */
-                    delay_y = ( ((1<<(sf-1)) * (sf+1)) + (3 * (1<<(sf-4))) ) / bw_pow;
-                    delay_z = 32 * (2*(sz+2*crc_en) + 5) / bw_pow;
-                } else {
-                    delay_y = ( ((1<<(sf-1)) * (sf+1)) + ((4 - ppm) * (1<<(sf-4))) ) / bw_pow;
-                    delay_z = (16 + 4*cr) * (((2*(sz+2*crc_en)-sf+6) % (sf - 2*ppm)) + 1) / bw_pow;
-                }
-                timestamp_correction = delay_x + delay_y + delay_z;
+            /* timestamp correction, precomputed for the current modems configuration */
+            if ((sf >= TSTAMP_SF_MIN) && (sf < (TSTAMP_SF_MIN + TSTAMP_SF_NB))) {
+                timestamp_correction = lora_tstamp_corr[ifmod == IF_LORA_STD][sf - TSTAMP_SF_MIN][cr][crc_en][sz];
             } else {
                 timestamp_correction = 0;
                 DEBUG_MSG("WARNING: invalid packet, no timestamp correction\n");
@@ -1299,7 +2441,7 @@ int lgw_receive(uint8_t max_pkt, struct lgw_pkt_rx_s *pkt_data) {
             p->bandwidth = fsk_rx_bw;
             p->datarate = fsk_rx_dr;
             p->coderate = CR_UNDEFINED;
-            timestamp_correction = ((uint32_t)680000 / fsk_rx_dr) - 20;
+            timestamp_correction = fsk_tstamp_corr;
 
             /* RSSI correction */
             p->rssi = RSSI_FSK_POLY_0 + RSSI_FSK_POLY_1 * p->rssi + RSSI_FSK_POLY_2 * pow(p->rssi, 2);
@@ -1321,8 +2463,30 @@ int lgw_receive(uint8_t max_pkt, struct lgw_pkt_rx_s *pkt_data) {
         p->count_us = raw_timestamp - timestamp_correction;
         p->crc = (uint16_t)buff[sz+10] + ((uint16_t)buff[sz+11] << 8);
 
-        /* advance packet FIFO */
-        lgw_reg_w(LGW_RX_PACKET_DATA_FIFO_NUM_STORED, 0);
+        /* apply the RX filters, then get payload of accepted packet and advance packet FIFO */
+        if (rx_filter_meta == true) {
+            drop = (rx_filter_accept(p) == false);
+            nb_fetch = 0;
+            if ((drop == false) && (sz > 0)) {
+                buf_addr[0] = (uint8_t)pkt_addr;
+                buf_addr[1] = (uint8_t)(pkt_addr >> 8);
+                rx_burst_set(&fetch[nb_fetch++], LGW_RX_DATA_BUF_ADDR, false, buf_addr, 2);
+                rx_burst_set(&fetch[nb_fetch++], LGW_RX_DATA_BUF_DATA, true, p->payload, sz);
+            }
+            rx_burst_set(&fetch[nb_fetch++], LGW_RX_PACKET_DATA_FIFO_NUM_STORED, false, &fifo_next, 1);
+            if ((drop == true) || (nb_pkt_fetch + 1 < max_pkt)) {
+                rx_burst_set(&fetch[nb_fetch++], LGW_RX_PACKET_DATA_FIFO_NUM_STORED, true, fifo, 5);
+            }
+            if (lgw_reg_burst_seq(fetch, nb_fetch) != LGW_REG_SUCCESS) {
+                DEBUG_MSG("ERROR: FAILED TO FETCH PACKET PAYLOAD, ABORTING\n");
+                break;
+            }
+            if (drop == true) {
+                continue;
+            }
+        }
+
+        ++nb_pkt_fetch;
     }
 
     return nb_pkt_fetch;
@@ -1330,7 +2494,149 @@ int lgw_receive(uint8_t max_pkt, struct lgw_pkt_rx_s *pkt_data) {
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+int lgw_rxpoll_init(struct lgw_rxpoll_s *rxpoll, uint32_t min_us, uint32_t max_us) {
+    uint32_t toa[LGW_IF_CHAIN_NB]; /* shortest time on air per enabled IF chain, 0 if disabled */
+    uint32_t next[LGW_IF_CHAIN_NB]; /* end of the next packet on each IF chain, worst case */
+    uint32_t t;
+    int nb_pkt;
+    int i;
+
+    /* check input parameters */
+    CHECK_NULL(rxpoll);
+    if ((min_us == 0) || (max_us < min_us)) {
+        DEBUG_MSG("ERROR: INVALID POLLING INTERVAL BOUNDS\n");
+        return LGW_HAL_ERROR;
+    }
+
+    /* shortest packet each enabled IF chain can receive */
+    for (i = 0; i < LGW_IF_CHAIN_NB; ++i) {
+        toa[i] = 0;
+        if (if_enable[i] == false) {
+            continue;
+        }
+        switch (ifmod_config[i]) {
+            case IF_LORA_MULTI:
+                if ((lora_multi_sfmask[i] & DR_LORA_MULTI) != 0) {
+                    toa[i] = rxpoll_toa_us(MOD_LORA, BW_125KHZ, lora_multi_sfmask[i] & -lora_multi_sfmask[i] & DR_LORA_MULTI, CR_LORA_4_5, 0);
+                }
+                break;
+            case IF_LORA_STD:
+                toa[i] = rxpoll_toa_us(MOD_LORA, lora_rx_bw, lora_rx_sf, CR_LORA_4_5, 0);
+                break;
+            case IF_FSK_STD:
+                toa[i] = rxpoll_toa_us(MOD_FSK, fsk_rx_bw, fsk_rx_dr, CR_UNDEFINED, 0);
+                break;
+            default:
+                break;
+        }
+    }
+
+    /* one packet in flight per IF chain, then one per time on air, until the FIFO overflows */
+    nb_pkt = 0;
+    for (i = 0; i < LGW_IF_CHAIN_NB; ++i) {
+        next[i] = toa[i];
+        nb_pkt += (toa[i] > 0) ? 1 : 0;
+    }
+    rxpoll->fill_us = (nb_pkt > 0) ? 0 : UINT32_MAX;
+    while ((nb_pkt > 0) && (nb_pkt <= LGW_PKT_FIFO_SIZE)) {
+        t = UINT32_MAX;
+        for (i = 0; i < LGW_IF_CHAIN_NB; ++i) {
+            if ((toa[i] > 0) && (next[i] < t)) {
+                t = next[i];
+            }
+        }
+        for (i = 0; i < LGW_IF_CHAIN_NB; ++i) {
+            if ((toa[i] > 0) && (next[i] == t)) {
+                nb_pkt += 1;
+                next[i] += toa[i];
+            }
+        }
+        rxpoll->fill_us = t;
+    }
+
+    rxpoll->min_us = min_us;
+    rxpoll->max_us = max_us;
+    rxpoll->interval_us = min_us;
+    DEBUG_PRINTF("Note: RX FIFO overflow not before %u us\n", rxpoll->fill_us);
+
+    return LGW_HAL_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+uint32_t lgw_rxpoll_next(struct lgw_rxpoll_s *rxpoll, const struct lgw_pkt_rx_s *pkt_data, int nb_pkt, int max_pkt) {
+    uint64_t interval; /* before bounding */
+    uint32_t bound; /* half of the FIFO fill time, margin for the polling jitter */
+    uint32_t toa, toa_min;
+    int i;
+
+    if (rxpoll == NULL) {
+        return 0;
+    }
+
+    /* FIFO not drained by the last call */
+    if ((nb_pkt > 0) && (nb_pkt >= max_pkt)) {
+        rxpoll->interval_us = rxpoll->min_us;
+        return 0;
+    }
+
+    if (nb_pkt == 0) {
+        /* idle: back off */
+        interval = 2 * (uint64_t)rxpoll->interval_us;
+    } else if ((nb_pkt > 0) && (pkt_data != NULL)) {
+        /* next poll expected with the FIFO half full, at the observed packet rate */
+        interval = (uint64_t)rxpoll->interval_us * (LGW_PKT_FIFO_SIZE / 2) / nb_pkt;
+        /* no packet completes on the same IF chain before the end of the next one */
+        toa_min = UINT32_MAX;
+        for (i = 0; i < nb_pkt; ++i) {
+            toa = rxpoll_toa_us(pkt_data[i].modulation, pkt_data[i].bandwidth, pkt_data[i].datarate, pkt_data[i].coderate, pkt_data[i].size);
+            if (toa < toa_min) {
+                toa_min = toa;
+            }
+        }
+        if (interval < toa_min) {
+            interval = toa_min;
+        }
+    } else {
+        interval = rxpoll->interval_us; /* lgw_receive error, unchanged */
+    }
+
+    bound = (rxpoll->max_us < (rxpoll->fill_us / 2)) ? rxpoll->max_us : (rxpoll->fill_us / 2);
+    if (interval > bound) {
+        interval = bound;
+    }
+    if (interval < rxpoll->min_us) {
+        interval = rxpoll->min_us;
+    }
+    rxpoll->interval_us = (uint32_t)interval;
+
+    return rxpoll->interval_us;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
 int lgw_send(struct lgw_pkt_tx_s pkt_data) {
+    uint8_t phase;
+    int x;
+
+    CHECK_START_BUSY();
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct hal_send_args_s args = {&pkt_data};
+        return lgw_worker_call(hal_send_job, &args, LGW_WORKER_PRIO_HIGH);
+    }
+
+    phase = lgw_reg_phase_set(LGW_REG_PHASE_SEND); /* register access statistics */
+    x = hal_send_impl(pkt_data);
+    lgw_reg_phase_set(phase);
+
+    return x;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int hal_send_impl(struct lgw_pkt_tx_s pkt_data) {
     int i, x;
     uint8_t buff[256+TX_METADATA_NB]; /* buffer to prepare the packet to send + metadata before SPI write burst */
     uint32_t part_int = 0; /* integer part for PLL register value calculation */
@@ -1423,15 +2729,15 @@ int lgw_send(struct lgw_pkt_tx_s pkt_data) {
     /* loading TX imbalance correction */
     target_mix_gain = txgain_lut.lut[pow_index].mix_gain;
     if (pkt_data.rf_chain == 0) { /* use radio A calibration table */
-        lgw_reg_w(LGW_TX_OFFSET_I, cal_offset_a_i[target_mix_gain - 8]);
-        lgw_reg_w(LGW_TX_OFFSET_Q, cal_offset_a_q[target_mix_gain - 8]);
+        LGW_REG_W(LGW_TX_OFFSET_I, cal_offset_a_i[target_mix_gain - 8]);
+        LGW_REG_W(LGW_TX_OFFSET_Q, cal_offset_a_q[target_mix_gain - 8]);
     } else { /* use radio B calibration table */
-        lgw_reg_w(LGW_TX_OFFSET_I, cal_offset_b_i[target_mix_gain - 8]);
-        lgw_reg_w(LGW_TX_OFFSET_Q, cal_offset_b_q[target_mix_gain - 8]);
+        LGW_REG_W(LGW_TX_OFFSET_I, cal_offset_b_i[target_mix_gain - 8]);
+        LGW_REG_W(LGW_TX_OFFSET_Q, cal_offset_b_q[target_mix_gain - 8]);
     }
 
     /* Set digital gain from LUT */
-    lgw_reg_w(LGW_TX_GAIN, txgain_lut.lut[pow_index].dig_gain);
+    LGW_REG_W(LGW_TX_GAIN, txgain_lut.lut[pow_index].dig_gain);
 
     /* fixed metadata, useful payload and misc metadata compositing */
     transfer_size = TX_METADATA_NB + pkt_data.size; /*  */
@@ -1587,7 +2893,7 @@ int lgw_send(struct lgw_pkt_tx_s pkt_data) {
     }
 
     /* Configure TX start delay based on TX notch filter */
-    lgw_reg_w(LGW_TX_START_DELAY, tx_start_delay);
+    LGW_REG_W(LGW_TX_START_DELAY, tx_start_delay);
 
     /* copy payload from user struct to buffer containing metadata */
     memcpy((void *)(buff + payload_offset), (void *)(pkt_data.payload), pkt_data.size);
@@ -1596,7 +2902,7 @@ int lgw_send(struct lgw_pkt_tx_s pkt_data) {
     lgw_abort_tx();
 
     /* put metadata + payload in the TX data buffer */
-    lgw_reg_w(LGW_TX_DATA_BUF_ADDR, 0);
+    LGW_REG_W(LGW_TX_DATA_BUF_ADDR, 0);
     lgw_reg_wb(LGW_TX_DATA_BUF_DATA, buff, transfer_size);
     DEBUG_ARRAY(i, transfer_size, buff);
 
@@ -1608,15 +2914,15 @@ int lgw_send(struct lgw_pkt_tx_s pkt_data) {
     if (tx_allowed == true) {
         switch(pkt_data.tx_mode) {
             case IMMEDIATE:
-                lgw_reg_w(LGW_TX_TRIG_IMMEDIATE, 1);
+                LGW_REG_W(LGW_TX_TRIG_IMMEDIATE, 1);
                 break;
 
             case TIMESTAMPED:
-                lgw_reg_w(LGW_TX_TRIG_DELAYED, 1);
+                LGW_REG_W(LGW_TX_TRIG_DELAYED, 1);
                 break;
 
             case ON_GPS:
-                lgw_reg_w(LGW_TX_TRIG_GPS, 1);
+                LGW_REG_W(LGW_TX_TRIG_GPS, 1);
                 break;
 
             default:
@@ -1634,13 +2940,21 @@ int lgw_send(struct lgw_pkt_tx_s pkt_data) {
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 int lgw_status(uint8_t select, uint8_t *code) {
-    int32_t read_value;
+    int32_t read_value = 0;
+
+    CHECK_START_BUSY();
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct hal_status_args_s args = {select, code};
+        return lgw_worker_call(hal_status_job, &args, LGW_WORKER_PRIO_HIGH);
+    }
 
     /* check input variables */
     CHECK_NULL(code);
 
     if (select == TX_STATUS) {
-        lgw_reg_r(LGW_TX_STATUS, &read_value);
+        LGW_REG_R(LGW_TX_STATUS, &read_value);
         if (lgw_is_started == false) {
             *code = TX_OFF;
         } else if ((read_value & 0x10) == 0) { /* bit 4 @1: TX programmed */
@@ -1668,7 +2982,14 @@ int lgw_status(uint8_t select, uint8_t *code) {
 int lgw_abort_tx(void) {
     int i;
 
-    i = lgw_reg_w(LGW_TX_TRIG_ALL, 0);
+    CHECK_START_BUSY();
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        return lgw_worker_call(hal_abort_tx_job, NULL, LGW_WORKER_PRIO_HIGH);
+    }
+
+    i = LGW_REG_W(LGW_TX_TRIG_ALL, 0);
 
     if (i == LGW_REG_SUCCESS) return LGW_HAL_SUCCESS;
     else return LGW_HAL_ERROR;
@@ -1679,8 +3000,19 @@ int lgw_abort_tx(void) {
 int lgw_get_trigcnt(uint32_t* trig_cnt_us) {
     int i;
     int32_t val;
+    uint8_t phase;
+
+    CHECK_START_BUSY();
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct hal_get_trigcnt_args_s args = {trig_cnt_us};
+        return lgw_worker_call(hal_get_trigcnt_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
 
-    i = lgw_reg_r(LGW_TIMESTAMP, &val);
+    phase = lgw_reg_phase_set(LGW_REG_PHASE_GPS); /* register access statistics */
+    i = LGW_REG_R(LGW_TIMESTAMP, &val);
+    lgw_reg_phase_set(phase);
     if (i == LGW_REG_SUCCESS) {
         *trig_cnt_us = (uint32_t)val;
         return LGW_HAL_SUCCESS;
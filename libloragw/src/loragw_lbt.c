@@ -42,6 +42,7 @@ Maintainer: Michael Coracin
 #endif
 
 #define LBT_TIMESTAMP_MASK  0x007FF000 /* 11-bits timestamp */
+#define LBT_READY_POLL_US   10000
 
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE TYPES -------------------------------------------------------- */
@@ -65,12 +66,15 @@ static int8_t lbt_rssi_target_dBm;
 static int8_t lbt_rssi_offset_dB;
 static uint32_t lbt_start_freq;
 static struct lgw_conf_lbt_chan_s lbt_channel_cfg[LBT_CHANNEL_FREQ_NB];
+static int32_t lbt_timestamp_start[LBT_CHANNEL_FREQ_NB]; /* channel timestamps when the FSM was started */
 
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE FUNCTIONS ---------------------------------------------------- */
 
 bool is_equal_freq(uint32_t a, uint32_t b);
 
+bool lbt_all_scanned(void *arg);
+
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC FUNCTIONS DEFINITION ------------------------------------------ */
 
@@ -203,6 +207,18 @@ int lbt_setup(void) {
 
 int lbt_start(void) {
     int x;
+    int i;
+
+    /* The FPGA is not reset by lgw_stop, so timestamps of a previous run are
+    still there on a restart: keep them to only accept the ones updated now */
+    for (i = 0; i < lbt_nb_active_channel; i++) {
+        x  = lgw_fpga_reg_w(LGW_FPGA_LBT_TIMESTAMP_SELECT_CH, i);
+        x |= lgw_fpga_reg_r(LGW_FPGA_LBT_TIMESTAMP_CH, &lbt_timestamp_start[i]);
+        if (x != LGW_REG_SUCCESS) {
+            DEBUG_MSG("ERROR: Failed to read LBT timestamps\n");
+            return LGW_LBT_ERROR;
+        }
+    }
 
     x = lgw_fpga_reg_w(LGW_FPGA_CTRL_FEATURE_START, 1);
     if (x != LGW_REG_SUCCESS) {
@@ -217,7 +233,7 @@ int lbt_start(void) {
 
 int lbt_is_channel_free(struct lgw_pkt_tx_s * pkt_data, uint16_t tx_start_delay, bool * tx_allowed) {
     int i;
-    int32_t val;
+    int32_t val = 0;
     uint32_t tx_start_time = 0;
     uint32_t tx_end_time = 0;
     uint32_t delta_time = 0;
@@ -229,18 +245,22 @@ int lbt_is_channel_free(struct lgw_pkt_tx_s * pkt_data, uint16_t tx_start_delay,
     int lbt_channel_decod_1 = -1;
     int lbt_channel_decod_2 = -1;
     uint32_t packet_duration = 0;
+    uint8_t phase;
 
     /* Check input parameters */
     if ((pkt_data == NULL) || (tx_allowed == NULL)) {
         return LGW_LBT_ERROR;
     }
 
+    phase = lgw_reg_phase_set(LGW_REG_PHASE_LBT); /* register access statistics */
+
     /* Check if TX is allowed */
     if (lbt_enable == true) {
         /* TX allowed for LoRa only */
         if (pkt_data->modulation != MOD_LORA) {
             *tx_allowed = false;
             DEBUG_PRINTF("INFO: TX is not allowed for this modulation (%x)\n", pkt_data->modulation);
+            lgw_reg_phase_set(phase);
             return LGW_LBT_SUCCESS;
         }
 
@@ -261,6 +281,7 @@ int lbt_is_channel_free(struct lgw_pkt_tx_s * pkt_data, uint16_t tx_start_delay,
                 DEBUG_MSG("ERROR: tx_mode IMMEDIATE is not supported when LBT is enabled\n");
                 /* FALLTHROUGH  */
             default:
+                lgw_reg_phase_set(phase);
                 return LGW_LBT_ERROR;
         }
 
@@ -303,13 +324,13 @@ int lbt_is_channel_free(struct lgw_pkt_tx_s * pkt_data, uint16_t tx_start_delay,
 
         /* Get last time when selected channel was free */
         if ((lbt_channel_decod_1 >= 0) && (lbt_channel_decod_2 >= 0)) {
-            lgw_fpga_reg_w(LGW_FPGA_LBT_TIMESTAMP_SELECT_CH, (int32_t)lbt_channel_decod_1);
-            lgw_fpga_reg_r(LGW_FPGA_LBT_TIMESTAMP_CH, &val);
+            LGW_FPGA_REG_W(LGW_FPGA_LBT_TIMESTAMP_SELECT_CH, (int32_t)lbt_channel_decod_1);
+            LGW_FPGA_REG_R(LGW_FPGA_LBT_TIMESTAMP_CH, &val);
             lbt_time = lbt_time1 = (uint32_t)(val & 0x0000FFFF) * 256; /* 16bits (1LSB = 256µs) */
 
             if (lbt_channel_decod_1 != lbt_channel_decod_2 ) {
-                lgw_fpga_reg_w(LGW_FPGA_LBT_TIMESTAMP_SELECT_CH, (int32_t)lbt_channel_decod_2);
-                lgw_fpga_reg_r(LGW_FPGA_LBT_TIMESTAMP_CH, &val);
+                LGW_FPGA_REG_W(LGW_FPGA_LBT_TIMESTAMP_SELECT_CH, (int32_t)lbt_channel_decod_2);
+                LGW_FPGA_REG_R(LGW_FPGA_LBT_TIMESTAMP_CH, &val);
                 lbt_time2 = (uint32_t)(val & 0x0000FFFF) * 256; /* 16bits (1LSB = 256µs) */
 
                 if (lbt_time2 < lbt_time1) {
@@ -356,6 +377,7 @@ int lbt_is_channel_free(struct lgw_pkt_tx_s * pkt_data, uint16_t tx_start_delay,
         *tx_allowed = true;
     }
 
+    lgw_reg_phase_set(phase);
     return LGW_LBT_SUCCESS;
 }
 
@@ -365,6 +387,21 @@ bool lbt_is_enabled(void) {
     return lbt_enable;
 }
 
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lbt_wait_ready(unsigned long timeout_ms) {
+    if (lbt_enable == false) {
+        return LGW_LBT_SUCCESS;
+    }
+
+    if (wait_cond(lbt_all_scanned, NULL, timeout_ms, LBT_READY_POLL_US) == false) {
+        DEBUG_PRINTF("WARNING: LBT channels not all scanned after %lu ms\n", timeout_ms);
+        return LGW_LBT_ERROR;
+    }
+
+    return LGW_LBT_SUCCESS;
+}
+
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE FUNCTIONS DEFINITION ----------------------------------------- */
 
@@ -388,4 +425,25 @@ bool is_equal_freq(uint32_t a, uint32_t b) {
     return false;
 }
 
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* The FPGA timestamp of a channel stays 0 until the FSM found it free once,
+after a reset. It is not cleared by a restart of the FSM, so a channel is only
+scanned once its timestamp differs from the one read by lbt_start */
+bool lbt_all_scanned(void *arg) {
+    int i;
+    int32_t val = 0;
+
+    (void)arg;
+    for (i = 0; i < lbt_nb_active_channel; i++) {
+        LGW_FPGA_REG_W(LGW_FPGA_LBT_TIMESTAMP_SELECT_CH, i);
+        LGW_FPGA_REG_R(LGW_FPGA_LBT_TIMESTAMP_CH, &val);
+        if ((val == 0) || (val == lbt_timestamp_start[i])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /* --- EOF ------------------------------------------------------------------ */
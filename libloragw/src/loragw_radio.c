@@ -31,6 +31,7 @@ Maintainer: Michael Coracin
 #include "loragw_hal.h"
 #include "loragw_radio.h"
 #include "loragw_fpga.h"
+#include "loragw_worker.h"
 
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE MACROS ------------------------------------------------------- */
@@ -69,10 +70,70 @@ struct lgw_radio_type_version_s {
     uint8_t reg_version;
 };
 
+/* arguments of the calls executed by the SPI worker thread */
+struct sx125x_setup_args_s {
+    uint8_t rf_chain;
+    uint8_t rf_clkout;
+    bool rf_enable;
+    uint8_t rf_radio_type;
+    uint32_t freq_hz;
+};
+
+struct sx125x_setup_all_args_s {
+    uint8_t rf_clkout;
+    const bool *rf_enable;
+    const enum lgw_radio_type_e *rf_radio_type;
+    const uint32_t *freq_hz;
+};
+
+struct sx125x_multi_args_s {
+    uint8_t rf_chain;
+    struct lgw_sx125x_reg_s *regs;
+    int nb_regs;
+};
+
+struct sx127x_w_args_s {
+    uint8_t address;
+    uint8_t reg_value;
+};
+
+struct sx127x_r_args_s {
+    uint8_t address;
+    uint8_t *reg_value;
+};
+
+struct sx127x_setup_args_s {
+    uint32_t frequency;
+    uint8_t modulation;
+    enum lgw_sx127x_rxbw_e rxbw_khz;
+    int8_t rssi_offset;
+};
+
+struct sx127x_retune_args_s {
+    uint32_t frequency;
+    enum lgw_sx127x_rxbw_e rxbw_khz;
+};
+
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE CONSTANTS ---------------------------------------------------- */
 
 #define PLL_LOCK_MAX_ATTEMPTS 5
+#define PLL_LOCK_SETTLE_MS      1   /* before the first poll, the lock bit of the previous state may still be set */
+#define PLL_LOCK_TIMEOUT_MS     100 /* per attempt */
+#define PLL_LOCK_POLL_US        100
+
+#define SX125X_SETUP_SEQ_MAX    (LGW_RF_CHAIN_NB * 48) /* bridge registers writes to configure all the radios */
+#define SX125X_QUEUE_W_SIZE     4   /* bridge registers accesses of a SX125x register write */
+#define SX125X_QUEUE_R_SIZE     5   /* bridge registers accesses of a SX125x register read */
+
+#define SX127X_RETUNE_TIMEOUT_MS    10  /* mode change, or PLL lock and RX start after a frequency change */
+#define SX127X_RETUNE_POLL_US       50
+
+/* SX1301 SPI master registers, for each radio */
+static const uint16_t sx125x_bridge_addr[LGW_RF_CHAIN_NB] = {LGW_SPI_RADIO_A__ADDR, LGW_SPI_RADIO_B__ADDR};
+static const uint16_t sx125x_bridge_data[LGW_RF_CHAIN_NB] = {LGW_SPI_RADIO_A__DATA, LGW_SPI_RADIO_B__DATA};
+static const uint16_t sx125x_bridge_cs[LGW_RF_CHAIN_NB] = {LGW_SPI_RADIO_A__CS, LGW_SPI_RADIO_B__CS};
+static const uint16_t sx125x_bridge_rb[LGW_RF_CHAIN_NB] = {LGW_SPI_RADIO_A__DATA_READBACK, LGW_SPI_RADIO_B__DATA_READBACK};
 
 const struct lgw_sx127x_FSK_bandwidth_s sx127x_FskBandwidths[] =
 {
@@ -104,10 +165,14 @@ const struct lgw_sx127x_FSK_bandwidth_s sx127x_FskBandwidths[] =
 
 extern void *lgw_spi_target; /*! generic pointer to the SPI device */
 
+static enum lgw_radio_type_e sx127x_radio_type = LGW_RADIO_TYPE_NONE; /*! SX127x found by the last lgw_setup_sx127x */
+static enum lgw_sx127x_rxbw_e sx127x_rxbw; /*! RX bandwidth currently set in the SX127x */
+
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE FUNCTIONS ---------------------------------------------------- */
 
-void sx125x_write(uint8_t channel, uint8_t addr, uint8_t data);
+int sx125x_queue(struct lgw_reg_val_s *seq, int nb, uint8_t channel, uint8_t addr, uint8_t data);
+int sx125x_queue_r(struct lgw_reg_val_s *seq, int nb, uint8_t channel, uint8_t addr);
 uint8_t sx125x_read(uint8_t channel, uint8_t addr);
 
 int setup_sx1272_FSK(uint32_t frequency, enum lgw_sx127x_rxbw_e rxbw_khz, int8_t rssi_offset);
@@ -115,97 +180,186 @@ int setup_sx1276_FSK(uint32_t frequency, enum lgw_sx127x_rxbw_e rxbw_khz, int8_t
 
 int reset_sx127x(enum lgw_radio_type_e radio_type);
 
+bool sx125x_pll_locked(void *arg);
+int sx125x_setup_queue(struct lgw_reg_val_s *seq, int nb, uint8_t rf_chain, uint8_t rf_clkout, bool rf_enable, uint8_t rf_radio_type, uint32_t freq_hz);
+int sx125x_pll_start(uint8_t rf_mask);
+
+bool sx127x_fs_ready(void *arg);
+bool sx127x_rx_ready(void *arg);
+
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE FUNCTIONS DEFINITION ----------------------------------------- */
 
-void sx125x_write(uint8_t channel, uint8_t addr, uint8_t data) {
-    int reg_add, reg_dat, reg_cs;
+/* bridge registers writes of a SX125x register access, chip select expected low before */
+int sx125x_queue(struct lgw_reg_val_s *seq, int nb, uint8_t channel, uint8_t addr, uint8_t data) {
+    /* SPI master transaction, on the rising edge of the chip select */
+    seq[nb].register_id = sx125x_bridge_addr[channel];
+    seq[nb++].value = addr;
+    seq[nb].register_id = sx125x_bridge_data[channel];
+    seq[nb++].value = data;
+    seq[nb].register_id = sx125x_bridge_cs[channel];
+    seq[nb++].value = 1;
+    seq[nb].register_id = sx125x_bridge_cs[channel];
+    seq[nb++].value = 0;
+
+    return nb;
+}
 
-    /* checking input parameters */
-    if (channel >= LGW_RF_CHAIN_NB) {
-        DEBUG_MSG("ERROR: INVALID RF_CHAIN\n");
-        return;
-    }
-    if (addr >= 0x7F) {
-        DEBUG_MSG("ERROR: ADDRESS OUT OF RANGE\n");
-        return;
-    }
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-    /* selecting the target radio */
-    switch (channel) {
-        case 0:
-            reg_add = LGW_SPI_RADIO_A__ADDR;
-            reg_dat = LGW_SPI_RADIO_A__DATA;
-            reg_cs  = LGW_SPI_RADIO_A__CS;
-            break;
+/* same as sx125x_queue for a read, the read-back register is the last element (SX125X_QUEUE_R_SIZE) */
+int sx125x_queue_r(struct lgw_reg_val_s *seq, int nb, uint8_t channel, uint8_t addr) {
+    nb = sx125x_queue(seq, nb, channel, addr, 0); /* MSB at 0 for read operation */
+    seq[nb].register_id = sx125x_bridge_rb[channel];
+    seq[nb++].value = 0;
 
-        case 1:
-            reg_add = LGW_SPI_RADIO_B__ADDR;
-            reg_dat = LGW_SPI_RADIO_B__DATA;
-            reg_cs  = LGW_SPI_RADIO_B__CS;
-            break;
+    return nb;
+}
 
-        default:
-            DEBUG_PRINTF("ERROR: UNEXPECTED VALUE %d IN SWITCH STATEMENT\n", channel);
-            return;
-    }
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-    /* SPI master data write procedure */
-    lgw_reg_w(reg_cs, 0);
-    lgw_reg_w(reg_add, 0x80 | addr); /* MSB at 1 for write operation */
-    lgw_reg_w(reg_dat, data);
-    lgw_reg_w(reg_cs, 1);
-    lgw_reg_w(reg_cs, 0);
+uint8_t sx125x_read(uint8_t channel, uint8_t addr) {
+    uint8_t read_value = 0;
+
+    lgw_sx125x_reg_r(channel, addr, &read_value);
 
-    return;
+    return read_value;
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-uint8_t sx125x_read(uint8_t channel, uint8_t addr) {
-    int reg_add, reg_dat, reg_cs, reg_rb;
-    int32_t read_value;
-
-    /* checking input parameters */
-    if (channel >= LGW_RF_CHAIN_NB) {
-        DEBUG_MSG("ERROR: INVALID RF_CHAIN\n");
-        return 0;
+/* polling condition, arg points to the mask of the RF chains waiting for their PLL lock */
+bool sx125x_pll_locked(void *arg) {
+    struct lgw_reg_val_s seq[LGW_RF_CHAIN_NB * (1 + SX125X_QUEUE_R_SIZE)];
+    int pos[LGW_RF_CHAIN_NB];
+    uint8_t *rf_mask = arg;
+    int i, nb = 0;
+
+    /* status of all the radios still waiting, in a single SPI transaction */
+    for (i = 0; i < LGW_RF_CHAIN_NB; ++i) {
+        if ((*rf_mask & (1 << i)) != 0) {
+            seq[nb].register_id = sx125x_bridge_cs[i];
+            seq[nb++].value = 0;
+            nb = sx125x_queue_r(seq, nb, i, 0x11);
+            pos[i] = nb - 1;
+        }
     }
-    if (addr >= 0x7F) {
-        DEBUG_MSG("ERROR: ADDRESS OUT OF RANGE\n");
-        return 0;
+    if (lgw_reg_seq(seq, nb) != LGW_REG_SUCCESS) {
+        return false;
     }
+    for (i = 0; i < LGW_RF_CHAIN_NB; ++i) {
+        if (((*rf_mask & (1 << i)) != 0) && ((seq[pos[i]].value & 0x02) != 0)) {
+            *rf_mask &= ~(1 << i);
+        }
+    }
+    return (*rf_mask == 0);
+}
 
-    /* selecting the target radio */
-    switch (channel) {
-        case 0:
-            reg_add = LGW_SPI_RADIO_A__ADDR;
-            reg_dat = LGW_SPI_RADIO_A__DATA;
-            reg_cs  = LGW_SPI_RADIO_A__CS;
-            reg_rb  = LGW_SPI_RADIO_A__DATA_READBACK;
-            break;
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-        case 1:
-            reg_add = LGW_SPI_RADIO_B__ADDR;
-            reg_dat = LGW_SPI_RADIO_B__DATA;
-            reg_cs  = LGW_SPI_RADIO_B__CS;
-            reg_rb  = LGW_SPI_RADIO_B__DATA_READBACK;
-            break;
+int sx125x_setup_queue(struct lgw_reg_val_s *seq, int nb, uint8_t rf_chain, uint8_t rf_clkout, bool rf_enable, uint8_t rf_radio_type, uint32_t freq_hz) {
+    uint32_t part_int = 0;
+    uint32_t part_frac = 0;
+
+    /* Get version to identify SX1255/57 silicon revision */
+    DEBUG_PRINTF("Note: SX125x #%d version register returned 0x%02x\n", rf_chain, sx125x_read(rf_chain, 0x07));
+
+    /* chip select of the SPI master low before the first transaction */
+    seq[nb].register_id = sx125x_bridge_cs[rf_chain];
+    seq[nb++].value = 0;
+
+    /* General radio setup */
+    if (rf_clkout == rf_chain) {
+        nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x10, SX125x_TX_DAC_CLK_SEL + 2);
+        DEBUG_PRINTF("Note: SX125x #%d clock output enabled\n", rf_chain);
+    } else {
+        nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x10, SX125x_TX_DAC_CLK_SEL);
+        DEBUG_PRINTF("Note: SX125x #%d clock output disabled\n", rf_chain);
+    }
 
+    switch (rf_radio_type) {
+        case LGW_RADIO_TYPE_SX1255:
+            nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x28, SX125x_XOSC_GM_STARTUP + SX125x_XOSC_DISABLE*16);
+            break;
+        case LGW_RADIO_TYPE_SX1257:
+            nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x26, SX125x_XOSC_GM_STARTUP + SX125x_XOSC_DISABLE*16);
+            break;
         default:
-            DEBUG_PRINTF("ERROR: UNEXPECTED VALUE %d IN SWITCH STATEMENT\n", channel);
-            return 0;
+            DEBUG_PRINTF("ERROR: UNEXPECTED VALUE %d FOR RADIO TYPE\n", rf_radio_type);
+            break;
+    }
+
+    if (rf_enable == true) {
+        /* Tx gain and trim */
+        nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x08, SX125x_TX_MIX_GAIN + SX125x_TX_DAC_GAIN*16);
+        nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x0A, SX125x_TX_ANA_BW + SX125x_TX_PLL_BW*32);
+        nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x0B, SX125x_TX_DAC_BW);
+
+        /* Rx gain and trim */
+        nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x0C, SX125x_LNA_ZIN + SX125x_RX_BB_GAIN*2 + SX125x_RX_LNA_GAIN*32);
+        nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x0D, SX125x_RX_BB_BW + SX125x_RX_ADC_TRIM*4 + SX125x_RX_ADC_BW*32);
+        nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x0E, SX125x_ADC_TEMP + SX125x_RX_PLL_BW*2);
+
+        /* set RX PLL frequency */
+        switch (rf_radio_type) {
+            case LGW_RADIO_TYPE_SX1255:
+                part_int = freq_hz / (SX125x_32MHz_FRAC << 7); /* integer part, gives the MSB */
+                part_frac = ((freq_hz % (SX125x_32MHz_FRAC << 7)) << 9) / SX125x_32MHz_FRAC; /* fractional part, gives middle part and LSB */
+                break;
+            case LGW_RADIO_TYPE_SX1257:
+                part_int = freq_hz / (SX125x_32MHz_FRAC << 8); /* integer part, gives the MSB */
+                part_frac = ((freq_hz % (SX125x_32MHz_FRAC << 8)) << 8) / SX125x_32MHz_FRAC; /* fractional part, gives middle part and LSB */
+                break;
+            default:
+                DEBUG_PRINTF("ERROR: UNEXPECTED VALUE %d FOR RADIO TYPE\n", rf_radio_type);
+                break;
+        }
+
+        nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x01, 0xFF & part_int); /* Most Significant Byte */
+        nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x02, 0xFF & (part_frac >> 8)); /* middle byte */
+        nb = sx125x_queue(seq, nb, rf_chain, 0x80 | 0x03, 0xFF & part_frac); /* Least Significant Byte */
+    } else {
+        DEBUG_PRINTF("Note: SX125x #%d kept in standby mode\n", rf_chain);
+    }
+
+    return nb;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int sx125x_pll_start(uint8_t rf_mask) {
+    struct lgw_reg_val_s seq[LGW_RF_CHAIN_NB * 8];
+    uint8_t pending = rf_mask;
+    int cpt_attempts = 0;
+    int i, nb;
+
+    if (pending == 0) {
+        return 0;
     }
 
-    /* SPI master data read procedure */
-    lgw_reg_w(reg_cs, 0);
-    lgw_reg_w(reg_add, addr); /* MSB at 0 for read operation */
-    lgw_reg_w(reg_dat, 0);
-    lgw_reg_w(reg_cs, 1);
-    lgw_reg_w(reg_cs, 0);
-    lgw_reg_r(reg_rb, &read_value);
+    /* start and PLL lock, the radios not locked yet are restarted together */
+    do {
+        if (cpt_attempts >= PLL_LOCK_MAX_ATTEMPTS) {
+            DEBUG_PRINTF("ERROR: FAIL TO LOCK PLL (RF chains mask 0x%02x)\n", pending);
+            return -1;
+        }
+        nb = 0;
+        for (i = 0; i < LGW_RF_CHAIN_NB; ++i) {
+            if ((pending & (1 << i)) != 0) {
+                nb = sx125x_queue(seq, nb, i, 0x80 | 0x00, 1); /* enable Xtal oscillator */
+                nb = sx125x_queue(seq, nb, i, 0x80 | 0x00, 3); /* Enable RX (PLL+FE) */
+            }
+        }
+        if (lgw_reg_w_seq(seq, nb) != LGW_REG_SUCCESS) {
+            DEBUG_MSG("ERROR: FAIL TO START PLL\n");
+            return -1;
+        }
+        ++cpt_attempts;
+        DEBUG_PRINTF("Note: SX125x PLL start (RF chains mask 0x%02x, attempt %d)\n", pending, cpt_attempts);
+        wait_ms(PLL_LOCK_SETTLE_MS);
+    } while (wait_cond(sx125x_pll_locked, &pending, PLL_LOCK_TIMEOUT_MS, PLL_LOCK_POLL_US) == false);
 
-    return (uint8_t)read_value;
+    return 0;
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
@@ -390,101 +544,283 @@ int reset_sx127x(enum lgw_radio_type_e radio_type) {
     return LGW_REG_SUCCESS;
 }
 
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* polling condition, PLL locked and receiver ready (same register on SX1272 and SX1276) */
+bool sx127x_rx_ready(void *arg) {
+    uint8_t reg_val = 0;
+
+    (void)arg;
+    if (lgw_sx127x_reg_r(SX1276_REG_IRQFLAGS1, &reg_val) != LGW_SPI_SUCCESS) {
+        return false;
+    }
+    return ((TAKE_N_BITS_FROM(reg_val, 6, 1) == 1) && (TAKE_N_BITS_FROM(reg_val, 4, 1) == 1));
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* SX127x out of RX mode: ModeReady set, RxReady cleared (same register for SX1272 and SX1276) */
+bool sx127x_fs_ready(void *arg) {
+    uint8_t reg_val = 0;
+
+    (void)arg;
+    if (lgw_sx127x_reg_r(SX1276_REG_IRQFLAGS1, &reg_val) != LGW_SPI_SUCCESS) {
+        return false;
+    }
+    return ((TAKE_N_BITS_FROM(reg_val, 7, 1) == 1) && (TAKE_N_BITS_FROM(reg_val, 6, 1) == 0));
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sx125x_setup_job(void *arg) {
+    struct sx125x_setup_args_s *a = arg;
+    return lgw_setup_sx125x(a->rf_chain, a->rf_clkout, a->rf_enable, a->rf_radio_type, a->freq_hz);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sx125x_setup_all_job(void *arg) {
+    struct sx125x_setup_all_args_s *a = arg;
+    return lgw_setup_sx125x_all(a->rf_clkout, a->rf_enable, a->rf_radio_type, a->freq_hz);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sx125x_w_multi_job(void *arg) {
+    struct sx125x_multi_args_s *a = arg;
+    return lgw_sx125x_reg_w_multi(a->rf_chain, a->regs, a->nb_regs);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sx125x_r_multi_job(void *arg) {
+    struct sx125x_multi_args_s *a = arg;
+    return lgw_sx125x_reg_r_multi(a->rf_chain, a->regs, a->nb_regs);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sx127x_w_job(void *arg) {
+    struct sx127x_w_args_s *a = arg;
+    return lgw_sx127x_reg_w(a->address, a->reg_value);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sx127x_r_job(void *arg) {
+    struct sx127x_r_args_s *a = arg;
+    return lgw_sx127x_reg_r(a->address, a->reg_value);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sx127x_setup_job(void *arg) {
+    struct sx127x_setup_args_s *a = arg;
+    return lgw_setup_sx127x(a->frequency, a->modulation, a->rxbw_khz, a->rssi_offset);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sx127x_retune_job(void *arg) {
+    struct sx127x_retune_args_s *a = arg;
+    return lgw_sx127x_retune(a->frequency, a->rxbw_khz);
+}
+
 /* -------------------------------------------------------------------------- */
 /* --- PUBLIC FUNCTIONS DEFINITION ------------------------------------------ */
 
 int lgw_setup_sx125x(uint8_t rf_chain, uint8_t rf_clkout, bool rf_enable, uint8_t rf_radio_type, uint32_t freq_hz) {
-    uint32_t part_int = 0;
-    uint32_t part_frac = 0;
-    int cpt_attempts = 0;
+    struct lgw_reg_val_s seq[SX125X_SETUP_SEQ_MAX];
+    int nb;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct sx125x_setup_args_s args = {rf_chain, rf_clkout, rf_enable, rf_radio_type, freq_hz};
+        return lgw_worker_call(sx125x_setup_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
 
     if (rf_chain >= LGW_RF_CHAIN_NB) {
         DEBUG_MSG("ERROR: INVALID RF_CHAIN\n");
         return -1;
     }
 
-    /* Get version to identify SX1255/57 silicon revision */
-    DEBUG_PRINTF("Note: SX125x #%d version register returned 0x%02x\n", rf_chain, sx125x_read(rf_chain, 0x07));
+    nb = sx125x_setup_queue(seq, 0, rf_chain, rf_clkout, rf_enable, rf_radio_type, freq_hz);
+    if (lgw_reg_w_seq(seq, nb) != LGW_REG_SUCCESS) {
+        DEBUG_MSG("ERROR: FAIL TO CONFIGURE RADIO\n");
+        return -1;
+    }
 
-    /* General radio setup */
-    if (rf_clkout == rf_chain) {
-        sx125x_write(rf_chain, 0x10, SX125x_TX_DAC_CLK_SEL + 2);
-        DEBUG_PRINTF("Note: SX125x #%d clock output enabled\n", rf_chain);
-    } else {
-        sx125x_write(rf_chain, 0x10, SX125x_TX_DAC_CLK_SEL);
-        DEBUG_PRINTF("Note: SX125x #%d clock output disabled\n", rf_chain);
+    return sx125x_pll_start((rf_enable == true) ? (1 << rf_chain) : 0);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_setup_sx125x_all(uint8_t rf_clkout, const bool *rf_enable, const enum lgw_radio_type_e *rf_radio_type, const uint32_t *freq_hz) {
+    struct lgw_reg_val_s seq[SX125X_SETUP_SEQ_MAX];
+    uint8_t rf_mask = 0;
+    int i, nb = 0;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct sx125x_setup_all_args_s args = {rf_clkout, rf_enable, rf_radio_type, freq_hz};
+        return lgw_worker_call(sx125x_setup_all_job, &args, LGW_WORKER_PRIO_NORMAL);
     }
 
-    switch (rf_radio_type) {
-        case LGW_RADIO_TYPE_SX1255:
-            sx125x_write(rf_chain, 0x28, SX125x_XOSC_GM_STARTUP + SX125x_XOSC_DISABLE*16);
-            break;
-        case LGW_RADIO_TYPE_SX1257:
-            sx125x_write(rf_chain, 0x26, SX125x_XOSC_GM_STARTUP + SX125x_XOSC_DISABLE*16);
-            break;
-        default:
-            DEBUG_PRINTF("ERROR: UNEXPECTED VALUE %d FOR RADIO TYPE\n", rf_radio_type);
-            break;
+    CHECK_NULL(rf_enable);
+    CHECK_NULL(rf_radio_type);
+    CHECK_NULL(freq_hz);
+
+    /* configuration of all the radios in a single SPI transaction */
+    for (i = 0; i < LGW_RF_CHAIN_NB; ++i) {
+        nb = sx125x_setup_queue(seq, nb, i, rf_clkout, rf_enable[i], rf_radio_type[i], freq_hz[i]);
+        if (rf_enable[i] == true) {
+            rf_mask |= (1 << i);
+        }
+    }
+    if (lgw_reg_w_seq(seq, nb) != LGW_REG_SUCCESS) {
+        DEBUG_MSG("ERROR: FAIL TO CONFIGURE RADIOS\n");
+        return -1;
     }
 
-    if (rf_enable == true) {
-        /* Tx gain and trim */
-        sx125x_write(rf_chain, 0x08, SX125x_TX_MIX_GAIN + SX125x_TX_DAC_GAIN*16);
-        sx125x_write(rf_chain, 0x0A, SX125x_TX_ANA_BW + SX125x_TX_PLL_BW*32);
-        sx125x_write(rf_chain, 0x0B, SX125x_TX_DAC_BW);
+    /* PLLs started together, and their locks polled in the same loop */
+    return sx125x_pll_start(rf_mask);
+}
 
-        /* Rx gain and trim */
-        sx125x_write(rf_chain, 0x0C, SX125x_LNA_ZIN + SX125x_RX_BB_GAIN*2 + SX125x_RX_LNA_GAIN*32);
-        sx125x_write(rf_chain, 0x0D, SX125x_RX_BB_BW + SX125x_RX_ADC_TRIM*4 + SX125x_RX_ADC_BW*32);
-        sx125x_write(rf_chain, 0x0E, SX125x_ADC_TEMP + SX125x_RX_PLL_BW*2);
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-        /* set RX PLL frequency */
-        switch (rf_radio_type) {
-            case LGW_RADIO_TYPE_SX1255:
-                part_int = freq_hz / (SX125x_32MHz_FRAC << 7); /* integer part, gives the MSB */
-                part_frac = ((freq_hz % (SX125x_32MHz_FRAC << 7)) << 9) / SX125x_32MHz_FRAC; /* fractional part, gives middle part and LSB */
-                break;
-            case LGW_RADIO_TYPE_SX1257:
-                part_int = freq_hz / (SX125x_32MHz_FRAC << 8); /* integer part, gives the MSB */
-                part_frac = ((freq_hz % (SX125x_32MHz_FRAC << 8)) << 8) / SX125x_32MHz_FRAC; /* fractional part, gives middle part and LSB */
-                break;
-            default:
-                DEBUG_PRINTF("ERROR: UNEXPECTED VALUE %d FOR RADIO TYPE\n", rf_radio_type);
-                break;
+int lgw_sx125x_reg_w(uint8_t rf_chain, uint8_t address, uint8_t reg_value) {
+    struct lgw_sx125x_reg_s reg = {address, reg_value};
+
+    return lgw_sx125x_reg_w_multi(rf_chain, &reg, 1);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_sx125x_reg_r(uint8_t rf_chain, uint8_t address, uint8_t *reg_value) {
+    struct lgw_sx125x_reg_s reg = {address, 0};
+    int x;
+
+    CHECK_NULL(reg_value);
+
+    x = lgw_sx125x_reg_r_multi(rf_chain, &reg, 1);
+    *reg_value = reg.value;
+
+    return x;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_sx125x_reg_w_multi(uint8_t rf_chain, const struct lgw_sx125x_reg_s *regs, int nb_regs) {
+    struct lgw_reg_val_s seq[LGW_REG_MULTI_MAX];
+    int i, nb;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct sx125x_multi_args_s args = {rf_chain, (struct lgw_sx125x_reg_s *)regs, nb_regs};
+        return lgw_worker_call(sx125x_w_multi_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
+    /* checking input parameters */
+    CHECK_NULL(regs);
+    if (rf_chain >= LGW_RF_CHAIN_NB) {
+        DEBUG_MSG("ERROR: INVALID RF_CHAIN\n");
+        return LGW_REG_ERROR;
+    }
+    for (i = 0; i < nb_regs; ++i) {
+        if (regs[i].address > 0x7F) {
+            DEBUG_MSG("ERROR: ADDRESS OUT OF RANGE\n");
+            return LGW_REG_ERROR;
+        }
+    }
+
+    /* SPI master data write procedures, as many as possible in each SPI transaction */
+    for (i = 0, nb = 0; i < nb_regs; ++i) {
+        if (nb == 0) {
+            seq[nb].register_id = sx125x_bridge_cs[rf_chain];
+            seq[nb++].value = 0;
+        }
+        nb = sx125x_queue(seq, nb, rf_chain, 0x80 | regs[i].address, regs[i].value); /* MSB at 1 for write operation */
+        if ((i == (nb_regs - 1)) || ((nb + SX125X_QUEUE_W_SIZE) > LGW_REG_MULTI_MAX)) {
+            if (lgw_reg_w_seq(seq, nb) != LGW_REG_SUCCESS) {
+                DEBUG_MSG("ERROR: FAIL TO WRITE SX125X REGISTERS\n");
+                return LGW_REG_ERROR;
+            }
+            nb = 0;
         }
+    }
+
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_sx125x_reg_r_multi(uint8_t rf_chain, struct lgw_sx125x_reg_s *regs, int nb_regs) {
+    struct lgw_reg_val_s seq[LGW_REG_MULTI_MAX];
+    int i, j, nb, first;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct sx125x_multi_args_s args = {rf_chain, regs, nb_regs};
+        return lgw_worker_call(sx125x_r_multi_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
 
-        sx125x_write(rf_chain, 0x01,0xFF & part_int); /* Most Significant Byte */
-        sx125x_write(rf_chain, 0x02,0xFF & (part_frac >> 8)); /* middle byte */
-        sx125x_write(rf_chain, 0x03,0xFF & part_frac); /* Least Significant Byte */
+    /* checking input parameters */
+    CHECK_NULL(regs);
+    if (rf_chain >= LGW_RF_CHAIN_NB) {
+        DEBUG_MSG("ERROR: INVALID RF_CHAIN\n");
+        return LGW_REG_ERROR;
+    }
+    for (i = 0; i < nb_regs; ++i) {
+        if (regs[i].address > 0x7F) {
+            DEBUG_MSG("ERROR: ADDRESS OUT OF RANGE\n");
+            return LGW_REG_ERROR;
+        }
+    }
 
-        /* start and PLL lock */
-        do {
-            if (cpt_attempts >= PLL_LOCK_MAX_ATTEMPTS) {
-                DEBUG_MSG("ERROR: FAIL TO LOCK PLL\n");
-                return -1;
+    /* SPI master data read procedures, each followed by the read of its result */
+    for (i = 0, nb = 0, first = 0; i < nb_regs; ++i) {
+        if (nb == 0) {
+            seq[nb].register_id = sx125x_bridge_cs[rf_chain];
+            seq[nb++].value = 0;
+            first = i;
+        }
+        nb = sx125x_queue_r(seq, nb, rf_chain, regs[i].address);
+        if ((i == (nb_regs - 1)) || ((nb + SX125X_QUEUE_R_SIZE) > LGW_REG_MULTI_MAX)) {
+            if (lgw_reg_seq(seq, nb) != LGW_REG_SUCCESS) {
+                DEBUG_MSG("ERROR: FAIL TO READ SX125X REGISTERS\n");
+                return LGW_REG_ERROR;
             }
-            sx125x_write(rf_chain, 0x00, 1); /* enable Xtal oscillator */
-            sx125x_write(rf_chain, 0x00, 3); /* Enable RX (PLL+FE) */
-            ++cpt_attempts;
-            DEBUG_PRINTF("Note: SX125x #%d PLL start (attempt %d)\n", rf_chain, cpt_attempts);
-            wait_ms(1);
-        } while((sx125x_read(rf_chain, 0x11) & 0x02) == 0);
-    } else {
-        DEBUG_PRINTF("Note: SX125x #%d kept in standby mode\n", rf_chain);
+            for (j = first; j <= i; ++j) {
+                regs[j].value = (uint8_t)seq[(j - first + 1) * SX125X_QUEUE_R_SIZE].value;
+            }
+            nb = 0;
+        }
     }
 
-    return 0;
+    return LGW_REG_SUCCESS;
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 int lgw_sx127x_reg_w(uint8_t address, uint8_t reg_value) {
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct sx127x_w_args_s args = {address, reg_value};
+        return lgw_worker_call(sx127x_w_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
     return lgw_spi_w(lgw_spi_target, LGW_SPI_MUX_MODE1, LGW_SPI_MUX_TARGET_SX127X, address, reg_value);
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 int lgw_sx127x_reg_r(uint8_t address, uint8_t *reg_value) {
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct sx127x_r_args_s args = {address, reg_value};
+        return lgw_worker_call(sx127x_r_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
     return lgw_spi_r(lgw_spi_target, LGW_SPI_MUX_MODE1, LGW_SPI_MUX_TARGET_SX127X, address, reg_value);
 }
 
@@ -499,6 +835,12 @@ int lgw_setup_sx127x(uint32_t frequency, uint8_t modulation, enum lgw_sx127x_rxb
         {LGW_RADIO_TYPE_SX1276, 0x12}
     };
 
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct sx127x_setup_args_s args = {frequency, modulation, rxbw_khz, rssi_offset};
+        return lgw_worker_call(sx127x_setup_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
     /* Check parameters */
     if (modulation != MOD_FSK) {
         DEBUG_PRINTF("ERROR: modulation not supported for SX127x (%u)\n", modulation);
@@ -553,8 +895,81 @@ int lgw_setup_sx127x(uint32_t frequency, uint8_t modulation, enum lgw_sx127x_rxb
     }
     if (x != LGW_REG_SUCCESS) {
         DEBUG_MSG("ERROR: failed to setup SX127x\n");
+        sx127x_radio_type = LGW_RADIO_TYPE_NONE;
         return x;
     }
+    sx127x_radio_type = radio_type;
+    sx127x_rxbw = rxbw_khz;
+
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_sx127x_retune(uint32_t frequency, enum lgw_sx127x_rxbw_e rxbw_khz) {
+    uint64_t freq_reg;
+    uint8_t frf[3];
+    uint8_t reg_frf, reg_rxbw, reg_opmode;
+    int x;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct sx127x_retune_args_s args = {frequency, rxbw_khz};
+        return lgw_worker_call(sx127x_retune_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
+    /* Check parameters */
+    if (sx127x_radio_type == LGW_RADIO_TYPE_NONE) {
+        DEBUG_MSG("ERROR: SX127x not configured, lgw_setup_sx127x must be called first\n");
+        return LGW_REG_ERROR;
+    }
+    if (rxbw_khz > LGW_SX127X_RXBW_250K_HZ) {
+        DEBUG_PRINTF("ERROR: RX bandwidth not supported for SX127x (%u)\n", rxbw_khz);
+        return LGW_REG_ERROR;
+    }
+    if (sx127x_radio_type == LGW_RADIO_TYPE_SX1272) {
+        reg_frf = SX1272_REG_FRFMSB;
+        reg_rxbw = SX1272_REG_RXBW;
+        reg_opmode = SX1272_REG_OPMODE;
+    } else {
+        reg_frf = SX1276_REG_FRFMSB;
+        reg_rxbw = SX1276_REG_RXBW;
+        reg_opmode = SX1276_REG_OPMODE;
+    }
+
+    /* leave RX for frequency synthesis, so that the RX flags of the previous frequency are cleared */
+    x = lgw_sx127x_reg_w(reg_opmode, 4); /* FS RX mode, no FSK shaping */
+
+    /* Set RF carrier frequency in one burst, applied when the LSB is written (PllHop set by the setup) */
+    freq_reg = ((uint64_t)frequency << 19) / (uint64_t)32000000;
+    frf[0] = (uint8_t)(freq_reg >> 16);
+    frf[1] = (uint8_t)(freq_reg >> 8);
+    frf[2] = (uint8_t)(freq_reg >> 0);
+    x |= lgw_spi_wb(lgw_spi_target, LGW_SPI_MUX_MODE1, LGW_SPI_MUX_TARGET_SX127X, reg_frf, frf, sizeof frf);
+
+    /* RX bandwidth, only if it changes */
+    if (rxbw_khz != sx127x_rxbw) {
+        x |= lgw_sx127x_reg_w(reg_rxbw, sx127x_FskBandwidths[rxbw_khz].RxBwExp | (sx127x_FskBandwidths[rxbw_khz].RxBwMant << 3));
+    }
+    if (x != LGW_SPI_SUCCESS) {
+        DEBUG_MSG("ERROR: Failed to retune SX127x\n");
+        return LGW_REG_ERROR;
+    }
+    sx127x_rxbw = rxbw_khz;
+    if (wait_cond(sx127x_fs_ready, NULL, SX127X_RETUNE_TIMEOUT_MS, SX127X_RETUNE_POLL_US) == false) {
+        DEBUG_MSG("ERROR: SX127x did not leave RX mode\n");
+        return LGW_REG_ERROR;
+    }
+
+    /* back to RX, ready once the PLL is locked on the new frequency (AGC disabled by the setup) */
+    if (lgw_sx127x_reg_w(reg_opmode, 5) != LGW_SPI_SUCCESS) { /* Receiver mode, no FSK shaping */
+        DEBUG_MSG("ERROR: Failed to retune SX127x\n");
+        return LGW_REG_ERROR;
+    }
+    if (wait_cond(sx127x_rx_ready, NULL, SX127X_RETUNE_TIMEOUT_MS, SX127X_RETUNE_POLL_US) == false) {
+        DEBUG_MSG("ERROR: SX127x PLL not locked after retune\n");
+        return LGW_REG_ERROR;
+    }
 
     return LGW_REG_SUCCESS;
 }
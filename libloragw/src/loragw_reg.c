@@ -23,10 +23,12 @@ Maintainer: Sylvain Miermont
 #include <stdint.h>     /* C99 types */
 #include <stdbool.h>    /* bool type */
 #include <stdio.h>      /* printf fprintf */
+#include <string.h>     /* memset, memcpy */
 
 #include "loragw_spi.h"
 #include "loragw_reg.h"
 #include "loragw_fpga.h"
+#include "loragw_worker.h"
 
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE MACROS ------------------------------------------------------- */
@@ -48,6 +50,11 @@ Maintainer: Sylvain Miermont
 #define PAGE_ADDR        0x00
 #define PAGE_MASK        0x03
 
+#define SHADOW_SIZE      ((PAGE_MASK + 1) * 128) /* page-global registers are stored in page 0 addresses */
+#define SHADOW_VALID     0x01 /* shadow byte content is known */
+#define SHADOW_VOLATILE  0x02 /* byte modified by hardware or with side effects, never cached */
+#define SHADOW_NOBURST   0x04 /* byte with side effects, never merged with its neighbours in a burst */
+
 const uint8_t FPGA_VERSION[] = { 31, 33 }; /* several versions could be supported */
 
 /*
@@ -57,332 +64,438 @@ this file is autogenerated from registers description
 293 registers are defined
 */
 const struct lgw_reg_s loregs[LGW_TOTALREGS] = {
-    {-1,0,0,0,2,0,0},         /* PAGE_REG */
-    {-1,0,7,0,1,0,0},         /* SOFT_RESET */
-    {-1,1,0,0,8,1,103},       /* VERSION */
-    {-1,2,0,0,16,0,0},        /* RX_DATA_BUF_ADDR */
-    {-1,4,0,0,8,0,0},         /* RX_DATA_BUF_DATA */
-    {-1,5,0,0,8,0,0},         /* TX_DATA_BUF_ADDR */
-    {-1,6,0,0,8,0,0},         /* TX_DATA_BUF_DATA */
-    {-1,7,0,0,8,0,0},         /* CAPTURE_RAM_ADDR */
-    {-1,8,0,0,8,1,0},         /* CAPTURE_RAM_DATA */
-    {-1,9,0,0,8,0,0},         /* MCU_PROM_ADDR */
-    {-1,10,0,0,8,0,0},        /* MCU_PROM_DATA */
-    {-1,11,0,0,8,0,0},        /* RX_PACKET_DATA_FIFO_NUM_STORED */
-    {-1,12,0,0,16,1,0},       /* RX_PACKET_DATA_FIFO_ADDR_POINTER */
-    {-1,14,0,0,8,1,0},        /* RX_PACKET_DATA_FIFO_STATUS */
-    {-1,15,0,0,8,1,0},        /* RX_PACKET_DATA_FIFO_PAYLOAD_SIZE */
-    {-1,16,0,0,1,0,0},        /* MBWSSF_MODEM_ENABLE */
-    {-1,16,1,0,1,0,0},        /* CONCENTRATOR_MODEM_ENABLE */
-    {-1,16,2,0,1,0,0},        /* FSK_MODEM_ENABLE */
-    {-1,16,3,0,1,0,0},        /* GLOBAL_EN */
-    {-1,17,0,0,1,0,1},        /* CLK32M_EN */
-    {-1,17,1,0,1,0,1},        /* CLKHS_EN */
-    {-1,18,0,0,1,0,0},        /* START_BIST0 */
-    {-1,18,1,0,1,0,0},        /* START_BIST1 */
-    {-1,18,2,0,1,0,0},        /* CLEAR_BIST0 */
-    {-1,18,3,0,1,0,0},        /* CLEAR_BIST1 */
-    {-1,19,0,0,1,1,0},        /* BIST0_FINISHED */
-    {-1,19,1,0,1,1,0},        /* BIST1_FINISHED */
-    {-1,20,0,0,1,1,0},        /* MCU_AGC_PROG_RAM_BIST_STATUS */
-    {-1,20,1,0,1,1,0},        /* MCU_ARB_PROG_RAM_BIST_STATUS */
-    {-1,20,2,0,1,1,0},        /* CAPTURE_RAM_BIST_STATUS */
-    {-1,20,3,0,1,1,0},        /* CHAN_FIR_RAM0_BIST_STATUS */
-    {-1,20,4,0,1,1,0},        /* CHAN_FIR_RAM1_BIST_STATUS */
-    {-1,21,0,0,1,1,0},        /* CORR0_RAM_BIST_STATUS */
-    {-1,21,1,0,1,1,0},        /* CORR1_RAM_BIST_STATUS */
-    {-1,21,2,0,1,1,0},        /* CORR2_RAM_BIST_STATUS */
-    {-1,21,3,0,1,1,0},        /* CORR3_RAM_BIST_STATUS */
-    {-1,21,4,0,1,1,0},        /* CORR4_RAM_BIST_STATUS */
-    {-1,21,5,0,1,1,0},        /* CORR5_RAM_BIST_STATUS */
-    {-1,21,6,0,1,1,0},        /* CORR6_RAM_BIST_STATUS */
-    {-1,21,7,0,1,1,0},        /* CORR7_RAM_BIST_STATUS */
-    {-1,22,0,0,1,1,0},        /* MODEM0_RAM0_BIST_STATUS */
-    {-1,22,1,0,1,1,0},        /* MODEM1_RAM0_BIST_STATUS */
-    {-1,22,2,0,1,1,0},        /* MODEM2_RAM0_BIST_STATUS */
-    {-1,22,3,0,1,1,0},        /* MODEM3_RAM0_BIST_STATUS */
-    {-1,22,4,0,1,1,0},        /* MODEM4_RAM0_BIST_STATUS */
-    {-1,22,5,0,1,1,0},        /* MODEM5_RAM0_BIST_STATUS */
-    {-1,22,6,0,1,1,0},        /* MODEM6_RAM0_BIST_STATUS */
-    {-1,22,7,0,1,1,0},        /* MODEM7_RAM0_BIST_STATUS */
-    {-1,23,0,0,1,1,0},        /* MODEM0_RAM1_BIST_STATUS */
-    {-1,23,1,0,1,1,0},        /* MODEM1_RAM1_BIST_STATUS */
-    {-1,23,2,0,1,1,0},        /* MODEM2_RAM1_BIST_STATUS */
-    {-1,23,3,0,1,1,0},        /* MODEM3_RAM1_BIST_STATUS */
-    {-1,23,4,0,1,1,0},        /* MODEM4_RAM1_BIST_STATUS */
-    {-1,23,5,0,1,1,0},        /* MODEM5_RAM1_BIST_STATUS */
-    {-1,23,6,0,1,1,0},        /* MODEM6_RAM1_BIST_STATUS */
-    {-1,23,7,0,1,1,0},        /* MODEM7_RAM1_BIST_STATUS */
-    {-1,24,0,0,1,1,0},        /* MODEM0_RAM2_BIST_STATUS */
-    {-1,24,1,0,1,1,0},        /* MODEM1_RAM2_BIST_STATUS */
-    {-1,24,2,0,1,1,0},        /* MODEM2_RAM2_BIST_STATUS */
-    {-1,24,3,0,1,1,0},        /* MODEM3_RAM2_BIST_STATUS */
-    {-1,24,4,0,1,1,0},        /* MODEM4_RAM2_BIST_STATUS */
-    {-1,24,5,0,1,1,0},        /* MODEM5_RAM2_BIST_STATUS */
-    {-1,24,6,0,1,1,0},        /* MODEM6_RAM2_BIST_STATUS */
-    {-1,24,7,0,1,1,0},        /* MODEM7_RAM2_BIST_STATUS */
-    {-1,25,0,0,1,1,0},        /* MODEM_MBWSSF_RAM0_BIST_STATUS */
-    {-1,25,1,0,1,1,0},        /* MODEM_MBWSSF_RAM1_BIST_STATUS */
-    {-1,25,2,0,1,1,0},        /* MODEM_MBWSSF_RAM2_BIST_STATUS */
-    {-1,26,0,0,1,1,0},        /* MCU_AGC_DATA_RAM_BIST0_STATUS */
-    {-1,26,1,0,1,1,0},        /* MCU_AGC_DATA_RAM_BIST1_STATUS */
-    {-1,26,2,0,1,1,0},        /* MCU_ARB_DATA_RAM_BIST0_STATUS */
-    {-1,26,3,0,1,1,0},        /* MCU_ARB_DATA_RAM_BIST1_STATUS */
-    {-1,26,4,0,1,1,0},        /* TX_TOP_RAM_BIST0_STATUS */
-    {-1,26,5,0,1,1,0},        /* TX_TOP_RAM_BIST1_STATUS */
-    {-1,26,6,0,1,1,0},        /* DATA_MNGT_RAM_BIST0_STATUS */
-    {-1,26,7,0,1,1,0},        /* DATA_MNGT_RAM_BIST1_STATUS */
-    {-1,27,0,0,4,0,0},        /* GPIO_SELECT_INPUT */
-    {-1,28,0,0,4,0,0},        /* GPIO_SELECT_OUTPUT */
-    {-1,29,0,0,5,0,0},        /* GPIO_MODE */
-    {-1,30,0,0,5,1,0},        /* GPIO_PIN_REG_IN */
-    {-1,31,0,0,5,0,0},        /* GPIO_PIN_REG_OUT */
-    {-1,32,0,0,8,1,0},        /* MCU_AGC_STATUS */
-    {-1,125,0,0,8,1,0},       /* MCU_ARB_STATUS */
-    {-1,126,0,0,8,1,1},       /* CHIP_ID */
-    {-1,127,0,0,1,0,1},       /* EMERGENCY_FORCE_HOST_CTRL */
-    {0,33,0,0,1,0,0},         /* RX_INVERT_IQ */
-    {0,33,1,0,1,0,1},         /* MODEM_INVERT_IQ */
-    {0,33,2,0,1,0,0},         /* MBWSSF_MODEM_INVERT_IQ */
-    {0,33,3,0,1,0,0},         /* RX_EDGE_SELECT */
-    {0,33,4,0,1,0,0},         /* MISC_RADIO_EN */
-    {0,33,5,0,1,0,0},         /* FSK_MODEM_INVERT_IQ */
-    {0,34,0,0,4,0,7},         /* FILTER_GAIN */
-    {0,35,0,0,8,0,240},       /* RADIO_SELECT */
-    {0,36,0,1,13,0,-384},     /* IF_FREQ_0 */
-    {0,38,0,1,13,0,-128},     /* IF_FREQ_1 */
-    {0,40,0,1,13,0,128},      /* IF_FREQ_2 */
-    {0,42,0,1,13,0,384},      /* IF_FREQ_3 */
-    {0,44,0,1,13,0,-384},     /* IF_FREQ_4 */
-    {0,46,0,1,13,0,-128},     /* IF_FREQ_5 */
-    {0,48,0,1,13,0,128},      /* IF_FREQ_6 */
-    {0,50,0,1,13,0,384},      /* IF_FREQ_7 */
-    {0,52,0,1,13,0,0},        /* IF_FREQ_8 */
-    {0,54,0,1,13,0,0},        /* IF_FREQ_9 */
-    {0,64,0,0,1,0,0},        /* CHANN_OVERRIDE_AGC_GAIN */
-    {0,64,1,0,4,0,7},        /* CHANN_AGC_GAIN */
-    {0,65,0,0,7,0,0},        /* CORR0_DETECT_EN */
-    {0,66,0,0,7,0,0},        /* CORR1_DETECT_EN */
-    {0,67,0,0,7,0,0},        /* CORR2_DETECT_EN */
-    {0,68,0,0,7,0,0},        /* CORR3_DETECT_EN */
-    {0,69,0,0,7,0,0},        /* CORR4_DETECT_EN */
-    {0,70,0,0,7,0,0},        /* CORR5_DETECT_EN */
-    {0,71,0,0,7,0,0},        /* CORR6_DETECT_EN */
-    {0,72,0,0,7,0,0},        /* CORR7_DETECT_EN */
-    {0,73,0,0,1,0,0},        /* CORR_SAME_PEAKS_OPTION_SF6 */
-    {0,73,1,0,1,0,1},        /* CORR_SAME_PEAKS_OPTION_SF7 */
-    {0,73,2,0,1,0,1},        /* CORR_SAME_PEAKS_OPTION_SF8 */
-    {0,73,3,0,1,0,1},        /* CORR_SAME_PEAKS_OPTION_SF9 */
-    {0,73,4,0,1,0,1},        /* CORR_SAME_PEAKS_OPTION_SF10 */
-    {0,73,5,0,1,0,1},        /* CORR_SAME_PEAKS_OPTION_SF11 */
-    {0,73,6,0,1,0,1},        /* CORR_SAME_PEAKS_OPTION_SF12 */
-    {0,74,0,0,4,0,4},        /* CORR_SIG_NOISE_RATIO_SF6 */
-    {0,74,4,0,4,0,4},        /* CORR_SIG_NOISE_RATIO_SF7 */
-    {0,75,0,0,4,0,4},        /* CORR_SIG_NOISE_RATIO_SF8 */
-    {0,75,4,0,4,0,4},        /* CORR_SIG_NOISE_RATIO_SF9 */
-    {0,76,0,0,4,0,4},        /* CORR_SIG_NOISE_RATIO_SF10 */
-    {0,76,4,0,4,0,4},        /* CORR_SIG_NOISE_RATIO_SF11 */
-    {0,77,0,0,4,0,4},        /* CORR_SIG_NOISE_RATIO_SF12 */
-    {0,78,0,0,4,0,4},        /* CORR_NUM_SAME_PEAK */
-    {0,78,4,0,3,0,5},        /* CORR_MAC_GAIN */
-    {0,81,0,0,12,0,0},       /* ADJUST_MODEM_START_OFFSET_RDX4 */
-    {0,83,0,0,12,0,4092},    /* ADJUST_MODEM_START_OFFSET_SF12_RDX4 */
-    {0,85,0,0,8,0,7},        /* DBG_CORR_SELECT_SF */
-    {0,86,0,0,8,0,0},        /* DBG_CORR_SELECT_CHANNEL */
-    {0,87,0,0,8,1,0},        /* DBG_DETECT_CPT */
-    {0,88,0,0,8,1,0},        /* DBG_SYMB_CPT */
-    {0,89,0,0,1,0,1},        /* CHIRP_INVERT_RX */
-    {0,89,1,0,1,0,1},        /* DC_NOTCH_EN */
-    {0,90,0,0,1,0,0},        /* IMPLICIT_CRC_EN */
-    {0,90,1,0,3,0,0},        /* IMPLICIT_CODING_RATE */
-    {0,91,0,0,8,0,0},        /* IMPLICIT_PAYLOAD_LENGHT */
-    {0,92,0,0,8,0,29},       /* FREQ_TO_TIME_INVERT */
-    {0,93,0,0,6,0,9},        /* FREQ_TO_TIME_DRIFT */
-    {0,94,0,0,2,0,2},        /* PAYLOAD_FINE_TIMING_GAIN */
-    {0,94,2,0,2,0,1},        /* PREAMBLE_FINE_TIMING_GAIN */
-    {0,94,4,0,2,0,0},        /* TRACKING_INTEGRAL */
-    {0,95,0,0,4,0,1},        /* FRAME_SYNCH_PEAK1_POS */
-    {0,95,4,0,4,0,2},        /* FRAME_SYNCH_PEAK2_POS */
-    {0,96,0,0,16,0,10},      /* PREAMBLE_SYMB1_NB */
-    {0,98,0,0,1,0,1},        /* FRAME_SYNCH_GAIN */
-    {0,98,1,0,1,0,1},        /* SYNCH_DETECT_TH */
-    {0,99,0,0,4,0,8},        /* LLR_SCALE */
-    {0,99,4,0,2,0,2},        /* SNR_AVG_CST */
-    {0,100,0,0,7,0,0},       /* PPM_OFFSET */
-    {0,101,0,0,8,0,255},     /* MAX_PAYLOAD_LEN */
-    {0,102,0,0,1,0,1},        /* ONLY_CRC_EN */
-    {0,103,0,0,8,0,0},        /* ZERO_PAD */
-    {0,104,0,0,4,0,8},        /* DEC_GAIN_OFFSET */
-    {0,104,4,0,4,0,7},        /* CHAN_GAIN_OFFSET */
-    {0,105,1,0,1,0,1},        /* FORCE_HOST_RADIO_CTRL */
-    {0,105,2,0,1,0,1},        /* FORCE_HOST_FE_CTRL */
-    {0,105,3,0,1,0,1},        /* FORCE_DEC_FILTER_GAIN */
-    {0,106,0,0,1,0,1},        /* MCU_RST_0 */
-    {0,106,1,0,1,0,1},        /* MCU_RST_1 */
-    {0,106,2,0,1,0,0},        /* MCU_SELECT_MUX_0 */
-    {0,106,3,0,1,0,0},        /* MCU_SELECT_MUX_1 */
-    {0,106,4,0,1,1,0},        /* MCU_CORRUPTION_DETECTED_0 */
-    {0,106,5,0,1,1,0},        /* MCU_CORRUPTION_DETECTED_1 */
-    {0,106,6,0,1,0,0},        /* MCU_SELECT_EDGE_0 */
-    {0,106,7,0,1,0,0},        /* MCU_SELECT_EDGE_1 */
-    {0,107,0,0,8,0,1},        /* CHANN_SELECT_RSSI */
-    {0,108,0,0,8,0,32},       /* RSSI_BB_DEFAULT_VALUE */
-    {0,109,0,0,8,0,100},      /* RSSI_DEC_DEFAULT_VALUE */
-    {0,110,0,0,8,0,100},      /* RSSI_CHANN_DEFAULT_VALUE */
-    {0,111,0,0,5,0,7},        /* RSSI_BB_FILTER_ALPHA */
-    {0,112,0,0,5,0,5},        /* RSSI_DEC_FILTER_ALPHA */
-    {0,113,0,0,5,0,8},        /* RSSI_CHANN_FILTER_ALPHA */
-    {0,114,0,0,6,0,0},        /* IQ_MISMATCH_A_AMP_COEFF */
-    {0,115,0,0,6,0,0},        /* IQ_MISMATCH_A_PHI_COEFF */
-    {0,116,0,0,6,0,0},        /* IQ_MISMATCH_B_AMP_COEFF */
-    {0,116,6,0,1,0,0},        /* IQ_MISMATCH_B_SEL_I */
-    {0,117,0,0,6,0,0},        /* IQ_MISMATCH_B_PHI_COEFF */
-    {1,33,0,0,1,0,0},         /* TX_TRIG_IMMEDIATE */
-    {1,33,1,0,1,0,0},         /* TX_TRIG_DELAYED */
-    {1,33,2,0,1,0,0},         /* TX_TRIG_GPS */
-    {1,34,0,0,16,0,0},        /* TX_START_DELAY */
-    {1,36,0,0,4,0,1},        /* TX_FRAME_SYNCH_PEAK1_POS */
-    {1,36,4,0,4,0,2},        /* TX_FRAME_SYNCH_PEAK2_POS */
-    {1,37,0,0,3,0,0},        /* TX_RAMP_DURATION */
-    {1,39,0,1,8,0,0},        /* TX_OFFSET_I */
-    {1,40,0,1,8,0,0},        /* TX_OFFSET_Q */
-    {1,41,0,0,1,0,0},        /* TX_MODE */
-    {1,41,1,0,4,0,0},        /* TX_ZERO_PAD */
-    {1,41,5,0,1,0,0},        /* TX_EDGE_SELECT */
-    {1,41,6,0,1,0,0},        /* TX_EDGE_SELECT_TOP */
-    {1,42,0,0,2,0,0},        /* TX_GAIN */
-    {1,42,2,0,3,0,5},        /* TX_CHIRP_LOW_PASS */
-    {1,42,5,0,2,0,0},        /* TX_FCC_WIDEBAND */
-    {1,42,7,0,1,0,1},        /* TX_SWAP_IQ */
-    {1,43,0,0,1,0,0},        /* MBWSSF_IMPLICIT_HEADER */
-    {1,43,1,0,1,0,0},        /* MBWSSF_IMPLICIT_CRC_EN */
-    {1,43,2,0,3,0,0},        /* MBWSSF_IMPLICIT_CODING_RATE */
-    {1,44,0,0,8,0,0},        /* MBWSSF_IMPLICIT_PAYLOAD_LENGHT */
-    {1,45,0,0,1,0,1},        /* MBWSSF_AGC_FREEZE_ON_DETECT */
-    {1,46,0,0,4,0,1},        /* MBWSSF_FRAME_SYNCH_PEAK1_POS */
-    {1,46,4,0,4,0,2},        /* MBWSSF_FRAME_SYNCH_PEAK2_POS */
-    {1,47,0,0,16,0,10},      /* MBWSSF_PREAMBLE_SYMB1_NB */
-    {1,49,0,0,1,0,1},        /* MBWSSF_FRAME_SYNCH_GAIN */
-    {1,49,1,0,1,0,1},        /* MBWSSF_SYNCH_DETECT_TH */
-    {1,50,0,0,8,0,10},       /* MBWSSF_DETECT_MIN_SINGLE_PEAK */
-    {1,51,0,0,3,0,3},        /* MBWSSF_DETECT_TRIG_SAME_PEAK_NB */
-    {1,52,0,0,8,0,29},       /* MBWSSF_FREQ_TO_TIME_INVERT */
-    {1,53,0,0,6,0,36},       /* MBWSSF_FREQ_TO_TIME_DRIFT */
-    {1,54,0,0,12,0,0},       /* MBWSSF_PPM_CORRECTION */
-    {1,56,0,0,2,0,2},        /* MBWSSF_PAYLOAD_FINE_TIMING_GAIN */
-    {1,56,2,0,2,0,1},        /* MBWSSF_PREAMBLE_FINE_TIMING_GAIN */
-    {1,56,4,0,2,0,0},        /* MBWSSF_TRACKING_INTEGRAL */
-    {1,57,0,0,8,0,0},        /* MBWSSF_ZERO_PAD */
-    {1,58,0,0,2,0,0},        /* MBWSSF_MODEM_BW */
-    {1,58,2,0,1,0,0},        /* MBWSSF_RADIO_SELECT */
-    {1,58,3,0,1,0,1},        /* MBWSSF_RX_CHIRP_INVERT */
-    {1,59,0,0,4,0,8},        /* MBWSSF_LLR_SCALE */
-    {1,59,4,0,2,0,3},        /* MBWSSF_SNR_AVG_CST */
-    {1,59,6,0,1,0,0},        /* MBWSSF_PPM_OFFSET */
-    {1,60,0,0,4,0,7},        /* MBWSSF_RATE_SF */
-    {1,60,4,0,1,0,1},        /* MBWSSF_ONLY_CRC_EN */
-    {1,61,0,0,8,0,255},      /* MBWSSF_MAX_PAYLOAD_LEN */
-    {1,62,0,0,8,1,128},      /* TX_STATUS */
-    {1,63,0,0,3,0,0},        /* FSK_CH_BW_EXPO */
-    {1,63,3,0,3,0,0},        /* FSK_RSSI_LENGTH */
-    {1,63,6,0,1,0,0},        /* FSK_RX_INVERT */
-    {1,63,7,0,1,0,0},        /* FSK_PKT_MODE */
-    {1,64,0,0,3,0,0},        /* FSK_PSIZE */
-    {1,64,3,0,1,0,0},        /* FSK_CRC_EN */
-    {1,64,4,0,2,0,0},        /* FSK_DCFREE_ENC */
-    {1,64,6,0,1,0,0},        /* FSK_CRC_IBM */
-    {1,65,0,0,5,0,0},        /* FSK_ERROR_OSR_TOL */
-    {1,65,7,0,1,0,0},        /* FSK_RADIO_SELECT */
-    {1,66,0,0,16,0,0},       /* FSK_BR_RATIO */
-    {1,68,0,0,32,0,0},       /* FSK_REF_PATTERN_LSB */
-    {1,72,0,0,32,0,0},       /* FSK_REF_PATTERN_MSB */
-    {1,76,0,0,8,0,0},        /* FSK_PKT_LENGTH */
-    {1,77,0,0,1,0,1},        /* FSK_TX_GAUSSIAN_EN */
-    {1,77,1,0,2,0,0},        /* FSK_TX_GAUSSIAN_SELECT_BT */
-    {1,77,3,0,1,0,1},        /* FSK_TX_PATTERN_EN */
-    {1,77,4,0,1,0,0},        /* FSK_TX_PREAMBLE_SEQ */
-    {1,77,5,0,3,0,0},        /* FSK_TX_PSIZE */
-    {1,80,0,0,8,0,0},        /* FSK_NODE_ADRS */
-    {1,81,0,0,8,0,0},        /* FSK_BROADCAST */
-    {1,82,0,0,1,0,1},        /* FSK_AUTO_AFC_ON */
-    {1,83,0,0,10,0,0},       /* FSK_PATTERN_TIMEOUT_CFG */
-    {2,33,0,0,8,0,0},        /* SPI_RADIO_A__DATA */
-    {2,34,0,0,8,1,0},        /* SPI_RADIO_A__DATA_READBACK */
-    {2,35,0,0,8,0,0},        /* SPI_RADIO_A__ADDR */
-    {2,37,0,0,1,0,0},        /* SPI_RADIO_A__CS */
-    {2,38,0,0,8,0,0},        /* SPI_RADIO_B__DATA */
-    {2,39,0,0,8,1,0},        /* SPI_RADIO_B__DATA_READBACK */
-    {2,40,0,0,8,0,0},        /* SPI_RADIO_B__ADDR */
-    {2,42,0,0,1,0,0},        /* SPI_RADIO_B__CS */
-    {2,43,0,0,1,0,0},        /* RADIO_A_EN */
-    {2,43,1,0,1,0,0},        /* RADIO_B_EN */
-    {2,43,2,0,1,0,1},        /* RADIO_RST */
-    {2,43,3,0,1,0,0},        /* LNA_A_EN */
-    {2,43,4,0,1,0,0},        /* PA_A_EN */
-    {2,43,5,0,1,0,0},        /* LNA_B_EN */
-    {2,43,6,0,1,0,0},        /* PA_B_EN */
-    {2,44,0,0,2,0,0},        /* PA_GAIN */
-    {2,45,0,0,4,0,2},        /* LNA_A_CTRL_LUT */
-    {2,45,4,0,4,0,4},        /* PA_A_CTRL_LUT */
-    {2,46,0,0,4,0,2},        /* LNA_B_CTRL_LUT */
-    {2,46,4,0,4,0,4},        /* PA_B_CTRL_LUT */
-    {2,47,0,0,5,0,0},        /* CAPTURE_SOURCE */
-    {2,47,5,0,1,0,0},        /* CAPTURE_START */
-    {2,47,6,0,1,0,0},        /* CAPTURE_FORCE_TRIGGER */
-    {2,47,7,0,1,0,0},        /* CAPTURE_WRAP */
-    {2,48,0,0,16,0,0},       /* CAPTURE_PERIOD */
-    {2,51,0,0,8,1,0},        /* MODEM_STATUS */
-    {2,52,0,0,8,1,0},        /* VALID_HEADER_COUNTER_0 */
-    {2,54,0,0,8,1,0},        /* VALID_PACKET_COUNTER_0 */
-    {2,56,0,0,8,1,0},        /* VALID_HEADER_COUNTER_MBWSSF */
-    {2,57,0,0,8,1,0},        /* VALID_HEADER_COUNTER_FSK */
-    {2,58,0,0,8,1,0},        /* VALID_PACKET_COUNTER_MBWSSF */
-    {2,59,0,0,8,1,0},        /* VALID_PACKET_COUNTER_FSK */
-    {2,60,0,0,8,1,0},        /* CHANN_RSSI */
-    {2,61,0,0,8,1,0},        /* BB_RSSI */
-    {2,62,0,0,8,1,0},        /* DEC_RSSI */
-    {2,63,0,0,8,1,0},        /* DBG_MCU_DATA */
-    {2,64,0,0,8,1,0},        /* DBG_ARB_MCU_RAM_DATA */
-    {2,65,0,0,8,1,0},        /* DBG_AGC_MCU_RAM_DATA */
-    {2,66,0,0,16,1,0},       /* NEXT_PACKET_CNT */
-    {2,68,0,0,16,1,0},       /* ADDR_CAPTURE_COUNT */
-    {2,70,0,0,32,1,0},       /* TIMESTAMP */
-    {2,74,0,0,4,1,0},        /* DBG_CHANN0_GAIN */
-    {2,74,4,0,4,1,0},        /* DBG_CHANN1_GAIN */
-    {2,75,0,0,4,1,0},        /* DBG_CHANN2_GAIN */
-    {2,75,4,0,4,1,0},        /* DBG_CHANN3_GAIN */
-    {2,76,0,0,4,1,0},        /* DBG_CHANN4_GAIN */
-    {2,76,4,0,4,1,0},        /* DBG_CHANN5_GAIN */
-    {2,77,0,0,4,1,0},        /* DBG_CHANN6_GAIN */
-    {2,77,4,0,4,1,0},        /* DBG_CHANN7_GAIN */
-    {2,78,0,0,4,1,0},        /* DBG_DEC_FILT_GAIN */
-    {2,79,0,0,3,1,0},        /* SPI_DATA_FIFO_PTR */
-    {2,79,3,0,3,1,0},        /* PACKET_DATA_FIFO_PTR */
-    {2,80,0,0,8,0,0},        /* DBG_ARB_MCU_RAM_ADDR */
-    {2,81,0,0,8,0,0},        /* DBG_AGC_MCU_RAM_ADDR */
-    {2,82,0,0,1,0,0},        /* SPI_MASTER_CHIP_SELECT_POLARITY */
-    {2,82,1,0,1,0,0},        /* SPI_MASTER_CPOL */
-    {2,82,2,0,1,0,0},        /* SPI_MASTER_CPHA */
-    {2,83,0,0,1,0,0},        /* SIG_GEN_ANALYSER_MUX_SEL */
-    {2,84,0,0,1,0,0},        /* SIG_GEN_EN */
-    {2,84,1,0,1,0,0},        /* SIG_ANALYSER_EN */
-    {2,84,2,0,2,0,0},        /* SIG_ANALYSER_AVG_LEN */
-    {2,84,4,0,3,0,0},        /* SIG_ANALYSER_PRECISION */
-    {2,84,7,0,1,1,0},        /* SIG_ANALYSER_VALID_OUT */
-    {2,85,0,0,8,0,0},        /* SIG_GEN_FREQ */
-    {2,86,0,0,8,0,0},        /* SIG_ANALYSER_FREQ */
-    {2,87,0,0,8,1,0},        /* SIG_ANALYSER_I_OUT */
-    {2,88,0,0,8,1,0},        /* SIG_ANALYSER_Q_OUT */
-    {2,89,0,0,1,0,0},        /* GPS_EN */
-    {2,89,1,0,1,0,1},        /* GPS_POL */
-    {2,90,0,1,8,0,0},        /* SW_TEST_REG1 */
-    {2,91,2,1,6,0,0},        /* SW_TEST_REG2 */
-    {2,92,0,1,16,0,0},       /* SW_TEST_REG3 */
-    {2,94,0,0,4,1,0},        /* DATA_MNGT_STATUS */
-    {2,95,0,0,5,1,0},        /* DATA_MNGT_CPT_FRAME_ALLOCATED */
-    {2,96,0,0,5,1,0},        /* DATA_MNGT_CPT_FRAME_FINISHED */
-    {2,97,0,0,5,1,0},        /* DATA_MNGT_CPT_FRAME_READEN */
-    {1,33,0,0,8,0,0}         /* TX_TRIG_ALL (alias) */
+    {LGW_PAGE_REG_DESC},
+    {LGW_SOFT_RESET_DESC},
+    {LGW_VERSION_DESC},
+    {LGW_RX_DATA_BUF_ADDR_DESC},
+    {LGW_RX_DATA_BUF_DATA_DESC},
+    {LGW_TX_DATA_BUF_ADDR_DESC},
+    {LGW_TX_DATA_BUF_DATA_DESC},
+    {LGW_CAPTURE_RAM_ADDR_DESC},
+    {LGW_CAPTURE_RAM_DATA_DESC},
+    {LGW_MCU_PROM_ADDR_DESC},
+    {LGW_MCU_PROM_DATA_DESC},
+    {LGW_RX_PACKET_DATA_FIFO_NUM_STORED_DESC},
+    {LGW_RX_PACKET_DATA_FIFO_ADDR_POINTER_DESC},
+    {LGW_RX_PACKET_DATA_FIFO_STATUS_DESC},
+    {LGW_RX_PACKET_DATA_FIFO_PAYLOAD_SIZE_DESC},
+    {LGW_MBWSSF_MODEM_ENABLE_DESC},
+    {LGW_CONCENTRATOR_MODEM_ENABLE_DESC},
+    {LGW_FSK_MODEM_ENABLE_DESC},
+    {LGW_GLOBAL_EN_DESC},
+    {LGW_CLK32M_EN_DESC},
+    {LGW_CLKHS_EN_DESC},
+    {LGW_START_BIST0_DESC},
+    {LGW_START_BIST1_DESC},
+    {LGW_CLEAR_BIST0_DESC},
+    {LGW_CLEAR_BIST1_DESC},
+    {LGW_BIST0_FINISHED_DESC},
+    {LGW_BIST1_FINISHED_DESC},
+    {LGW_MCU_AGC_PROG_RAM_BIST_STATUS_DESC},
+    {LGW_MCU_ARB_PROG_RAM_BIST_STATUS_DESC},
+    {LGW_CAPTURE_RAM_BIST_STATUS_DESC},
+    {LGW_CHAN_FIR_RAM0_BIST_STATUS_DESC},
+    {LGW_CHAN_FIR_RAM1_BIST_STATUS_DESC},
+    {LGW_CORR0_RAM_BIST_STATUS_DESC},
+    {LGW_CORR1_RAM_BIST_STATUS_DESC},
+    {LGW_CORR2_RAM_BIST_STATUS_DESC},
+    {LGW_CORR3_RAM_BIST_STATUS_DESC},
+    {LGW_CORR4_RAM_BIST_STATUS_DESC},
+    {LGW_CORR5_RAM_BIST_STATUS_DESC},
+    {LGW_CORR6_RAM_BIST_STATUS_DESC},
+    {LGW_CORR7_RAM_BIST_STATUS_DESC},
+    {LGW_MODEM0_RAM0_BIST_STATUS_DESC},
+    {LGW_MODEM1_RAM0_BIST_STATUS_DESC},
+    {LGW_MODEM2_RAM0_BIST_STATUS_DESC},
+    {LGW_MODEM3_RAM0_BIST_STATUS_DESC},
+    {LGW_MODEM4_RAM0_BIST_STATUS_DESC},
+    {LGW_MODEM5_RAM0_BIST_STATUS_DESC},
+    {LGW_MODEM6_RAM0_BIST_STATUS_DESC},
+    {LGW_MODEM7_RAM0_BIST_STATUS_DESC},
+    {LGW_MODEM0_RAM1_BIST_STATUS_DESC},
+    {LGW_MODEM1_RAM1_BIST_STATUS_DESC},
+    {LGW_MODEM2_RAM1_BIST_STATUS_DESC},
+    {LGW_MODEM3_RAM1_BIST_STATUS_DESC},
+    {LGW_MODEM4_RAM1_BIST_STATUS_DESC},
+    {LGW_MODEM5_RAM1_BIST_STATUS_DESC},
+    {LGW_MODEM6_RAM1_BIST_STATUS_DESC},
+    {LGW_MODEM7_RAM1_BIST_STATUS_DESC},
+    {LGW_MODEM0_RAM2_BIST_STATUS_DESC},
+    {LGW_MODEM1_RAM2_BIST_STATUS_DESC},
+    {LGW_MODEM2_RAM2_BIST_STATUS_DESC},
+    {LGW_MODEM3_RAM2_BIST_STATUS_DESC},
+    {LGW_MODEM4_RAM2_BIST_STATUS_DESC},
+    {LGW_MODEM5_RAM2_BIST_STATUS_DESC},
+    {LGW_MODEM6_RAM2_BIST_STATUS_DESC},
+    {LGW_MODEM7_RAM2_BIST_STATUS_DESC},
+    {LGW_MODEM_MBWSSF_RAM0_BIST_STATUS_DESC},
+    {LGW_MODEM_MBWSSF_RAM1_BIST_STATUS_DESC},
+    {LGW_MODEM_MBWSSF_RAM2_BIST_STATUS_DESC},
+    {LGW_MCU_AGC_DATA_RAM_BIST0_STATUS_DESC},
+    {LGW_MCU_AGC_DATA_RAM_BIST1_STATUS_DESC},
+    {LGW_MCU_ARB_DATA_RAM_BIST0_STATUS_DESC},
+    {LGW_MCU_ARB_DATA_RAM_BIST1_STATUS_DESC},
+    {LGW_TX_TOP_RAM_BIST0_STATUS_DESC},
+    {LGW_TX_TOP_RAM_BIST1_STATUS_DESC},
+    {LGW_DATA_MNGT_RAM_BIST0_STATUS_DESC},
+    {LGW_DATA_MNGT_RAM_BIST1_STATUS_DESC},
+    {LGW_GPIO_SELECT_INPUT_DESC},
+    {LGW_GPIO_SELECT_OUTPUT_DESC},
+    {LGW_GPIO_MODE_DESC},
+    {LGW_GPIO_PIN_REG_IN_DESC},
+    {LGW_GPIO_PIN_REG_OUT_DESC},
+    {LGW_MCU_AGC_STATUS_DESC},
+    {LGW_MCU_ARB_STATUS_DESC},
+    {LGW_CHIP_ID_DESC},
+    {LGW_EMERGENCY_FORCE_HOST_CTRL_DESC},
+    {LGW_RX_INVERT_IQ_DESC},
+    {LGW_MODEM_INVERT_IQ_DESC},
+    {LGW_MBWSSF_MODEM_INVERT_IQ_DESC},
+    {LGW_RX_EDGE_SELECT_DESC},
+    {LGW_MISC_RADIO_EN_DESC},
+    {LGW_FSK_MODEM_INVERT_IQ_DESC},
+    {LGW_FILTER_GAIN_DESC},
+    {LGW_RADIO_SELECT_DESC},
+    {LGW_IF_FREQ_0_DESC},
+    {LGW_IF_FREQ_1_DESC},
+    {LGW_IF_FREQ_2_DESC},
+    {LGW_IF_FREQ_3_DESC},
+    {LGW_IF_FREQ_4_DESC},
+    {LGW_IF_FREQ_5_DESC},
+    {LGW_IF_FREQ_6_DESC},
+    {LGW_IF_FREQ_7_DESC},
+    {LGW_IF_FREQ_8_DESC},
+    {LGW_IF_FREQ_9_DESC},
+    {LGW_CHANN_OVERRIDE_AGC_GAIN_DESC},
+    {LGW_CHANN_AGC_GAIN_DESC},
+    {LGW_CORR0_DETECT_EN_DESC},
+    {LGW_CORR1_DETECT_EN_DESC},
+    {LGW_CORR2_DETECT_EN_DESC},
+    {LGW_CORR3_DETECT_EN_DESC},
+    {LGW_CORR4_DETECT_EN_DESC},
+    {LGW_CORR5_DETECT_EN_DESC},
+    {LGW_CORR6_DETECT_EN_DESC},
+    {LGW_CORR7_DETECT_EN_DESC},
+    {LGW_CORR_SAME_PEAKS_OPTION_SF6_DESC},
+    {LGW_CORR_SAME_PEAKS_OPTION_SF7_DESC},
+    {LGW_CORR_SAME_PEAKS_OPTION_SF8_DESC},
+    {LGW_CORR_SAME_PEAKS_OPTION_SF9_DESC},
+    {LGW_CORR_SAME_PEAKS_OPTION_SF10_DESC},
+    {LGW_CORR_SAME_PEAKS_OPTION_SF11_DESC},
+    {LGW_CORR_SAME_PEAKS_OPTION_SF12_DESC},
+    {LGW_CORR_SIG_NOISE_RATIO_SF6_DESC},
+    {LGW_CORR_SIG_NOISE_RATIO_SF7_DESC},
+    {LGW_CORR_SIG_NOISE_RATIO_SF8_DESC},
+    {LGW_CORR_SIG_NOISE_RATIO_SF9_DESC},
+    {LGW_CORR_SIG_NOISE_RATIO_SF10_DESC},
+    {LGW_CORR_SIG_NOISE_RATIO_SF11_DESC},
+    {LGW_CORR_SIG_NOISE_RATIO_SF12_DESC},
+    {LGW_CORR_NUM_SAME_PEAK_DESC},
+    {LGW_CORR_MAC_GAIN_DESC},
+    {LGW_ADJUST_MODEM_START_OFFSET_RDX4_DESC},
+    {LGW_ADJUST_MODEM_START_OFFSET_SF12_RDX4_DESC},
+    {LGW_DBG_CORR_SELECT_SF_DESC},
+    {LGW_DBG_CORR_SELECT_CHANNEL_DESC},
+    {LGW_DBG_DETECT_CPT_DESC},
+    {LGW_DBG_SYMB_CPT_DESC},
+    {LGW_CHIRP_INVERT_RX_DESC},
+    {LGW_DC_NOTCH_EN_DESC},
+    {LGW_IMPLICIT_CRC_EN_DESC},
+    {LGW_IMPLICIT_CODING_RATE_DESC},
+    {LGW_IMPLICIT_PAYLOAD_LENGHT_DESC},
+    {LGW_FREQ_TO_TIME_INVERT_DESC},
+    {LGW_FREQ_TO_TIME_DRIFT_DESC},
+    {LGW_PAYLOAD_FINE_TIMING_GAIN_DESC},
+    {LGW_PREAMBLE_FINE_TIMING_GAIN_DESC},
+    {LGW_TRACKING_INTEGRAL_DESC},
+    {LGW_FRAME_SYNCH_PEAK1_POS_DESC},
+    {LGW_FRAME_SYNCH_PEAK2_POS_DESC},
+    {LGW_PREAMBLE_SYMB1_NB_DESC},
+    {LGW_FRAME_SYNCH_GAIN_DESC},
+    {LGW_SYNCH_DETECT_TH_DESC},
+    {LGW_LLR_SCALE_DESC},
+    {LGW_SNR_AVG_CST_DESC},
+    {LGW_PPM_OFFSET_DESC},
+    {LGW_MAX_PAYLOAD_LEN_DESC},
+    {LGW_ONLY_CRC_EN_DESC},
+    {LGW_ZERO_PAD_DESC},
+    {LGW_DEC_GAIN_OFFSET_DESC},
+    {LGW_CHAN_GAIN_OFFSET_DESC},
+    {LGW_FORCE_HOST_RADIO_CTRL_DESC},
+    {LGW_FORCE_HOST_FE_CTRL_DESC},
+    {LGW_FORCE_DEC_FILTER_GAIN_DESC},
+    {LGW_MCU_RST_0_DESC},
+    {LGW_MCU_RST_1_DESC},
+    {LGW_MCU_SELECT_MUX_0_DESC},
+    {LGW_MCU_SELECT_MUX_1_DESC},
+    {LGW_MCU_CORRUPTION_DETECTED_0_DESC},
+    {LGW_MCU_CORRUPTION_DETECTED_1_DESC},
+    {LGW_MCU_SELECT_EDGE_0_DESC},
+    {LGW_MCU_SELECT_EDGE_1_DESC},
+    {LGW_CHANN_SELECT_RSSI_DESC},
+    {LGW_RSSI_BB_DEFAULT_VALUE_DESC},
+    {LGW_RSSI_DEC_DEFAULT_VALUE_DESC},
+    {LGW_RSSI_CHANN_DEFAULT_VALUE_DESC},
+    {LGW_RSSI_BB_FILTER_ALPHA_DESC},
+    {LGW_RSSI_DEC_FILTER_ALPHA_DESC},
+    {LGW_RSSI_CHANN_FILTER_ALPHA_DESC},
+    {LGW_IQ_MISMATCH_A_AMP_COEFF_DESC},
+    {LGW_IQ_MISMATCH_A_PHI_COEFF_DESC},
+    {LGW_IQ_MISMATCH_B_AMP_COEFF_DESC},
+    {LGW_IQ_MISMATCH_B_SEL_I_DESC},
+    {LGW_IQ_MISMATCH_B_PHI_COEFF_DESC},
+    {LGW_TX_TRIG_IMMEDIATE_DESC},
+    {LGW_TX_TRIG_DELAYED_DESC},
+    {LGW_TX_TRIG_GPS_DESC},
+    {LGW_TX_START_DELAY_DESC},
+    {LGW_TX_FRAME_SYNCH_PEAK1_POS_DESC},
+    {LGW_TX_FRAME_SYNCH_PEAK2_POS_DESC},
+    {LGW_TX_RAMP_DURATION_DESC},
+    {LGW_TX_OFFSET_I_DESC},
+    {LGW_TX_OFFSET_Q_DESC},
+    {LGW_TX_MODE_DESC},
+    {LGW_TX_ZERO_PAD_DESC},
+    {LGW_TX_EDGE_SELECT_DESC},
+    {LGW_TX_EDGE_SELECT_TOP_DESC},
+    {LGW_TX_GAIN_DESC},
+    {LGW_TX_CHIRP_LOW_PASS_DESC},
+    {LGW_TX_FCC_WIDEBAND_DESC},
+    {LGW_TX_SWAP_IQ_DESC},
+    {LGW_MBWSSF_IMPLICIT_HEADER_DESC},
+    {LGW_MBWSSF_IMPLICIT_CRC_EN_DESC},
+    {LGW_MBWSSF_IMPLICIT_CODING_RATE_DESC},
+    {LGW_MBWSSF_IMPLICIT_PAYLOAD_LENGHT_DESC},
+    {LGW_MBWSSF_AGC_FREEZE_ON_DETECT_DESC},
+    {LGW_MBWSSF_FRAME_SYNCH_PEAK1_POS_DESC},
+    {LGW_MBWSSF_FRAME_SYNCH_PEAK2_POS_DESC},
+    {LGW_MBWSSF_PREAMBLE_SYMB1_NB_DESC},
+    {LGW_MBWSSF_FRAME_SYNCH_GAIN_DESC},
+    {LGW_MBWSSF_SYNCH_DETECT_TH_DESC},
+    {LGW_MBWSSF_DETECT_MIN_SINGLE_PEAK_DESC},
+    {LGW_MBWSSF_DETECT_TRIG_SAME_PEAK_NB_DESC},
+    {LGW_MBWSSF_FREQ_TO_TIME_INVERT_DESC},
+    {LGW_MBWSSF_FREQ_TO_TIME_DRIFT_DESC},
+    {LGW_MBWSSF_PPM_CORRECTION_DESC},
+    {LGW_MBWSSF_PAYLOAD_FINE_TIMING_GAIN_DESC},
+    {LGW_MBWSSF_PREAMBLE_FINE_TIMING_GAIN_DESC},
+    {LGW_MBWSSF_TRACKING_INTEGRAL_DESC},
+    {LGW_MBWSSF_ZERO_PAD_DESC},
+    {LGW_MBWSSF_MODEM_BW_DESC},
+    {LGW_MBWSSF_RADIO_SELECT_DESC},
+    {LGW_MBWSSF_RX_CHIRP_INVERT_DESC},
+    {LGW_MBWSSF_LLR_SCALE_DESC},
+    {LGW_MBWSSF_SNR_AVG_CST_DESC},
+    {LGW_MBWSSF_PPM_OFFSET_DESC},
+    {LGW_MBWSSF_RATE_SF_DESC},
+    {LGW_MBWSSF_ONLY_CRC_EN_DESC},
+    {LGW_MBWSSF_MAX_PAYLOAD_LEN_DESC},
+    {LGW_TX_STATUS_DESC},
+    {LGW_FSK_CH_BW_EXPO_DESC},
+    {LGW_FSK_RSSI_LENGTH_DESC},
+    {LGW_FSK_RX_INVERT_DESC},
+    {LGW_FSK_PKT_MODE_DESC},
+    {LGW_FSK_PSIZE_DESC},
+    {LGW_FSK_CRC_EN_DESC},
+    {LGW_FSK_DCFREE_ENC_DESC},
+    {LGW_FSK_CRC_IBM_DESC},
+    {LGW_FSK_ERROR_OSR_TOL_DESC},
+    {LGW_FSK_RADIO_SELECT_DESC},
+    {LGW_FSK_BR_RATIO_DESC},
+    {LGW_FSK_REF_PATTERN_LSB_DESC},
+    {LGW_FSK_REF_PATTERN_MSB_DESC},
+    {LGW_FSK_PKT_LENGTH_DESC},
+    {LGW_FSK_TX_GAUSSIAN_EN_DESC},
+    {LGW_FSK_TX_GAUSSIAN_SELECT_BT_DESC},
+    {LGW_FSK_TX_PATTERN_EN_DESC},
+    {LGW_FSK_TX_PREAMBLE_SEQ_DESC},
+    {LGW_FSK_TX_PSIZE_DESC},
+    {LGW_FSK_NODE_ADRS_DESC},
+    {LGW_FSK_BROADCAST_DESC},
+    {LGW_FSK_AUTO_AFC_ON_DESC},
+    {LGW_FSK_PATTERN_TIMEOUT_CFG_DESC},
+    {LGW_SPI_RADIO_A__DATA_DESC},
+    {LGW_SPI_RADIO_A__DATA_READBACK_DESC},
+    {LGW_SPI_RADIO_A__ADDR_DESC},
+    {LGW_SPI_RADIO_A__CS_DESC},
+    {LGW_SPI_RADIO_B__DATA_DESC},
+    {LGW_SPI_RADIO_B__DATA_READBACK_DESC},
+    {LGW_SPI_RADIO_B__ADDR_DESC},
+    {LGW_SPI_RADIO_B__CS_DESC},
+    {LGW_RADIO_A_EN_DESC},
+    {LGW_RADIO_B_EN_DESC},
+    {LGW_RADIO_RST_DESC},
+    {LGW_LNA_A_EN_DESC},
+    {LGW_PA_A_EN_DESC},
+    {LGW_LNA_B_EN_DESC},
+    {LGW_PA_B_EN_DESC},
+    {LGW_PA_GAIN_DESC},
+    {LGW_LNA_A_CTRL_LUT_DESC},
+    {LGW_PA_A_CTRL_LUT_DESC},
+    {LGW_LNA_B_CTRL_LUT_DESC},
+    {LGW_PA_B_CTRL_LUT_DESC},
+    {LGW_CAPTURE_SOURCE_DESC},
+    {LGW_CAPTURE_START_DESC},
+    {LGW_CAPTURE_FORCE_TRIGGER_DESC},
+    {LGW_CAPTURE_WRAP_DESC},
+    {LGW_CAPTURE_PERIOD_DESC},
+    {LGW_MODEM_STATUS_DESC},
+    {LGW_VALID_HEADER_COUNTER_0_DESC},
+    {LGW_VALID_PACKET_COUNTER_0_DESC},
+    {LGW_VALID_HEADER_COUNTER_MBWSSF_DESC},
+    {LGW_VALID_HEADER_COUNTER_FSK_DESC},
+    {LGW_VALID_PACKET_COUNTER_MBWSSF_DESC},
+    {LGW_VALID_PACKET_COUNTER_FSK_DESC},
+    {LGW_CHANN_RSSI_DESC},
+    {LGW_BB_RSSI_DESC},
+    {LGW_DEC_RSSI_DESC},
+    {LGW_DBG_MCU_DATA_DESC},
+    {LGW_DBG_ARB_MCU_RAM_DATA_DESC},
+    {LGW_DBG_AGC_MCU_RAM_DATA_DESC},
+    {LGW_NEXT_PACKET_CNT_DESC},
+    {LGW_ADDR_CAPTURE_COUNT_DESC},
+    {LGW_TIMESTAMP_DESC},
+    {LGW_DBG_CHANN0_GAIN_DESC},
+    {LGW_DBG_CHANN1_GAIN_DESC},
+    {LGW_DBG_CHANN2_GAIN_DESC},
+    {LGW_DBG_CHANN3_GAIN_DESC},
+    {LGW_DBG_CHANN4_GAIN_DESC},
+    {LGW_DBG_CHANN5_GAIN_DESC},
+    {LGW_DBG_CHANN6_GAIN_DESC},
+    {LGW_DBG_CHANN7_GAIN_DESC},
+    {LGW_DBG_DEC_FILT_GAIN_DESC},
+    {LGW_SPI_DATA_FIFO_PTR_DESC},
+    {LGW_PACKET_DATA_FIFO_PTR_DESC},
+    {LGW_DBG_ARB_MCU_RAM_ADDR_DESC},
+    {LGW_DBG_AGC_MCU_RAM_ADDR_DESC},
+    {LGW_SPI_MASTER_CHIP_SELECT_POLARITY_DESC},
+    {LGW_SPI_MASTER_CPOL_DESC},
+    {LGW_SPI_MASTER_CPHA_DESC},
+    {LGW_SIG_GEN_ANALYSER_MUX_SEL_DESC},
+    {LGW_SIG_GEN_EN_DESC},
+    {LGW_SIG_ANALYSER_EN_DESC},
+    {LGW_SIG_ANALYSER_AVG_LEN_DESC},
+    {LGW_SIG_ANALYSER_PRECISION_DESC},
+    {LGW_SIG_ANALYSER_VALID_OUT_DESC},
+    {LGW_SIG_GEN_FREQ_DESC},
+    {LGW_SIG_ANALYSER_FREQ_DESC},
+    {LGW_SIG_ANALYSER_I_OUT_DESC},
+    {LGW_SIG_ANALYSER_Q_OUT_DESC},
+    {LGW_GPS_EN_DESC},
+    {LGW_GPS_POL_DESC},
+    {LGW_SW_TEST_REG1_DESC},
+    {LGW_SW_TEST_REG2_DESC},
+    {LGW_SW_TEST_REG3_DESC},
+    {LGW_DATA_MNGT_STATUS_DESC},
+    {LGW_DATA_MNGT_CPT_FRAME_ALLOCATED_DESC},
+    {LGW_DATA_MNGT_CPT_FRAME_FINISHED_DESC},
+    {LGW_DATA_MNGT_CPT_FRAME_READEN_DESC},
+    {LGW_TX_TRIG_ALL_DESC} /* alias */
+};
+
+/* writable registers that must not be cached nor merged, on top of the read-only ones */
+static const uint16_t shadow_volatile[] = {
+    LGW_PAGE_REG,
+    LGW_SOFT_RESET,
+    LGW_IQ_MISMATCH_A_AMP_COEFF, /* written by the calibration firmware */
+    LGW_IQ_MISMATCH_A_PHI_COEFF,
+    LGW_IQ_MISMATCH_B_AMP_COEFF,
+    LGW_IQ_MISMATCH_B_SEL_I,
+    LGW_IQ_MISMATCH_B_PHI_COEFF,
+    LGW_RX_DATA_BUF_ADDR,
+    LGW_RX_DATA_BUF_DATA,
+    LGW_TX_DATA_BUF_ADDR,
+    LGW_TX_DATA_BUF_DATA,
+    LGW_CAPTURE_RAM_ADDR,
+    LGW_CAPTURE_RAM_DATA,
+    LGW_MCU_PROM_ADDR,
+    LGW_MCU_PROM_DATA,
+    LGW_RX_PACKET_DATA_FIFO_NUM_STORED,
+    LGW_START_BIST0,
+    LGW_START_BIST1,
+    LGW_CLEAR_BIST0,
+    LGW_CLEAR_BIST1,
+    LGW_EMERGENCY_FORCE_HOST_CTRL,
+    LGW_RADIO_SELECT,
+    LGW_TX_TRIG_ALL,
+    LGW_CAPTURE_START,
+    LGW_CAPTURE_FORCE_TRIGGER,
+    LGW_DBG_ARB_MCU_RAM_DATA,
+    LGW_DBG_AGC_MCU_RAM_DATA,
+    LGW_DBG_ARB_MCU_RAM_ADDR,
+    LGW_DBG_AGC_MCU_RAM_ADDR
+};
+
+/* data ports (address auto-increment on read), never read by a snapshot */
+static const uint16_t snapshot_ports[] = {
+    LGW_RX_DATA_BUF_DATA,
+    LGW_TX_DATA_BUF_DATA,
+    LGW_CAPTURE_RAM_DATA,
+    LGW_MCU_PROM_DATA,
+    LGW_DBG_ARB_MCU_RAM_DATA,
+    LGW_DBG_AGC_MCU_RAM_DATA
+};
+
+/* FPGA registers with side effects, never written back by a snapshot restore */
+static const uint16_t snapshot_fpga_volatile[] = {
+    LGW_FPGA_SOFT_RESET,
+    LGW_FPGA_CTRL_RADIO_RESET,
+    LGW_FPGA_CTRL_ACCESS_HISTO_MEM,
+    LGW_FPGA_CTRL_CLEAR_HISTO_MEM,
+    LGW_FPGA_HISTO_RAM_ADDR
+};
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE TYPES -------------------------------------------------------- */
+
+/* page switch and access of a single register access, sent in a single SPI
+message: a small batch, the full ones are only used by the multiple accesses */
+struct prefix_s {
+    struct lgw_spi_batch_s  batch;
+    struct lgw_spi_op_s     op[2];
+};
+
+/* arguments of the calls executed by the SPI worker thread */
+struct reg_w_args_s {
+    uint16_t register_id;
+    int32_t reg_value;
+};
+
+struct reg_r_args_s {
+    uint16_t register_id;
+    int32_t *reg_value;
+};
+
+struct reg_w_multi_args_s {
+    struct lgw_reg_val_s *regs;
+    int nb_regs;
+};
+
+struct reg_r_multi_args_s {
+    struct lgw_reg_val_s *regs;
+    int nb_regs;
+};
+
+struct reg_wb_args_s {
+    uint16_t register_id;
+    uint8_t *data;
+    uint16_t size;
+};
+
+struct reg_rb_args_s {
+    uint16_t register_id;
+    uint8_t *data;
+    uint16_t size;
+};
+
+struct reg_burst_seq_args_s {
+    const struct lgw_reg_burst_s *bursts;
+    int nb_bursts;
+};
+
+struct reg_script_compile_args_s {
+    const struct lgw_reg_val_s *regs;
+    int nb_regs;
+    struct lgw_reg_script_s *script;
 };
 
 /* -------------------------------------------------------------------------- */
@@ -390,16 +503,52 @@ const struct lgw_reg_s loregs[LGW_TOTALREGS] = {
 
 static int lgw_regpage = -1; /*! keep the value of the register page selected */
 
+static bool lgw_shadow_en = false; /*! host-side copy of the registers in use */
+static uint8_t lgw_shadow[SHADOW_SIZE]; /*! host-side copy of the register bytes */
+static uint8_t lgw_shadow_flag[SHADOW_SIZE]; /*! SHADOW_VALID/SHADOW_VOLATILE/SHADOW_NOBURST flags of each byte */
+static bool lgw_shadow_ready = false; /*! volatile flags have been computed */
+
+static struct lgw_reg_stat_s stat_reg[LGW_TOTALREGS]; /*! access counters of each register */
+static struct lgw_reg_stat_s stat_phase[LGW_REG_PHASE_NB]; /*! access counters of each phase */
+static uint8_t stat_cur_phase = LGW_REG_PHASE_OTHER; /*! phase of the current accesses */
+static int stat_cur_reg = -1; /*! register of the current access, -1 if none */
+
 /* -------------------------------------------------------------------------- */
 /* --- INTERNAL SHARED VARIABLES -------------------------------------------- */
 
+extern const struct lgw_reg_s fpga_regs[LGW_FPGA_TOTALREGS];
+
 void *lgw_spi_target = NULL; /*! generic pointer to the SPI device */
 uint8_t lgw_spi_mux_mode = 0; /*! current SPI mux mode used */
 
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE FUNCTIONS ---------------------------------------------------- */
 
+/* account a new access to a register (-1 if none) in the current phase */
+static void stat_access(int register_id) {
+    stat_cur_reg = ((register_id >= 0) && (register_id < LGW_TOTALREGS)) ? register_id : -1;
+    stat_phase[stat_cur_phase].nb_call += 1;
+    if (stat_cur_reg >= 0) {
+        stat_reg[stat_cur_reg].nb_call += 1;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* account bytes and page switches to the current access */
+static void stat_transfer(uint32_t nb_byte, uint32_t nb_page_switch) {
+    stat_phase[stat_cur_phase].nb_byte += nb_byte;
+    stat_phase[stat_cur_phase].nb_page_switch += nb_page_switch;
+    if (stat_cur_reg >= 0) {
+        stat_reg[stat_cur_reg].nb_byte += nb_byte;
+        stat_reg[stat_cur_reg].nb_page_switch += nb_page_switch;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
 int page_switch(uint8_t target) {
+    stat_transfer(0, 1);
     lgw_regpage = PAGE_MASK & target;
     lgw_spi_w(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, PAGE_ADDR, (uint8_t)lgw_regpage);
     return LGW_REG_SUCCESS;
@@ -407,6 +556,346 @@ int page_switch(uint8_t target) {
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+/* empty the prefix batch */
+static void prefix_init(struct prefix_s *prefix) {
+    lgw_spi_batch_init(&(prefix->batch), prefix->op, ARRAY_SIZE(prefix->op));
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* empty the prefix batch, then queue a page switch in it if the register is not on the selected page */
+static int page_queue(struct prefix_s *prefix, struct lgw_reg_s r) {
+    prefix_init(prefix);
+    if ((r.page != -1) && (r.page != lgw_regpage)) {
+        stat_transfer(0, 1);
+        lgw_regpage = PAGE_MASK & r.page;
+        return lgw_spi_batch_w(&(prefix->batch), lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, PAGE_ADDR, (uint8_t)lgw_regpage);
+    }
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* SPI accesses sent in a single SPI message with the operations queued in the
+prefix batch (if any), the prefix batch is emptied after use */
+
+static int fused_w(struct prefix_s *prefix, void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t data) {
+    int x;
+
+    stat_transfer(1, 0);
+    if ((prefix == NULL) || (prefix->batch.nb_op == 0)) {
+        return lgw_spi_w(spi_target, spi_mux_mode, spi_mux_target, address, data);
+    }
+    x = lgw_spi_batch_w(&(prefix->batch), spi_mux_mode, spi_mux_target, address, data);
+    x += lgw_spi_batch_submit(spi_target, &(prefix->batch));
+    lgw_spi_batch_clear(&(prefix->batch));
+    return x;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int fused_r(struct prefix_s *prefix, void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data) {
+    int x;
+
+    stat_transfer(1, 0);
+    if ((prefix == NULL) || (prefix->batch.nb_op == 0)) {
+        return lgw_spi_r(spi_target, spi_mux_mode, spi_mux_target, address, data);
+    }
+    x = lgw_spi_batch_r(&(prefix->batch), spi_mux_mode, spi_mux_target, address, data);
+    x += lgw_spi_batch_submit(spi_target, &(prefix->batch));
+    lgw_spi_batch_clear(&(prefix->batch));
+    return x;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int fused_wb(struct prefix_s *prefix, void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size) {
+    int x;
+
+    stat_transfer(size, 0);
+    if ((prefix == NULL) || (prefix->batch.nb_op == 0)) {
+        return lgw_spi_wb(spi_target, spi_mux_mode, spi_mux_target, address, data, size);
+    }
+    x = lgw_spi_batch_wb(&(prefix->batch), spi_mux_mode, spi_mux_target, address, data, size);
+    x += lgw_spi_batch_submit(spi_target, &(prefix->batch));
+    lgw_spi_batch_clear(&(prefix->batch));
+    return x;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int fused_rb(struct prefix_s *prefix, void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size) {
+    int x;
+
+    stat_transfer(size, 0);
+    if ((prefix == NULL) || (prefix->batch.nb_op == 0)) {
+        return lgw_spi_rb(spi_target, spi_mux_mode, spi_mux_target, address, data, size);
+    }
+    x = lgw_spi_batch_rb(&(prefix->batch), spi_mux_mode, spi_mux_target, address, data, size);
+    x += lgw_spi_batch_submit(spi_target, &(prefix->batch));
+    lgw_spi_batch_clear(&(prefix->batch));
+    return x;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int shadow_index(struct lgw_reg_s r) {
+    return (r.page == -1) ? r.addr : ((r.page & PAGE_MASK) * 128 + r.addr);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int shadow_size(struct lgw_reg_s r) {
+    return (r.offs + r.leng + 7) / 8;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* true if all the bytes of the register can be cached */
+static bool shadow_cacheable(struct lgw_reg_s r) {
+    int i, idx, n;
+
+    if (lgw_shadow_en == false) {
+        return false;
+    }
+    if (((r.offs + r.leng) > 8) && (r.offs != 0)) {
+        return false; /* not supported by reg_w_align32 either */
+    }
+    idx = shadow_index(r);
+    n = shadow_size(r);
+    for (i = 0; i < n; ++i) {
+        if ((lgw_shadow_flag[idx + i] & SHADOW_VOLATILE) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* (re)build the volatile flags, and the shadow content from default values if seed is true */
+static void shadow_init(bool seed) {
+    struct lgw_reg_s r;
+    uint32_t u;
+    uint8_t mask;
+    int i, j, idx, n;
+
+    memset(lgw_shadow, 0, sizeof lgw_shadow);
+    memset(lgw_shadow_flag, 0, sizeof lgw_shadow_flag);
+
+    /* mark all the bytes shared with a volatile register */
+    for (i = 0; i < LGW_TOTALREGS; ++i) {
+        r = loregs[i];
+        if (r.rdon == 1) {
+            idx = shadow_index(r);
+            n = shadow_size(r);
+            for (j = 0; j < n; ++j) {
+                lgw_shadow_flag[idx + j] |= SHADOW_VOLATILE;
+            }
+        }
+    }
+    for (i = 0; i < (int)ARRAY_SIZE(shadow_volatile); ++i) {
+        r = loregs[shadow_volatile[i]];
+        idx = shadow_index(r);
+        n = shadow_size(r);
+        for (j = 0; j < n; ++j) {
+            lgw_shadow_flag[idx + j] |= SHADOW_VOLATILE | SHADOW_NOBURST;
+        }
+    }
+    lgw_shadow_ready = true;
+
+    if (seed == false) {
+        return;
+    }
+
+    /* fill the other bytes with the default value of the registers */
+    for (i = 0; i < LGW_TOTALREGS; ++i) {
+        r = loregs[i];
+        if (shadow_cacheable(r) == false) {
+            continue;
+        }
+        idx = shadow_index(r);
+        if ((r.offs + r.leng) <= 8) {
+            mask = (uint8_t)(((1 << r.leng) - 1) << r.offs);
+            lgw_shadow[idx] = (lgw_shadow[idx] & ~mask) | (((uint8_t)r.dflt << r.offs) & mask);
+            lgw_shadow_flag[idx] |= SHADOW_VALID;
+        } else {
+            u = (uint32_t)r.dflt;
+            n = shadow_size(r);
+            for (j = 0; j < n; ++j) {
+                lgw_shadow[idx + j] = (uint8_t)(u >> (8 * j));
+                lgw_shadow_flag[idx + j] |= SHADOW_VALID;
+            }
+        }
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* true if one of the bytes of the register has the flag(s) set */
+static bool shadow_flag_any(struct lgw_reg_s r, uint8_t flag) {
+    int i, idx, n;
+
+    if (lgw_shadow_ready == false) {
+        shadow_init(false);
+    }
+    idx = shadow_index(r);
+    n = shadow_size(r);
+    for (i = 0; i < n; ++i) {
+        if ((lgw_shadow_flag[idx + i] & flag) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* update the shadow after a burst access starting on register r */
+static void shadow_burst(struct lgw_reg_s r, uint8_t *data, uint16_t size) {
+    int i, idx;
+
+    if (lgw_shadow_en == false) {
+        return;
+    }
+    idx = shadow_index(r);
+    for (i = 0; (i < size) && ((r.addr + i) < 128); ++i) {
+        if ((lgw_shadow_flag[idx + i] & SHADOW_VOLATILE) == 0) {
+            lgw_shadow[idx + i] = data[i];
+            lgw_shadow_flag[idx + i] |= SHADOW_VALID;
+        }
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* write some bits of a cacheable byte using the shadow, without read-modify-write */
+static int shadow_w_bits(struct lgw_reg_s r, uint8_t mask, uint8_t data) {
+    int spi_stat = LGW_SPI_SUCCESS;
+    struct prefix_s prefix;
+    uint8_t byte;
+    int idx;
+
+    idx = shadow_index(r);
+
+    if ((mask != 0xFF) && ((lgw_shadow_flag[idx] & SHADOW_VALID) == 0)) {
+        /* content of the other bits unknown, read the byte once */
+        spi_stat += page_queue(&prefix, r);
+        spi_stat += fused_r(&prefix, lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, &lgw_shadow[idx]);
+        if (spi_stat != LGW_SPI_SUCCESS) {
+            return spi_stat;
+        }
+        lgw_shadow_flag[idx] |= SHADOW_VALID;
+    }
+    byte = (lgw_shadow[idx] & ~mask) | (data & mask);
+    if (((lgw_shadow_flag[idx] & SHADOW_VALID) != 0) && (byte == lgw_shadow[idx])) {
+        return spi_stat; /* no change, nothing to write */
+    }
+    spi_stat += page_queue(&prefix, r);
+    spi_stat += fused_w(&prefix, lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, byte);
+
+    /* update the shadow only if the concentrator was updated */
+    if (spi_stat == LGW_SPI_SUCCESS) {
+        lgw_shadow[idx] = byte;
+    } else {
+        lgw_shadow_flag[idx] &= ~SHADOW_VALID;
+    }
+
+    return spi_stat;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* write whole cacheable bytes using the shadow, skipped if they do not change */
+static int shadow_w_bytes(struct lgw_reg_s r, const uint8_t *data, int size) {
+    int spi_stat = LGW_SPI_SUCCESS;
+    struct prefix_s prefix;
+    uint8_t buf[4];
+    bool same = true;
+    int i, idx;
+
+    idx = shadow_index(r);
+
+    for (i = 0; i < size; ++i) {
+        buf[i] = data[i];
+        if (((lgw_shadow_flag[idx + i] & SHADOW_VALID) == 0) || (buf[i] != lgw_shadow[idx + i])) {
+            same = false;
+        }
+    }
+    if (same == true) {
+        return spi_stat; /* no change, nothing to write */
+    }
+    spi_stat += page_queue(&prefix, r);
+    spi_stat += fused_wb(&prefix, lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, buf, size);
+
+    /* update the shadow only if the concentrator was updated */
+    for (i = 0; i < size; ++i) {
+        if (spi_stat == LGW_SPI_SUCCESS) {
+            lgw_shadow[idx + i] = buf[i];
+            lgw_shadow_flag[idx + i] |= SHADOW_VALID;
+        } else {
+            lgw_shadow_flag[idx + i] &= ~SHADOW_VALID;
+        }
+    }
+
+    return spi_stat;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* write a cacheable register using the shadow, without read-modify-write */
+static int reg_w_shadow(struct lgw_reg_s r, int32_t reg_value) {
+    uint8_t buf[4];
+    uint8_t mask;
+    int i, size_byte;
+
+    if ((r.offs + r.leng) <= 8) {
+        mask = (uint8_t)(((1 << r.leng) - 1) << r.offs);
+        return shadow_w_bits(r, mask, (uint8_t)reg_value << r.offs);
+    }
+    size_byte = shadow_size(r);
+    for (i = 0; i < size_byte; ++i) {
+        buf[i] = (uint8_t)(0x000000FF & reg_value); /* LSB first, same as reg_w_align32 */
+        reg_value = (reg_value >> 8);
+    }
+    return shadow_w_bytes(r, buf, size_byte);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* check the target of a byte-level access, and select the SPI mux mode to use */
+static int reg_bytes_check(uint8_t spi_mux_target, int8_t page, uint8_t addr, uint8_t size, uint8_t *spi_mux_mode) {
+    if ((size == 0) || (size > 4) || ((addr + size) > 128)) {
+        DEBUG_MSG("ERROR: REGISTER SIZE IS NOT SUPPORTED\n");
+        return LGW_REG_ERROR;
+    }
+    if (lgw_spi_target == NULL) {
+        DEBUG_MSG("ERROR: CONCENTRATOR UNCONNECTED\n");
+        return LGW_REG_ERROR;
+    }
+    if (spi_mux_target == LGW_SPI_MUX_TARGET_FPGA) {
+        *spi_mux_mode = LGW_SPI_MUX_MODE1;
+        return LGW_REG_SUCCESS;
+    } else if (spi_mux_target != LGW_SPI_MUX_TARGET_SX1301) {
+        DEBUG_MSG("ERROR: SPI MUX TARGET NOT SUPPORTED\n");
+        return LGW_REG_ERROR;
+    }
+    if (lgw_regpage < 0) {
+        DEBUG_MSG("ERROR: CONCENTRATOR UNCONNECTED\n");
+        return LGW_REG_ERROR;
+    }
+    if ((page == -1) && (addr == PAGE_ADDR)) {
+        DEBUG_MSG("ERROR: PAGE_REG AND SOFT_RESET MUST BE WRITTEN WITH LGW_REG_W\n");
+        return LGW_REG_ERROR;
+    }
+    *spi_mux_mode = lgw_spi_mux_mode;
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
 bool check_fpga_version(uint8_t version) {
     int i;
 
@@ -421,17 +910,17 @@ bool check_fpga_version(uint8_t version) {
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-int reg_w_align32(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, struct lgw_reg_s r, int32_t reg_value) {
+static int reg_w_fused(struct prefix_s *prefix, void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, struct lgw_reg_s r, int32_t reg_value) {
     int spi_stat = LGW_REG_SUCCESS;
     int i, size_byte;
     uint8_t buf[4] = "\x00\x00\x00\x00";
 
     if ((r.leng == 8) && (r.offs == 0)) {
         /* direct write */
-        spi_stat += lgw_spi_w(spi_target, spi_mux_mode, spi_mux_target, r.addr, (uint8_t)reg_value);
+        spi_stat += fused_w(prefix, spi_target, spi_mux_mode, spi_mux_target, r.addr, (uint8_t)reg_value);
     } else if ((r.offs + r.leng) <= 8) {
         /* single-byte read-modify-write, offs:[0-7], leng:[1-7] */
-        spi_stat += lgw_spi_r(spi_target, spi_mux_mode, spi_mux_target, r.addr, &buf[0]);
+        spi_stat += fused_r(prefix, spi_target, spi_mux_mode, spi_mux_target, r.addr, &buf[0]);
         buf[1] = ((1 << r.leng) - 1) << r.offs; /* bit mask */
         buf[2] = ((uint8_t)reg_value) << r.offs; /* new data offsetted */
         buf[3] = (~buf[1] & buf[0]) | (buf[1] & buf[2]); /* mixing old & new data */
@@ -445,205 +934,1390 @@ int reg_w_align32(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target
             buf[i] = (uint8_t)(0x000000FF & reg_value);
             reg_value = (reg_value >> 8);
         }
-        spi_stat += lgw_spi_wb(spi_target, spi_mux_mode, spi_mux_target, r.addr, buf, size_byte); /* write the register in one burst */
+        spi_stat += fused_wb(prefix, spi_target, spi_mux_mode, spi_mux_target, r.addr, buf, size_byte); /* write the register in one burst */
+    } else {
+        /* register spanning multiple memory bytes but with an offset */
+        DEBUG_MSG("ERROR: REGISTER SIZE AND OFFSET ARE NOT SUPPORTED\n");
+        return LGW_REG_ERROR;
+    }
+
+    return spi_stat;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int reg_r_fused(struct prefix_s *prefix, void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, struct lgw_reg_s r, int32_t *reg_value) {
+    int spi_stat = LGW_SPI_SUCCESS;
+    uint8_t bufu[4] = "\x00\x00\x00\x00";
+    int8_t *bufs = (int8_t *)bufu;
+    int i, size_byte;
+    uint32_t u = 0;
+
+    if ((r.offs + r.leng) <= 8) {
+        /* read one byte, then shift and mask bits to get reg value with sign extension if needed */
+        spi_stat += fused_r(prefix, spi_target, spi_mux_mode, spi_mux_target, r.addr, &bufu[0]);
+        bufu[1] = bufu[0] << (8 - r.leng - r.offs); /* left-align the data */
+        if (r.sign == true) {
+            bufs[2] = bufs[1] >> (8 - r.leng); /* right align the data with sign extension (ARITHMETIC right shift) */
+            *reg_value = (int32_t)bufs[2]; /* signed pointer -> 32b sign extension */
+        } else {
+            bufu[2] = bufu[1] >> (8 - r.leng); /* right align the data, no sign extension */
+            *reg_value = (int32_t)bufu[2]; /* unsigned pointer -> no sign extension */
+        }
+    } else if ((r.offs == 0) && (r.leng > 0) && (r.leng <= 32)) {
+        size_byte = (r.leng + 7) / 8; /* add a byte if it's not an exact multiple of 8 */
+        spi_stat += fused_rb(prefix, spi_target, spi_mux_mode, spi_mux_target, r.addr, bufu, size_byte);
+        u = 0;
+        for (i=(size_byte-1); i>=0; --i) {
+            u = (uint32_t)bufu[i] + (u << 8); /* transform a 4-byte array into a 32 bit word */
+        }
+        if (r.sign == true) {
+            u = u << (32 - r.leng); /* left-align the data */
+            *reg_value = (int32_t)u >> (32 - r.leng); /* right-align the data with sign extension (ARITHMETIC right shift) */
+        } else {
+            *reg_value = (int32_t)u; /* unsigned value -> return 'as is' */
+        }
     } else {
         /* register spanning multiple memory bytes but with an offset */
         DEBUG_MSG("ERROR: REGISTER SIZE AND OFFSET ARE NOT SUPPORTED\n");
         return LGW_REG_ERROR;
     }
-
-    return spi_stat;
+
+    return spi_stat;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int reg_w_align32(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, struct lgw_reg_s r, int32_t reg_value) {
+    stat_access(-1);
+    return reg_w_fused(NULL, spi_target, spi_mux_mode, spi_mux_target, r, reg_value);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int reg_r_align32(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, struct lgw_reg_s r, int32_t *reg_value) {
+    stat_access(-1);
+    return reg_r_fused(NULL, spi_target, spi_mux_mode, spi_mux_target, r, reg_value);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int reg_w_bits(uint8_t spi_mux_target, int register_id, int8_t page, uint8_t addr, uint8_t mask, uint8_t data) {
+    int spi_stat = LGW_SPI_SUCCESS;
+    struct lgw_reg_s r = {page, addr, 0, false, 8, false, 0};
+    struct prefix_s prefix;
+    uint8_t spi_mux_mode;
+    uint8_t byte;
+
+    if (reg_bytes_check(spi_mux_target, page, addr, 1, &spi_mux_mode) != LGW_REG_SUCCESS) {
+        return LGW_REG_ERROR;
+    }
+    stat_access(register_id);
+
+    if (spi_mux_target == LGW_SPI_MUX_TARGET_SX1301) {
+        if (shadow_cacheable(r) == true) {
+            spi_stat += shadow_w_bits(r, mask, data);
+            return (spi_stat == LGW_SPI_SUCCESS) ? LGW_REG_SUCCESS : LGW_REG_ERROR;
+        }
+        spi_stat += page_queue(&prefix, r);
+    } else {
+        prefix_init(&prefix); /* FPGA registers are not paged */
+    }
+
+    if (mask != 0xFF) {
+        /* single-byte read-modify-write */
+        spi_stat += fused_r(&prefix, lgw_spi_target, spi_mux_mode, spi_mux_target, addr, &byte);
+        data = (byte & ~mask) | (data & mask);
+    }
+    spi_stat += fused_w(&prefix, lgw_spi_target, spi_mux_mode, spi_mux_target, addr, data);
+
+    return (spi_stat == LGW_SPI_SUCCESS) ? LGW_REG_SUCCESS : LGW_REG_ERROR;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int reg_w_bytes(uint8_t spi_mux_target, int register_id, int8_t page, uint8_t addr, const uint8_t *data, uint8_t size) {
+    int spi_stat = LGW_SPI_SUCCESS;
+    struct lgw_reg_s r = {page, addr, 0, false, 8 * size, false, 0};
+    struct prefix_s prefix;
+    uint8_t spi_mux_mode;
+    uint8_t buf[4];
+
+    CHECK_NULL(data);
+    if (reg_bytes_check(spi_mux_target, page, addr, size, &spi_mux_mode) != LGW_REG_SUCCESS) {
+        return LGW_REG_ERROR;
+    }
+    stat_access(register_id);
+
+    if (spi_mux_target == LGW_SPI_MUX_TARGET_SX1301) {
+        if (shadow_cacheable(r) == true) {
+            spi_stat += shadow_w_bytes(r, data, size);
+            return (spi_stat == LGW_SPI_SUCCESS) ? LGW_REG_SUCCESS : LGW_REG_ERROR;
+        }
+        spi_stat += page_queue(&prefix, r);
+    } else {
+        prefix_init(&prefix); /* FPGA registers are not paged */
+    }
+
+    memcpy(buf, data, size);
+    spi_stat += fused_wb(&prefix, lgw_spi_target, spi_mux_mode, spi_mux_target, addr, buf, size);
+    if ((spi_stat == LGW_SPI_SUCCESS) && (spi_mux_target == LGW_SPI_MUX_TARGET_SX1301)) {
+        shadow_burst(r, buf, size); /* bytes shared with a volatile register */
+    }
+
+    return (spi_stat == LGW_SPI_SUCCESS) ? LGW_REG_SUCCESS : LGW_REG_ERROR;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int reg_r_bytes(uint8_t spi_mux_target, int register_id, int8_t page, uint8_t addr, uint8_t *data, uint8_t size) {
+    int spi_stat = LGW_SPI_SUCCESS;
+    struct lgw_reg_s r = {page, addr, 0, false, 8 * size, false, 0};
+    struct prefix_s prefix;
+    uint8_t spi_mux_mode;
+
+    CHECK_NULL(data);
+    if (reg_bytes_check(spi_mux_target, page, addr, size, &spi_mux_mode) != LGW_REG_SUCCESS) {
+        return LGW_REG_ERROR;
+    }
+    stat_access(register_id);
+
+    if (spi_mux_target == LGW_SPI_MUX_TARGET_SX1301) {
+        spi_stat += page_queue(&prefix, r);
+    } else {
+        prefix_init(&prefix); /* FPGA registers are not paged */
+    }
+
+    if (size == 1) {
+        spi_stat += fused_r(&prefix, lgw_spi_target, spi_mux_mode, spi_mux_target, addr, data);
+    } else {
+        spi_stat += fused_rb(&prefix, lgw_spi_target, spi_mux_mode, spi_mux_target, addr, data, size);
+    }
+
+    /* refresh the shadow with the bytes read */
+    if ((spi_stat == LGW_SPI_SUCCESS) && (spi_mux_target == LGW_SPI_MUX_TARGET_SX1301)) {
+        shadow_burst(r, data, size);
+    }
+
+    return (spi_stat == LGW_SPI_SUCCESS) ? LGW_REG_SUCCESS : LGW_REG_ERROR;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* extract the value of register r from the bytes starting at its address */
+static int32_t reg_decode(struct lgw_reg_s r, const uint8_t *buf) {
+    uint32_t u = 0;
+    int i;
+
+    if ((r.offs + r.leng) <= 8) {
+        u = (buf[0] >> r.offs) & ((1 << r.leng) - 1);
+    } else {
+        for (i = shadow_size(r) - 1; i >= 0; --i) {
+            u = (uint32_t)buf[i] + (u << 8);
+        }
+        if (r.leng < 32) {
+            u &= (1UL << r.leng) - 1;
+        }
+    }
+    if ((r.sign == true) && (r.leng < 32) && ((u & (1UL << (r.leng - 1))) != 0)) {
+        u |= ~((1UL << r.leng) - 1); /* sign extension */
+    }
+    return (int32_t)u;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* sort registers by page and address, keeping the order of registers at the same address */
+static int multi_sort(const struct lgw_reg_val_s *regs, int nb_regs, int *order) {
+    struct lgw_reg_s r, q;
+    int i, j, k;
+
+    for (i = 0; i < nb_regs; ++i) {
+        if (regs[i].register_id >= LGW_TOTALREGS) {
+            DEBUG_MSG("ERROR: REGISTER NUMBER OUT OF DEFINED RANGE\n");
+            return LGW_REG_ERROR;
+        }
+        r = loregs[regs[i].register_id];
+        if (((r.offs + r.leng) > 8) && (r.offs != 0)) {
+            DEBUG_MSG("ERROR: REGISTER SIZE AND OFFSET ARE NOT SUPPORTED\n");
+            return LGW_REG_ERROR;
+        }
+        /* insertion sort, stable */
+        for (j = i; j > 0; --j) {
+            q = loregs[regs[order[j - 1]].register_id];
+            if ((q.page < r.page) || ((q.page == r.page) && (q.addr <= r.addr))) {
+                break;
+            }
+        }
+        for (k = i; k > j; --k) {
+            order[k] = order[k - 1];
+        }
+        order[j] = i;
+    }
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* number of sorted registers, starting at order[start], that can be accessed in one burst */
+static int multi_run(const struct lgw_reg_val_s *regs, int nb_regs, const int *order, int start, int *run_size) {
+    struct lgw_reg_s r, q;
+    int end, i;
+
+    r = loregs[regs[order[start]].register_id];
+    end = r.addr + shadow_size(r);
+    if (shadow_flag_any(r, SHADOW_NOBURST) == true) {
+        *run_size = shadow_size(r);
+        return 1;
+    }
+    for (i = start + 1; i < nb_regs; ++i) {
+        q = loregs[regs[order[i]].register_id];
+        if ((q.page != r.page) || (q.addr > end) || (shadow_flag_any(q, SHADOW_NOBURST) == true)) {
+            break;
+        }
+        if ((q.addr + shadow_size(q)) > end) {
+            end = q.addr + shadow_size(q);
+        }
+    }
+    *run_size = end - r.addr;
+    return i - start;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* content of a burst of nb sorted registers, and bits of the burst set by the registers */
+static void multi_image(const struct lgw_reg_val_s *regs, const int *order, int start, int nb, int size, uint8_t *img, uint8_t *mask) {
+    struct lgw_reg_s r, q;
+    uint32_t u;
+    int j, k, n;
+
+    r = loregs[regs[order[start]].register_id];
+    memset(img, 0, size);
+    memset(mask, 0, size);
+    for (j = start; j < (start + nb); ++j) {
+        q = loregs[regs[order[j]].register_id];
+        k = q.addr - r.addr;
+        if ((q.offs + q.leng) <= 8) {
+            n = ((1 << q.leng) - 1) << q.offs;
+            img[k] = (img[k] & ~n) | (((uint8_t)regs[order[j]].value << q.offs) & n);
+            mask[k] |= (uint8_t)n;
+        } else {
+            u = (uint32_t)regs[order[j]].value;
+            for (n = 0; n < shadow_size(q); ++n) {
+                img[k + n] = (uint8_t)(u >> (8 * n)); /* LSB first, same as reg_w_align32 */
+                mask[k + n] = 0xFF;
+            }
+        }
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* current content of a burst starting on register r, from the shadow or the concentrator if some bits are not set by the burst */
+static int multi_base(struct prefix_s *prefix, struct lgw_reg_s r, const uint8_t *mask, int size, uint8_t *base) {
+    bool need_read = false;
+    int k, idx;
+
+    idx = shadow_index(r);
+    for (k = 0; k < size; ++k) {
+        if ((mask[k] != 0xFF) && ((lgw_shadow_en == false) || ((lgw_shadow_flag[idx + k] & (SHADOW_VALID | SHADOW_VOLATILE)) != SHADOW_VALID))) {
+            need_read = true;
+        }
+    }
+    if (need_read == true) {
+        return page_queue(prefix, r) + fused_rb(prefix, lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, base, size);
+    }
+    for (k = 0; k < size; ++k) {
+        base[k] = lgw_shadow[idx + k];
+    }
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static bool reg_in_list(uint16_t register_id, const uint16_t *list, int nb) {
+    int i;
+
+    for (i = 0; i < nb; ++i) {
+        if (list[i] == register_id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* queue the burst reads of the [start, end[ addresses of a register space, split around the skipped ones */
+static int snapshot_queue(struct lgw_spi_batch_s *batch, uint8_t spi_mux_mode, uint8_t spi_mux_target, const bool *skip, int start, int end, uint8_t *img) {
+    int x = LGW_SPI_SUCCESS;
+    int i, j;
+
+    for (i = start; i < end; i = j) {
+        if (skip[i] == true) {
+            j = i + 1;
+            continue;
+        }
+        for (j = i + 1; (j < end) && (skip[j] == false); ++j);
+        x += lgw_spi_batch_rb(batch, spi_mux_mode, spi_mux_target, (uint8_t)i, img + i, (uint16_t)(j - i));
+        stat_transfer(j - i, 0);
+    }
+    return x;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* first byte of a register in a snapshot, page-global registers are read in page 0 */
+static const uint8_t *snapshot_ptr(const struct lgw_reg_snapshot_s *snap, struct lgw_reg_s r) {
+    return (r.page == -1) ? &(snap->page[0][r.addr]) : &(snap->page[r.page][r.addr]);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* ordered writes (and reads of the read-only registers if rd is true) sent in a single SPI batch */
+static int reg_seq(struct lgw_reg_val_s *regs, int nb_regs, bool rd) {
+    int spi_stat = LGW_SPI_SUCCESS;
+    struct prefix_s prefix;
+    struct lgw_spi_op_s batch_op[LGW_SPI_BATCH_MAX_OP];
+    struct lgw_spi_batch_s batch;
+    struct lgw_reg_s r;
+    int idx_list[LGW_REG_MULTI_MAX]; /* shadow index of the bytes written by the sequence */
+    uint8_t byte_list[LGW_REG_MULTI_MAX]; /* content of these bytes, as the sequence goes */
+    uint8_t rd_list[LGW_REG_MULTI_MAX]; /* bytes read by the sequence */
+    uint8_t mask;
+    int i, j, nb, idx;
+
+    /* check input parameters */
+    CHECK_NULL(regs);
+    if ((nb_regs < 0) || (nb_regs > LGW_REG_MULTI_MAX)) {
+        DEBUG_MSG("ERROR: TOO MANY REGISTERS\n");
+        return LGW_REG_ERROR;
+    }
+    for (i = 0; i < nb_regs; ++i) {
+        if (regs[i].register_id >= LGW_TOTALREGS) {
+            DEBUG_MSG("ERROR: REGISTER NUMBER OUT OF DEFINED RANGE\n");
+            return LGW_REG_ERROR;
+        }
+        r = loregs[regs[i].register_id];
+        if ((regs[i].register_id == LGW_PAGE_REG) || (regs[i].register_id == LGW_SOFT_RESET) || ((r.rdon == 1) && (rd == false)) || ((r.offs + r.leng) > 8)) {
+            DEBUG_MSG("ERROR: REGISTER CANNOT BE PART OF A SEQUENCE\n");
+            return LGW_REG_ERROR;
+        }
+    }
+
+    /* check if SPI is initialised */
+    if ((lgw_spi_target == NULL) || (lgw_regpage < 0)) {
+        DEBUG_MSG("ERROR: CONCENTRATOR UNCONNECTED\n");
+        return LGW_REG_ERROR;
+    }
+
+    /* current content of the bytes holding bit fields, from the shadow or read once */
+    nb = 0;
+    for (i = 0; i < nb_regs; ++i) {
+        r = loregs[regs[i].register_id];
+        if (r.rdon == 1) {
+            continue;
+        }
+        idx = shadow_index(r);
+        for (j = 0; (j < nb) && (idx_list[j] != idx); ++j);
+        if (j < nb) {
+            continue;
+        }
+        idx_list[nb] = idx;
+        byte_list[nb] = 0;
+        if (r.leng != 8) {
+            if ((lgw_shadow_en == true) && ((lgw_shadow_flag[idx] & (SHADOW_VALID | SHADOW_VOLATILE)) == SHADOW_VALID)) {
+                byte_list[nb] = lgw_shadow[idx];
+            } else {
+                stat_access(regs[i].register_id);
+                spi_stat += page_queue(&prefix, r);
+                spi_stat += fused_r(&prefix, lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, &byte_list[nb]);
+            }
+        }
+        ++nb;
+    }
+
+    /* every write is sent, even if it does not change the register */
+    lgw_spi_batch_init(&batch, batch_op, LGW_SPI_BATCH_MAX_OP);
+    for (i = 0; i < nb_regs; ++i) {
+        r = loregs[regs[i].register_id];
+
+        /* room for a page switch and the access, otherwise send what is queued */
+        if ((batch.nb_op + 2) > LGW_SPI_BATCH_MAX_OP) {
+            spi_stat += lgw_spi_batch_submit(lgw_spi_target, &batch);
+            lgw_spi_batch_clear(&batch);
+        }
+        stat_access(regs[i].register_id);
+        if ((r.page != -1) && (r.page != lgw_regpage)) {
+            stat_transfer(0, 1);
+            lgw_regpage = PAGE_MASK & r.page;
+            spi_stat += lgw_spi_batch_w(&batch, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, PAGE_ADDR, (uint8_t)lgw_regpage);
+        }
+        stat_transfer(1, 0);
+        if (r.rdon == 1) {
+            spi_stat += lgw_spi_batch_r(&batch, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, &rd_list[i]);
+            continue;
+        }
+        idx = shadow_index(r);
+        for (j = 0; idx_list[j] != idx; ++j);
+        mask = (uint8_t)(((1 << r.leng) - 1) << r.offs);
+        byte_list[j] = (byte_list[j] & ~mask) | ((uint8_t)(regs[i].value << r.offs) & mask);
+        spi_stat += lgw_spi_batch_w(&batch, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, byte_list[j]);
+        shadow_burst(r, &byte_list[j], 1);
+    }
+    spi_stat += lgw_spi_batch_submit(lgw_spi_target, &batch);
+
+    /* values of the registers read */
+    for (i = 0; i < nb_regs; ++i) {
+        r = loregs[regs[i].register_id];
+        if (r.rdon == 1) {
+            regs[i].value = reg_decode(r, &rd_list[i]);
+        }
+    }
+
+    if (spi_stat != LGW_SPI_SUCCESS) {
+        DEBUG_MSG("ERROR: SPI ERROR DURING REGISTERS SEQUENCE\n");
+        shadow_init(false); /* content of the concentrator unknown */
+        return LGW_REG_ERROR;
+    } else {
+        return LGW_REG_SUCCESS;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int reg_w_job(void *arg) {
+    struct reg_w_args_s *a = arg;
+    return lgw_reg_w(a->register_id, a->reg_value);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int reg_r_job(void *arg) {
+    struct reg_r_args_s *a = arg;
+    return lgw_reg_r(a->register_id, a->reg_value);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int reg_w_multi_job(void *arg) {
+    struct reg_w_multi_args_s *a = arg;
+    return lgw_reg_w_multi(a->regs, a->nb_regs);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int reg_w_seq_job(void *arg) {
+    struct reg_w_multi_args_s *a = arg;
+    return lgw_reg_w_seq(a->regs, a->nb_regs);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int reg_seq_job(void *arg) {
+    struct reg_w_multi_args_s *a = arg;
+    return lgw_reg_seq(a->regs, a->nb_regs);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int reg_burst_seq_job(void *arg) {
+    struct reg_burst_seq_args_s *a = arg;
+    return lgw_reg_burst_seq(a->bursts, a->nb_bursts);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int reg_r_multi_job(void *arg) {
+    struct reg_r_multi_args_s *a = arg;
+    return lgw_reg_r_multi(a->regs, a->nb_regs);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int reg_wb_job(void *arg) {
+    struct reg_wb_args_s *a = arg;
+    return lgw_reg_wb(a->register_id, a->data, a->size);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int reg_rb_job(void *arg) {
+    struct reg_rb_args_s *a = arg;
+    return lgw_reg_rb(a->register_id, a->data, a->size);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int reg_script_compile_job(void *arg) {
+    struct reg_script_compile_args_s *a = arg;
+    return lgw_reg_script_compile(a->regs, a->nb_regs, a->script);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int reg_script_run_job(void *arg) {
+    return lgw_reg_script_run(arg);
+}
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC FUNCTIONS DEFINITION ------------------------------------------ */
+
+/* Concentrator connect */
+int lgw_connect(bool spi_only, uint32_t tx_notch_freq) {
+    int spi_stat = LGW_SPI_SUCCESS;
+    uint8_t u = 0;
+    int x;
+
+    /* check SPI link status */
+    if (lgw_spi_target != NULL) {
+        DEBUG_MSG("WARNING: concentrator was already connected\n");
+        lgw_spi_close(lgw_spi_target);
+    }
+
+    /* open the SPI link */
+    spi_stat = lgw_spi_open(&lgw_spi_target);
+    if (spi_stat != LGW_SPI_SUCCESS) {
+        DEBUG_MSG("ERROR CONNECTING CONCENTRATOR\n");
+        return LGW_REG_ERROR;
+    }
+
+    if (spi_only == false ) {
+        /* Detect if the gateway has an FPGA with SPI mux header support */
+        /* First, we assume there is an FPGA, and try to read its version */
+        spi_stat = lgw_spi_r(lgw_spi_target, LGW_SPI_MUX_MODE1, LGW_SPI_MUX_TARGET_FPGA, loregs[LGW_VERSION].addr, &u);
+        if (spi_stat != LGW_SPI_SUCCESS) {
+            DEBUG_MSG("ERROR READING VERSION REGISTER\n");
+            return LGW_REG_ERROR;
+        }
+        if (check_fpga_version(u) != true) {
+            /* We failed to read expected FPGA version, so let's assume there is no FPGA */
+            DEBUG_PRINTF("INFO: no FPGA detected or version not supported (v%u)\n", u);
+            lgw_spi_mux_mode = LGW_SPI_MUX_MODE0;
+        } else {
+            DEBUG_PRINTF("INFO: detected FPGA with SPI mux header (v%u)\n", u);
+            lgw_spi_mux_mode = LGW_SPI_MUX_MODE1;
+            /* FPGA Soft Reset */
+            lgw_spi_w(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_FPGA, 0, 1);
+            lgw_spi_w(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_FPGA, 0, 0);
+            /* FPGA configure */
+            x = lgw_fpga_configure(tx_notch_freq);
+            if (x != LGW_REG_SUCCESS) {
+                DEBUG_MSG("ERROR CONFIGURING FPGA\n");
+                return LGW_REG_ERROR;
+            }
+        }
+
+        /* check SX1301 version */
+        spi_stat = lgw_spi_r(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, loregs[LGW_VERSION].addr, &u);
+        if (spi_stat != LGW_SPI_SUCCESS) {
+            DEBUG_MSG("ERROR READING CHIP VERSION REGISTER\n");
+            return LGW_REG_ERROR;
+        }
+        if (u != loregs[LGW_VERSION].dflt) {
+            DEBUG_PRINTF("ERROR: NOT EXPECTED CHIP VERSION (v%u)\n", u);
+            return LGW_REG_ERROR;
+        }
+
+        /* write 0 to the page/reset register */
+        spi_stat = lgw_spi_w(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, loregs[LGW_PAGE_REG].addr, 0);
+        if (spi_stat != LGW_SPI_SUCCESS) {
+            DEBUG_MSG("ERROR WRITING PAGE REGISTER\n");
+            return LGW_REG_ERROR;
+        } else {
+            lgw_regpage = 0;
+        }
+    }
+
+    /* concentrator state unknown until next soft reset or accesses */
+    if (lgw_shadow_en == true) {
+        shadow_init(false);
+    }
+
+    DEBUG_MSG("Note: success connecting the concentrator\n");
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Concentrator disconnect */
+int lgw_disconnect(void) {
+    if (lgw_spi_target != NULL) {
+        lgw_spi_close(lgw_spi_target);
+        lgw_spi_target = NULL;
+        DEBUG_MSG("Note: success disconnecting the concentrator\n");
+        return LGW_REG_SUCCESS;
+    } else {
+        DEBUG_MSG("WARNING: concentrator was already disconnected\n");
+        return LGW_REG_ERROR;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* soft-reset function */
+int lgw_soft_reset(void) {
+    /* check if SPI is initialised */
+    if ((lgw_spi_target == NULL) || (lgw_regpage < 0)) {
+        DEBUG_MSG("ERROR: CONCENTRATOR UNCONNECTED\n");
+        return LGW_REG_ERROR;
+    }
+    lgw_spi_w(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, 0, 0x80); /* 1 -> SOFT_RESET bit */
+    lgw_regpage = 0; /* reset the paging static variable */
+    if (lgw_shadow_en == true) {
+        shadow_init(true); /* all registers back to default values */
+    }
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* enable/disable register shadow */
+int lgw_reg_shadow_enable(bool enable) {
+    lgw_shadow_en = enable;
+    if (enable == true) {
+        shadow_init(false); /* content unknown until next soft reset */
+    }
+    DEBUG_PRINTF("Note: register shadow %s\n", enable ? "enabled" : "disabled");
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* forget the content of the shadow, registers were modified behind the host */
+int lgw_reg_shadow_invalidate(void) {
+    if (lgw_shadow_en == true) {
+        shadow_init(false); /* content unknown until next soft reset */
+    }
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Select the phase of the next register accesses */
+uint8_t lgw_reg_phase_set(uint8_t phase) {
+    uint8_t prev = stat_cur_phase;
+
+    stat_cur_phase = (phase < LGW_REG_PHASE_NB) ? phase : LGW_REG_PHASE_OTHER;
+    return prev;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Access counters of a register */
+int lgw_reg_stat_get(uint16_t register_id, struct lgw_reg_stat_s *stat) {
+    CHECK_NULL(stat);
+    if (register_id >= LGW_TOTALREGS) {
+        DEBUG_MSG("ERROR: REGISTER NUMBER OUT OF DEFINED RANGE\n");
+        return LGW_REG_ERROR;
+    }
+    *stat = stat_reg[register_id];
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Access counters of a phase */
+int lgw_reg_stat_get_phase(uint8_t phase, struct lgw_reg_stat_s *stat) {
+    CHECK_NULL(stat);
+    if (phase >= LGW_REG_PHASE_NB) {
+        DEBUG_MSG("ERROR: INVALID PHASE\n");
+        return LGW_REG_ERROR;
+    }
+    *stat = stat_phase[phase];
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Reset all the access counters */
+void lgw_reg_stat_reset(void) {
+    memset(stat_reg, 0, sizeof stat_reg);
+    memset(stat_phase, 0, sizeof stat_phase);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* register verification */
+int lgw_reg_check(FILE *f) {
+    struct lgw_reg_s r;
+    struct lgw_reg_snapshot_s snap;
+    int32_t read_value;
+    char ok_msg[] = "+++MATCH+++";
+    char notok_msg[] = "###MISMATCH###";
+    char *ptr;
+    int i;
+
+    /* check if SPI is initialised */
+    if ((lgw_spi_target == NULL) || (lgw_regpage < 0)) {
+        DEBUG_MSG("ERROR: CONCENTRATOR UNCONNECTED\n");
+        fprintf(f, "ERROR: CONCENTRATOR UNCONNECTED\n");
+        return LGW_REG_ERROR;
+    }
+
+    /* read all the registers at once, data ports are read one by one */
+    if (lgw_reg_snapshot(&snap) != LGW_REG_SUCCESS) {
+        fprintf(f, "ERROR: REGISTER SNAPSHOT FAILED\n");
+        return LGW_REG_ERROR;
+    }
+
+    fprintf(f, "Start of register verification\n");
+    for (i=0; i<LGW_TOTALREGS; ++i) {
+        r = loregs[i];
+        if (lgw_reg_snapshot_get(&snap, i, &read_value) != LGW_REG_SUCCESS) {
+            lgw_reg_r(i, &read_value);
+        }
+        ptr = (read_value == r.dflt) ? ok_msg : notok_msg;
+        if (r.sign == true)
+            fprintf(f, "%s reg number %d read: %d (%x) default: %d (%x)\n", ptr, i, read_value, read_value, r.dflt, r.dflt);
+        else
+            fprintf(f, "%s reg number %d read: %u (%x) default: %u (%x)\n", ptr, i, read_value, read_value, r.dflt, r.dflt);
+    }
+    fprintf(f, "End of register verification\n");
+
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Capture all the registers in a single SPI transaction */
+int lgw_reg_snapshot(struct lgw_reg_snapshot_s *snap) {
+    int spi_stat = LGW_SPI_SUCCESS;
+    struct lgw_spi_op_s batch_op[LGW_SPI_BATCH_MAX_OP];
+    struct lgw_spi_batch_s batch;
+    struct lgw_reg_s r;
+    bool glob[128]; /* addresses of page-global registers */
+    bool skip[LGW_REG_SNAPSHOT_PAGES][128];
+    bool fpga_skip[LGW_REG_SNAPSHOT_FPGA_SIZE];
+    int fpga_end = 0;
+    int i, j, p;
+
+    /* check input parameters */
+    CHECK_NULL(snap);
+
+    /* check if SPI is initialised */
+    if ((lgw_spi_target == NULL) || (lgw_regpage < 0)) {
+        DEBUG_MSG("ERROR: CONCENTRATOR UNCONNECTED\n");
+        return LGW_REG_ERROR;
+    }
+
+    memset(snap, 0, sizeof *snap);
+    memset(glob, 0, sizeof glob);
+    memset(skip, 0, sizeof skip);
+    memset(fpga_skip, 0, sizeof fpga_skip);
+
+    /* page-global registers are only read in page 0, data ports are never read */
+    for (i = 0; i < LGW_TOTALREGS; ++i) {
+        r = loregs[i];
+        for (j = 0; (r.page == -1) && (j < shadow_size(r)); ++j) {
+            glob[r.addr + j] = true;
+        }
+    }
+    for (i = 0; i < (int)ARRAY_SIZE(snapshot_ports); ++i) {
+        r = loregs[snapshot_ports[i]];
+        for (p = 0; p < LGW_REG_SNAPSHOT_PAGES; ++p) {
+            if ((r.page == -1) || (r.page == p)) {
+                skip[p][r.addr] = true;
+            }
+        }
+    }
+    for (p = 1; p < LGW_REG_SNAPSHOT_PAGES; ++p) {
+        for (j = 0; j < 128; ++j) {
+            skip[p][j] |= glob[j];
+        }
+    }
+
+    stat_access(-1);
+    lgw_spi_batch_init(&batch, batch_op, LGW_SPI_BATCH_MAX_OP);
+    for (p = 0; p < LGW_REG_SNAPSHOT_PAGES; ++p) {
+        spi_stat += lgw_spi_batch_w(&batch, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, PAGE_ADDR, (uint8_t)p);
+        stat_transfer(0, 1);
+        spi_stat += snapshot_queue(&batch, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, skip[p], 0, 128, snap->page[p]);
+    }
+    lgw_regpage = LGW_REG_SNAPSHOT_PAGES - 1;
+
+    /* FPGA register space, up to the last register */
+    if (lgw_spi_mux_mode == LGW_SPI_MUX_MODE1) {
+        for (i = 0; i < LGW_FPGA_TOTALREGS; ++i) {
+            r = fpga_regs[i];
+            if ((r.addr + shadow_size(r)) > fpga_end) {
+                fpga_end = r.addr + shadow_size(r);
+            }
+        }
+        fpga_skip[fpga_regs[LGW_FPGA_HISTO_RAM_DATA].addr] = true;
+        spi_stat += snapshot_queue(&batch, LGW_SPI_MUX_MODE1, LGW_SPI_MUX_TARGET_FPGA, fpga_skip, 0, fpga_end, snap->fpga);
+        snap->fpga_valid = true;
+    }
+
+    spi_stat += lgw_spi_batch_submit(lgw_spi_target, &batch);
+    if (spi_stat != LGW_SPI_SUCCESS) {
+        DEBUG_MSG("ERROR: SPI ERROR DURING REGISTER SNAPSHOT\n");
+        snap->fpga_valid = false;
+        return LGW_REG_ERROR;
+    }
+
+    /* same page-global content in all pages, and refresh of the shadow */
+    for (p = 0; p < LGW_REG_SNAPSHOT_PAGES; ++p) {
+        for (j = 0; (p > 0) && (j < 128); ++j) {
+            if (glob[j] == true) {
+                snap->page[p][j] = snap->page[0][j];
+            }
+        }
+        r = loregs[LGW_PAGE_REG];
+        r.page = p;
+        shadow_burst(r, snap->page[p], 128);
+    }
+
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Decode a register from a snapshot */
+int lgw_reg_snapshot_get(const struct lgw_reg_snapshot_s *snap, uint16_t register_id, int32_t *reg_value) {
+    /* check input parameters */
+    CHECK_NULL(snap);
+    CHECK_NULL(reg_value);
+    if (register_id >= LGW_TOTALREGS) {
+        DEBUG_MSG("ERROR: REGISTER NUMBER OUT OF DEFINED RANGE\n");
+        return LGW_REG_ERROR;
+    }
+    if (reg_in_list(register_id, snapshot_ports, ARRAY_SIZE(snapshot_ports)) == true) {
+        DEBUG_MSG("ERROR: DATA PORT NOT CAPTURED IN SNAPSHOT\n");
+        return LGW_REG_ERROR;
+    }
+
+    *reg_value = reg_decode(loregs[register_id], snapshot_ptr(snap, loregs[register_id]));
+
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Decode a FPGA register from a snapshot */
+int lgw_reg_snapshot_get_fpga(const struct lgw_reg_snapshot_s *snap, uint16_t register_id, int32_t *reg_value) {
+    /* check input parameters */
+    CHECK_NULL(snap);
+    CHECK_NULL(reg_value);
+    if (register_id >= LGW_FPGA_TOTALREGS) {
+        DEBUG_MSG("ERROR: REGISTER NUMBER OUT OF DEFINED RANGE\n");
+        return LGW_REG_ERROR;
+    }
+    if ((snap->fpga_valid == false) || (register_id == LGW_FPGA_HISTO_RAM_DATA)) {
+        DEBUG_MSG("ERROR: FPGA REGISTER NOT CAPTURED IN SNAPSHOT\n");
+        return LGW_REG_ERROR;
+    }
+
+    *reg_value = reg_decode(fpga_regs[register_id], &(snap->fpga[fpga_regs[register_id].addr]));
+
+    return LGW_REG_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* List the registers with a different value in two snapshots */
+int lgw_reg_snapshot_diff(const struct lgw_reg_snapshot_s *snap_a, const struct lgw_reg_snapshot_s *snap_b, struct lgw_reg_diff_s *diff, int max_diff) {
+    int32_t a, b;
+    int i, nb_diff = 0;
+
+    /* check input parameters */
+    CHECK_NULL(snap_a);
+    CHECK_NULL(snap_b);
+    if ((max_diff < 0) || ((max_diff > 0) && (diff == NULL))) {
+        DEBUG_MSG("ERROR: INVALID DIFF ARRAY\n");
+        return LGW_REG_ERROR;
+    }
+
+    for (i = 0; i < LGW_TOTALREGS; ++i) {
+        if ((lgw_reg_snapshot_get(snap_a, i, &a) != LGW_REG_SUCCESS) || (lgw_reg_snapshot_get(snap_b, i, &b) != LGW_REG_SUCCESS) || (a == b)) {
+            continue;
+        }
+        if (nb_diff < max_diff) {
+            diff[nb_diff] = (struct lgw_reg_diff_s){false, (uint16_t)i, a, b};
+        }
+        ++nb_diff;
+    }
+    for (i = 0; (snap_a->fpga_valid == true) && (snap_b->fpga_valid == true) && (i < LGW_FPGA_TOTALREGS); ++i) {
+        if ((lgw_reg_snapshot_get_fpga(snap_a, i, &a) != LGW_REG_SUCCESS) || (lgw_reg_snapshot_get_fpga(snap_b, i, &b) != LGW_REG_SUCCESS) || (a == b)) {
+            continue;
+        }
+        if (nb_diff < max_diff) {
+            diff[nb_diff] = (struct lgw_reg_diff_s){true, (uint16_t)i, a, b};
+        }
+        ++nb_diff;
+    }
+
+    return nb_diff;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Write back the registers that differ from a snapshot */
+int lgw_reg_snapshot_restore(const struct lgw_reg_snapshot_s *snap) {
+    struct lgw_reg_snapshot_s cur;
+    struct lgw_reg_val_s regs[LGW_REG_MULTI_MAX];
+    int32_t a, b;
+    int x = LGW_REG_SUCCESS;
+    int i, nb_regs = 0;
+
+    /* check input parameters */
+    CHECK_NULL(snap);
+
+    if (lgw_reg_snapshot(&cur) != LGW_REG_SUCCESS) {
+        return LGW_REG_ERROR;
+    }
+
+    /* LoRa registers, merged in bursts */
+    for (i = 0; i < LGW_TOTALREGS; ++i) {
+        if ((loregs[i].rdon == 1) || (reg_in_list(i, shadow_volatile, ARRAY_SIZE(shadow_volatile)) == true)) {
+            continue;
+        }
+        lgw_reg_snapshot_get(snap, i, &a);
+        lgw_reg_snapshot_get(&cur, i, &b);
+        if (a == b) {
+            continue;
+        }
+        regs[nb_regs++] = (struct lgw_reg_val_s){(uint16_t)i, a};
+        if (nb_regs == LGW_REG_MULTI_MAX) {
+            x |= lgw_reg_w_multi(regs, nb_regs);
+            nb_regs = 0;
+        }
+    }
+    x |= lgw_reg_w_multi(regs, nb_regs);
+
+    /* FPGA registers */
+    for (i = 0; (snap->fpga_valid == true) && (cur.fpga_valid == true) && (i < LGW_FPGA_TOTALREGS); ++i) {
+        if ((fpga_regs[i].rdon == 1) || (reg_in_list(i, snapshot_fpga_volatile, ARRAY_SIZE(snapshot_fpga_volatile)) == true)) {
+            continue;
+        }
+        lgw_reg_snapshot_get_fpga(snap, i, &a);
+        lgw_reg_snapshot_get_fpga(&cur, i, &b);
+        if (a != b) {
+            x |= lgw_fpga_reg_w(i, a);
+        }
+    }
+
+    if (x != LGW_REG_SUCCESS) {
+        DEBUG_MSG("ERROR: SNAPSHOT RESTORE FAILED\n");
+        return LGW_REG_ERROR;
+    } else {
+        return LGW_REG_SUCCESS;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Write to a register addressed by name */
+int lgw_reg_w(uint16_t register_id, int32_t reg_value) {
+    int spi_stat = LGW_SPI_SUCCESS;
+    struct lgw_reg_s r;
+    struct prefix_s prefix;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct reg_w_args_s args = {register_id, reg_value};
+        return lgw_worker_call(reg_w_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
+    /* check input parameters */
+    if (register_id >= LGW_TOTALREGS) {
+        DEBUG_MSG("ERROR: REGISTER NUMBER OUT OF DEFINED RANGE\n");
+        return LGW_REG_ERROR;
+    }
+
+    /* check if SPI is initialised */
+    if ((lgw_spi_target == NULL) || (lgw_regpage < 0)) {
+        DEBUG_MSG("ERROR: CONCENTRATOR UNCONNECTED\n");
+        return LGW_REG_ERROR;
+    }
+
+    stat_access(register_id);
+
+    /* intercept direct access to PAGE_REG & SOFT_RESET */
+    if (register_id == LGW_PAGE_REG) {
+        page_switch(reg_value);
+        return LGW_REG_SUCCESS;
+    } else if (register_id == LGW_SOFT_RESET) {
+        /* only reset if lsb is 1 */
+        if ((reg_value & 0x01) != 0)
+            lgw_soft_reset();
+        return LGW_REG_SUCCESS;
+    }
+
+    /* get register struct from the struct array */
+    r = loregs[register_id];
+
+    /* reject write to read-only registers */
+    if (r.rdon == 1){
+        DEBUG_MSG("ERROR: TRYING TO WRITE A READ-ONLY REGISTER\n");
+        return LGW_REG_ERROR;
+    }
+
+    if (shadow_cacheable(r) == true) {
+        /* no read-modify-write, skipped if the value does not change */
+        spi_stat += reg_w_shadow(r, reg_value);
+    } else {
+        /* select proper register page if needed, in the same SPI message as the access */
+        spi_stat += page_queue(&prefix, r);
+
+        spi_stat += reg_w_fused(&prefix, lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r, reg_value);
+    }
+
+    if (spi_stat != LGW_SPI_SUCCESS) {
+        DEBUG_MSG("ERROR: SPI ERROR DURING REGISTER WRITE\n");
+        return LGW_REG_ERROR;
+    } else {
+        return LGW_REG_SUCCESS;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Read to a register addressed by name */
+int lgw_reg_r(uint16_t register_id, int32_t *reg_value) {
+    int spi_stat = LGW_SPI_SUCCESS;
+    struct lgw_reg_s r;
+    struct prefix_s prefix;
+    uint8_t buf[4];
+    uint32_t u;
+    int i;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct reg_r_args_s args = {register_id, reg_value};
+        return lgw_worker_call(reg_r_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
+    /* check input parameters */
+    CHECK_NULL(reg_value);
+    if (register_id >= LGW_TOTALREGS) {
+        DEBUG_MSG("ERROR: REGISTER NUMBER OUT OF DEFINED RANGE\n");
+        return LGW_REG_ERROR;
+    }
+
+    /* check if SPI is initialised */
+    if ((lgw_spi_target == NULL) || (lgw_regpage < 0)) {
+        DEBUG_MSG("ERROR: CONCENTRATOR UNCONNECTED\n");
+        return LGW_REG_ERROR;
+    }
+
+    stat_access(register_id);
+
+    /* get register struct from the struct array */
+    r = loregs[register_id];
+
+    /* select proper register page if needed, in the same SPI message as the access */
+    spi_stat += page_queue(&prefix, r);
+
+    spi_stat += reg_r_fused(&prefix, lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r, reg_value);
+
+    /* refresh the shadow of registers made of whole bytes */
+    if ((spi_stat == LGW_SPI_SUCCESS) && (r.offs == 0) && ((r.leng % 8) == 0) && (shadow_cacheable(r) == true)) {
+        u = (uint32_t)*reg_value;
+        for (i = 0; i < (r.leng / 8); ++i) {
+            buf[i] = (uint8_t)(u >> (8 * i));
+        }
+        shadow_burst(r, buf, r.leng / 8);
+    }
+
+    if (spi_stat != LGW_SPI_SUCCESS) {
+        DEBUG_MSG("ERROR: SPI ERROR DURING REGISTER WRITE\n");
+        return LGW_REG_ERROR;
+    } else {
+        return LGW_REG_SUCCESS;
+    }
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-int reg_r_align32(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, struct lgw_reg_s r, int32_t *reg_value) {
+/* Write multiple registers, coalesced in bursts */
+int lgw_reg_w_multi(const struct lgw_reg_val_s *regs, int nb_regs) {
     int spi_stat = LGW_SPI_SUCCESS;
-    uint8_t bufu[4] = "\x00\x00\x00\x00";
-    int8_t *bufs = (int8_t *)bufu;
-    int i, size_byte;
-    uint32_t u = 0;
+    struct prefix_s prefix;
+    struct lgw_reg_s r;
+    int order[LGW_REG_MULTI_MAX];
+    uint8_t img[128]; /* new content of the bytes of the burst */
+    uint8_t mask[128]; /* bits of the bytes of the burst set by the registers */
+    uint8_t base[128]; /* current content of the bytes of the burst */
+    bool same;
+    int i, j, k, nb, size, idx;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct reg_w_multi_args_s args = {(struct lgw_reg_val_s *)regs, nb_regs};
+        return lgw_worker_call(reg_w_multi_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
 
-    if ((r.offs + r.leng) <= 8) {
-        /* read one byte, then shift and mask bits to get reg value with sign extension if needed */
-        spi_stat += lgw_spi_r(spi_target, spi_mux_mode, spi_mux_target, r.addr, &bufu[0]);
-        bufu[1] = bufu[0] << (8 - r.leng - r.offs); /* left-align the data */
-        if (r.sign == true) {
-            bufs[2] = bufs[1] >> (8 - r.leng); /* right align the data with sign extension (ARITHMETIC right shift) */
-            *reg_value = (int32_t)bufs[2]; /* signed pointer -> 32b sign extension */
-        } else {
-            bufu[2] = bufu[1] >> (8 - r.leng); /* right align the data, no sign extension */
-            *reg_value = (int32_t)bufu[2]; /* unsigned pointer -> no sign extension */
+    /* check input parameters */
+    CHECK_NULL(regs);
+    if ((nb_regs < 0) || (nb_regs > LGW_REG_MULTI_MAX)) {
+        DEBUG_MSG("ERROR: TOO MANY REGISTERS\n");
+        return LGW_REG_ERROR;
+    }
+    if (multi_sort(regs, nb_regs, order) != LGW_REG_SUCCESS) {
+        return LGW_REG_ERROR;
+    }
+    for (i = 0; i < nb_regs; ++i) {
+        if ((regs[i].register_id == LGW_PAGE_REG) || (regs[i].register_id == LGW_SOFT_RESET) || (loregs[regs[i].register_id].rdon == 1)) {
+            DEBUG_MSG("ERROR: REGISTER CANNOT BE PART OF A MULTIPLE WRITE\n");
+            return LGW_REG_ERROR;
         }
-    } else if ((r.offs == 0) && (r.leng > 0) && (r.leng <= 32)) {
-        size_byte = (r.leng + 7) / 8; /* add a byte if it's not an exact multiple of 8 */
-        spi_stat += lgw_spi_rb(spi_target, spi_mux_mode, spi_mux_target, r.addr, bufu, size_byte);
-        u = 0;
-        for (i=(size_byte-1); i>=0; --i) {
-            u = (uint32_t)bufu[i] + (u << 8); /* transform a 4-byte array into a 32 bit word */
+    }
+
+    /* check if SPI is initialised */
+    if ((lgw_spi_target == NULL) || (lgw_regpage < 0)) {
+        DEBUG_MSG("ERROR: CONCENTRATOR UNCONNECTED\n");
+        return LGW_REG_ERROR;
+    }
+
+    for (i = 0; i < nb_regs; i += nb) {
+        nb = multi_run(regs, nb_regs, order, i, &size);
+        r = loregs[regs[order[i]].register_id];
+        if (nb == 1) {
+            /* single register, usual write (with shadow if enabled) */
+            if (lgw_reg_w(regs[order[i]].register_id, regs[order[i]].value) != LGW_REG_SUCCESS) {
+                spi_stat = LGW_SPI_ERROR;
+            }
+            continue;
         }
-        if (r.sign == true) {
-            u = u << (32 - r.leng); /* left-align the data */
-            *reg_value = (int32_t)u >> (32 - r.leng); /* right-align the data with sign extension (ARITHMETIC right shift) */
-        } else {
-            *reg_value = (int32_t)u; /* unsigned value -> return 'as is' */
+
+        /* count an access for each register, the burst for the first one */
+        for (j = (i + nb - 1); j >= i; --j) {
+            stat_access(regs[order[j]].register_id);
+        }
+
+        /* build the content of the burst, with the bits not set by the registers */
+        multi_image(regs, order, i, nb, size, img, mask);
+        spi_stat += multi_base(&prefix, r, mask, size, base);
+        idx = shadow_index(r);
+        same = lgw_shadow_en;
+        for (k = 0; k < size; ++k) {
+            img[k] = (base[k] & ~mask[k]) | (img[k] & mask[k]);
+            if ((lgw_shadow_en == true) && (((lgw_shadow_flag[idx + k] & (SHADOW_VALID | SHADOW_VOLATILE)) != SHADOW_VALID) || (img[k] != lgw_shadow[idx + k]))) {
+                same = false;
+            }
+        }
+
+        /* write the burst, unless the content does not change */
+        if (same == false) {
+            spi_stat += page_queue(&prefix, r);
+            spi_stat += fused_wb(&prefix, lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, img, size);
+            if (spi_stat == LGW_SPI_SUCCESS) {
+                shadow_burst(r, img, size);
+            }
         }
-    } else {
-        /* register spanning multiple memory bytes but with an offset */
-        DEBUG_MSG("ERROR: REGISTER SIZE AND OFFSET ARE NOT SUPPORTED\n");
-        return LGW_REG_ERROR;
     }
 
-    return spi_stat;
+    if (spi_stat != LGW_SPI_SUCCESS) {
+        DEBUG_MSG("ERROR: SPI ERROR DURING MULTIPLE REGISTERS WRITE\n");
+        return LGW_REG_ERROR;
+    } else {
+        return LGW_REG_SUCCESS;
+    }
 }
 
-/* -------------------------------------------------------------------------- */
-/* --- PUBLIC FUNCTIONS DEFINITION ------------------------------------------ */
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-/* Concentrator connect */
-int lgw_connect(bool spi_only, uint32_t tx_notch_freq) {
+/* Read multiple registers, coalesced in bursts */
+int lgw_reg_r_multi(struct lgw_reg_val_s *regs, int nb_regs) {
     int spi_stat = LGW_SPI_SUCCESS;
-    uint8_t u = 0;
-    int x;
+    struct prefix_s prefix;
+    struct lgw_reg_s r;
+    int order[LGW_REG_MULTI_MAX];
+    uint8_t buf[128];
+    int i, j, nb, size;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct reg_r_multi_args_s args = {regs, nb_regs};
+        return lgw_worker_call(reg_r_multi_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
 
-    /* check SPI link status */
-    if (lgw_spi_target != NULL) {
-        DEBUG_MSG("WARNING: concentrator was already connected\n");
-        lgw_spi_close(lgw_spi_target);
+    /* check input parameters */
+    CHECK_NULL(regs);
+    if ((nb_regs < 0) || (nb_regs > LGW_REG_MULTI_MAX)) {
+        DEBUG_MSG("ERROR: TOO MANY REGISTERS\n");
+        return LGW_REG_ERROR;
+    }
+    if (multi_sort(regs, nb_regs, order) != LGW_REG_SUCCESS) {
+        return LGW_REG_ERROR;
     }
 
-    /* open the SPI link */
-    spi_stat = lgw_spi_open(&lgw_spi_target);
-    if (spi_stat != LGW_SPI_SUCCESS) {
-        DEBUG_MSG("ERROR CONNECTING CONCENTRATOR\n");
+    /* check if SPI is initialised */
+    if ((lgw_spi_target == NULL) || (lgw_regpage < 0)) {
+        DEBUG_MSG("ERROR: CONCENTRATOR UNCONNECTED\n");
         return LGW_REG_ERROR;
     }
 
-    if (spi_only == false ) {
-        /* Detect if the gateway has an FPGA with SPI mux header support */
-        /* First, we assume there is an FPGA, and try to read its version */
-        spi_stat = lgw_spi_r(lgw_spi_target, LGW_SPI_MUX_MODE1, LGW_SPI_MUX_TARGET_FPGA, loregs[LGW_VERSION].addr, &u);
-        if (spi_stat != LGW_SPI_SUCCESS) {
-            DEBUG_MSG("ERROR READING VERSION REGISTER\n");
-            return LGW_REG_ERROR;
-        }
-        if (check_fpga_version(u) != true) {
-            /* We failed to read expected FPGA version, so let's assume there is no FPGA */
-            DEBUG_PRINTF("INFO: no FPGA detected or version not supported (v%u)\n", u);
-            lgw_spi_mux_mode = LGW_SPI_MUX_MODE0;
-        } else {
-            DEBUG_PRINTF("INFO: detected FPGA with SPI mux header (v%u)\n", u);
-            lgw_spi_mux_mode = LGW_SPI_MUX_MODE1;
-            /* FPGA Soft Reset */
-            lgw_spi_w(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_FPGA, 0, 1);
-            lgw_spi_w(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_FPGA, 0, 0);
-            /* FPGA configure */
-            x = lgw_fpga_configure(tx_notch_freq);
-            if (x != LGW_REG_SUCCESS) {
-                DEBUG_MSG("ERROR CONFIGURING FPGA\n");
-                return LGW_REG_ERROR;
+    for (i = 0; i < nb_regs; i += nb) {
+        nb = multi_run(regs, nb_regs, order, i, &size);
+        r = loregs[regs[order[i]].register_id];
+        if (nb == 1) {
+            if (lgw_reg_r(regs[order[i]].register_id, &(regs[order[i]].value)) != LGW_REG_SUCCESS) {
+                spi_stat = LGW_SPI_ERROR;
             }
+            continue;
         }
-
-        /* check SX1301 version */
-        spi_stat = lgw_spi_r(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, loregs[LGW_VERSION].addr, &u);
-        if (spi_stat != LGW_SPI_SUCCESS) {
-            DEBUG_MSG("ERROR READING CHIP VERSION REGISTER\n");
-            return LGW_REG_ERROR;
+        for (j = (i + nb - 1); j >= i; --j) {
+            stat_access(regs[order[j]].register_id); /* burst counted for the first register */
         }
-        if (u != loregs[LGW_VERSION].dflt) {
-            DEBUG_PRINTF("ERROR: NOT EXPECTED CHIP VERSION (v%u)\n", u);
-            return LGW_REG_ERROR;
+        spi_stat += page_queue(&prefix, r);
+        spi_stat += fused_rb(&prefix, lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, buf, size);
+        for (j = i; j < (i + nb); ++j) {
+            regs[order[j]].value = reg_decode(loregs[regs[order[j]].register_id], buf + (loregs[regs[order[j]].register_id].addr - r.addr));
         }
-
-        /* write 0 to the page/reset register */
-        spi_stat = lgw_spi_w(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, loregs[LGW_PAGE_REG].addr, 0);
-        if (spi_stat != LGW_SPI_SUCCESS) {
-            DEBUG_MSG("ERROR WRITING PAGE REGISTER\n");
-            return LGW_REG_ERROR;
-        } else {
-            lgw_regpage = 0;
+        if (spi_stat == LGW_SPI_SUCCESS) {
+            shadow_burst(r, buf, size); /* only the cacheable bytes are updated */
         }
     }
 
-    DEBUG_MSG("Note: success connecting the concentrator\n");
-    return LGW_REG_SUCCESS;
+    if (spi_stat != LGW_SPI_SUCCESS) {
+        DEBUG_MSG("ERROR: SPI ERROR DURING MULTIPLE REGISTERS READ\n");
+        return LGW_REG_ERROR;
+    } else {
+        return LGW_REG_SUCCESS;
+    }
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-/* Concentrator disconnect */
-int lgw_disconnect(void) {
-    if (lgw_spi_target != NULL) {
-        lgw_spi_close(lgw_spi_target);
-        lgw_spi_target = NULL;
-        DEBUG_MSG("Note: success disconnecting the concentrator\n");
-        return LGW_REG_SUCCESS;
-    } else {
-        DEBUG_MSG("WARNING: concentrator was already disconnected\n");
-        return LGW_REG_ERROR;
+/* Write multiple registers in the given order, in a single SPI batch */
+int lgw_reg_w_seq(const struct lgw_reg_val_s *regs, int nb_regs) {
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct reg_w_multi_args_s args = {(struct lgw_reg_val_s *)regs, nb_regs};
+        return lgw_worker_call(reg_w_seq_job, &args, LGW_WORKER_PRIO_NORMAL);
     }
+
+    /* the array is not modified, as read-only registers are rejected */
+    return reg_seq((struct lgw_reg_val_s *)regs, nb_regs, false);
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-/* soft-reset function */
-int lgw_soft_reset(void) {
-    /* check if SPI is initialised */
-    if ((lgw_spi_target == NULL) || (lgw_regpage < 0)) {
-        DEBUG_MSG("ERROR: CONCENTRATOR UNCONNECTED\n");
-        return LGW_REG_ERROR;
+/* Write and read multiple registers in the given order, in a single SPI batch */
+int lgw_reg_seq(struct lgw_reg_val_s *regs, int nb_regs) {
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct reg_w_multi_args_s args = {regs, nb_regs};
+        return lgw_worker_call(reg_seq_job, &args, LGW_WORKER_PRIO_NORMAL);
     }
-    lgw_spi_w(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, 0, 0x80); /* 1 -> SOFT_RESET bit */
-    lgw_regpage = 0; /* reset the paging static variable */
-    return LGW_REG_SUCCESS;
+
+    return reg_seq(regs, nb_regs, true);
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-/* register verification */
-int lgw_reg_check(FILE *f) {
+/* Burst accesses in the given order, in a single SPI batch */
+int lgw_reg_burst_seq(const struct lgw_reg_burst_s *bursts, int nb_bursts) {
+    int spi_stat = LGW_SPI_SUCCESS;
+    struct lgw_spi_op_s batch_op[LGW_SPI_BATCH_MAX_OP];
+    struct lgw_spi_batch_s batch;
     struct lgw_reg_s r;
-    int32_t read_value;
-    char ok_msg[] = "+++MATCH+++";
-    char notok_msg[] = "###MISMATCH###";
-    char *ptr;
     int i;
 
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct reg_burst_seq_args_s args = {bursts, nb_bursts};
+        return lgw_worker_call(reg_burst_seq_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
+
+    /* check input parameters */
+    CHECK_NULL(bursts);
+    if ((nb_bursts < 0) || (nb_bursts > LGW_REG_BURST_SEQ_MAX)) {
+        DEBUG_MSG("ERROR: TOO MANY BURSTS\n");
+        return LGW_REG_ERROR;
+    }
+    for (i = 0; i < nb_bursts; ++i) {
+        if ((bursts[i].data == NULL) || (bursts[i].size == 0) || (bursts[i].register_id >= LGW_TOTALREGS)) {
+            DEBUG_MSG("ERROR: INVALID BURST\n");
+            return LGW_REG_ERROR;
+        }
+        if ((bursts[i].register_id == LGW_PAGE_REG) || (bursts[i].register_id == LGW_SOFT_RESET) || ((bursts[i].read == false) && (loregs[bursts[i].register_id].rdon == 1))) {
+            DEBUG_MSG("ERROR: REGISTER CANNOT BE PART OF A BURST SEQUENCE\n");
+            return LGW_REG_ERROR;
+        }
+    }
+
     /* check if SPI is initialised */
     if ((lgw_spi_target == NULL) || (lgw_regpage < 0)) {
         DEBUG_MSG("ERROR: CONCENTRATOR UNCONNECTED\n");
-        fprintf(f, "ERROR: CONCENTRATOR UNCONNECTED\n");
         return LGW_REG_ERROR;
     }
 
-    fprintf(f, "Start of register verification\n");
-    for (i=0; i<LGW_TOTALREGS; ++i) {
-        r = loregs[i];
-        lgw_reg_r(i, &read_value);
-        ptr = (read_value == r.dflt) ? ok_msg : notok_msg;
-        if (r.sign == true)
-            fprintf(f, "%s reg number %d read: %d (%x) default: %d (%x)\n", ptr, i, read_value, read_value, r.dflt, r.dflt);
-        else
-            fprintf(f, "%s reg number %d read: %u (%x) default: %u (%x)\n", ptr, i, read_value, read_value, r.dflt, r.dflt);
+    /* at most one page switch per burst, always fits in a single batch */
+    lgw_spi_batch_init(&batch, batch_op, LGW_SPI_BATCH_MAX_OP);
+    for (i = 0; i < nb_bursts; ++i) {
+        r = loregs[bursts[i].register_id];
+        stat_access(bursts[i].register_id);
+        if ((r.page != -1) && (r.page != lgw_regpage)) {
+            stat_transfer(0, 1);
+            lgw_regpage = PAGE_MASK & r.page;
+            spi_stat += lgw_spi_batch_w(&batch, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, PAGE_ADDR, (uint8_t)lgw_regpage);
+        }
+        stat_transfer(bursts[i].size, 0);
+        if (bursts[i].read == true) {
+            spi_stat += lgw_spi_batch_rb(&batch, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, bursts[i].data, bursts[i].size);
+        } else {
+            spi_stat += lgw_spi_batch_wb(&batch, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, bursts[i].data, bursts[i].size);
+        }
+    }
+    spi_stat += lgw_spi_batch_submit(lgw_spi_target, &batch);
+
+    if (spi_stat != LGW_SPI_SUCCESS) {
+        DEBUG_MSG("ERROR: SPI ERROR DURING BURST SEQUENCE\n");
+        shadow_init(false); /* content of the concentrator unknown */
+        return LGW_REG_ERROR;
+    }
+
+    /* shadow of the bytes accessed, in access order */
+    for (i = 0; i < nb_bursts; ++i) {
+        r = loregs[bursts[i].register_id];
+        if (shadow_cacheable(r) == true) {
+            shadow_burst(r, bursts[i].data, bursts[i].size);
+        }
     }
-    fprintf(f, "End of register verification\n");
 
     return LGW_REG_SUCCESS;
 }
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-/* Write to a register addressed by name */
-int lgw_reg_w(uint16_t register_id, int32_t reg_value) {
+/* Compile multiple registers writes into a script of bursts */
+int lgw_reg_script_compile(const struct lgw_reg_val_s *regs, int nb_regs, struct lgw_reg_script_s *script) {
     int spi_stat = LGW_SPI_SUCCESS;
+    struct prefix_s prefix;
     struct lgw_reg_s r;
+    int order[LGW_REG_MULTI_MAX];
+    uint8_t img[128]; /* content of the bytes of the burst set by the registers */
+    uint8_t mask[128]; /* bits of the bytes of the burst set by the registers */
+    uint8_t base[128]; /* current content of the bytes of the burst */
+    uint8_t *p;
+    int i, j, k, nb, size;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct reg_script_compile_args_s args = {regs, nb_regs, script};
+        return lgw_worker_call(reg_script_compile_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
 
     /* check input parameters */
-    if (register_id >= LGW_TOTALREGS) {
-        DEBUG_MSG("ERROR: REGISTER NUMBER OUT OF DEFINED RANGE\n");
+    CHECK_NULL(regs);
+    CHECK_NULL(script);
+    if ((nb_regs < 0) || (nb_regs > LGW_REG_MULTI_MAX)) {
+        DEBUG_MSG("ERROR: TOO MANY REGISTERS\n");
         return LGW_REG_ERROR;
     }
+    if (multi_sort(regs, nb_regs, order) != LGW_REG_SUCCESS) {
+        return LGW_REG_ERROR;
+    }
+    for (i = 0; i < nb_regs; ++i) {
+        r = loregs[regs[i].register_id];
+        if ((regs[i].register_id == LGW_PAGE_REG) || (regs[i].register_id == LGW_SOFT_RESET) || (r.rdon == 1) || (shadow_flag_any(r, SHADOW_NOBURST) == true)) {
+            DEBUG_MSG("ERROR: REGISTER CANNOT BE PART OF A SCRIPT\n");
+            return LGW_REG_ERROR;
+        }
+    }
 
     /* check if SPI is initialised */
     if ((lgw_spi_target == NULL) || (lgw_regpage < 0)) {
@@ -651,35 +2325,37 @@ int lgw_reg_w(uint16_t register_id, int32_t reg_value) {
         return LGW_REG_ERROR;
     }
 
-    /* intercept direct access to PAGE_REG & SOFT_RESET */
-    if (register_id == LGW_PAGE_REG) {
-        page_switch(reg_value);
-        return LGW_REG_SUCCESS;
-    } else if (register_id == LGW_SOFT_RESET) {
-        /* only reset if lsb is 1 */
-        if ((reg_value & 0x01) != 0)
-            lgw_soft_reset();
-        return LGW_REG_SUCCESS;
-    }
-
-    /* get register struct from the struct array */
-    r = loregs[register_id];
-
-    /* reject write to read-only registers */
-    if (r.rdon == 1){
-        DEBUG_MSG("ERROR: TRYING TO WRITE A READ-ONLY REGISTER\n");
-        return LGW_REG_ERROR;
-    }
+    script->size = 0;
+    script->nb_burst = 0;
+    for (i = 0; i < nb_regs; i += nb) {
+        nb = multi_run(regs, nb_regs, order, i, &size);
+        r = loregs[regs[order[i]].register_id];
+        if ((script->size + 3 + size) > LGW_REG_SCRIPT_SIZE) {
+            DEBUG_MSG("ERROR: SCRIPT TOO LARGE\n");
+            return LGW_REG_ERROR;
+        }
+        for (j = (i + nb - 1); j >= i; --j) {
+            stat_access(regs[order[j]].register_id);
+        }
 
-    /* select proper register page if needed */
-    if ((r.page != -1) && (r.page != lgw_regpage)) {
-        spi_stat += page_switch(r.page);
+        /* content of the burst, with the bits not set by the registers as they are now */
+        multi_image(regs, order, i, nb, size, img, mask);
+        spi_stat += multi_base(&prefix, r, mask, size, base);
+
+        /* burst: page (0xFF if none), address, size, content */
+        p = &(script->data[script->size]);
+        p[0] = (r.page == -1) ? 0xFF : (uint8_t)(PAGE_MASK & r.page);
+        p[1] = r.addr;
+        p[2] = (uint8_t)size;
+        for (k = 0; k < size; ++k) {
+            p[3 + k] = (base[k] & ~mask[k]) | (img[k] & mask[k]);
+        }
+        script->size += 3 + size;
+        script->nb_burst += 1;
     }
 
-    spi_stat += reg_w_align32(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r, reg_value);
-
     if (spi_stat != LGW_SPI_SUCCESS) {
-        DEBUG_MSG("ERROR: SPI ERROR DURING REGISTER WRITE\n");
+        DEBUG_MSG("ERROR: SPI ERROR DURING SCRIPT COMPILATION\n");
         return LGW_REG_ERROR;
     } else {
         return LGW_REG_SUCCESS;
@@ -688,15 +2364,24 @@ int lgw_reg_w(uint16_t register_id, int32_t reg_value) {
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-/* Read to a register addressed by name */
-int lgw_reg_r(uint16_t register_id, int32_t *reg_value) {
+/* Replay a script, all the bursts and page switches in as few SPI messages as possible */
+int lgw_reg_script_run(const struct lgw_reg_script_s *script) {
     int spi_stat = LGW_SPI_SUCCESS;
+    struct lgw_spi_op_s batch_op[LGW_SPI_BATCH_MAX_OP];
+    struct lgw_spi_batch_s batch;
     struct lgw_reg_s r;
+    uint8_t *p;
+    int i;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        return lgw_worker_call(reg_script_run_job, (void *)script, LGW_WORKER_PRIO_NORMAL);
+    }
 
     /* check input parameters */
-    CHECK_NULL(reg_value);
-    if (register_id >= LGW_TOTALREGS) {
-        DEBUG_MSG("ERROR: REGISTER NUMBER OUT OF DEFINED RANGE\n");
+    CHECK_NULL(script);
+    if (script->size > LGW_REG_SCRIPT_SIZE) {
+        DEBUG_MSG("ERROR: INVALID SCRIPT\n");
         return LGW_REG_ERROR;
     }
 
@@ -706,18 +2391,38 @@ int lgw_reg_r(uint16_t register_id, int32_t *reg_value) {
         return LGW_REG_ERROR;
     }
 
-    /* get register struct from the struct array */
-    r = loregs[register_id];
+    memset(&r, 0, sizeof r);
+    lgw_spi_batch_init(&batch, batch_op, LGW_SPI_BATCH_MAX_OP);
+    for (i = 0; i < script->size; i += 3 + p[2]) {
+        p = (uint8_t *)&(script->data[i]);
+        if (((i + 3) > script->size) || ((i + 3 + p[2]) > script->size)) {
+            DEBUG_MSG("ERROR: INVALID SCRIPT\n");
+            return LGW_REG_ERROR;
+        }
+        /* room for a page switch and the burst, otherwise send what is queued */
+        if ((batch.nb_op + 2) > LGW_SPI_BATCH_MAX_OP) {
+            spi_stat += lgw_spi_batch_submit(lgw_spi_target, &batch);
+            lgw_spi_batch_clear(&batch);
+        }
+        stat_access(-1);
+        if ((p[0] != 0xFF) && (p[0] != lgw_regpage)) {
+            stat_transfer(0, 1);
+            lgw_regpage = p[0];
+            spi_stat += lgw_spi_batch_w(&batch, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, PAGE_ADDR, p[0]);
+        }
+        stat_transfer(p[2], 0);
+        spi_stat += lgw_spi_batch_wb(&batch, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, p[1], &p[3], p[2]);
 
-    /* select proper register page if needed */
-    if ((r.page != -1) && (r.page != lgw_regpage)) {
-        spi_stat += page_switch(r.page);
+        /* shadow of the bytes of the burst */
+        r.page = (p[0] == 0xFF) ? -1 : (int8_t)p[0];
+        r.addr = p[1];
+        shadow_burst(r, &p[3], p[2]);
     }
-
-    spi_stat += reg_r_align32(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r, reg_value);
+    spi_stat += lgw_spi_batch_submit(lgw_spi_target, &batch);
 
     if (spi_stat != LGW_SPI_SUCCESS) {
-        DEBUG_MSG("ERROR: SPI ERROR DURING REGISTER WRITE\n");
+        DEBUG_MSG("ERROR: SPI ERROR DURING SCRIPT REPLAY\n");
+        shadow_init(false); /* content of the concentrator unknown */
         return LGW_REG_ERROR;
     } else {
         return LGW_REG_SUCCESS;
@@ -730,6 +2435,13 @@ int lgw_reg_r(uint16_t register_id, int32_t *reg_value) {
 int lgw_reg_wb(uint16_t register_id, uint8_t *data, uint16_t size) {
     int spi_stat = LGW_SPI_SUCCESS;
     struct lgw_reg_s r;
+    struct prefix_s prefix;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct reg_wb_args_s args = {register_id, data, size};
+        return lgw_worker_call(reg_wb_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
 
     /* check input parameters */
     CHECK_NULL(data);
@@ -748,6 +2460,8 @@ int lgw_reg_wb(uint16_t register_id, uint8_t *data, uint16_t size) {
         return LGW_REG_ERROR;
     }
 
+    stat_access(register_id);
+
     /* get register struct from the struct array */
     r = loregs[register_id];
 
@@ -757,13 +2471,14 @@ int lgw_reg_wb(uint16_t register_id, uint8_t *data, uint16_t size) {
         return LGW_REG_ERROR;
     }
 
-    /* select proper register page if needed */
-    if ((r.page != -1) && (r.page != lgw_regpage)) {
-        spi_stat += page_switch(r.page);
-    }
+    /* select proper register page if needed, in the same SPI message as the access */
+    spi_stat += page_queue(&prefix, r);
 
     /* do the burst write */
-    spi_stat += lgw_spi_wb(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, data, size);
+    spi_stat += fused_wb(&prefix, lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, data, size);
+    if ((spi_stat == LGW_SPI_SUCCESS) && (shadow_cacheable(r) == true)) {
+        shadow_burst(r, data, size);
+    }
 
     if (spi_stat != LGW_SPI_SUCCESS) {
         DEBUG_MSG("ERROR: SPI ERROR DURING REGISTER BURST WRITE\n");
@@ -779,6 +2494,13 @@ int lgw_reg_wb(uint16_t register_id, uint8_t *data, uint16_t size) {
 int lgw_reg_rb(uint16_t register_id, uint8_t *data, uint16_t size) {
     int spi_stat = LGW_SPI_SUCCESS;
     struct lgw_reg_s r;
+    struct prefix_s prefix;
+
+    /* executed by the SPI worker thread, if running */
+    if (lgw_worker_delegate() == true) {
+        struct reg_rb_args_s args = {register_id, data, size};
+        return lgw_worker_call(reg_rb_job, &args, LGW_WORKER_PRIO_NORMAL);
+    }
 
     /* check input parameters */
     CHECK_NULL(data);
@@ -797,16 +2519,19 @@ int lgw_reg_rb(uint16_t register_id, uint8_t *data, uint16_t size) {
         return LGW_REG_ERROR;
     }
 
+    stat_access(register_id);
+
     /* get register struct from the struct array */
     r = loregs[register_id];
 
-    /* select proper register page if needed */
-    if ((r.page != -1) && (r.page != lgw_regpage)) {
-        spi_stat += page_switch(r.page);
-    }
+    /* select proper register page if needed, in the same SPI message as the access */
+    spi_stat += page_queue(&prefix, r);
 
     /* do the burst read */
-    spi_stat += lgw_spi_rb(lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, data, size);
+    spi_stat += fused_rb(&prefix, lgw_spi_target, lgw_spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, r.addr, data, size);
+    if ((spi_stat == LGW_SPI_SUCCESS) && (shadow_cacheable(r) == true)) {
+        shadow_burst(r, data, size);
+    }
 
     if (spi_stat != LGW_SPI_SUCCESS) {
         DEBUG_MSG("ERROR: SPI ERROR DURING REGISTER BURST READ\n");
@@ -0,0 +1,254 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+  (C)2013 Semtech-Cycleo
+
+Description:
+    Optional background RX engine: a thread drains the concentrator RX FIFO
+    into a preallocated single-producer/single-consumer ring of packets, and
+    notifies the consumer through an eventfd (usable with poll/epoll).
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+Maintainer: Sylvain Miermont
+*/
+
+
+/* -------------------------------------------------------------------------- */
+/* --- DEPENDANCIES --------------------------------------------------------- */
+
+/* fix an issue between POSIX and C99 */
+#if __STDC_VERSION__ >= 199901L
+    #define _XOPEN_SOURCE 600
+#else
+    #define _XOPEN_SOURCE 500
+#endif
+
+#include <stdint.h>     /* C99 types */
+#include <stdbool.h>    /* bool type */
+#include <stdio.h>      /* printf fprintf */
+#include <unistd.h>     /* read, write, close */
+#include <pthread.h>    /* pthread_create, pthread_join */
+#include <sys/eventfd.h> /* eventfd */
+
+#include "loragw_rx.h"
+#include "loragw_aux.h"
+#include "loragw_worker.h"
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE MACROS ------------------------------------------------------- */
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#if DEBUG_HAL == 1
+    #define DEBUG_MSG(str)                fprintf(stderr, str)
+    #define DEBUG_PRINTF(fmt, args...)    fprintf(stderr,"%s:%d: "fmt, __FUNCTION__, __LINE__, args)
+    #define CHECK_NULL(a)                if(a==NULL){fprintf(stderr,"%s:%d: ERROR: NULL POINTER AS ARGUMENT\n", __FUNCTION__, __LINE__);return LGW_RX_ERROR;}
+#else
+    #define DEBUG_MSG(str)
+    #define DEBUG_PRINTF(fmt, args...)
+    #define CHECK_NULL(a)                if(a==NULL){return LGW_RX_ERROR;}
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE CONSTANTS ---------------------------------------------------- */
+
+#define RX_RING_MASK    (LGW_RX_RING_SIZE - 1)
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE VARIABLES ---------------------------------------------------- */
+
+static struct lgw_pkt_rx_s rx_ring[LGW_RX_RING_SIZE];
+static uint32_t rx_head = 0; /* packets queued, only written by the RX thread */
+static uint32_t rx_tail = 0; /* packets dequeued, only written by the consumer */
+static struct lgw_rx_stat_s rx_stat;
+
+static pthread_t rx_thread;
+static bool rx_running = false;
+static bool rx_worker_own = false; /* SPI worker started by lgw_rx_start */
+static unsigned long rx_poll_us;
+static int rx_fd = -1; /* eventfd, number of packets signaled and not dequeued yet */
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE FUNCTIONS DEFINITION ----------------------------------------- */
+
+static void rx_notify(uint64_t nb_pkt) {
+    if (write(rx_fd, &nb_pkt, sizeof nb_pkt) != sizeof nb_pkt) {
+        DEBUG_MSG("ERROR: FAILED TO SIGNAL RX PACKETS\n");
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void *rx_loop(void *arg) {
+    struct lgw_pkt_rx_s scratch[LGW_PKT_FIFO_SIZE]; /* packets dropped when the ring is full */
+    uint32_t tail, nb_free, idx, fill;
+    int max_pkt, nb_pkt;
+
+    (void)arg;
+    while (__atomic_load_n(&rx_running, __ATOMIC_ACQUIRE) == true) {
+        tail = __atomic_load_n(&rx_tail, __ATOMIC_ACQUIRE);
+        nb_free = LGW_RX_RING_SIZE - (rx_head - tail);
+        idx = rx_head & RX_RING_MASK;
+
+        if (nb_free == 0) {
+            /* keep draining the concentrator FIFO, the newest packets are lost */
+            max_pkt = ARRAY_SIZE(scratch);
+            nb_pkt = lgw_receive(max_pkt, scratch);
+            if (nb_pkt > 0) {
+                __atomic_fetch_add(&rx_stat.nb_drop, nb_pkt, __ATOMIC_RELAXED);
+            }
+        } else {
+            /* packets decoded in place, in contiguous free slots of the ring */
+            max_pkt = (nb_free < (LGW_RX_RING_SIZE - idx)) ? nb_free : (LGW_RX_RING_SIZE - idx);
+            if (max_pkt > LGW_PKT_FIFO_SIZE) {
+                max_pkt = LGW_PKT_FIFO_SIZE;
+            }
+            nb_pkt = lgw_receive(max_pkt, &rx_ring[idx]);
+            if (nb_pkt > 0) {
+                __atomic_store_n(&rx_head, rx_head + nb_pkt, __ATOMIC_RELEASE);
+                __atomic_fetch_add(&rx_stat.nb_pkt, nb_pkt, __ATOMIC_RELAXED);
+                fill = rx_head - tail;
+                if (fill > __atomic_load_n(&rx_stat.max_fill, __ATOMIC_RELAXED)) {
+                    __atomic_store_n(&rx_stat.max_fill, fill, __ATOMIC_RELAXED);
+                }
+                rx_notify(nb_pkt);
+            }
+        }
+        if (nb_pkt < 0) {
+            __atomic_fetch_add(&rx_stat.nb_error, 1, __ATOMIC_RELAXED);
+        }
+
+        /* concentrator FIFO empty (or error), wait before polling it again */
+        if (nb_pkt < max_pkt) {
+            wait_us(rx_poll_us);
+        }
+    }
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC FUNCTIONS DEFINITION ------------------------------------------ */
+
+int lgw_rx_start(unsigned long poll_us) {
+    if (__atomic_load_n(&rx_running, __ATOMIC_ACQUIRE) == true) {
+        DEBUG_MSG("ERROR: RX ENGINE ALREADY RUNNING\n");
+        return LGW_RX_ERROR;
+    }
+
+    rx_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (rx_fd < 0) {
+        DEBUG_MSG("ERROR: FAILED TO CREATE RX EVENTFD\n");
+        return LGW_RX_ERROR;
+    }
+    rx_head = 0;
+    rx_tail = 0;
+    rx_stat.nb_pkt = 0;
+    rx_stat.nb_drop = 0;
+    rx_stat.nb_error = 0;
+    rx_stat.max_fill = 0;
+    rx_poll_us = poll_us;
+
+    /* the application keeps calling the HAL from its own threads */
+    rx_worker_own = false;
+    if (lgw_worker_delegate() == false) {
+        if (lgw_worker_start() != LGW_WORKER_SUCCESS) {
+            DEBUG_MSG("ERROR: FAILED TO START THE SPI WORKER\n");
+            close(rx_fd);
+            rx_fd = -1;
+            return LGW_RX_ERROR;
+        }
+        rx_worker_own = true;
+    }
+
+    __atomic_store_n(&rx_running, true, __ATOMIC_RELEASE);
+    if (pthread_create(&rx_thread, NULL, rx_loop, NULL) != 0) {
+        DEBUG_MSG("ERROR: FAILED TO CREATE RX THREAD\n");
+        __atomic_store_n(&rx_running, false, __ATOMIC_RELEASE);
+        if (rx_worker_own == true) {
+            lgw_worker_stop();
+        }
+        close(rx_fd);
+        rx_fd = -1;
+        return LGW_RX_ERROR;
+    }
+
+    return LGW_RX_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_rx_stop(void) {
+    if (__atomic_load_n(&rx_running, __ATOMIC_ACQUIRE) == false) {
+        DEBUG_MSG("ERROR: RX ENGINE NOT RUNNING\n");
+        return LGW_RX_ERROR;
+    }
+
+    __atomic_store_n(&rx_running, false, __ATOMIC_RELEASE);
+    pthread_join(rx_thread, NULL);
+    if (rx_worker_own == true) {
+        lgw_worker_stop();
+    }
+    close(rx_fd);
+    rx_fd = -1;
+
+    return LGW_RX_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_rx_fd(void) {
+    return rx_fd;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_rx_dequeue(struct lgw_pkt_rx_s *pkt_data, int max_pkt) {
+    uint64_t cnt;
+    uint32_t head, nb_pkt;
+    int i;
+
+    CHECK_NULL(pkt_data);
+    if ((__atomic_load_n(&rx_running, __ATOMIC_ACQUIRE) == false) || (max_pkt < 0)) {
+        DEBUG_MSG("ERROR: RX ENGINE NOT RUNNING, OR INVALID MAX NUMBER OF PACKETS\n");
+        return LGW_RX_ERROR;
+    }
+
+    /* reset the notification before looking at the ring, so that no packet queued later is missed */
+    if (read(rx_fd, &cnt, sizeof cnt) != sizeof cnt) {
+        cnt = 0; /* nothing signaled (EAGAIN) */
+    }
+
+    head = __atomic_load_n(&rx_head, __ATOMIC_ACQUIRE);
+    nb_pkt = head - rx_tail;
+    if (nb_pkt > (uint32_t)max_pkt) {
+        nb_pkt = (uint32_t)max_pkt;
+    }
+    for (i = 0; i < (int)nb_pkt; ++i) {
+        pkt_data[i] = rx_ring[(rx_tail + i) & RX_RING_MASK];
+    }
+    __atomic_store_n(&rx_tail, rx_tail + nb_pkt, __ATOMIC_RELEASE);
+
+    /* packets left in the ring, the descriptor stays readable */
+    if (head != rx_tail) {
+        rx_notify(head - rx_tail);
+    }
+
+    return (int)nb_pkt;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_rx_stat_get(struct lgw_rx_stat_s *stat) {
+    CHECK_NULL(stat);
+
+    stat->nb_pkt = __atomic_load_n(&rx_stat.nb_pkt, __ATOMIC_RELAXED);
+    stat->nb_drop = __atomic_load_n(&rx_stat.nb_drop, __ATOMIC_RELAXED);
+    stat->nb_error = __atomic_load_n(&rx_stat.nb_error, __ATOMIC_RELAXED);
+    stat->max_fill = __atomic_load_n(&rx_stat.max_fill, __ATOMIC_RELAXED);
+
+    return LGW_RX_SUCCESS;
+}
+
+/* --- EOF ------------------------------------------------------------------ */
@@ -0,0 +1,380 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+  (C)2013 Semtech-Cycleo
+
+Description:
+    Functions to address the LoRa concentrator registers through a SPI
+    interface, dispatched to the selected host-specific backend.
+    Batches of read/write operations sent in a single transaction.
+    Access counters and latency histograms, for all backends.
+    Does not handle pagination.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+Maintainer: Sylvain Miermont
+*/
+
+
+/* -------------------------------------------------------------------------- */
+/* --- DEPENDANCIES --------------------------------------------------------- */
+
+/* fix an issue between POSIX and C99 */
+#if __STDC_VERSION__ >= 199901L
+    #define _XOPEN_SOURCE 600
+#else
+    #define _XOPEN_SOURCE 500
+#endif
+
+#include <stdint.h>        /* C99 types */
+#include <stdio.h>        /* printf fprintf */
+#include <stdlib.h>        /* getenv */
+#include <string.h>        /* strcmp, memset */
+#include <time.h>          /* clock_gettime */
+
+#include "loragw_spi.h"
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE MACROS ------------------------------------------------------- */
+
+#if DEBUG_SPI == 1
+    #define DEBUG_MSG(str)                fprintf(stderr, str)
+    #define DEBUG_PRINTF(fmt, args...)    fprintf(stderr,"%s:%d: "fmt, __FUNCTION__, __LINE__, args)
+    #define CHECK_NULL(a)                if(a==NULL){fprintf(stderr,"%s:%d: ERROR: NULL POINTER AS ARGUMENT\n", __FUNCTION__, __LINE__);return LGW_SPI_ERROR;}
+#else
+    #define DEBUG_MSG(str)
+    #define DEBUG_PRINTF(fmt, args...)
+    #define CHECK_NULL(a)                if(a==NULL){return LGW_SPI_ERROR;}
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE CONSTANTS ---------------------------------------------------- */
+
+#define READ_ACCESS     0x00
+#define WRITE_ACCESS    0x80
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE VARIABLES ---------------------------------------------------- */
+
+static const struct lgw_spi_backend_s *spi_backend = NULL; /* selected at opening if not set by user */
+static int spi_open_cnt = 0; /* number of targets currently opened with the backend */
+static struct lgw_spi_stat_s spi_stat_type[LGW_SPI_STAT_NB]; /* counters of each type of access */
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE FUNCTIONS DECLARATION ---------------------------------------- */
+
+static int batch_queue(struct lgw_spi_batch_s *batch, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t read, uint8_t *data, uint16_t size);
+
+static int batch_unroll(void *spi_target, struct lgw_spi_batch_s *batch);
+static uint64_t stat_now(void);
+static int stat_count(uint8_t type, uint64_t start_ns, uint32_t nb_byte, int x);
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE FUNCTIONS DEFINITION ----------------------------------------- */
+
+static int batch_queue(struct lgw_spi_batch_s *batch, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t read, uint8_t *data, uint16_t size) {
+    struct lgw_spi_op_s *op;
+
+    /* check input parameters */
+    CHECK_NULL(batch);
+    CHECK_NULL(data);
+    if ((address & 0x80) != 0) {
+        DEBUG_MSG("WARNING: SPI address > 127\n");
+    }
+    if (size == 0) {
+        DEBUG_MSG("ERROR: BURST OF NULL LENGTH\n");
+        return LGW_SPI_ERROR;
+    }
+    if (batch->nb_op >= batch->max_op) {
+        DEBUG_MSG("ERROR: SPI BATCH FULL\n");
+        return LGW_SPI_ERROR;
+    }
+
+    /* prepare command bytes, same framing as individual accesses */
+    op = &(batch->op[batch->nb_op]);
+    if (spi_mux_mode == LGW_SPI_MUX_MODE1) {
+        op->command[0] = spi_mux_target;
+        op->command[1] = (read ? READ_ACCESS : WRITE_ACCESS) | (address & 0x7F);
+        op->command_size = 2;
+    } else {
+        op->command[0] = (read ? READ_ACCESS : WRITE_ACCESS) | (address & 0x7F);
+        op->command_size = 1;
+    }
+    op->read = read;
+    op->data = data;
+    op->size = size;
+    batch->nb_op += 1;
+
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* for backends without native batch support: one access per queued operation */
+static int batch_unroll(void *spi_target, struct lgw_spi_batch_s *batch) {
+    struct lgw_spi_op_s *op;
+    uint8_t mux_mode, mux_target, address;
+    int spi_stat = LGW_SPI_SUCCESS;
+    int i;
+
+    for (i = 0; i < batch->nb_op; ++i) {
+        op = &(batch->op[i]);
+        if (op->command_size == 2) {
+            mux_mode = LGW_SPI_MUX_MODE1;
+            mux_target = op->command[0];
+        } else {
+            mux_mode = LGW_SPI_MUX_MODE0;
+            mux_target = LGW_SPI_MUX_TARGET_SX1301;
+        }
+        address = op->command[op->command_size - 1] & 0x7F;
+
+        if (op->read) {
+            if (op->size == 1) {
+                spi_stat += spi_backend->r(spi_target, mux_mode, mux_target, address, op->data);
+            } else {
+                spi_stat += spi_backend->rb(spi_target, mux_mode, mux_target, address, op->data, op->size);
+            }
+        } else {
+            if (op->size == 1) {
+                spi_stat += spi_backend->w(spi_target, mux_mode, mux_target, address, *(op->data));
+            } else {
+                spi_stat += spi_backend->wb(spi_target, mux_mode, mux_target, address, op->data, op->size);
+            }
+        }
+    }
+
+    return (spi_stat == LGW_SPI_SUCCESS) ? LGW_SPI_SUCCESS : LGW_SPI_ERROR;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static uint64_t stat_now(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ULL + (uint64_t)t.tv_nsec;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* account an access that started at start_ns, return its status unchanged */
+static int stat_count(uint8_t type, uint64_t start_ns, uint32_t nb_byte, int x) {
+    struct lgw_spi_stat_s *st = &spi_stat_type[type];
+    uint64_t dt = stat_now() - start_ns;
+    uint32_t us = (uint32_t)(dt / 1000);
+    int bin = 0;
+
+    while ((us != 0) && (bin < (LGW_SPI_STAT_HISTO_NB - 1))) {
+        us >>= 1;
+        bin += 1;
+    }
+    st->nb_call += 1;
+    st->nb_error += (x != LGW_SPI_SUCCESS) ? 1 : 0;
+    st->nb_byte += nb_byte;
+    st->time_ns += dt;
+    st->histo[bin] += 1;
+    return x;
+}
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC FUNCTIONS DEFINITION ------------------------------------------ */
+
+int lgw_spi_set_backend(const struct lgw_spi_backend_s *backend) {
+    if (spi_open_cnt > 0) {
+        DEBUG_MSG("ERROR: CANNOT CHANGE SPI BACKEND WHILE LINK IS OPEN\n");
+        return LGW_SPI_ERROR;
+    }
+    spi_backend = backend;
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+const struct lgw_spi_backend_s *lgw_spi_get_backend(void) {
+    return spi_backend;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* SPI initialization and configuration */
+int lgw_spi_open(void **spi_target_ptr) {
+    char *env;
+    int x;
+
+    /* select backend if user did not */
+    if (spi_backend == NULL) {
+        env = getenv("LGW_SPI_BACKEND");
+        if ((env != NULL) && (strcmp(env, "sim") == 0)) {
+            spi_backend = &lgw_spi_sim_backend;
+        } else {
+            spi_backend = &lgw_spi_native_backend;
+        }
+        DEBUG_PRINTF("Note: using %s SPI backend\n", spi_backend->name);
+    }
+
+    x = spi_backend->open(spi_target_ptr);
+    if (x == LGW_SPI_SUCCESS) {
+        spi_open_cnt += 1;
+    }
+    return x;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* SPI release */
+int lgw_spi_close(void *spi_target) {
+    CHECK_NULL(spi_backend);
+    if (spi_open_cnt > 0) {
+        spi_open_cnt -= 1;
+    }
+    return spi_backend->close(spi_target);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Simple write */
+int lgw_spi_w(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t data) {
+    uint64_t t = stat_now();
+
+    CHECK_NULL(spi_backend);
+    return stat_count(LGW_SPI_STAT_W, t, 1, spi_backend->w(spi_target, spi_mux_mode, spi_mux_target, address, data));
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Simple read */
+int lgw_spi_r(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data) {
+    uint64_t t = stat_now();
+
+    CHECK_NULL(spi_backend);
+    return stat_count(LGW_SPI_STAT_R, t, 1, spi_backend->r(spi_target, spi_mux_mode, spi_mux_target, address, data));
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Burst (multiple-byte) write */
+int lgw_spi_wb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size) {
+    uint64_t t = stat_now();
+
+    CHECK_NULL(spi_backend);
+    return stat_count(LGW_SPI_STAT_WB, t, size, spi_backend->wb(spi_target, spi_mux_mode, spi_mux_target, address, data, size));
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Burst (multiple-byte) read */
+int lgw_spi_rb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size) {
+    uint64_t t = stat_now();
+
+    CHECK_NULL(spi_backend);
+    return stat_count(LGW_SPI_STAT_RB, t, size, spi_backend->rb(spi_target, spi_mux_mode, spi_mux_target, address, data, size));
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Batch initialization, with the array storing its operations */
+void lgw_spi_batch_init(struct lgw_spi_batch_s *batch, struct lgw_spi_op_s *op, int max_op) {
+    if (batch != NULL) {
+        batch->nb_op = 0;
+        batch->max_op = (op != NULL) ? max_op : 0;
+        batch->op = op;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Batch emptying */
+void lgw_spi_batch_clear(struct lgw_spi_batch_s *batch) {
+    if (batch != NULL) {
+        batch->nb_op = 0;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Queue a simple write */
+int lgw_spi_batch_w(struct lgw_spi_batch_s *batch, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t data) {
+    int x;
+
+    CHECK_NULL(batch);
+    if (batch->nb_op >= batch->max_op) {
+        DEBUG_MSG("ERROR: SPI BATCH FULL\n");
+        return LGW_SPI_ERROR;
+    }
+
+    /* the byte is copied in the batch, the caller variable can go out of scope */
+    batch->op[batch->nb_op].byte = data;
+    x = batch_queue(batch, spi_mux_mode, spi_mux_target, address, 0, &(batch->op[batch->nb_op].byte), 1);
+
+    return x;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Queue a simple read */
+int lgw_spi_batch_r(struct lgw_spi_batch_s *batch, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data) {
+    return batch_queue(batch, spi_mux_mode, spi_mux_target, address, 1, data, 1);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Queue a burst (multiple-byte) write */
+int lgw_spi_batch_wb(struct lgw_spi_batch_s *batch, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size) {
+    return batch_queue(batch, spi_mux_mode, spi_mux_target, address, 0, data, size);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Queue a burst (multiple-byte) read */
+int lgw_spi_batch_rb(struct lgw_spi_batch_s *batch, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size) {
+    return batch_queue(batch, spi_mux_mode, spi_mux_target, address, 1, data, size);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Send a batch of operations */
+int lgw_spi_batch_submit(void *spi_target, struct lgw_spi_batch_s *batch) {
+    uint64_t t = stat_now();
+    uint32_t nb_byte = 0;
+    int i;
+
+    CHECK_NULL(spi_backend);
+    CHECK_NULL(batch);
+
+    if (batch->nb_op == 0) {
+        return LGW_SPI_SUCCESS;
+    }
+
+    for (i = 0; i < batch->nb_op; ++i) {
+        nb_byte += batch->op[i].size;
+    }
+    if (spi_backend->batch != NULL) {
+        return stat_count(LGW_SPI_STAT_BATCH, t, nb_byte, spi_backend->batch(spi_target, batch));
+    } else {
+        return stat_count(LGW_SPI_STAT_BATCH, t, nb_byte, batch_unroll(spi_target, batch));
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Counters of a type of access */
+int lgw_spi_stat_get(uint8_t type, struct lgw_spi_stat_s *stat) {
+    CHECK_NULL(stat);
+    if (type >= LGW_SPI_STAT_NB) {
+        DEBUG_MSG("ERROR: INVALID SPI STATISTICS TYPE\n");
+        return LGW_SPI_ERROR;
+    }
+    *stat = spi_stat_type[type];
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Reset all the counters */
+void lgw_spi_stat_reset(void) {
+    memset(spi_stat_type, 0, sizeof spi_stat_type);
+}
+
+/* --- EOF ------------------------------------------------------------------ */
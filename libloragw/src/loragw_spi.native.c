@@ -8,8 +8,9 @@
 
 Description:
     Host specific functions to address the LoRa concentrator registers through
-    a SPI interface.
+    a SPI interface (Linux spidev backend).
     Single-byte read/write and burst read/write.
+    Batches of read/write operations sent in a single transaction.
     Does not handle pagination.
     Could be used with multiple SPI ports in parallel (explicit file descriptor)
 
@@ -23,10 +24,10 @@ Maintainer: Sylvain Miermont
 
 #include <stdint.h>        /* C99 types */
 #include <stdio.h>        /* printf fprintf */
-#include <stdlib.h>        /* malloc free */
+#include <stdlib.h>        /* malloc free getenv strtoul */
 #include <unistd.h>        /* lseek, close */
 #include <fcntl.h>        /* open */
-#include <string.h>        /* memset */
+#include <string.h>        /* memset strncpy */
 
 #include <sys/ioctl.h>
 #include <linux/spi/spidev.h>
@@ -53,16 +54,131 @@ Maintainer: Sylvain Miermont
 
 #define READ_ACCESS     0x00
 #define WRITE_ACCESS    0x80
-#define SPI_SPEED       8000000
-#define SPI_DEV_PATH    "/dev/spidev0.0"
+#define SPI_SPEED       8000000 /* default, see lgw_spi_native_setconf */
+#define SPI_DEV_PATH    "/dev/spidev0.0" /* default, see lgw_spi_native_setconf */
 //#define SPI_DEV_PATH    "/dev/spidev32766.0"
 
+#define SPI_MSG_MAX_XFER    64      /* max number of spi_ioc_transfer per SPI_IOC_MESSAGE */
+#define SPI_MSG_MAX_BYTES   4096    /* default spidev 'bufsiz', max bytes per SPI_IOC_MESSAGE */
+#define SPI_CHUNK_MAX       (SPI_MSG_MAX_BYTES - 2) /* a burst chunk and its command must fit in a message */
+
 /* -------------------------------------------------------------------------- */
-/* --- PUBLIC FUNCTIONS DEFINITION ------------------------------------------ */
+/* --- PRIVATE TYPES -------------------------------------------------------- */
+
+/* SPI target of the native backend, one per opened port */
+struct spi_native_s {
+    int         fd;         /* spidev file descriptor */
+    uint32_t    speed_hz;   /* SPI clock applied by the driver */
+    int         chunk_size; /* max size of the data phase of a burst transfer */
+};
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE VARIABLES ---------------------------------------------------- */
+
+static struct lgw_spi_native_conf_s spi_conf = {
+    SPI_DEV_PATH,
+    SPI_SPEED,
+    LGW_BURST_CHUNK,
+    0
+};
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE FUNCTIONS DECLARATION ---------------------------------------- */
+
+static int batch_flush(int spi_device, struct spi_ioc_transfer *k, int nb_xfer, int nb_byte);
+
+static int conf_env(struct lgw_spi_native_conf_s *conf);
+
+static int spi_native_open(void **spi_target_ptr);
+static int spi_native_close(void *spi_target);
+static int spi_native_w(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t data);
+static int spi_native_r(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data);
+static int spi_native_wb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size);
+static int spi_native_rb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size);
+static int spi_native_batch(void *spi_target, struct lgw_spi_batch_s *batch);
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC VARIABLES ----------------------------------------------------- */
+
+const struct lgw_spi_backend_s lgw_spi_native_backend = {
+    "native",
+    spi_native_open,
+    spi_native_close,
+    spi_native_w,
+    spi_native_r,
+    spi_native_wb,
+    spi_native_rb,
+    spi_native_batch
+};
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE FUNCTIONS DEFINITION ----------------------------------------- */
+
+static int batch_flush(int spi_device, struct spi_ioc_transfer *k, int nb_xfer, int nb_byte) {
+    int a;
+
+    if (nb_xfer == 0) {
+        return LGW_SPI_SUCCESS;
+    }
+
+    /* CS must not stay asserted after the last transfer of the message */
+    k[nb_xfer - 1].cs_change = 0;
+    a = ioctl(spi_device, SPI_IOC_MESSAGE(nb_xfer), k);
+    DEBUG_PRINTF("BATCH: %d transfers # %d bytes # transferred %d\n", nb_xfer, nb_byte, a);
+
+    if (a != nb_byte) {
+        DEBUG_MSG("ERROR: SPI BATCH FAILURE\n");
+        return LGW_SPI_ERROR;
+    }
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* apply environment overrides on top of the user configuration */
+static int conf_env(struct lgw_spi_native_conf_s *conf) {
+    char *env;
+    char *end;
+    unsigned long val;
+
+    env = getenv("LGW_SPI_DEV");
+    if ((env != NULL) && (env[0] != '\0')) {
+        if (strlen(env) >= sizeof conf->dev_path) {
+            DEBUG_MSG("ERROR: LGW_SPI_DEV TOO LONG\n");
+            return LGW_SPI_ERROR;
+        }
+        strncpy(conf->dev_path, env, sizeof conf->dev_path);
+    }
+
+    env = getenv("LGW_SPI_SPEED");
+    if ((env != NULL) && (env[0] != '\0')) {
+        val = strtoul(env, &end, 0);
+        if ((*end != '\0') || (val == 0) || (val > 0xFFFFFFFFUL)) {
+            DEBUG_PRINTF("ERROR: INVALID LGW_SPI_SPEED %s\n", env);
+            return LGW_SPI_ERROR;
+        }
+        conf->speed_hz = (uint32_t)val;
+    }
+
+    env = getenv("LGW_SPI_CHUNK");
+    if ((env != NULL) && (env[0] != '\0')) {
+        val = strtoul(env, &end, 0);
+        if ((*end != '\0') || (val == 0) || (val > SPI_CHUNK_MAX)) {
+            DEBUG_PRINTF("ERROR: INVALID LGW_SPI_CHUNK %s\n", env);
+            return LGW_SPI_ERROR;
+        }
+        conf->chunk_size = (uint16_t)val;
+    }
+
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 /* SPI initialization and configuration */
-int lgw_spi_open(void **spi_target_ptr) {
-    int *spi_device = NULL;
+static int spi_native_open(void **spi_target_ptr) {
+    struct spi_native_s *spi_device = NULL;
+    struct lgw_spi_native_conf_s conf = spi_conf;
     int dev;
     int a=0, b=0;
     int i;
@@ -70,17 +186,23 @@ int lgw_spi_open(void **spi_target_ptr) {
     /* check input variables */
     CHECK_NULL(spi_target_ptr); /* cannot be null, must point on a void pointer (*spi_target_ptr can be null) */
 
+    /* get effective configuration */
+    if (conf_env(&conf) != LGW_SPI_SUCCESS) {
+        return LGW_SPI_ERROR;
+    }
+
     /* allocate memory for the device descriptor */
-    spi_device = malloc(sizeof(int));
+    spi_device = malloc(sizeof(struct spi_native_s));
     if (spi_device == NULL) {
         DEBUG_MSG("ERROR: MALLOC FAIL\n");
         return LGW_SPI_ERROR;
     }
 
     /* open SPI device */
-    dev = open(SPI_DEV_PATH, O_RDWR);
+    dev = open(conf.dev_path, O_RDWR);
     if (dev < 0) {
-        DEBUG_PRINTF("ERROR: failed to open SPI device %s\n", SPI_DEV_PATH);
+        DEBUG_PRINTF("ERROR: failed to open SPI device %s\n", conf.dev_path);
+        free(spi_device);
         return LGW_SPI_ERROR;
     }
 
@@ -95,8 +217,8 @@ int lgw_spi_open(void **spi_target_ptr) {
         return LGW_SPI_ERROR;
     }
 
-    /* setting SPI max clk (in Hz) */
-    i = SPI_SPEED;
+    /* setting SPI max clk (in Hz), the driver may round it down */
+    i = (int)conf.speed_hz;
     a = ioctl(dev, SPI_IOC_WR_MAX_SPEED_HZ, &i);
     b = ioctl(dev, SPI_IOC_RD_MAX_SPEED_HZ, &i);
     if ((a < 0) || (b < 0)) {
@@ -105,6 +227,8 @@ int lgw_spi_open(void **spi_target_ptr) {
         free(spi_device);
         return LGW_SPI_ERROR;
     }
+    spi_device->speed_hz = (uint32_t)i;
+    DEBUG_PRINTF("Note: SPI clock requested %u Hz, applied %u Hz\n", conf.speed_hz, spi_device->speed_hz);
 
     /* setting SPI to MSB first */
     i = 0;
@@ -124,10 +248,13 @@ int lgw_spi_open(void **spi_target_ptr) {
     if ((a < 0) || (b < 0)) {
         DEBUG_MSG("ERROR: SPI PORT FAIL TO SET 8 BITS-PER-WORD\n");
         close(dev);
+        free(spi_device);
         return LGW_SPI_ERROR;
     }
 
-    *spi_device = dev;
+    spi_device->fd = dev;
+    spi_device->chunk_size = conf.chunk_size;
+    spi_conf.speed_applied = spi_device->speed_hz;
     *spi_target_ptr = (void *)spi_device;
     DEBUG_MSG("Note: SPI port opened and configured ok\n");
     return LGW_SPI_SUCCESS;
@@ -136,7 +263,7 @@ int lgw_spi_open(void **spi_target_ptr) {
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 /* SPI release */
-int lgw_spi_close(void *spi_target) {
+static int spi_native_close(void *spi_target) {
     int spi_device;
     int a;
 
@@ -144,7 +271,7 @@ int lgw_spi_close(void *spi_target) {
     CHECK_NULL(spi_target);
 
     /* close file & deallocate file descriptor */
-    spi_device = *(int *)spi_target; /* must check that spi_target is not null beforehand */
+    spi_device = ((struct spi_native_s *)spi_target)->fd; /* must check that spi_target is not null beforehand */
     a = close(spi_device);
     free(spi_target);
 
@@ -161,7 +288,7 @@ int lgw_spi_close(void *spi_target) {
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 /* Simple write */
-int lgw_spi_w(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t data) {
+static int spi_native_w(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t data) {
     int spi_device;
     uint8_t out_buf[3];
     uint8_t command_size;
@@ -174,7 +301,7 @@ int lgw_spi_w(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, ui
         DEBUG_MSG("WARNING: SPI address > 127\n");
     }
 
-    spi_device = *(int *)spi_target; /* must check that spi_target is not null beforehand */
+    spi_device = ((struct spi_native_s *)spi_target)->fd; /* must check that spi_target is not null beforehand */
 
     /* prepare frame to be sent */
     if (spi_mux_mode == LGW_SPI_MUX_MODE1) {
@@ -192,7 +319,7 @@ int lgw_spi_w(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, ui
     memset(&k, 0, sizeof(k)); /* clear k */
     k.tx_buf = (unsigned long) out_buf;
     k.len = command_size;
-    k.speed_hz = SPI_SPEED;
+    k.speed_hz = ((struct spi_native_s *)spi_target)->speed_hz;
     k.cs_change = 0;
     k.bits_per_word = 8;
     a = ioctl(spi_device, SPI_IOC_MESSAGE(1), &k);
@@ -210,7 +337,7 @@ int lgw_spi_w(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, ui
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 /* Simple read */
-int lgw_spi_r(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data) {
+static int spi_native_r(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data) {
     int spi_device;
     uint8_t out_buf[3];
     uint8_t command_size;
@@ -225,7 +352,7 @@ int lgw_spi_r(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, ui
     }
     CHECK_NULL(data);
 
-    spi_device = *(int *)spi_target; /* must check that spi_target is not null beforehand */
+    spi_device = ((struct spi_native_s *)spi_target)->fd; /* must check that spi_target is not null beforehand */
 
     /* prepare frame to be sent */
     if (spi_mux_mode == LGW_SPI_MUX_MODE1) {
@@ -261,12 +388,12 @@ int lgw_spi_r(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, ui
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 /* Burst (multiple-byte) write */
-int lgw_spi_wb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size) {
+static int spi_native_wb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size) {
     int spi_device;
     uint8_t command[2];
     uint8_t command_size;
     struct spi_ioc_transfer k[2];
-    int size_to_do, chunk_size, offset;
+    int size_to_do, chunk_size, chunk_max, offset;
     int byte_transfered = 0;
     int i;
 
@@ -281,7 +408,7 @@ int lgw_spi_wb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, u
         return LGW_SPI_ERROR;
     }
 
-    spi_device = *(int *)spi_target; /* must check that spi_target is not null beforehand */
+    spi_device = ((struct spi_native_s *)spi_target)->fd; /* must check that spi_target is not null beforehand */
 
     /* prepare command byte */
     if (spi_mux_mode == LGW_SPI_MUX_MODE1) {
@@ -293,6 +420,7 @@ int lgw_spi_wb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, u
         command_size = 1;
     }
     size_to_do = size;
+    chunk_max = ((struct spi_native_s *)spi_target)->chunk_size;
 
     /* I/O transaction */
     memset(&k, 0, sizeof(k)); /* clear k */
@@ -301,8 +429,8 @@ int lgw_spi_wb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, u
     k[0].cs_change = 0;
     k[1].cs_change = 0;
     for (i=0; size_to_do > 0; ++i) {
-        chunk_size = (size_to_do < LGW_BURST_CHUNK) ? size_to_do : LGW_BURST_CHUNK;
-        offset = i * LGW_BURST_CHUNK;
+        chunk_size = (size_to_do < chunk_max) ? size_to_do : chunk_max;
+        offset = i * chunk_max;
         k[1].tx_buf = (unsigned long)(data + offset);
         k[1].len = chunk_size;
         byte_transfered += (ioctl(spi_device, SPI_IOC_MESSAGE(2), &k) - k[0].len );
@@ -323,12 +451,12 @@ int lgw_spi_wb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, u
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 /* Burst (multiple-byte) read */
-int lgw_spi_rb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size) {
+static int spi_native_rb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size) {
     int spi_device;
     uint8_t command[2];
     uint8_t command_size;
     struct spi_ioc_transfer k[2];
-    int size_to_do, chunk_size, offset;
+    int size_to_do, chunk_size, chunk_max, offset;
     int byte_transfered = 0;
     int i;
 
@@ -343,7 +471,7 @@ int lgw_spi_rb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, u
         return LGW_SPI_ERROR;
     }
 
-    spi_device = *(int *)spi_target; /* must check that spi_target is not null beforehand */
+    spi_device = ((struct spi_native_s *)spi_target)->fd; /* must check that spi_target is not null beforehand */
 
     /* prepare command byte */
     if (spi_mux_mode == LGW_SPI_MUX_MODE1) {
@@ -355,6 +483,7 @@ int lgw_spi_rb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, u
         command_size = 1;
     }
     size_to_do = size;
+    chunk_max = ((struct spi_native_s *)spi_target)->chunk_size;
 
     /* I/O transaction */
     memset(&k, 0, sizeof(k)); /* clear k */
@@ -363,8 +492,8 @@ int lgw_spi_rb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, u
     k[0].cs_change = 0;
     k[1].cs_change = 0;
     for (i=0; size_to_do > 0; ++i) {
-        chunk_size = (size_to_do < LGW_BURST_CHUNK) ? size_to_do : LGW_BURST_CHUNK;
-        offset = i * LGW_BURST_CHUNK;
+        chunk_size = (size_to_do < chunk_max) ? size_to_do : chunk_max;
+        offset = i * chunk_max;
         k[1].rx_buf = (unsigned long)(data + offset);
         k[1].len = chunk_size;
         byte_transfered += (ioctl(spi_device, SPI_IOC_MESSAGE(2), &k) - k[0].len );
@@ -382,4 +511,104 @@ int lgw_spi_rb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, u
     }
 }
 
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Send a batch of operations, as few SPI_IOC_MESSAGE as possible */
+static int spi_native_batch(void *spi_target, struct lgw_spi_batch_s *batch) {
+    int spi_device;
+    struct spi_ioc_transfer k[SPI_MSG_MAX_XFER];
+    struct lgw_spi_op_s *op;
+    int nb_xfer = 0;
+    int nb_byte = 0;
+    int size_to_do, chunk_size, chunk_max, offset;
+    int i;
+
+    /* check input parameters */
+    CHECK_NULL(spi_target);
+    CHECK_NULL(batch);
+
+    spi_device = ((struct spi_native_s *)spi_target)->fd; /* must check that spi_target is not null beforehand */
+
+    chunk_max = ((struct spi_native_s *)spi_target)->chunk_size;
+
+    /* build transfers array, each burst chunk is a command + data pair */
+    memset(&k, 0, sizeof(k)); /* clear k */
+    for (i = 0; i < batch->nb_op; ++i) {
+        op = &(batch->op[i]);
+        size_to_do = op->size;
+        for (offset = 0; size_to_do > 0; offset += chunk_size) {
+            chunk_size = (size_to_do < chunk_max) ? size_to_do : chunk_max;
+
+            /* send what is already queued if that chunk does not fit in the message */
+            if (((nb_xfer + 2) > SPI_MSG_MAX_XFER) || ((nb_byte + op->command_size + chunk_size) > SPI_MSG_MAX_BYTES)) {
+                if (batch_flush(spi_device, k, nb_xfer, nb_byte) != LGW_SPI_SUCCESS) {
+                    return LGW_SPI_ERROR;
+                }
+                memset(&k, 0, sizeof(k));
+                nb_xfer = 0;
+                nb_byte = 0;
+            }
+
+            /* command phase, CS kept asserted for data phase */
+            k[nb_xfer].tx_buf = (unsigned long) &(op->command[0]);
+            k[nb_xfer].len = op->command_size;
+            k[nb_xfer].cs_change = 0;
+            nb_xfer += 1;
+
+            /* data phase, read data is scattered directly into caller buffer */
+            if (op->read) {
+                k[nb_xfer].rx_buf = (unsigned long)(op->data + offset);
+            } else {
+                k[nb_xfer].tx_buf = (unsigned long)(op->data + offset);
+            }
+            k[nb_xfer].len = chunk_size;
+            k[nb_xfer].cs_change = 1; /* release CS between operations */
+            nb_xfer += 1;
+
+            nb_byte += op->command_size + chunk_size;
+            size_to_do -= chunk_size;
+        }
+    }
+
+    if (batch_flush(spi_device, k, nb_xfer, nb_byte) != LGW_SPI_SUCCESS) {
+        return LGW_SPI_ERROR;
+    }
+
+    DEBUG_MSG("Note: SPI batch success\n");
+    return LGW_SPI_SUCCESS;
+}
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC FUNCTIONS DEFINITION ------------------------------------------ */
+
+int lgw_spi_native_setconf(struct lgw_spi_native_conf_s conf) {
+    /* check input parameters */
+    if ((conf.dev_path[0] == '\0') || (memchr(conf.dev_path, '\0', sizeof conf.dev_path) == NULL)) {
+        DEBUG_MSG("ERROR: INVALID SPI DEVICE PATH\n");
+        return LGW_SPI_ERROR;
+    }
+    if (conf.speed_hz == 0) {
+        DEBUG_MSG("ERROR: INVALID SPI SPEED\n");
+        return LGW_SPI_ERROR;
+    }
+    if ((conf.chunk_size == 0) || (conf.chunk_size > SPI_CHUNK_MAX)) {
+        DEBUG_PRINTF("ERROR: INVALID SPI CHUNK SIZE, MUST BE 1 TO %d\n", SPI_CHUNK_MAX);
+        return LGW_SPI_ERROR;
+    }
+
+    /* applied speed is owned by the backend */
+    conf.speed_applied = spi_conf.speed_applied;
+    spi_conf = conf;
+
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_spi_native_getconf(struct lgw_spi_native_conf_s *conf) {
+    CHECK_NULL(conf);
+    *conf = spi_conf;
+    return LGW_SPI_SUCCESS;
+}
+
 /* --- EOF ------------------------------------------------------------------ */
@@ -0,0 +1,846 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+  (C)2013 Semtech-Cycleo
+
+Description:
+    In-memory simulation of a LoRa concentrator board, seen through the SPI
+    interface (simulation backend).
+    Models the SX1301 paged register file, RX data buffer and packet FIFO, TX
+    data buffer, MCU program RAMs and firmware start-up handshakes, SX125x
+    radios behind the SX1301 SPI bridge, and optionally the SX1301AP2 FPGA
+    registers and SX127x radio.
+    Intended for tests and host CPU benchmarks, not for RF accuracy.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+Maintainer: Sylvain Miermont
+*/
+
+
+/* -------------------------------------------------------------------------- */
+/* --- DEPENDANCIES --------------------------------------------------------- */
+
+/* fix an issue between POSIX and C99 */
+#if __STDC_VERSION__ >= 199901L
+    #define _XOPEN_SOURCE 600
+#else
+    #define _XOPEN_SOURCE 500
+#endif
+
+#include <stdint.h>        /* C99 types */
+#include <stdbool.h>       /* bool type */
+#include <stdio.h>         /* printf fprintf */
+#include <string.h>        /* memset memcpy */
+#include <time.h>          /* clock_gettime */
+
+#include "loragw_spi.h"
+#include "loragw_hal.h"
+#include "loragw_reg.h"
+#include "loragw_fpga.h"
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE MACROS ------------------------------------------------------- */
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#if DEBUG_SPI == 1
+    #define DEBUG_MSG(str)                fprintf(stderr, str)
+    #define DEBUG_PRINTF(fmt, args...)    fprintf(stderr,"%s:%d: "fmt, __FUNCTION__, __LINE__, args)
+    #define CHECK_NULL(a)                if(a==NULL){fprintf(stderr,"%s:%d: ERROR: NULL POINTER AS ARGUMENT\n", __FUNCTION__, __LINE__);return LGW_SPI_ERROR;}
+#else
+    #define DEBUG_MSG(str)
+    #define DEBUG_PRINTF(fmt, args...)
+    #define CHECK_NULL(a)                if(a==NULL){return LGW_SPI_ERROR;}
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE CONSTANTS ---------------------------------------------------- */
+
+#define SIM_NB_PAGE         4
+#define SIM_RX_BUF_SIZE     4096    /* must be a power of 2 */
+#define SIM_TX_BUF_SIZE     512     /* must be a power of 2 */
+#define SIM_PROM_SIZE       8192
+#define SIM_MCU_RAM_SIZE    256
+#define SIM_RX_METADATA_NB  16
+
+/* SX1301 register addresses with a side effect (see loregs[]) */
+#define SX1301_PAGE_RST         0
+#define SX1301_RX_BUF_ADDR_LSB  2
+#define SX1301_RX_BUF_ADDR_MSB  3
+#define SX1301_RX_BUF_DATA      4
+#define SX1301_TX_BUF_ADDR      5
+#define SX1301_TX_BUF_DATA      6
+#define SX1301_CAPTURE_DATA     8
+#define SX1301_PROM_ADDR        9
+#define SX1301_PROM_DATA        10
+#define SX1301_FIFO_NUM_STORED  11
+#define SX1301_FIFO_ADDR_LSB    12
+#define SX1301_FIFO_ADDR_MSB    13
+#define SX1301_FIFO_STATUS      14
+#define SX1301_FIFO_SIZE        15
+#define SX1301_AGC_STATUS       32
+#define SX1301_ARB_STATUS       125
+#define SX1301_EMERGENCY_CTRL   127
+#define SX1301_P0_RADIO_SELECT  35
+#define SX1301_P0_MCU_CTRL      106
+#define SX1301_P0_IQ_MISMATCH   114 /* A_AMP, A_PHI, B_AMP (+ B_SEL_I bit 6), B_PHI */
+#define SX1301_P1_TX_TRIG       33
+#define SX1301_P2_RADIO_A_DATA  33
+#define SX1301_P2_RADIO_A_RB    34
+#define SX1301_P2_RADIO_A_ADDR  35
+#define SX1301_P2_RADIO_A_CS    37
+#define SX1301_P2_RADIO_B_DATA  38
+#define SX1301_P2_RADIO_B_RB    39
+#define SX1301_P2_RADIO_B_ADDR  40
+#define SX1301_P2_RADIO_B_CS    42
+#define SX1301_P2_ARB_RAM_DATA  64
+#define SX1301_P2_AGC_RAM_DATA  65
+#define SX1301_P2_TIMESTAMP     70
+#define SX1301_P2_ARB_RAM_ADDR  80
+#define SX1301_P2_AGC_RAM_ADDR  81
+
+/* FPGA register addresses with a side effect (see fpga_regs[]) */
+#define FPGA_CTRL0              0
+#define FPGA_VERSION            1
+#define FPGA_CTRL_FEATURE       3
+#define FPGA_LBT_TIMESTAMP_LSB  14
+#define FPGA_LBT_TIMESTAMP_MSB  15
+#define FPGA_SIM_VERSION        33
+#define FPGA_SIM_FEATURES       0x07 /* TX notch filter, spectral scan, LBT */
+#define FPGA_SIM_LBT_FREQ       1    /* 863 MHz */
+
+/* SX125x & SX127x registers */
+#define SX125X_MODE             0x00
+#define SX125X_VERSION          0x07
+#define SX125X_STATUS           0x11
+#define SX125X_SIM_VERSION      0x21
+#define SX127X_OPMODE           0x01
+#define SX127X_IRQFLAGS1        0x3E
+#define SX127X_VERSION          0x42
+
+/* MCU firmwares are identified by the first bytes of the program */
+#define MCU_ARB                 0
+#define MCU_AGC                 1
+#define AGC_CMD_WAIT            16
+#define AGC_CMD_ABORT           17
+#define AGC_LUT_SIZE            16
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE TYPES -------------------------------------------------------- */
+
+enum sim_fw_e {
+    SIM_FW_NONE,
+    SIM_FW_CAL,
+    SIM_FW_AGC,
+    SIM_FW_ARB
+};
+
+enum sim_agc_init_e {
+    SIM_AGC_LUT,        /* receiving TX gain LUT entries */
+    SIM_AGC_FREQ,       /* waiting for TX freq MSB */
+    SIM_AGC_CHAN,       /* waiting for chan_select option */
+    SIM_AGC_RADIO,      /* waiting for RADIO_SELECT value */
+    SIM_AGC_RUN         /* initialization done */
+};
+
+struct sim_fw_sign_s {
+    enum sim_fw_e   fw;
+    uint8_t         sign[4];
+    uint8_t         version; /* value at FW_VERSION_ADDR in data memory */
+};
+
+struct sim_mcu_s {
+    bool                running;
+    enum sim_fw_e       fw;
+    uint8_t             ram[SIM_MCU_RAM_SIZE];
+    uint8_t             status;
+    bool                mbox_wait;      /* AGC_CMD_WAIT received, next write is a parameter */
+    enum sim_agc_init_e agc_init;
+    int                 lut_cnt;
+};
+
+struct sim_rx_pkt_s {
+    uint16_t    addr;
+    uint8_t     status;
+    uint8_t     size;
+};
+
+struct sim_state_s {
+    bool                powered;
+    struct lgw_spi_sim_conf_s conf;
+    struct timespec     t0;
+    /* SX1301 */
+    uint8_t             page;
+    uint8_t             glob[128];
+    uint8_t             paged[SIM_NB_PAGE][128];
+    uint8_t             rx_buf[SIM_RX_BUF_SIZE];
+    uint16_t            rx_addr;        /* read pointer, RX_DATA_BUF_DATA */
+    uint16_t            rx_wr;          /* write pointer, for simulated packets */
+    struct sim_rx_pkt_s fifo[LGW_PKT_FIFO_SIZE];
+    int                 fifo_head;
+    int                 fifo_nb;
+    uint8_t             tx_buf[SIM_TX_BUF_SIZE];
+    uint16_t            tx_addr;
+    uint32_t            tx_cnt;
+    uint8_t             prom[2][SIM_PROM_SIZE];
+    uint16_t            prom_addr;
+    uint8_t             prom_pipe;      /* one-stage read pipeline */
+    struct sim_mcu_s    mcu[2];
+    uint32_t            timestamp;      /* latched on LSB read */
+    /* SX125x radios behind the SX1301 SPI bridge */
+    uint8_t             radio[LGW_RF_CHAIN_NB][128];
+    /* SX1301AP2 */
+    uint8_t             fpga[128];
+    uint8_t             sx127x[128];
+    uint16_t            lbt_timestamp;  /* latched on LSB read */
+    bool                lbt_busy;       /* LBT channels never found free, timestamps frozen */
+    /* fault injection */
+    uint32_t            fault_cnt;      /* frames before the failing one, 0 if none */
+};
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE VARIABLES ---------------------------------------------------- */
+
+extern const struct lgw_reg_s loregs[];
+extern const struct lgw_reg_s fpga_regs[];
+
+static const struct sim_fw_sign_s sim_fw_sign[] = {
+    {SIM_FW_CAL, {0x8A, 0x51, 0x6F, 0x28}, 2},
+    {SIM_FW_AGC, {0x8A, 0x51, 0x11, 0x28}, 4},
+    {SIM_FW_ARB, {0x8A, 0x51, 0xAE, 0x6E}, 1}
+};
+
+static struct sim_state_s sim = {
+    .powered = false,
+    .conf = {false, 0x12}
+};
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE FUNCTIONS DECLARATION ---------------------------------------- */
+
+static int sim_open(void **spi_target_ptr);
+static int sim_close(void *spi_target);
+static int sim_w(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t data);
+static int sim_r(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data);
+static int sim_wb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size);
+static int sim_rb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size);
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC VARIABLES ----------------------------------------------------- */
+
+const struct lgw_spi_backend_s lgw_spi_sim_backend = {
+    "sim",
+    sim_open,
+    sim_close,
+    sim_w,
+    sim_r,
+    sim_wb,
+    sim_rb,
+    NULL
+};
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE FUNCTIONS DEFINITION ----------------------------------------- */
+
+static uint32_t sim_time_us(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint32_t)((t.tv_sec - sim.t0.tv_sec) * 1000000 + (t.tv_nsec - sim.t0.tv_nsec) / 1000);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* load default value of registers described in a table, -1 page is page-independent */
+static void sim_seed(const struct lgw_reg_s *tab, int nb, uint8_t *glob, uint8_t (*paged)[128]) {
+    uint8_t *mem;
+    uint32_t val;
+    int i, j, size_byte;
+
+    for (i = 0; i < nb; ++i) {
+        mem = (tab[i].page < 0) ? glob : paged[tab[i].page];
+        if ((tab[i].offs + tab[i].leng) <= 8) {
+            val = ((1 << tab[i].leng) - 1) << tab[i].offs;
+            mem[tab[i].addr] = (mem[tab[i].addr] & ~val) | (((uint32_t)tab[i].dflt << tab[i].offs) & val);
+        } else {
+            size_byte = (tab[i].leng + 7) / 8;
+            val = (uint32_t)tab[i].dflt;
+            if (tab[i].leng < 32) {
+                val &= (1UL << tab[i].leng) - 1;
+            }
+            for (j = 0; j < size_byte; ++j) {
+                mem[tab[i].addr + j] = (uint8_t)(val >> (8 * j));
+            }
+        }
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void sim_sx1301_reset(void) {
+    memset(sim.glob, 0, sizeof sim.glob);
+    memset(sim.paged, 0, sizeof sim.paged);
+    sim_seed(loregs, LGW_TOTALREGS, sim.glob, sim.paged);
+    sim.page = 0;
+    sim.rx_addr = 0;
+    sim.rx_wr = 0;
+    sim.fifo_head = 0;
+    sim.fifo_nb = 0;
+    sim.tx_addr = 0;
+    sim.prom_addr = 0;
+    memset(sim.mcu, 0, sizeof sim.mcu); /* MCUs are held in reset (MCU_RST_x default value) */
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void sim_fpga_reset(void) {
+    memset(sim.fpga, 0, sizeof sim.fpga);
+    sim_seed(fpga_regs, LGW_FPGA_TOTALREGS, sim.fpga, NULL);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void sim_power_up(void) {
+    memset(&sim.rx_buf, 0, sizeof sim.rx_buf);
+    memset(&sim.tx_buf, 0, sizeof sim.tx_buf);
+    memset(&sim.prom, 0, sizeof sim.prom);
+    memset(&sim.radio, 0, sizeof sim.radio);
+    memset(&sim.sx127x, 0, sizeof sim.sx127x);
+    sim.tx_cnt = 0;
+    clock_gettime(CLOCK_MONOTONIC, &sim.t0);
+    sim_sx1301_reset();
+    sim_fpga_reset();
+    sim.powered = true;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void sim_mcu_start(int m) {
+    struct sim_mcu_s *mcu = &sim.mcu[m];
+    int i;
+
+    memset(mcu, 0, sizeof *mcu);
+    mcu->running = true;
+    mcu->fw = SIM_FW_NONE;
+    for (i = 0; i < (int)ARRAY_SIZE(sim_fw_sign); ++i) {
+        if (memcmp(sim.prom[m], sim_fw_sign[i].sign, sizeof sim_fw_sign[i].sign) == 0) {
+            mcu->fw = sim_fw_sign[i].fw;
+            mcu->ram[0x20] = sim_fw_sign[i].version;
+        }
+    }
+    if (mcu->fw == SIM_FW_AGC) {
+        mcu->status = 0x10; /* ready for TX gain LUT */
+        mcu->agc_init = SIM_AGC_LUT;
+    }
+    DEBUG_PRINTF("Note: simulated MCU %d started with firmware %d\n", m, mcu->fw);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* calibration firmware starts when host gives control of the registers */
+static void sim_mcu_calibrate(void) {
+    struct sim_mcu_s *mcu = &sim.mcu[MCU_AGC];
+    uint8_t cmd = sim.paged[0][SX1301_P0_RADIO_SELECT];
+
+    mcu->status = 0x81; /* finished, could access SX1301 registers */
+    mcu->status |= (cmd & 0x01) ? 0x0A : 0x00; /* radio A access & image rejection */
+    mcu->status |= (cmd & 0x02) ? 0x14 : 0x00; /* radio B access & image rejection */
+    mcu->status |= (cmd & 0x04) ? 0x20 : 0x00; /* radio A TX DC offset */
+    mcu->status |= (cmd & 0x08) ? 0x40 : 0x00; /* radio B TX DC offset */
+    memset(&mcu->ram[0xA0], 0, 32); /* TX DC offsets */
+
+    /* image rejection: IQ mismatch coefficients written in the SX1301 registers */
+    if ((cmd & 0x01) != 0) {
+        sim.paged[0][SX1301_P0_IQ_MISMATCH + 0] = 0x05;
+        sim.paged[0][SX1301_P0_IQ_MISMATCH + 1] = 0x3A;
+    }
+    if ((cmd & 0x02) != 0) {
+        sim.paged[0][SX1301_P0_IQ_MISMATCH + 2] = (sim.paged[0][SX1301_P0_IQ_MISMATCH + 2] & 0x40) | 0x07;
+        sim.paged[0][SX1301_P0_IQ_MISMATCH + 3] = 0x02;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* AGC firmware start-up: host sends parameters through the RADIO_SELECT mailbox */
+static void sim_mcu_mailbox(uint8_t data) {
+    struct sim_mcu_s *mcu = &sim.mcu[MCU_AGC];
+
+    if ((mcu->running == false) || (mcu->fw != SIM_FW_AGC) || (mcu->agc_init == SIM_AGC_RUN)) {
+        return;
+    }
+    if (mcu->mbox_wait == false) {
+        mcu->mbox_wait = (data == AGC_CMD_WAIT);
+        return;
+    }
+    mcu->mbox_wait = false;
+
+    switch (mcu->agc_init) {
+        case SIM_AGC_LUT:
+            if (data == AGC_CMD_ABORT) {
+                mcu->status = 0x30;
+                mcu->agc_init = SIM_AGC_FREQ;
+            } else {
+                mcu->status = 0x30 + mcu->lut_cnt;
+                mcu->lut_cnt += 1;
+                if (mcu->lut_cnt >= AGC_LUT_SIZE) {
+                    mcu->agc_init = SIM_AGC_FREQ;
+                }
+            }
+            break;
+        case SIM_AGC_FREQ:
+            mcu->status = 0x30 + (data & 0x0F);
+            mcu->agc_init = SIM_AGC_CHAN;
+            break;
+        case SIM_AGC_CHAN:
+            mcu->status = 0x30 + (data & 0x0F);
+            mcu->agc_init = SIM_AGC_RADIO;
+            break;
+        default:
+            mcu->status = 0x40;
+            mcu->agc_init = SIM_AGC_RUN;
+            break;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* SX1301 SPI master to SX125x, transaction on CS rising edge */
+static void sim_radio_bridge(int rf_chain, uint8_t cs_old, uint8_t cs_new) {
+    uint8_t addr, data;
+    uint8_t *p2 = sim.paged[2];
+
+    if (((cs_old & 0x01) != 0) || ((cs_new & 0x01) == 0)) {
+        return;
+    }
+    addr = p2[(rf_chain == 0) ? SX1301_P2_RADIO_A_ADDR : SX1301_P2_RADIO_B_ADDR];
+    data = p2[(rf_chain == 0) ? SX1301_P2_RADIO_A_DATA : SX1301_P2_RADIO_B_DATA];
+    if ((addr & 0x80) != 0) {
+        sim.radio[rf_chain][addr & 0x7F] = data;
+    } else {
+        switch (addr) {
+            case SX125X_VERSION:
+                data = SX125X_SIM_VERSION;
+                break;
+            case SX125X_STATUS:
+                data = ((sim.radio[rf_chain][SX125X_MODE] & 0x03) == 0x03) ? 0x02 : 0x00; /* RX PLL locked */
+                break;
+            default:
+                data = sim.radio[rf_chain][addr & 0x7F];
+        }
+        p2[(rf_chain == 0) ? SX1301_P2_RADIO_A_RB : SX1301_P2_RADIO_B_RB] = data;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static uint8_t sim_sx1301_r(uint8_t addr) {
+    struct sim_rx_pkt_s *pkt = &sim.fifo[sim.fifo_head];
+    uint8_t *mem;
+    uint8_t data;
+    int m;
+
+    switch (addr) {
+        case SX1301_PAGE_RST:
+            return sim.page;
+        case SX1301_RX_BUF_DATA:
+            data = sim.rx_buf[sim.rx_addr & (SIM_RX_BUF_SIZE - 1)];
+            sim.rx_addr += 1;
+            return data;
+        case SX1301_CAPTURE_DATA:
+            return 0;
+        case SX1301_PROM_DATA:
+            m = ((sim.paged[0][SX1301_P0_MCU_CTRL] & 0x04) == 0) ? MCU_ARB : MCU_AGC;
+            data = sim.prom_pipe;
+            sim.prom_pipe = sim.prom[m][sim.prom_addr];
+            sim.prom_addr = (sim.prom_addr + 1) % SIM_PROM_SIZE;
+            return data;
+        case SX1301_FIFO_NUM_STORED:
+            if (sim.fifo_nb > 0) {
+                sim.rx_addr = pkt->addr; /* point to the packet on top of the FIFO */
+            }
+            return (uint8_t)sim.fifo_nb;
+        case SX1301_FIFO_ADDR_LSB:
+            return (sim.fifo_nb > 0) ? (uint8_t)(pkt->addr) : 0;
+        case SX1301_FIFO_ADDR_MSB:
+            return (sim.fifo_nb > 0) ? (uint8_t)(pkt->addr >> 8) : 0;
+        case SX1301_FIFO_STATUS:
+            return (sim.fifo_nb > 0) ? pkt->status : 0;
+        case SX1301_FIFO_SIZE:
+            return (sim.fifo_nb > 0) ? pkt->size : 0;
+        case SX1301_AGC_STATUS:
+            return sim.mcu[MCU_AGC].status;
+        case SX1301_ARB_STATUS:
+            return sim.mcu[MCU_ARB].status;
+        default:
+            break;
+    }
+
+    /* page-independent registers */
+    if ((addr <= SX1301_AGC_STATUS) || (addr >= SX1301_ARB_STATUS)) {
+        return sim.glob[addr];
+    }
+
+    /* page-specific registers */
+    mem = sim.paged[sim.page];
+    if (sim.page == 2) {
+        switch (addr) {
+            case SX1301_P2_ARB_RAM_DATA:
+                return sim.mcu[MCU_ARB].ram[mem[SX1301_P2_ARB_RAM_ADDR]];
+            case SX1301_P2_AGC_RAM_DATA:
+                return sim.mcu[MCU_AGC].ram[mem[SX1301_P2_AGC_RAM_ADDR]];
+            case SX1301_P2_TIMESTAMP:
+                sim.timestamp = sim_time_us();
+                /* FALLTHROUGH */
+            case SX1301_P2_TIMESTAMP + 1:
+            case SX1301_P2_TIMESTAMP + 2:
+            case SX1301_P2_TIMESTAMP + 3:
+                return (uint8_t)(sim.timestamp >> (8 * (addr - SX1301_P2_TIMESTAMP)));
+            default:
+                break;
+        }
+    }
+    return mem[addr];
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void sim_sx1301_w(uint8_t addr, uint8_t data) {
+    uint8_t *mem;
+    uint8_t old;
+    int m;
+
+    switch (addr) {
+        case SX1301_PAGE_RST:
+            if ((data & 0x80) != 0) {
+                sim_sx1301_reset();
+            } else {
+                sim.page = data & 0x03;
+            }
+            return;
+        case SX1301_RX_BUF_ADDR_LSB:
+        case SX1301_RX_BUF_ADDR_MSB:
+            sim.glob[addr] = data;
+            sim.rx_addr = (uint16_t)sim.glob[SX1301_RX_BUF_ADDR_LSB] | ((uint16_t)sim.glob[SX1301_RX_BUF_ADDR_MSB] << 8);
+            return;
+        case SX1301_TX_BUF_ADDR:
+            sim.glob[addr] = data;
+            sim.tx_addr = data;
+            return;
+        case SX1301_TX_BUF_DATA:
+            sim.tx_buf[sim.tx_addr & (SIM_TX_BUF_SIZE - 1)] = data;
+            sim.tx_addr += 1;
+            return;
+        case SX1301_PROM_ADDR:
+            sim.glob[addr] = data;
+            sim.prom_addr = data;
+            return;
+        case SX1301_PROM_DATA:
+            /* host has access to the program RAM of each MCU with SELECT_MUX at 0 */
+            for (m = 0; m < 2; ++m) {
+                if ((sim.paged[0][SX1301_P0_MCU_CTRL] & (0x04 << m)) == 0) {
+                    sim.prom[m][sim.prom_addr] = data;
+                }
+            }
+            sim.prom_addr = (sim.prom_addr + 1) % SIM_PROM_SIZE;
+            return;
+        case SX1301_FIFO_NUM_STORED:
+            if (sim.fifo_nb > 0) { /* any write advances the FIFO */
+                sim.fifo_head = (sim.fifo_head + 1) % LGW_PKT_FIFO_SIZE;
+                sim.fifo_nb -= 1;
+            }
+            return;
+        case SX1301_EMERGENCY_CTRL:
+            sim.glob[addr] = data;
+            if (((data & 0x01) == 0) && (sim.mcu[MCU_AGC].running == true) && (sim.mcu[MCU_AGC].fw == SIM_FW_CAL)) {
+                sim_mcu_calibrate();
+            }
+            return;
+        default:
+            break;
+    }
+
+    /* page-independent registers */
+    if ((addr <= SX1301_AGC_STATUS) || (addr >= SX1301_ARB_STATUS)) {
+        sim.glob[addr] = data;
+        return;
+    }
+
+    /* page-specific registers */
+    mem = sim.paged[sim.page];
+    old = mem[addr];
+    mem[addr] = data;
+    switch (sim.page) {
+        case 0:
+            if (addr == SX1301_P0_RADIO_SELECT) {
+                sim_mcu_mailbox(data);
+            } else if (addr == SX1301_P0_MCU_CTRL) {
+                for (m = 0; m < 2; ++m) {
+                    if (((old & (1 << m)) != 0) && ((data & (1 << m)) == 0)) {
+                        sim_mcu_start(m);
+                    } else if ((data & (1 << m)) != 0) {
+                        sim.mcu[m].running = false;
+                        sim.mcu[m].status = 0;
+                    }
+                }
+            }
+            break;
+        case 1:
+            if ((addr == SX1301_P1_TX_TRIG) && ((data & 0x07) != 0)) {
+                sim.tx_cnt += 1;
+            }
+            break;
+        case 2:
+            if (addr == SX1301_P2_RADIO_A_CS) {
+                sim_radio_bridge(0, old, data);
+            } else if (addr == SX1301_P2_RADIO_B_CS) {
+                sim_radio_bridge(1, old, data);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static uint8_t sim_fpga_r(uint8_t addr) {
+    switch (addr) {
+        case FPGA_CTRL0:
+            return (sim.fpga[FPGA_CTRL0] & 0x01) | (FPGA_SIM_FEATURES << 1) | (FPGA_SIM_LBT_FREQ << 5);
+        case FPGA_VERSION:
+            return FPGA_SIM_VERSION;
+        case FPGA_LBT_TIMESTAMP_LSB:
+            /* channels free unless busy, last free time is now (1 LSB = 256us) */
+            if ((sim.fpga[FPGA_CTRL_FEATURE] & 0x01) == 0) {
+                sim.lbt_timestamp = 0;
+            } else if (sim.lbt_busy == false) {
+                sim.lbt_timestamp = (uint16_t)(sim_time_us() >> 8);
+            }
+            return (uint8_t)sim.lbt_timestamp;
+        case FPGA_LBT_TIMESTAMP_MSB:
+            return (uint8_t)(sim.lbt_timestamp >> 8);
+        default:
+            return sim.fpga[addr];
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void sim_fpga_w(uint8_t addr, uint8_t data) {
+    if ((addr == FPGA_CTRL0) && ((sim.fpga[FPGA_CTRL0] & 0x01) != 0) && ((data & 0x01) == 0)) {
+        sim_fpga_reset(); /* soft reset released */
+        return;
+    }
+    sim.fpga[addr] = data;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static uint8_t sim_sx127x_r(uint8_t addr) {
+    switch (addr) {
+        case SX127X_VERSION:
+            return sim.conf.sx127x_version;
+        case SX127X_IRQFLAGS1:
+            if ((sim.sx127x[SX127X_OPMODE] & 0x07) == 5) {
+                return 0xD0; /* ModeReady, RxReady, PllLock */
+            } else {
+                return 0x80; /* ModeReady */
+            }
+        default:
+            return sim.sx127x[addr];
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* one SPI frame: command then 'size' data bytes, address auto-incremented except for data ports */
+static int sim_access(uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, bool read, uint8_t *data, uint16_t size) {
+    bool port;
+    uint8_t a;
+    int i;
+
+    CHECK_NULL(data);
+    if (sim.powered == false) {
+        sim_power_up();
+    }
+    if ((sim.fault_cnt > 0) && (--sim.fault_cnt == 0)) {
+        DEBUG_MSG("Note: simulated SPI frame failed\n");
+        return LGW_SPI_ERROR; /* frame lost, nothing read or written */
+    }
+    address &= 0x7F;
+
+    /* without FPGA, there is no SPI mux and the SX1301 is the only target */
+    if (spi_mux_mode != LGW_SPI_MUX_MODE1) {
+        spi_mux_target = LGW_SPI_MUX_TARGET_SX1301;
+    } else if ((sim.conf.fpga == false) && (spi_mux_target != LGW_SPI_MUX_TARGET_SX1301)) {
+        if (read) {
+            memset(data, 0, size);
+        }
+        return LGW_SPI_SUCCESS;
+    }
+
+    for (i = 0; i < size; ++i) {
+        switch (spi_mux_target) {
+            case LGW_SPI_MUX_TARGET_SX1301:
+                port = (address == SX1301_RX_BUF_DATA) || (address == SX1301_TX_BUF_DATA) || (address == SX1301_CAPTURE_DATA) || (address == SX1301_PROM_DATA);
+                a = port ? address : ((address + i) & 0x7F);
+                if (read) {
+                    data[i] = sim_sx1301_r(a);
+                } else {
+                    sim_sx1301_w(a, data[i]);
+                }
+                break;
+            case LGW_SPI_MUX_TARGET_FPGA:
+                a = (address + i) & 0x7F;
+                if (read) {
+                    data[i] = sim_fpga_r(a);
+                } else {
+                    sim_fpga_w(a, data[i]);
+                }
+                break;
+            case LGW_SPI_MUX_TARGET_SX127X:
+                a = (address + i) & 0x7F;
+                if (read) {
+                    data[i] = sim_sx127x_r(a);
+                } else {
+                    sim.sx127x[a] = data[i];
+                }
+                break;
+            default: /* EEPROM not simulated, blank content */
+                if (read) {
+                    data[i] = 0xFF;
+                }
+                break;
+        }
+    }
+
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sim_open(void **spi_target_ptr) {
+    CHECK_NULL(spi_target_ptr);
+
+    if (sim.powered == false) {
+        sim_power_up();
+    }
+    *spi_target_ptr = (void *)&sim;
+    DEBUG_MSG("Note: simulated SPI port opened\n");
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sim_close(void *spi_target) {
+    CHECK_NULL(spi_target);
+    DEBUG_MSG("Note: simulated SPI port closed\n");
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sim_w(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t data) {
+    CHECK_NULL(spi_target);
+    return sim_access(spi_mux_mode, spi_mux_target, address, false, &data, 1);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sim_r(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data) {
+    CHECK_NULL(spi_target);
+    return sim_access(spi_mux_mode, spi_mux_target, address, true, data, 1);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sim_wb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size) {
+    CHECK_NULL(spi_target);
+    if (size == 0) {
+        DEBUG_MSG("ERROR: BURST OF NULL LENGTH\n");
+        return LGW_SPI_ERROR;
+    }
+    return sim_access(spi_mux_mode, spi_mux_target, address, false, data, size);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int sim_rb(void *spi_target, uint8_t spi_mux_mode, uint8_t spi_mux_target, uint8_t address, uint8_t *data, uint16_t size) {
+    CHECK_NULL(spi_target);
+    if (size == 0) {
+        DEBUG_MSG("ERROR: BURST OF NULL LENGTH\n");
+        return LGW_SPI_ERROR;
+    }
+    return sim_access(spi_mux_mode, spi_mux_target, address, true, data, size);
+}
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC FUNCTIONS DEFINITION ------------------------------------------ */
+
+int lgw_spi_sim_setconf(struct lgw_spi_sim_conf_s conf) {
+    sim.conf = conf;
+    sim_power_up();
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_spi_sim_rx_push(uint8_t status, const uint8_t *payload, uint8_t size, const uint8_t *metadata) {
+    struct sim_rx_pkt_s *pkt;
+    int i;
+
+    CHECK_NULL(metadata);
+    if ((payload == NULL) && (size > 0)) {
+        return LGW_SPI_ERROR;
+    }
+    if (sim.powered == false) {
+        sim_power_up();
+    }
+    if (sim.fifo_nb >= LGW_PKT_FIFO_SIZE) {
+        DEBUG_MSG("WARNING: simulated RX FIFO full, packet dropped\n");
+        return LGW_SPI_ERROR;
+    }
+
+    pkt = &sim.fifo[(sim.fifo_head + sim.fifo_nb) % LGW_PKT_FIFO_SIZE];
+    pkt->addr = sim.rx_wr;
+    pkt->status = status;
+    pkt->size = size;
+    for (i = 0; i < size; ++i) {
+        sim.rx_buf[(sim.rx_wr++) & (SIM_RX_BUF_SIZE - 1)] = payload[i];
+    }
+    for (i = 0; i < SIM_RX_METADATA_NB; ++i) {
+        sim.rx_buf[(sim.rx_wr++) & (SIM_RX_BUF_SIZE - 1)] = metadata[i];
+    }
+    sim.rx_wr &= (SIM_RX_BUF_SIZE - 1);
+    sim.fifo_nb += 1;
+
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_spi_sim_fault(uint32_t nb_frame) {
+    sim.fault_cnt = nb_frame;
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_spi_sim_lbt_busy(bool busy) {
+    sim.lbt_busy = busy;
+    return LGW_SPI_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+uint32_t lgw_spi_sim_tx_get(uint8_t *data, uint16_t size) {
+    if (data != NULL) {
+        memcpy(data, sim.tx_buf, (size < SIM_TX_BUF_SIZE) ? size : SIM_TX_BUF_SIZE);
+    }
+    return sim.tx_cnt;
+}
+
+/* --- EOF ------------------------------------------------------------------ */
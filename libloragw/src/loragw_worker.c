@@ -0,0 +1,253 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+  (C)2013 Semtech-Cycleo
+
+Description:
+    Optional SPI owner thread: HAL calls made by several application threads
+    are queued (lock-free, by priority) and executed one at a time by the
+    worker thread, so that the register layer state stays consistent.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+Maintainer: Sylvain Miermont
+*/
+
+
+/* -------------------------------------------------------------------------- */
+/* --- DEPENDANCIES --------------------------------------------------------- */
+
+/* fix an issue between POSIX and C99 */
+#if __STDC_VERSION__ >= 199901L
+    #define _XOPEN_SOURCE 600
+#else
+    #define _XOPEN_SOURCE 500
+#endif
+
+#include <stdint.h>     /* C99 types */
+#include <stdbool.h>    /* bool type */
+#include <stdio.h>      /* printf fprintf */
+#include <pthread.h>    /* pthread_create, pthread_join */
+#include <semaphore.h>  /* sem_init, sem_wait, sem_post */
+#include <sched.h>      /* sched_yield */
+
+#include "loragw_worker.h"
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE MACROS ------------------------------------------------------- */
+
+#if DEBUG_HAL == 1
+    #define DEBUG_MSG(str)                fprintf(stderr, str)
+    #define DEBUG_PRINTF(fmt, args...)    fprintf(stderr,"%s:%d: "fmt, __FUNCTION__, __LINE__, args)
+    #define CHECK_NULL(a)                if(a==NULL){fprintf(stderr,"%s:%d: ERROR: NULL POINTER AS ARGUMENT\n", __FUNCTION__, __LINE__);return LGW_WORKER_ERROR;}
+#else
+    #define DEBUG_MSG(str)
+    #define DEBUG_PRINTF(fmt, args...)
+    #define CHECK_NULL(a)                if(a==NULL){return LGW_WORKER_ERROR;}
+#endif
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE TYPES -------------------------------------------------------- */
+
+/* link of the intrusive MPSC queue, first member of the requests */
+struct worker_node_s {
+    struct worker_node_s *next;
+};
+
+/* transaction submitted by a caller, lives on the caller stack until completion */
+struct worker_req_s {
+    struct worker_node_s node;
+    int (*job)(void *arg);  /* NULL to stop the worker */
+    void *arg;
+    int status;             /* value returned by the job */
+    sem_t done;             /* posted by the worker on completion */
+};
+
+/* multiple producers, single consumer queue (Vyukov), with a stub node */
+struct worker_queue_s {
+    struct worker_node_s *head;     /* last pushed node, updated by the producers */
+    struct worker_node_s *tail;     /* next node to pop, only used by the consumer */
+    struct worker_node_s stub;
+};
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE VARIABLES ---------------------------------------------------- */
+
+static struct worker_queue_s worker_queue[LGW_WORKER_PRIO_NB]; /* one queue per priority */
+static sem_t worker_pending; /* number of requests pushed and not popped yet */
+static pthread_t worker_thread;
+static bool worker_running = false;
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE FUNCTIONS DEFINITION ----------------------------------------- */
+
+static void queue_init(struct worker_queue_s *q) {
+    q->stub.next = NULL;
+    q->head = &(q->stub);
+    q->tail = &(q->stub);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* wait-free for the producers: one atomic exchange */
+static void queue_push(struct worker_queue_s *q, struct worker_node_s *n) {
+    struct worker_node_s *prev;
+
+    __atomic_store_n(&(n->next), NULL, __ATOMIC_RELAXED);
+    prev = __atomic_exchange_n(&(q->head), n, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&(prev->next), n, __ATOMIC_RELEASE);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* consumer side, NULL if empty or if a producer is between its two steps */
+static struct worker_node_s *queue_pop(struct worker_queue_s *q) {
+    struct worker_node_s *tail = q->tail;
+    struct worker_node_s *next = __atomic_load_n(&(tail->next), __ATOMIC_ACQUIRE);
+
+    if (tail == &(q->stub)) {
+        if (next == NULL) {
+            return NULL;
+        }
+        q->tail = next;
+        tail = next;
+        next = __atomic_load_n(&(tail->next), __ATOMIC_ACQUIRE);
+    }
+    if (next != NULL) {
+        q->tail = next;
+        return tail;
+    }
+    if (tail != __atomic_load_n(&(q->head), __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+    queue_push(q, &(q->stub));
+    next = __atomic_load_n(&(tail->next), __ATOMIC_ACQUIRE);
+    if (next != NULL) {
+        q->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void *worker_loop(void *arg) {
+    struct worker_req_s *req;
+    int i;
+
+    (void)arg;
+    while (1) {
+        /* one post per request pushed, so at least one request is (being) queued */
+        sem_wait(&worker_pending);
+        do {
+            req = NULL;
+            for (i = 0; (req == NULL) && (i < LGW_WORKER_PRIO_NB); ++i) {
+                req = (struct worker_req_s *)queue_pop(&worker_queue[i]);
+            }
+            if (req == NULL) {
+                sched_yield(); /* producer preempted between its two steps */
+            }
+        } while (req == NULL);
+
+        if (req->job == NULL) {
+            sem_post(&(req->done));
+            break;
+        }
+        req->status = req->job(req->arg);
+        sem_post(&(req->done));
+    }
+    return NULL;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int worker_submit(int (*job)(void *arg), void *arg, uint8_t prio) {
+    struct worker_req_s req;
+
+    req.job = job;
+    req.arg = arg;
+    req.status = LGW_WORKER_ERROR;
+    if (sem_init(&(req.done), 0, 0) != 0) {
+        DEBUG_MSG("ERROR: FAILED TO INITIALIZE WORKER REQUEST\n");
+        return LGW_WORKER_ERROR;
+    }
+    queue_push(&worker_queue[prio], &(req.node));
+    sem_post(&worker_pending);
+    while (sem_wait(&(req.done)) != 0); /* retry if interrupted by a signal */
+    sem_destroy(&(req.done));
+
+    return req.status;
+}
+
+/* -------------------------------------------------------------------------- */
+/* --- PUBLIC FUNCTIONS DEFINITION ------------------------------------------ */
+
+int lgw_worker_start(void) {
+    int i;
+
+    if (__atomic_load_n(&worker_running, __ATOMIC_ACQUIRE) == true) {
+        DEBUG_MSG("WARNING: WORKER ALREADY RUNNING\n");
+        return LGW_WORKER_SUCCESS;
+    }
+
+    for (i = 0; i < LGW_WORKER_PRIO_NB; ++i) {
+        queue_init(&worker_queue[i]);
+    }
+    if (sem_init(&worker_pending, 0, 0) != 0) {
+        DEBUG_MSG("ERROR: FAILED TO INITIALIZE WORKER SEMAPHORE\n");
+        return LGW_WORKER_ERROR;
+    }
+    if (pthread_create(&worker_thread, NULL, worker_loop, NULL) != 0) {
+        DEBUG_MSG("ERROR: FAILED TO CREATE WORKER THREAD\n");
+        sem_destroy(&worker_pending);
+        return LGW_WORKER_ERROR;
+    }
+    __atomic_store_n(&worker_running, true, __ATOMIC_RELEASE);
+
+    return LGW_WORKER_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_worker_stop(void) {
+    if (lgw_worker_delegate() == false) {
+        DEBUG_MSG("ERROR: WORKER NOT RUNNING, OR STOPPED FROM THE WORKER THREAD\n");
+        return LGW_WORKER_ERROR;
+    }
+
+    /* stop request queued last, after all the pending transactions */
+    worker_submit(NULL, NULL, LGW_WORKER_PRIO_NB - 1);
+    pthread_join(worker_thread, NULL);
+    __atomic_store_n(&worker_running, false, __ATOMIC_RELEASE);
+    sem_destroy(&worker_pending);
+
+    return LGW_WORKER_SUCCESS;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+bool lgw_worker_delegate(void) {
+    if (__atomic_load_n(&worker_running, __ATOMIC_ACQUIRE) == false) {
+        return false;
+    }
+    return (pthread_equal(pthread_self(), worker_thread) == 0);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+int lgw_worker_call(int (*job)(void *arg), void *arg, uint8_t prio) {
+    CHECK_NULL(job);
+    if (prio >= LGW_WORKER_PRIO_NB) {
+        DEBUG_MSG("ERROR: INVALID WORKER PRIORITY\n");
+        return LGW_WORKER_ERROR;
+    }
+
+    if (lgw_worker_delegate() == false) {
+        return job(arg);
+    }
+    return worker_submit(job, arg, prio);
+}
+
+/* --- EOF ------------------------------------------------------------------ */
@@ -30,10 +30,12 @@ Maintainer: Sylvain Miermont
 #include <string.h>        /* memset */
 #include <signal.h>        /* sigaction */
 #include <unistd.h>        /* getopt access */
+#include <poll.h>          /* poll */
 
 #include "loragw_hal.h"
 #include "loragw_reg.h"
 #include "loragw_aux.h"
+#include "loragw_rx.h"
 
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE MACROS ------------------------------------------------------- */
@@ -97,6 +99,7 @@ int main(int argc, char **argv)
 
     int i, j;
     int nb_pkt;
+    struct pollfd pfd; /* readable when the RX engine has packets */
     uint32_t fa = 0, fb = 0, ft = 0;
     enum lgw_radio_type_e radio_type = LGW_RADIO_TYPE_NONE;
     uint8_t clocksource = 1; /* Radio B is source by default */
@@ -319,15 +322,24 @@ int main(int argc, char **argv)
         // fclose(reg_dump);
     // }
 
+    /* packets received in the background, the test loop waits for them */
+    if (lgw_rx_start(1000) != LGW_RX_SUCCESS) {
+        printf("*** Impossible to start the RX engine ***\n");
+        return -1;
+    }
+    pfd.fd = lgw_rx_fd();
+    pfd.events = POLLIN;
+
     while ((quit_sig != 1) && (exit_sig != 1)) {
         loop_cnt++;
 
-        /* fetch N packets */
-        nb_pkt = lgw_receive(ARRAY_SIZE(rxpkt), rxpkt);
+        /* fetch N packets, wait 300 ms at most */
+        nb_pkt = 0;
+        if (poll(&pfd, 1, 300) == 1) {
+            nb_pkt = lgw_rx_dequeue(rxpkt, ARRAY_SIZE(rxpkt));
+        }
 
-        if (nb_pkt == 0) {
-            wait_ms(300);
-        } else {
+        if (nb_pkt > 0) {
             /* display received packets */
             for(i=0; i < nb_pkt; ++i) {
                 p = &rxpkt[i];
@@ -404,6 +416,9 @@ int main(int argc, char **argv)
         }
     }
 
+    /* the RX engine thread is stopped on quit too, only the hardware is left running */
+    lgw_rx_stop();
+
     if (exit_sig == 1) {
         /* clean up before leaving */
         lgw_stop();
@@ -0,0 +1,1133 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+  (C)2013 Semtech-Cycleo
+
+Description:
+    Host CPU cost benchmark of the HAL (start, receive, send) running on the
+    simulated concentrator, no hardware required.
+    Returns a non-zero exit code if the HAL does not behave as expected.
+    With the SPI worker thread, packets are sent from a second thread while
+    the main thread receives.
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+Maintainer: Sylvain Miermont
+*/
+
+
+/* -------------------------------------------------------------------------- */
+/* --- DEPENDANCIES --------------------------------------------------------- */
+
+/* fix an issue between POSIX and C99 */
+#if __STDC_VERSION__ >= 199901L
+    #define _XOPEN_SOURCE 600
+#else
+    #define _XOPEN_SOURCE 500
+#endif
+
+#include <stdint.h>        /* C99 types */
+#include <stdbool.h>       /* bool type */
+#include <stdio.h>         /* printf */
+#include <stdlib.h>        /* atoi */
+#include <string.h>        /* memset */
+#include <time.h>          /* clock_gettime */
+#include <unistd.h>        /* getopt */
+#include <pthread.h>       /* pthread_create, pthread_join */
+#include <poll.h>          /* poll */
+#include <sys/stat.h>      /* stat */
+
+#include "loragw_hal.h"
+#include "loragw_reg.h"
+#include "loragw_aux.h"
+#include "loragw_radio.h"
+#include "loragw_spi.h"
+#include "loragw_worker.h"
+#include "loragw_rx.h"
+#include "loragw_lbt.h"
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE MACROS ------------------------------------------------------- */
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE CONSTANTS ---------------------------------------------------- */
+
+#define DEFAULT_NB_PKT      10000
+#define SIM_FREQ_A          867500000
+#define SIM_FREQ_B          868500000
+#define SIM_PAYLOAD_SIZE    24
+#define SIM_CALCACHE_PATH   "test_loragw_sim.cal"
+#define SIM_RX_POLL_US      100
+#define SIM_TRAFFIC_US      60000000    /* duration of the simulated traffic, virtual time */
+#define SIM_BURST_PERIOD_US 5000000     /* all IF chains busy during the first second of each period */
+#define SIM_BURST_US        1000000
+#define SIM_IDLE_GAP_US     2000000     /* maximum silence on an IF chain between two bursts */
+#define SIM_TSTAMP_RAW      0x10000000  /* 'RX finished' timestamp of the packets checking the timestamp correction */
+#define SIM_FSK_DR          50000
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE TYPES -------------------------------------------------------- */
+
+struct bench_s {
+    struct timespec wall;
+    struct timespec cpu;
+};
+
+struct send_args_s {
+    struct lgw_pkt_tx_s pkt;
+    int nb_pkt;
+    int nb_err;
+};
+
+struct start_busy_args_s {
+    bool stop;          /* set by the main thread at the end of lgw_start */
+    bool started;       /* lgw_start seen running, through a refused call */
+    int nb_accepted;    /* HAL calls accepted while lgw_start runs */
+};
+
+struct rx_push_args_s {
+    int first; /* first byte of the payload of the first packet, incremented */
+    int nb_pkt;
+    const uint8_t *metadata;
+};
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE FUNCTIONS DEFINITION ----------------------------------------- */
+
+static void bench_start(struct bench_s *b) {
+    clock_gettime(CLOCK_MONOTONIC, &b->wall);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &b->cpu);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static double diff_us(struct timespec *t0, struct timespec *t1) {
+    return (t1->tv_sec - t0->tv_sec) * 1E6 + (t1->tv_nsec - t0->tv_nsec) / 1E3;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void bench_stop(struct bench_s *b, const char *name, int nb_op) {
+    struct timespec wall, cpu;
+
+    clock_gettime(CLOCK_MONOTONIC, &wall);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+    printf("%-12s %8d op  wall %12.1f us  cpu %12.1f us  (%.2f us cpu/op)\n", name, nb_op, diff_us(&b->wall, &wall), diff_us(&b->cpu, &cpu), diff_us(&b->cpu, &cpu) / nb_op);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* inode of a file (changed by each rewrite through a temporary file), 0 if it does not exist */
+static uint64_t file_inode(const char *path) {
+    struct stat st;
+
+    if (stat(path, &st) != 0) {
+        return 0;
+    }
+    return (uint64_t)st.st_ino;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void start_profile_print(const struct lgw_start_profile_s *p) {
+    int i;
+
+    printf("lgw_start profile: status %d, %.1f us total\n", p->status, p->total_ns / 1E3);
+    for (i = 0; i < LGW_START_PHASE_NB; ++i) {
+        printf("  %-12s at %10.1f us  %10.1f us  %6u SPI  %8llu bytes\n", p->phase[i].name, p->phase[i].start_ns / 1E3, p->phase[i].duration_ns / 1E3, p->phase[i].nb_spi_call, (unsigned long long)p->phase[i].nb_spi_byte);
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* simulated packets pushed by the SPI worker thread, serialized with the RX engine accesses */
+static int rx_push_job(void *arg) {
+    struct rx_push_args_s *a = arg;
+    uint8_t payload[SIM_PAYLOAD_SIZE];
+    int i;
+
+    for (i = 0; i < SIM_PAYLOAD_SIZE; ++i) {
+        payload[i] = (uint8_t)i;
+    }
+    for (i = 0; i < a->nb_pkt; ++i) {
+        payload[0] = (uint8_t)(a->first + i);
+        lgw_spi_sim_rx_push(5, payload, SIM_PAYLOAD_SIZE, a->metadata); /* CRC OK */
+    }
+    return 0;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* RX filter predicate, rejects the packets with a non-zero CRC field */
+static bool rx_accept(const struct lgw_pkt_rx_s *pkt, void *arg) {
+    int *nb_call = arg;
+
+    *nb_call += 1;
+    return (pkt->crc == 0);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* reference LoRa timestamp correction, computed per packet as lgw_receive used to */
+static uint32_t tstamp_corr_ref(bool std, uint8_t bandwidth, uint8_t status, uint8_t sf_cr, unsigned sz) {
+    uint32_t delay_x, delay_y, delay_z;
+    uint32_t sf, cr, bw_pow, crc_en, ppm;
+    uint32_t datarate;
+
+    crc_en = (((status & 0x07) == 5) || ((status & 0x07) == 7)) ? 1 : 0;
+    bandwidth = (std == true) ? bandwidth : BW_125KHZ;
+    sf = (sf_cr >> 4) & 0x0F;
+    switch (sf) {
+        case 7: datarate = DR_LORA_SF7; break;
+        case 8: datarate = DR_LORA_SF8; break;
+        case 9: datarate = DR_LORA_SF9; break;
+        case 10: datarate = DR_LORA_SF10; break;
+        case 11: datarate = DR_LORA_SF11; break;
+        case 12: datarate = DR_LORA_SF12; break;
+        default: datarate = DR_UNDEFINED;
+    }
+    cr = (sf_cr >> 1) & 0x07;
+    ppm = ((bandwidth == BW_125KHZ) && ((datarate == DR_LORA_SF11) || (datarate == DR_LORA_SF12))) || ((bandwidth == BW_250KHZ) && (datarate == DR_LORA_SF12));
+
+    if (std == true) {
+        switch (bandwidth) {
+            case BW_125KHZ: delay_x = 64; bw_pow = 1; break;
+            case BW_250KHZ: delay_x = 32; bw_pow = 2; break;
+            case BW_500KHZ: delay_x = 16; bw_pow = 4; break;
+            default: delay_x = 0; bw_pow = 0;
+        }
+    } else {
+        delay_x = 114;
+        bw_pow = 1;
+    }
+
+    if ((sf >= 6) && (sf <= 12) && (bw_pow > 0)) {
+        if ((2*(sz + 2*crc_en) - (sf-7)) == 0) { /* unsigned, as in the original '<= 0' test */
+            delay_y = ( ((1<<(sf-1)) * (sf+1)) + (3 * (1<<(sf-4))) ) / bw_pow;
+            delay_z = 32 * (2*(sz+2*crc_en) + 5) / bw_pow;
+        } else {
+            delay_y = ( ((1<<(sf-1)) * (sf+1)) + ((4 - ppm) * (1<<(sf-4))) ) / bw_pow;
+            delay_z = (16 + 4*cr) * (((2*(sz+2*crc_en)-sf+6) % (sf - 2*ppm)) + 1) / bw_pow;
+        }
+        return delay_x + delay_y + delay_z;
+    } else {
+        return 0;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void *send_loop(void *arg) {
+    struct send_args_s *a = arg;
+    int i;
+
+    for (i = 0; i < a->nb_pkt; ++i) {
+        if (lgw_send(a->pkt) != LGW_HAL_SUCCESS) {
+            a->nb_err += 1;
+        }
+    }
+    return NULL;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* SX125x register lists written and read back, returns the number of mismatches */
+static int sx125x_list_check(uint8_t first_addr, int nb_loop) {
+    struct lgw_sx125x_reg_s regs[8];
+    int i, j, nb_err = 0;
+
+    for (j = 0; j < nb_loop; ++j) {
+        for (i = 0; i < (int)ARRAY_SIZE(regs); ++i) {
+            regs[i].address = first_addr + i;
+            regs[i].value = (uint8_t)(first_addr + i + j);
+        }
+        nb_err += (lgw_sx125x_reg_w_multi(1, regs, ARRAY_SIZE(regs)) != LGW_REG_SUCCESS);
+        for (i = 0; i < (int)ARRAY_SIZE(regs); ++i) {
+            regs[i].value = 0;
+        }
+        nb_err += (lgw_sx125x_reg_r_multi(1, regs, ARRAY_SIZE(regs)) != LGW_REG_SUCCESS);
+        for (i = 0; i < (int)ARRAY_SIZE(regs); ++i) {
+            nb_err += (regs[i].value != (uint8_t)(first_addr + i + j));
+        }
+    }
+    return nb_err;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void *sx125x_loop(void *arg) {
+    int *nb_err = arg;
+
+    *nb_err = sx125x_list_check(0x50, 500);
+    return NULL;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* HAL calls from another thread while lgw_start runs, all must be refused */
+static void *start_busy_loop(void *arg) {
+    struct start_busy_args_s *a = arg;
+    struct lgw_start_profile_s prof;
+    struct lgw_pkt_rx_s rxpkt[4];
+    struct lgw_pkt_tx_s txpkt;
+    uint8_t code;
+
+    memset(&txpkt, 0, sizeof txpkt);
+    /* the profile of the previous start is available until lgw_start is entered */
+    while (lgw_start_profile(&prof) == LGW_HAL_SUCCESS) {
+        if (__atomic_load_n(&a->stop, __ATOMIC_ACQUIRE) == true) {
+            return NULL;
+        }
+        wait_us(100);
+    }
+    /* right after the connection, lgw_start waits for the XTAL start-up */
+    a->started = true;
+    a->nb_accepted += (lgw_start() != LGW_HAL_ERROR);
+    a->nb_accepted += (lgw_stop() != LGW_HAL_ERROR);
+    a->nb_accepted += (lgw_receive(ARRAY_SIZE(rxpkt), rxpkt) != LGW_HAL_ERROR);
+    a->nb_accepted += (lgw_send(txpkt) != LGW_HAL_ERROR);
+    a->nb_accepted += (lgw_status(TX_STATUS, &code) != LGW_HAL_ERROR);
+    a->nb_accepted += (lgw_reconfigure(NULL, NULL) != LGW_HAL_ERROR);
+    return NULL;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void usage(void) {
+    printf("Available options:\n");
+    printf(" -h print this help\n");
+    printf(" -n <int> number of packets received and sent (default %d)\n", DEFAULT_NB_PKT);
+    printf(" -s enable the register shadow\n");
+    printf(" -w use the SPI worker thread, send and receive from two threads\n");
+}
+
+/* -------------------------------------------------------------------------- */
+/* --- MAIN FUNCTION -------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+    int i, j, k, x;
+    int nb_pkt = DEFAULT_NB_PKT;
+    int nb_rx = 0;
+    int err = 0;
+    bool use_worker = false;
+    bool use_shadow = false;
+    struct bench_s b;
+    pthread_t send_thread;
+    pthread_t busy_thread;
+    struct start_busy_args_s busy_args;
+    struct send_args_s send_args;
+
+    struct lgw_conf_board_s boardconf;
+    struct lgw_conf_calcache_s calconf;
+    struct lgw_conf_lbt_s lbtconf;
+    uint64_t calcache_ino[2];
+    struct lgw_conf_fw_s fwconf;
+    uint32_t nb_fw_access[3];
+    uint64_t nb_fw_byte[3];
+    struct lgw_conf_rxrf_s rfconf;
+    struct lgw_conf_rxif_s ifconf;
+    struct lgw_conf_rxif_s ifplan[LGW_IF_CHAIN_NB];
+    float rssi_offset[LGW_RF_CHAIN_NB];
+    struct lgw_reg_stat_s reg_stat_if[3];
+    float rssi_ref;
+    struct lgw_pkt_rx_s rxpkt[16];
+    uint8_t payload[SIM_PAYLOAD_SIZE];
+    uint8_t noise[255];
+    struct lgw_conf_rxfilter_s rxfilter;
+    int nb_accept_call = 0;
+    struct rx_push_args_s push_args;
+    int n;
+    struct pollfd pfd;
+    struct lgw_rx_stat_s rx_stat;
+    struct timespec t0, t1;
+    double rx_latency_max = 0.0;
+    struct lgw_rxpoll_s rxpoll;
+    struct lgw_pkt_tx_s toa_pkt;
+    uint32_t toa_us, seed, interval_us;
+    uint64_t t_us, next_end[LGW_MULTI_NB];
+    int nb_poll[2], nb_lost[2], nb_got[2];
+    uint8_t metadata[16];
+    const uint8_t bw_std[3] = {BW_125KHZ, BW_250KHZ, BW_500KHZ};
+    const uint8_t stat_std[3] = {1, 5, 7}; /* no CRC, CRC OK, CRC bad */
+    uint32_t tstamp_ref[8];
+    unsigned sf, cr, sz;
+    int nb_tstamp = 0;
+    uint8_t tx_buf[16 + SIM_PAYLOAD_SIZE];
+    uint32_t tx_cnt;
+    struct lgw_reg_stat_s reg_stat;
+    struct lgw_spi_stat_s spi_stat;
+    struct lgw_start_profile_s start_prof;
+    uint32_t nb_spi_call;
+    uint64_t nb_spi_byte;
+    struct lgw_reg_snapshot_s snap[2];
+    struct lgw_reg_diff_s diff[16];
+    int32_t val[2];
+    struct lgw_sx125x_reg_s radio_reg[8];
+    struct lgw_sx125x_reg_s radio_save[8];
+    struct lgw_spi_sim_conf_s sim_conf;
+    uint8_t sx127x_reg[5];
+
+    while ((i = getopt(argc, argv, "hn:sw")) != -1) {
+        switch (i) {
+            case 'n':
+                nb_pkt = atoi(optarg);
+                if (nb_pkt <= 0) {
+                    usage();
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 's':
+                use_shadow = true;
+                lgw_reg_shadow_enable(true);
+                break;
+            case 'w':
+                use_worker = true;
+                break;
+            default:
+                usage();
+                return (i == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    printf("Beginning of test for loragw_spi.sim.c\n");
+    lgw_spi_set_backend(&lgw_spi_sim_backend);
+
+    /* configure a typical 8-channel gateway */
+    memset(&boardconf, 0, sizeof boardconf);
+    boardconf.lorawan_public = true;
+    boardconf.clksrc = 1;
+    lgw_board_setconf(boardconf);
+
+    memset(&rfconf, 0, sizeof rfconf);
+    rfconf.enable = true;
+    rfconf.freq_hz = SIM_FREQ_A;
+    rfconf.type = LGW_RADIO_TYPE_SX1257;
+    rfconf.tx_enable = true;
+    lgw_rxrf_setconf(0, rfconf);
+    rfconf.freq_hz = SIM_FREQ_B;
+    rfconf.tx_enable = false;
+    lgw_rxrf_setconf(1, rfconf);
+
+    memset(&ifconf, 0, sizeof ifconf);
+    memset(ifplan, 0, sizeof ifplan);
+    ifconf.enable = true;
+    ifconf.datarate = DR_LORA_MULTI;
+    for (i = 0; i < LGW_MULTI_NB; ++i) {
+        ifconf.rf_chain = (i < 4) ? 0 : 1;
+        ifconf.freq_hz = -300000 + (i % 4) * 200000;
+        lgw_rxif_setconf(i, ifconf);
+        ifplan[i] = ifconf;
+    }
+
+    /* start */
+    bench_start(&b);
+    x = lgw_start();
+    bench_stop(&b, "lgw_start", 1);
+    if (x != LGW_HAL_SUCCESS) {
+        printf("ERROR: failed to start simulated concentrator\n");
+        return EXIT_FAILURE;
+    }
+
+    /* start-up profile, accounts all the SPI traffic of lgw_start */
+    lgw_start_profile(&start_prof);
+    start_profile_print(&start_prof);
+    for (i = 0, nb_spi_call = 0, nb_spi_byte = 0; i < LGW_SPI_STAT_NB; ++i) {
+        lgw_spi_stat_get(i, &spi_stat);
+        nb_spi_call += spi_stat.nb_call;
+        nb_spi_byte += spi_stat.nb_byte;
+    }
+    for (i = 0; i < LGW_START_PHASE_NB; ++i) {
+        nb_spi_call -= start_prof.phase[i].nb_spi_call;
+        nb_spi_byte -= start_prof.phase[i].nb_spi_byte;
+        start_prof.total_ns -= start_prof.phase[i].duration_ns;
+    }
+    if ((start_prof.status != LGW_HAL_SUCCESS) || (nb_spi_call != 0) || (nb_spi_byte != 0) || (start_prof.total_ns > start_prof.timestamp_ns) || (start_prof.phase[LGW_START_PHASE_LBT].nb_spi_call != 0)) {
+        printf("ERROR: inconsistent start-up profile, %u SPI accesses unaccounted\n", nb_spi_call);
+        return EXIT_FAILURE;
+    }
+
+    /* both radios configured through batched SPI bridge sequences, PLL locks polled together */
+    if (start_prof.phase[LGW_START_PHASE_RADIO].nb_spi_call > 40) {
+        printf("ERROR: radios set up in %u SPI transactions\n", start_prof.phase[LGW_START_PHASE_RADIO].nb_spi_call);
+        return EXIT_FAILURE;
+    }
+
+    /* SX125x registers written and read back in lists, one SPI transaction (+1 without shadow) */
+    for (i = 0; i < (int)ARRAY_SIZE(radio_reg); ++i) {
+        radio_save[i].address = (i < (int)ARRAY_SIZE(radio_reg) - 1) ? (0x08 + i) : 0x7F; /* last address included */
+        radio_reg[i].address = radio_save[i].address;
+        radio_reg[i].value = (uint8_t)(0xA5 ^ i);
+    }
+    x = lgw_sx125x_reg_r_multi(1, radio_save, ARRAY_SIZE(radio_save));
+    lgw_spi_stat_reset();
+    x |= lgw_sx125x_reg_w_multi(1, radio_reg, ARRAY_SIZE(radio_reg));
+    for (i = 0, nb_spi_call = 0; i < LGW_SPI_STAT_NB; ++i) {
+        lgw_spi_stat_get(i, &spi_stat);
+        nb_spi_call += spi_stat.nb_call;
+    }
+    for (i = 0; i < (int)ARRAY_SIZE(radio_reg); ++i) {
+        radio_reg[i].value = 0;
+    }
+    x |= lgw_sx125x_reg_r_multi(1, radio_reg, ARRAY_SIZE(radio_reg));
+    for (i = 0; i < (int)ARRAY_SIZE(radio_reg); ++i) {
+        if (radio_reg[i].value != (uint8_t)(0xA5 ^ i)) {
+            x = -1;
+        }
+    }
+    x |= lgw_sx125x_reg_w_multi(1, radio_save, ARRAY_SIZE(radio_save));
+    printf("%d SX125x registers written in %u SPI transactions\n", (int)ARRAY_SIZE(radio_reg), nb_spi_call);
+    if ((x != 0) || (nb_spi_call > 2)) {
+        printf("ERROR: SX125x registers multiple access failed\n");
+        return EXIT_FAILURE;
+    }
+    /* same radio accessed from two threads: each bridge sequence is a single worker transaction */
+    if (use_worker == true) {
+        x = lgw_worker_start();
+        x |= pthread_create(&busy_thread, NULL, sx125x_loop, &k);
+        j = sx125x_list_check(0x40, 500);
+        pthread_join(busy_thread, NULL);
+        x |= lgw_worker_stop();
+        if ((x != 0) || (j != 0) || (k != 0)) {
+            printf("ERROR: SX125x accesses from two threads interleaved, %d + %d errors\n", j, k);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* count the accesses of the receive & send loops only */
+    lgw_reg_stat_reset();
+    lgw_spi_stat_reset();
+
+    /* receive, FIFO filled with 16 packets at a time */
+    for (i = 0; i < SIM_PAYLOAD_SIZE; ++i) {
+        payload[i] = (uint8_t)i;
+    }
+    memset(metadata, 0, sizeof metadata);
+    metadata[1] = (7 << 4) | (CR_LORA_4_5 << 1); /* SF7, CR 4/5 */
+    metadata[5] = 100; /* RSSI */
+    memset(&send_args, 0, sizeof send_args);
+    send_args.pkt.freq_hz = SIM_FREQ_A;
+    send_args.pkt.tx_mode = IMMEDIATE;
+    send_args.pkt.rf_power = 14;
+    send_args.pkt.modulation = MOD_LORA;
+    send_args.pkt.bandwidth = BW_125KHZ;
+    send_args.pkt.datarate = DR_LORA_SF9;
+    send_args.pkt.coderate = CR_LORA_4_5;
+    send_args.pkt.size = SIM_PAYLOAD_SIZE;
+    memcpy(send_args.pkt.payload, payload, SIM_PAYLOAD_SIZE);
+    send_args.nb_pkt = nb_pkt;
+    tx_cnt = lgw_spi_sim_tx_get(NULL, 0);
+    bench_start(&b);
+    if (use_worker == true) {
+        if ((lgw_worker_start() != LGW_WORKER_SUCCESS) || (pthread_create(&send_thread, NULL, send_loop, &send_args) != 0)) {
+            printf("ERROR: failed to start the SPI worker or the send thread\n");
+            return EXIT_FAILURE;
+        }
+    }
+    for (i = 0; i < nb_pkt; i += k) {
+        k = ((nb_pkt - i) < 16) ? (nb_pkt - i) : 16;
+        for (j = 0; j < k; ++j) {
+            metadata[0] = (uint8_t)((i + j) % LGW_MULTI_NB); /* IF chain */
+            payload[0] = (uint8_t)(i + j);
+            lgw_spi_sim_rx_push(5, payload, SIM_PAYLOAD_SIZE, metadata); /* CRC OK */
+        }
+        do {
+            x = lgw_receive(ARRAY_SIZE(rxpkt), rxpkt);
+            for (j = 0; j < x; ++j) {
+                if ((rxpkt[j].size != SIM_PAYLOAD_SIZE) || (rxpkt[j].payload[0] != (uint8_t)nb_rx) || (rxpkt[j].status != STAT_CRC_OK) || (rxpkt[j].datarate != DR_LORA_SF7)) {
+                    err += 1;
+                }
+                nb_rx += 1;
+            }
+        } while (x > 0);
+    }
+    if (use_worker == false) {
+        bench_stop(&b, "lgw_receive", nb_rx);
+    }
+    if ((nb_rx != nb_pkt) || (err != 0)) {
+        printf("ERROR: %d packets received, %d expected, %d corrupted\n", nb_rx, nb_pkt, err);
+        return EXIT_FAILURE;
+    }
+
+    /* RX FIFO drained in one SPI transaction per packet (+1 per lgw_receive call) */
+    if (use_worker == false) {
+        for (i = 0, nb_spi_call = 0; i < LGW_SPI_STAT_NB; ++i) {
+            lgw_spi_stat_get(i, &spi_stat);
+            nb_spi_call += spi_stat.nb_call;
+        }
+        printf("%d packets received in %u SPI transactions, %.2f per packet\n", nb_rx, nb_spi_call, (double)nb_spi_call / nb_rx);
+        if ((double)nb_spi_call / nb_rx > 1.5) {
+            printf("ERROR: too many SPI transactions to drain the RX FIFO\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* send, from a second thread if the worker is used */
+    if (use_worker == false) {
+        bench_start(&b);
+        send_loop(&send_args);
+        bench_stop(&b, "lgw_send", nb_pkt);
+    } else {
+        pthread_join(send_thread, NULL);
+        bench_stop(&b, "lgw_rx+send", nb_pkt * 2);
+    }
+    tx_cnt = lgw_spi_sim_tx_get(tx_buf, sizeof tx_buf) - tx_cnt;
+    if ((send_args.nb_err != 0) || (tx_cnt != (uint32_t)nb_pkt) || (memcmp(tx_buf + 16, send_args.pkt.payload, SIM_PAYLOAD_SIZE) != 0)) {
+        printf("ERROR: %u packets triggered, %d expected, %d errors\n", tx_cnt, nb_pkt, send_args.nb_err);
+        return EXIT_FAILURE;
+    }
+
+    if ((use_worker == true) && (lgw_worker_stop() != LGW_WORKER_SUCCESS)) {
+        printf("ERROR: failed to stop the SPI worker\n");
+        return EXIT_FAILURE;
+    }
+
+    /* access statistics */
+    for (i = 0; i < LGW_REG_PHASE_NB; ++i) {
+        lgw_reg_stat_get_phase(i, &reg_stat);
+        printf("phase %d: %u accesses, %u page switches, %llu bytes\n", i, reg_stat.nb_call, reg_stat.nb_page_switch, (unsigned long long)reg_stat.nb_byte);
+        if (((i == LGW_REG_PHASE_RECEIVE) || (i == LGW_REG_PHASE_SEND)) && (reg_stat.nb_call < (uint32_t)nb_pkt)) {
+            err += 1;
+        }
+    }
+    for (i = 0; i < LGW_SPI_STAT_NB; ++i) {
+        lgw_spi_stat_get(i, &spi_stat);
+        printf("SPI access type %d: %u calls, %llu bytes, %.1f us avg, histogram:", i, spi_stat.nb_call, (unsigned long long)spi_stat.nb_byte, (spi_stat.nb_call == 0) ? 0.0 : (double)spi_stat.time_ns / 1000.0 / spi_stat.nb_call);
+        for (j = 0; j < LGW_SPI_STAT_HISTO_NB; ++j) {
+            printf(" %u", spi_stat.histo[j]);
+        }
+        printf("\n");
+    }
+    lgw_reg_stat_get(LGW_RX_PACKET_DATA_FIFO_NUM_STORED, &reg_stat);
+    if ((err != 0) || (reg_stat.nb_call < (uint32_t)nb_pkt)) {
+        printf("ERROR: unexpected register access statistics\n");
+        return EXIT_FAILURE;
+    }
+
+    /* snapshot, checked against single register reads, then diff & restore */
+    bench_start(&b);
+    x = lgw_reg_snapshot(&snap[0]);
+    bench_stop(&b, "lgw_reg_snapshot", 1);
+    for (i = 0; (x == LGW_REG_SUCCESS) && (i < LGW_TOTALREGS); ++i) {
+        if ((i != LGW_PAGE_REG) && (i != LGW_TIMESTAMP) && (lgw_reg_snapshot_get(&snap[0], i, &val[0]) == LGW_REG_SUCCESS)) {
+            lgw_reg_r(i, &val[1]);
+            if (val[0] != val[1]) {
+                printf("ERROR: register %d is %d in snapshot, %d read\n", i, val[0], val[1]);
+                err += 1;
+            }
+        }
+    }
+    lgw_reg_w(LGW_IF_FREQ_0, 1234);
+    lgw_reg_w(LGW_CORR0_DETECT_EN, 0);
+    lgw_reg_snapshot(&snap[1]);
+    x = lgw_reg_snapshot_diff(&snap[0], &snap[1], diff, ARRAY_SIZE(diff));
+    for (i = 0, j = 0; (i < x) && (i < (int)ARRAY_SIZE(diff)); ++i) {
+        if ((diff[i].fpga == false) && ((diff[i].register_id == LGW_IF_FREQ_0) || (diff[i].register_id == LGW_CORR0_DETECT_EN))) {
+            j += 1;
+        }
+    }
+    lgw_reg_snapshot_restore(&snap[0]);
+    lgw_reg_r(LGW_IF_FREQ_0, &val[0]);
+    lgw_reg_snapshot_get(&snap[0], LGW_IF_FREQ_0, &val[1]);
+    if ((err != 0) || (j != 2) || (val[0] != val[1])) {
+        printf("ERROR: snapshot failed, %d errors, %d/2 changes found, IF_FREQ_0 restored to %d instead of %d\n", err, j, val[0], val[1]);
+        return EXIT_FAILURE;
+    }
+
+    /* hot reconfiguration: move IF0, restrict IF3 to SF7-8, change the RSSI offset of radio A */
+    metadata[0] = 0; /* IF chain */
+    lgw_spi_sim_rx_push(5, payload, SIM_PAYLOAD_SIZE, metadata);
+    lgw_receive(ARRAY_SIZE(rxpkt), rxpkt);
+    rssi_ref = rxpkt[0].rssi; /* RSSI offset 0 */
+    ifplan[0].freq_hz = -250000;
+    ifplan[3].datarate = DR_LORA_SF7 | DR_LORA_SF8;
+    rssi_offset[0] = -166.0;
+    rssi_offset[1] = 0.0;
+    lgw_reg_stat_reset();
+    bench_start(&b);
+    x = lgw_reconfigure(ifplan, rssi_offset);
+    bench_stop(&b, "lgw_reconfigure", 1);
+    lgw_reg_stat_get(LGW_IF_FREQ_0, &reg_stat_if[0]);
+    lgw_reg_stat_get(LGW_CORR3_DETECT_EN, &reg_stat_if[1]);
+    lgw_reg_stat_get(LGW_IF_FREQ_1, &reg_stat_if[2]);
+    lgw_reg_r(LGW_IF_FREQ_0, &val[0]);
+    lgw_reg_r(LGW_CORR3_DETECT_EN, &val[1]);
+    if ((x != LGW_HAL_SUCCESS) || (reg_stat_if[0].nb_call != 1) || (reg_stat_if[1].nb_call != 1) || (reg_stat_if[2].nb_call != 0) || (val[0] != -(250000 << 5) / 15625) || (val[1] != (DR_LORA_SF7 | DR_LORA_SF8))) {
+        printf("ERROR: reconfiguration failed, IF_FREQ_0 %d (%u writes), CORR3_DETECT_EN 0x%02X (%u writes), IF_FREQ_1 %u writes\n", val[0], reg_stat_if[0].nb_call, val[1], reg_stat_if[1].nb_call, reg_stat_if[2].nb_call);
+        return EXIT_FAILURE;
+    }
+    /* radio of a LoRa 'multi' chain is fixed while running: rejected, nothing changed */
+    ifplan[0].freq_hz = -350000;
+    ifplan[1].rf_chain = 1;
+    x = lgw_reconfigure(ifplan, NULL);
+    ifplan[1].rf_chain = 0;
+    lgw_reg_r(LGW_IF_FREQ_0, &val[0]);
+    if ((x != LGW_HAL_ERROR) || (val[0] != -(250000 << 5) / 15625)) {
+        printf("ERROR: invalid reconfiguration not rejected\n");
+        return EXIT_FAILURE;
+    }
+    /* SPI failure on each frame of the write in turn: previous plan kept, in software and registers */
+    ifplan[3].datarate = DR_LORA_SF9;
+    for (k = 1, x = LGW_HAL_ERROR; (x != LGW_HAL_SUCCESS) && (k < 64); ++k) {
+        lgw_spi_sim_fault(k);
+        x = lgw_reconfigure(ifplan, NULL);
+        lgw_spi_sim_fault(0);
+        lgw_reg_r(LGW_IF_FREQ_0, &val[0]);
+        lgw_reg_r(LGW_CORR3_DETECT_EN, &val[1]);
+        if ((x != LGW_HAL_SUCCESS) && ((val[0] != -(250000 << 5) / 15625) || (val[1] != (DR_LORA_SF7 | DR_LORA_SF8)))) {
+            printf("ERROR: failed reconfiguration not rolled back, SPI frame %d, IF_FREQ_0 %d, CORR3_DETECT_EN 0x%02X\n", k, val[0], val[1]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((x != LGW_HAL_SUCCESS) || (k < 3) || (val[0] != -(350000 << 5) / 15625) || (val[1] != DR_LORA_SF9)) {
+        printf("ERROR: reconfiguration failed after SPI errors, %d frames, IF_FREQ_0 %d, CORR3_DETECT_EN 0x%02X\n", k, val[0], val[1]);
+        return EXIT_FAILURE;
+    }
+    ifplan[0].freq_hz = -250000;
+    ifplan[3].datarate = DR_LORA_SF7 | DR_LORA_SF8;
+    lgw_reconfigure(ifplan, NULL);
+    /* reception goes on with the new RSSI offset */
+    lgw_spi_sim_rx_push(5, payload, SIM_PAYLOAD_SIZE, metadata);
+    x = lgw_receive(ARRAY_SIZE(rxpkt), rxpkt);
+    if ((x != 1) || (rxpkt[0].rssi != (rssi_ref + rssi_offset[0]))) {
+        printf("ERROR: reception failed after reconfiguration, %d packets, RSSI %.1f\n", x, (x > 0) ? rxpkt[0].rssi : 0.0);
+        return EXIT_FAILURE;
+    }
+
+    /* RX filters: packets with a bad CRC dropped on their FIFO status, without payload transfer */
+    memset(noise, 0xAA, sizeof noise);
+    memset(&rxfilter, 0, sizeof rxfilter);
+    rxfilter.enable = true;
+    rxfilter.drop_crc_bad = true;
+    x = lgw_rxfilter_setconf(rxfilter);
+    for (i = 0; i < 8; ++i) {
+        payload[0] = (uint8_t)i;
+        lgw_spi_sim_rx_push(5, payload, SIM_PAYLOAD_SIZE, metadata); /* CRC OK */
+        lgw_spi_sim_rx_push(7, noise, sizeof noise, metadata); /* CRC bad */
+    }
+    lgw_spi_stat_reset();
+    k = lgw_receive(ARRAY_SIZE(rxpkt), rxpkt);
+    for (i = 0, nb_spi_byte = 0; i < LGW_SPI_STAT_NB; ++i) {
+        lgw_spi_stat_get(i, &spi_stat);
+        nb_spi_byte += spi_stat.nb_byte;
+    }
+    for (i = 0; i < k; ++i) {
+        if ((rxpkt[i].payload[0] != (uint8_t)i) || (rxpkt[i].status != STAT_CRC_OK)) {
+            x = -1;
+        }
+    }
+    printf("%d packets received, 8 dropped on CRC, %llu bytes transferred\n", k, (unsigned long long)nb_spi_byte);
+    if ((x != LGW_HAL_SUCCESS) || (k != 8) || (nb_spi_byte >= 8 * (SIM_PAYLOAD_SIZE + 16) + sizeof noise)) {
+        printf("ERROR: RX filter on CRC status failed\n");
+        return EXIT_FAILURE;
+    }
+    /* metadata read first: IF chain 2, low RSSI and non-zero CRC field (user predicate) dropped */
+    rxfilter.drop_crc_bad = false;
+    rxfilter.if_chain_mask = 0x3FF & ~(1 << 2);
+    rxfilter.rssi_check = true;
+    rxfilter.rssi_min = rssi_ref + rssi_offset[0] - 10.0;
+    rxfilter.accept = rx_accept;
+    rxfilter.accept_arg = &nb_accept_call;
+    x = lgw_rxfilter_setconf(rxfilter);
+    for (i = 0; i < 16; ++i) {
+        payload[0] = (uint8_t)i;
+        metadata[0] = ((i % 4) == 1) ? 2 : 0; /* IF chain */
+        metadata[5] = ((i % 4) == 2) ? 50 : 100; /* RSSI */
+        metadata[10] = ((i % 4) == 3) ? 0x55 : 0; /* CRC */
+        lgw_spi_sim_rx_push(5, payload, SIM_PAYLOAD_SIZE, metadata);
+    }
+    metadata[0] = 0;
+    metadata[5] = 100;
+    metadata[10] = 0;
+    k = lgw_receive(ARRAY_SIZE(rxpkt), rxpkt);
+    for (i = 0; i < k; ++i) {
+        if ((rxpkt[i].payload[0] != (uint8_t)(4 * i)) || (rxpkt[i].size != SIM_PAYLOAD_SIZE) || (memcmp(rxpkt[i].payload + 1, payload + 1, SIM_PAYLOAD_SIZE - 1) != 0)) {
+            x = -1;
+        }
+    }
+    if ((x != LGW_HAL_SUCCESS) || (k != 4) || (nb_accept_call != 8) || (lgw_receive(ARRAY_SIZE(rxpkt), rxpkt) != 0)) {
+        printf("ERROR: RX filters on metadata failed, %d packets received, predicate called %d times\n", k, nb_accept_call);
+        return EXIT_FAILURE;
+    }
+    rxfilter.if_chain_mask = 0x8000;
+    x = lgw_rxfilter_setconf(rxfilter);
+    memset(&rxfilter, 0, sizeof rxfilter); /* filters disabled */
+    if ((x != LGW_HAL_ERROR) || (lgw_rxfilter_setconf(rxfilter) != LGW_HAL_SUCCESS)) {
+        printf("ERROR: invalid RX filter configuration not rejected\n");
+        return EXIT_FAILURE;
+    }
+
+    /* background RX engine: packets pushed through the SPI worker, dequeued in batches when the eventfd is readable */
+    x = lgw_rx_start(SIM_RX_POLL_US);
+    pfd.fd = lgw_rx_fd();
+    pfd.events = POLLIN;
+    push_args.metadata = metadata;
+    push_args.nb_pkt = 8;
+    for (i = 0; (x == LGW_RX_SUCCESS) && (i < 64); i += push_args.nb_pkt) {
+        push_args.first = i;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        lgw_worker_call(rx_push_job, &push_args, LGW_WORKER_PRIO_NORMAL);
+        for (k = 0; (k < push_args.nb_pkt) && (poll(&pfd, 1, 1000) == 1); k += j) {
+            j = lgw_rx_dequeue(rxpkt, ARRAY_SIZE(rxpkt));
+            for (n = 0; n < j; ++n) {
+                if (rxpkt[n].payload[0] != (uint8_t)(i + k + n)) {
+                    x = LGW_RX_ERROR;
+                }
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        if (diff_us(&t0, &t1) > rx_latency_max) {
+            rx_latency_max = diff_us(&t0, &t1);
+        }
+        if (k != push_args.nb_pkt) {
+            x = LGW_RX_ERROR;
+        }
+    }
+    printf("RX engine: %d packets, max latency %.1f us\n", i, rx_latency_max);
+    /* ring full: the engine keeps draining the concentrator, the newest packets are dropped */
+    push_args.nb_pkt = 16;
+    for (i = 0; (x == LGW_RX_SUCCESS) && (i < LGW_RX_RING_SIZE + 32); i += push_args.nb_pkt) {
+        push_args.first = i;
+        lgw_worker_call(rx_push_job, &push_args, LGW_WORKER_PRIO_NORMAL);
+        for (k = 0; k < 1000; ++k) {
+            lgw_rx_stat_get(&rx_stat);
+            if ((rx_stat.nb_pkt - 64 + rx_stat.nb_drop) == (uint32_t)(i + push_args.nb_pkt)) {
+                break;
+            }
+            wait_ms(1);
+        }
+    }
+    for (i = 0, j = 1; (x == LGW_RX_SUCCESS) && (j > 0); i += j) {
+        j = lgw_rx_dequeue(rxpkt, ARRAY_SIZE(rxpkt));
+        for (k = 0; k < j; ++k) {
+            if (rxpkt[k].payload[0] != (uint8_t)(i + k)) {
+                x = LGW_RX_ERROR;
+            }
+        }
+    }
+    lgw_rx_stat_get(&rx_stat);
+    if ((x != LGW_RX_SUCCESS) || (i != LGW_RX_RING_SIZE) || (rx_stat.nb_drop != 32) || (rx_stat.max_fill != LGW_RX_RING_SIZE) || (poll(&pfd, 1, 0) != 0) || (lgw_rx_stop() != LGW_RX_SUCCESS)) {
+        printf("ERROR: RX engine failed, %d packets dequeued from the full ring, %u dropped\n", i, rx_stat.nb_drop);
+        return EXIT_FAILURE;
+    }
+
+    /* adaptive RX polling vs fixed 3 ms sleep, same simulated traffic in virtual time */
+    memset(&toa_pkt, 0, sizeof toa_pkt);
+    toa_pkt.modulation = MOD_LORA;
+    toa_pkt.bandwidth = BW_125KHZ;
+    toa_pkt.datarate = DR_LORA_SF7;
+    toa_pkt.coderate = CR_LORA_4_5;
+    toa_pkt.preamble = 8;
+    toa_pkt.size = SIM_PAYLOAD_SIZE;
+    toa_us = lgw_time_on_air(&toa_pkt) * 1000;
+    x = lgw_rxpoll_init(&rxpoll, 1000, 100000);
+    printf("RX FIFO overflow not before %u us, packets of %u us\n", rxpoll.fill_us, toa_us);
+    for (n = 0; (x == LGW_HAL_SUCCESS) && (n < 2); ++n) {
+        seed = 1;
+        for (i = 0; i < LGW_MULTI_NB; ++i) {
+            seed = seed * 1103515245 + 12345;
+            next_end[i] = toa_us + (seed >> 8) % SIM_IDLE_GAP_US;
+        }
+        nb_poll[n] = 0;
+        nb_lost[n] = 0;
+        nb_got[n] = 0;
+        interval_us = 3000;
+        bench_start(&b);
+        for (t_us = 0; t_us < SIM_TRAFFIC_US; t_us += interval_us) {
+            /* packets completed during the interval, in completion order */
+            while (1) {
+                for (i = 1, j = 0; i < LGW_MULTI_NB; ++i) {
+                    j = (next_end[i] < next_end[j]) ? i : j;
+                }
+                if (next_end[j] > t_us) {
+                    break;
+                }
+                metadata[0] = (uint8_t)j; /* IF chain */
+                if (lgw_spi_sim_rx_push(5, payload, SIM_PAYLOAD_SIZE, metadata) != LGW_SPI_SUCCESS) {
+                    nb_lost[n] += 1;
+                }
+                seed = seed * 1103515245 + 12345;
+                if ((next_end[j] % SIM_BURST_PERIOD_US) < SIM_BURST_US) {
+                    next_end[j] += toa_us; /* back-to-back packets */
+                } else {
+                    next_end[j] += toa_us + (seed >> 8) % SIM_IDLE_GAP_US;
+                }
+            }
+            k = lgw_receive(ARRAY_SIZE(rxpkt), rxpkt);
+            nb_poll[n] += 1;
+            nb_got[n] += (k > 0) ? k : 0;
+            interval_us = (n == 0) ? 3000 : lgw_rxpoll_next(&rxpoll, rxpkt, k, ARRAY_SIZE(rxpkt));
+        }
+        bench_stop(&b, (n == 0) ? "rx_poll_3ms" : "rx_poll_adapt", nb_poll[n]);
+        while ((k = lgw_receive(ARRAY_SIZE(rxpkt), rxpkt)) > 0) {
+            nb_got[n] += k;
+        }
+        printf("%s polling: %d polls, %d packets received, %d lost\n", (n == 0) ? "fixed 3 ms" : "adaptive", nb_poll[n], nb_got[n], nb_lost[n]);
+    }
+    metadata[0] = 0;
+    if ((x != LGW_HAL_SUCCESS) || (nb_got[0] + nb_lost[0] != nb_got[1] + nb_lost[1]) || (nb_poll[1] >= nb_poll[0]) || (nb_lost[1] > nb_lost[0])) {
+        printf("ERROR: adaptive RX polling not better than fixed polling\n");
+        return EXIT_FAILURE;
+    }
+
+    /* timestamp correction lookup vs per-packet formula, every LoRa packet of each modem and bandwidth */
+    ifplan[8].enable = true;
+    ifplan[8].rf_chain = 0;
+    ifplan[8].freq_hz = 0;
+    ifplan[8].datarate = DR_LORA_SF9;
+    ifplan[9].enable = true;
+    ifplan[9].rf_chain = 0;
+    ifplan[9].freq_hz = 300000;
+    ifplan[9].bandwidth = BW_125KHZ;
+    ifplan[9].datarate = SIM_FSK_DR;
+    metadata[6] = (uint8_t)(SIM_TSTAMP_RAW);
+    metadata[7] = (uint8_t)(SIM_TSTAMP_RAW >> 8);
+    metadata[8] = (uint8_t)(SIM_TSTAMP_RAW >> 16);
+    metadata[9] = (uint8_t)(SIM_TSTAMP_RAW >> 24);
+    err = 0;
+    for (n = 0; n < (int)ARRAY_SIZE(bw_std); ++n) {
+        ifplan[8].bandwidth = bw_std[n];
+        if (lgw_reconfigure(ifplan, NULL) != LGW_HAL_SUCCESS) {
+            err += 1;
+            break;
+        }
+        /* 'multi' modems are fixed at 125 kHz, checked once */
+        for (i = (n == 0) ? 0 : 8; i <= 8; i += 8) {
+            metadata[0] = (uint8_t)i; /* IF chain */
+            for (sf = 5; sf <= 13; ++sf) {
+                for (cr = 0; cr < 8; ++cr) {
+                    metadata[1] = (uint8_t)((sf << 4) | (cr << 1));
+                    for (j = 0; j < (int)ARRAY_SIZE(stat_std); ++j) {
+                        for (sz = 0; sz < 256; ++sz) {
+                            lgw_spi_sim_rx_push(stat_std[j], noise, (uint8_t)sz, metadata);
+                            tstamp_ref[sz % 8] = SIM_TSTAMP_RAW - tstamp_corr_ref((i == 8), bw_std[n], stat_std[j], metadata[1], sz);
+                            if ((sz % 8) != 7) {
+                                continue;
+                            }
+                            x = lgw_receive(ARRAY_SIZE(rxpkt), rxpkt);
+                            for (k = 0; k < 8; ++k) {
+                                if ((x != 8) || (rxpkt[k].count_us != tstamp_ref[k])) {
+                                    err += 1;
+                                }
+                            }
+                            nb_tstamp += 8;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    metadata[0] = 9; /* FSK */
+    lgw_spi_sim_rx_push(5, noise, SIM_PAYLOAD_SIZE, metadata);
+    x = lgw_receive(ARRAY_SIZE(rxpkt), rxpkt);
+    if ((x != 1) || (rxpkt[0].count_us != (uint32_t)SIM_TSTAMP_RAW - (((uint32_t)680000 / SIM_FSK_DR) - 20))) {
+        err += 1;
+    }
+    ifplan[8].enable = false;
+    ifplan[9].enable = false;
+    lgw_reconfigure(ifplan, NULL);
+    metadata[0] = 0;
+    metadata[1] = (7 << 4) | (CR_LORA_4_5 << 1);
+    memset(&metadata[6], 0, 4);
+    printf("%d timestamp corrections checked, %d errors\n", nb_tstamp, err);
+    /* 4 modem set-ups (multi, std at 3 bandwidths) x 9 SF x 8 CR x status x 256 sizes */
+    if ((err != 0) || (nb_tstamp != (4 * 9 * 8 * (int)ARRAY_SIZE(stat_std) * 256))) {
+        printf("ERROR: timestamp correction table differs from the formula\n");
+        return EXIT_FAILURE;
+    }
+
+    /* calibration cache: cold start, warm start, then cold again once the reuse limit is reached */
+    lgw_stop();
+    memset(&calconf, 0, sizeof calconf);
+    calconf.enable = true;
+    strcpy(calconf.path, SIM_CALCACHE_PATH);
+    calconf.board_id = 0x0123456789ABCDEFULL;
+    calconf.max_reuse = 1;
+    remove(SIM_CALCACHE_PATH);
+    lgw_calcache_setconf(calconf);
+    for (i = 0; i < 3; ++i) {
+        lgw_reg_stat_reset();
+        bench_start(&b);
+        x = lgw_start();
+        bench_stop(&b, (i == 1) ? "warm start" : "cold start", 1);
+        lgw_reg_stat_get(LGW_MCU_PROM_DATA, &reg_stat);
+        nb_fw_access[i] = reg_stat.nb_call; /* firmware loads and checks */
+        nb_fw_byte[i] = reg_stat.nb_byte;
+        lgw_stop();
+        if (x != LGW_HAL_SUCCESS) {
+            err += 1;
+        }
+    }
+    if ((err != 0) || (nb_fw_access[1] >= nb_fw_access[0]) || (nb_fw_access[2] != nb_fw_access[0])) {
+        printf("ERROR: calibration cache failed, %d start errors, firmware accesses %u (cold) %u (warm) %u (cold)\n", err, nb_fw_access[0], nb_fw_access[1], nb_fw_access[2]);
+        return EXIT_FAILURE;
+    }
+
+    /* resident firmwares with sampled check, on a warm start nothing is loaded */
+    fwconf.check = LGW_FW_CHECK_SAMPLE;
+    fwconf.keep_resident = true;
+    lgw_fw_setconf(fwconf);
+    calconf.max_reuse = 0;
+    lgw_calcache_setconf(calconf);
+    calcache_ino[0] = file_inode(SIM_CALCACHE_PATH);
+    lgw_reg_stat_reset();
+    bench_start(&b);
+    x = lgw_start();
+    bench_stop(&b, "resident fw", 1);
+    lgw_reg_stat_get(LGW_MCU_PROM_DATA, &reg_stat);
+    lgw_stop();
+    calcache_ino[1] = file_inode(SIM_CALCACHE_PATH);
+    if ((calcache_ino[0] == 0) || (calcache_ino[1] != calcache_ino[0])) {
+        printf("ERROR: calibration cache rewritten by a warm start without reuse limit\n");
+        return EXIT_FAILURE;
+    }
+    remove(SIM_CALCACHE_PATH);
+    printf("firmware bytes transferred: %llu (cold), %llu (warm), %llu (warm, resident)\n", (unsigned long long)nb_fw_byte[0], (unsigned long long)nb_fw_byte[1], (unsigned long long)reg_stat.nb_byte);
+    if ((x != LGW_HAL_SUCCESS) || (reg_stat.nb_byte > 2 * (LGW_FW_CHECK_SAMPLE_SIZE + 1))) {
+        printf("ERROR: resident firmwares reloaded\n");
+        return EXIT_FAILURE;
+    }
+
+    /* start-up script: compiled by the first start, replayed by the second, same registers content as without */
+    lgw_start();
+    lgw_reg_snapshot(&snap[0]);
+    lgw_stop();
+    lgw_start_script_enable(true);
+    for (i = 0; i < 2; ++i) {
+        bench_start(&b);
+        x = lgw_start();
+        bench_stop(&b, (i == 0) ? "script rec" : "script play", 1);
+        lgw_start_profile(&start_prof);
+        if (x != LGW_HAL_SUCCESS) {
+            err += 1;
+        }
+        if (i == 0) {
+            lgw_stop();
+        }
+    }
+    lgw_reg_snapshot(&snap[1]);
+    lgw_stop();
+    lgw_start_script_enable(false);
+    x = lgw_reg_snapshot_diff(&snap[0], &snap[1], diff, ARRAY_SIZE(diff));
+    for (i = 0; (i < x) && (i < (int)ARRAY_SIZE(diff)); ++i) {
+        if ((diff[i].fpga == true) || (diff[i].register_id != LGW_TIMESTAMP)) {
+            printf("ERROR: register %d (fpga %d) is %d without script, %d with\n", diff[i].register_id, diff[i].fpga, diff[i].value_a, diff[i].value_b);
+            err += 1;
+        }
+    }
+    printf("modem configuration replayed in %u SPI transactions, %llu bytes\n", start_prof.phase[LGW_START_PHASE_MODEM].nb_spi_call, (unsigned long long)start_prof.phase[LGW_START_PHASE_MODEM].nb_spi_byte);
+    if ((err != 0) || (x > (int)ARRAY_SIZE(diff)) || (start_prof.phase[LGW_START_PHASE_MODEM].nb_spi_call != 1)) {
+        printf("ERROR: start-up script failed\n");
+        return EXIT_FAILURE;
+    }
+
+    /* register shadow: same registers content with and without, after calibration, reception and bit-field writes */
+    calconf.enable = false;
+    lgw_calcache_setconf(calconf);
+    fwconf.check = LGW_FW_CHECK_FULL;
+    fwconf.keep_resident = false;
+    lgw_fw_setconf(fwconf);
+    for (n = 0; n < 2; ++n) {
+        lgw_reg_shadow_enable(n == 1);
+        x = lgw_start();
+        for (i = 0; i < 4; ++i) {
+            lgw_spi_sim_rx_push(5, payload, SIM_PAYLOAD_SIZE, metadata);
+        }
+        k = lgw_receive(ARRAY_SIZE(rxpkt), rxpkt);
+        lgw_reg_w(LGW_IQ_MISMATCH_B_SEL_I, 1); /* shares its byte with B_AMP_COEFF, set by the calibration */
+        lgw_reg_w(LGW_IQ_MISMATCH_A_AMP_COEFF, 0); /* default value, changed by the calibration */
+        lgw_reg_snapshot(&snap[n]);
+        lgw_stop();
+        if ((x != LGW_HAL_SUCCESS) || (k != 4)) {
+            err += 1;
+        }
+    }
+    lgw_reg_shadow_enable(use_shadow);
+    x = lgw_reg_snapshot_diff(&snap[0], &snap[1], diff, ARRAY_SIZE(diff));
+    for (i = 0; (i < x) && (i < (int)ARRAY_SIZE(diff)); ++i) {
+        if ((diff[i].fpga == true) || (diff[i].register_id != LGW_TIMESTAMP)) {
+            printf("ERROR: register %d (fpga %d) is %d without shadow, %d with\n", diff[i].register_id, diff[i].fpga, diff[i].value_a, diff[i].value_b);
+            err += 1;
+        }
+    }
+    lgw_reg_snapshot_get(&snap[1], LGW_IQ_MISMATCH_B_AMP_COEFF, &val[0]);
+    lgw_reg_snapshot_get(&snap[1], LGW_IQ_MISMATCH_A_AMP_COEFF, &val[1]);
+    if ((err != 0) || (x > (int)ARRAY_SIZE(diff)) || (val[0] == 0) || (val[1] != 0)) {
+        printf("ERROR: register shadow out of sync with the concentrator, IQ_MISMATCH_B_AMP_COEFF %d, IQ_MISMATCH_A_AMP_COEFF %d\n", val[0], val[1]);
+        return EXIT_FAILURE;
+    }
+
+    /* HAL calls from another thread are refused while lgw_start runs */
+    memset(&busy_args, 0, sizeof busy_args);
+    pthread_create(&busy_thread, NULL, start_busy_loop, &busy_args);
+    x = lgw_start();
+    __atomic_store_n(&busy_args.stop, true, __ATOMIC_RELEASE);
+    pthread_join(busy_thread, NULL);
+    k = lgw_start_profile(&start_prof);
+    lgw_stop();
+    if ((x != LGW_HAL_SUCCESS) || (busy_args.started == false) || (busy_args.nb_accepted != 0) || (k != LGW_HAL_SUCCESS) || (start_prof.status != LGW_HAL_SUCCESS)) {
+        printf("ERROR: HAL calls during lgw_start not refused, %d accepted\n", busy_args.nb_accepted);
+        return EXIT_FAILURE;
+    }
+
+    /* SX127x of a SX1301AP2 board: full set-up once, then only retuned for each step of a sweep */
+    memset(&sim_conf, 0, sizeof sim_conf);
+    sim_conf.fpga = true;
+    sim_conf.sx127x_version = 0x12; /* SX1276 */
+    lgw_spi_sim_setconf(sim_conf);
+    x = lgw_connect(false, 0);
+    if (use_worker == true) {
+        x |= lgw_worker_start(); /* set-up and retunes executed by the SPI worker */
+    }
+    bench_start(&b);
+    x |= lgw_setup_sx127x(863000000, MOD_FSK, LGW_SX127X_RXBW_100K_HZ, 0);
+    bench_stop(&b, "sx127x setup", 1);
+    bench_start(&b);
+    for (i = 0; (i < 200) && (x == 0); ++i) {
+        x = lgw_sx127x_retune(863000000 + i * 25000, (i < 199) ? LGW_SX127X_RXBW_100K_HZ : LGW_SX127X_RXBW_125K_HZ);
+    }
+    bench_stop(&b, "sx127x retune", 200);
+    for (i = 0; i < 3; ++i) {
+        x |= lgw_sx127x_reg_r(0x06 + i, &sx127x_reg[i]); /* Frf */
+    }
+    x |= lgw_sx127x_reg_r(0x12, &sx127x_reg[3]); /* RxBw */
+    x |= lgw_sx127x_reg_r(0x01, &sx127x_reg[4]); /* OpMode */
+
+    /* LBT readiness, the timestamps left by a previous run of the FSM are not a scan */
+    memset(&lbtconf, 0, sizeof lbtconf);
+    lbtconf.enable = true;
+    lbtconf.nb_channel = 2;
+    lbt_setconf(&lbtconf);
+    k  = (lbt_start() != LGW_LBT_SUCCESS) || (lbt_wait_ready(20) != LGW_LBT_SUCCESS);
+    lgw_spi_sim_lbt_busy(true);
+    k |= (lbt_start() != LGW_LBT_SUCCESS) || (lbt_wait_ready(20) != LGW_LBT_ERROR);
+    lgw_spi_sim_lbt_busy(false);
+    k |= (lbt_wait_ready(20) != LGW_LBT_SUCCESS);
+    lbtconf.enable = false;
+    lbt_setconf(&lbtconf);
+    if (use_worker == true) {
+        x |= lgw_worker_stop();
+    }
+    lgw_disconnect();
+    sim_conf.fpga = false;
+    lgw_spi_sim_setconf(sim_conf);
+    j = (int)((((uint64_t)(863000000 + 199 * 25000)) << 19) / 32000000);
+    if ((x != 0) || (sx127x_reg[0] != (uint8_t)(j >> 16)) || (sx127x_reg[1] != (uint8_t)(j >> 8)) || (sx127x_reg[2] != (uint8_t)j) || (sx127x_reg[3] != 0x02) || (sx127x_reg[4] != 0x05)) {
+        printf("ERROR: SX127x retune failed\n");
+        return EXIT_FAILURE;
+    }
+    if (k != 0) {
+        printf("ERROR: LBT ready with the timestamps of a previous run\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("End of test for loragw_spi.sim.c\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* --- EOF ------------------------------------------------------------------ */
@@ -45,6 +45,9 @@ int main()
     uint8_t dataout[BURST_TEST_SIZE];
     uint8_t datain[BURST_TEST_SIZE];
     uint8_t spi_mux_mode = LGW_SPI_MUX_MODE0;
+    struct lgw_spi_op_s batch_op[LGW_SPI_BATCH_MAX_OP];
+    struct lgw_spi_batch_s batch;
+    uint8_t batch_data[2] = {0, 0};
 
     for (i = 0; i < BURST_TEST_SIZE; ++i) {
         dataout[i] = 0x30 + (i % 10); /* ASCCI code for 0 -> 9 */
@@ -72,6 +75,17 @@ int main()
     for (i = 0; i < TIMING_REPEAT; ++i)
         lgw_spi_rb(spi_target, spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, 0x5A, datain, ARRAY_SIZE(datain));
 
+    /* batch test, mixed operations sent in a single transaction */
+    lgw_spi_batch_init(&batch, batch_op, LGW_SPI_BATCH_MAX_OP);
+    lgw_spi_batch_w(&batch, spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, 0xAA, 0x96);
+    lgw_spi_batch_r(&batch, spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, 0x55, &batch_data[0]);
+    lgw_spi_batch_wb(&batch, spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, 0x55, dataout, 16);
+    lgw_spi_batch_rb(&batch, spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, 0x5A, datain, ARRAY_SIZE(datain));
+    lgw_spi_batch_r(&batch, spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, 0x55, &batch_data[1]);
+    for (i = 0; i < TIMING_REPEAT; ++i)
+        lgw_spi_batch_submit(spi_target, &batch);
+    printf("data received (batch reads): %d %d\n", batch_data[0], batch_data[1]);
+
     /* last read (blocking), just to be sure no to quit before the FTDI buffer is flushed */
     lgw_spi_r(spi_target, spi_mux_mode, LGW_SPI_MUX_TARGET_SX1301, 0x55, &data);
     printf("data received (simple read): %d\n",data);
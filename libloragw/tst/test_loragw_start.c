@@ -0,0 +1,174 @@
+/*
+ / _____)             _              | |
+( (____  _____ ____ _| |_ _____  ____| |__
+ \____ \| ___ |    (_   _) ___ |/ ___)  _ \
+ _____) ) ____| | | || |_| ____( (___| | | |
+(______/|_____)_|_|_| \__)_____)\____)_| |_|
+  (C)2013 Semtech-Cycleo
+
+Description:
+    Start-up profile of the concentrator: starts and stops it a few times and
+    displays the time and SPI traffic of each phase of lgw_start
+
+License: Revised BSD License, see LICENSE.TXT file include in the project
+Maintainer: Sylvain Miermont
+*/
+
+
+/* -------------------------------------------------------------------------- */
+/* --- DEPENDANCIES --------------------------------------------------------- */
+
+/* fix an issue between POSIX and C99 */
+#if __STDC_VERSION__ >= 199901L
+    #define _XOPEN_SOURCE 600
+#else
+    #define _XOPEN_SOURCE 500
+#endif
+
+#include <stdint.h>        /* C99 types */
+#include <stdbool.h>       /* bool type */
+#include <stdio.h>         /* printf */
+#include <string.h>        /* memset */
+#include <unistd.h>        /* getopt */
+
+#include "loragw_hal.h"
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE CONSTANTS ---------------------------------------------------- */
+
+#define DEFAULT_NB_START    3
+
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE FUNCTIONS DEFINITION ----------------------------------------- */
+
+/* describe command line options */
+void usage(void) {
+    printf("Library version information: %s\n", lgw_version_info());
+    printf( "Available options:\n");
+    printf( " -h print this help\n");
+    printf( " -a <float> Radio A RX frequency in MHz\n");
+    printf( " -b <float> Radio B RX frequency in MHz\n");
+    printf( " -r <int> Radio type (SX1255:1255, SX1257:1257)\n");
+    printf( " -k <int> Concentrator clock source (0: radio_A, 1: radio_B(default))\n");
+    printf( " -n <int> Number of starts (default %d)\n", DEFAULT_NB_START);
+}
+
+/* -------------------------------------------------------------------------- */
+/* --- MAIN FUNCTION -------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+    struct lgw_conf_board_s boardconf;
+    struct lgw_conf_rxrf_s rfconf;
+    struct lgw_conf_rxif_s ifconf;
+    struct lgw_start_profile_s start_prof; /* time & SPI traffic of the start-up phases */
+
+    int i, j;
+    int nb_start = DEFAULT_NB_START;
+    uint32_t fa = 0, fb = 0;
+    enum lgw_radio_type_e radio_type = LGW_RADIO_TYPE_NONE;
+    uint8_t clocksource = 1; /* Radio B is source by default */
+    double xd = 0.0;
+    int xi = 0;
+
+    /* parse command line options */
+    while ((i = getopt (argc, argv, "ha:b:r:k:n:")) != -1) {
+        switch (i) {
+            case 'h':
+                usage();
+                return -1;
+                break;
+            case 'a': /* <float> Radio A RX frequency in MHz */
+                sscanf(optarg, "%lf", &xd);
+                fa = (uint32_t)((xd*1e6) + 0.5); /* .5 Hz offset to get rounding instead of truncating */
+                break;
+            case 'b': /* <float> Radio B RX frequency in MHz */
+                sscanf(optarg, "%lf", &xd);
+                fb = (uint32_t)((xd*1e6) + 0.5); /* .5 Hz offset to get rounding instead of truncating */
+                break;
+            case 'r': /* <int> Radio type (1255, 1257) */
+                sscanf(optarg, "%i", &xi);
+                switch (xi) {
+                    case 1255:
+                        radio_type = LGW_RADIO_TYPE_SX1255;
+                        break;
+                    case 1257:
+                        radio_type = LGW_RADIO_TYPE_SX1257;
+                        break;
+                    default:
+                        printf("ERROR: invalid radio type\n");
+                        usage();
+                        return -1;
+                }
+                break;
+            case 'k': /* <int> Concentrator clock source (Radio A or Radio B) */
+                sscanf(optarg, "%i", &xi);
+                clocksource = (uint8_t)xi;
+                break;
+            case 'n': /* <int> Number of starts */
+                sscanf(optarg, "%i", &xi);
+                nb_start = xi;
+                break;
+            default:
+                printf("ERROR: argument parsing\n");
+                usage();
+                return -1;
+        }
+    }
+
+    /* check input parameters */
+    if ((fa == 0) || (fb == 0) || (radio_type == LGW_RADIO_TYPE_NONE) || (nb_start <= 0)) {
+        printf("ERROR: missing or invalid input parameter\n");
+        usage();
+        return -1;
+    }
+
+    printf("Beginning of test for lgw_start profile\n");
+
+    /* set configuration for board */
+    memset(&boardconf, 0, sizeof(boardconf));
+    boardconf.lorawan_public = true;
+    boardconf.clksrc = clocksource;
+    lgw_board_setconf(boardconf);
+
+    /* set configuration for RF chains */
+    memset(&rfconf, 0, sizeof(rfconf));
+    rfconf.enable = true;
+    rfconf.freq_hz = fa;
+    rfconf.type = radio_type;
+    rfconf.tx_enable = true;
+    lgw_rxrf_setconf(0, rfconf); /* radio A, f0 */
+    rfconf.freq_hz = fb;
+    rfconf.tx_enable = false;
+    lgw_rxrf_setconf(1, rfconf); /* radio B, f1 */
+
+    /* set configuration for LoRa multi-SF channels, 4 on each radio */
+    memset(&ifconf, 0, sizeof(ifconf));
+    ifconf.enable = true;
+    ifconf.datarate = DR_LORA_MULTI;
+    for (i = 0; i < LGW_MULTI_NB; ++i) {
+        ifconf.rf_chain = (i < 4) ? 0 : 1;
+        ifconf.freq_hz = -300000 + (i % 4) * 200000;
+        lgw_rxif_setconf(i, ifconf);
+    }
+
+    for (i = 0; i < nb_start; ++i) {
+        if (lgw_start() != LGW_HAL_SUCCESS) {
+            printf("*** Impossible to start concentrator ***\n");
+        }
+        lgw_start_profile(&start_prof);
+        lgw_stop();
+        printf("start-up %d: %.1f ms, %s\n", i, start_prof.total_ns / 1E6, (start_prof.status == LGW_HAL_SUCCESS) ? "success" : "failure");
+        for (j = 0; j < LGW_START_PHASE_NB; ++j) {
+            printf("  %-12s %10.1f ms %6u SPI %8llu bytes\n", start_prof.phase[j].name, start_prof.phase[j].duration_ns / 1E6, start_prof.phase[j].nb_spi_call, (unsigned long long)start_prof.phase[j].nb_spi_byte);
+        }
+        if (start_prof.status != LGW_HAL_SUCCESS) {
+            return -1;
+        }
+    }
+
+    printf("End of test for lgw_start profile\n");
+    return 0;
+}
+
+/* --- EOF ------------------------------------------------------------------ */
@@ -43,6 +43,12 @@ Maintainer: Sylvain Miermont
 #define ARRAY_SIZE(a)   (sizeof(a) / sizeof((a)[0]))
 #define MSG(args...)    fprintf(stderr,"loragw_pkt_logger: " args) /* message that is destined to the user */
 
+/* -------------------------------------------------------------------------- */
+/* --- PRIVATE CONSTANTS ---------------------------------------------------- */
+
+#define RX_POLL_MIN_US  1000    /* shortest time between two packet fetches */
+#define RX_POLL_MAX_US  100000  /* longest time between two packet fetches, when idle */
+
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE VARIABLES (GLOBAL) ------------------------------------------- */
 
@@ -378,7 +384,9 @@ void usage(void) {
 int main(int argc, char **argv)
 {
     int i, j; /* loop and temporary variables */
-    struct timespec sleep_time = {0, 3000000}; /* 3 ms */
+    struct timespec sleep_time; /* time to wait before the next packet fetch */
+    struct lgw_rxpoll_s rxpoll; /* adaptive packet fetch interval */
+    uint32_t poll_us;
 
     /* clock and log rotation management */
     int log_rotate_interval = 3600; /* by default, rotation every hour */
@@ -465,6 +473,11 @@ int main(int argc, char **argv)
         MSG("ERROR: failed to start the concentrator\n");
         return EXIT_FAILURE;
     }
+    i = lgw_rxpoll_init(&rxpoll, RX_POLL_MIN_US, RX_POLL_MAX_US);
+    if (i != LGW_HAL_SUCCESS) {
+        MSG("ERROR: failed to initialize the RX polling policy\n");
+        return EXIT_FAILURE;
+    }
 
     /* transform the MAC address into a string */
     sprintf(lgwm_str, "%08X%08X", (uint32_t)(lgwm >> 32), (uint32_t)(lgwm & 0xFFFFFFFF));
@@ -480,9 +493,9 @@ int main(int argc, char **argv)
         if (nb_pkt == LGW_HAL_ERROR) {
             MSG("ERROR: failed packet fetch, exiting\n");
             return EXIT_FAILURE;
-        } else if (nb_pkt == 0) {
-            clock_nanosleep(CLOCK_MONOTONIC, 0, &sleep_time, NULL); /* wait a short time if no packets */
-        } else {
+        }
+        poll_us = lgw_rxpoll_next(&rxpoll, rxpkt, nb_pkt, ARRAY_SIZE(rxpkt));
+        if (nb_pkt > 0) {
             /* local timestamp generation until we get accurate GPS time */
             clock_gettime(CLOCK_REALTIME, &fetch_time);
             x = gmtime(&(fetch_time.tv_sec));
@@ -605,6 +618,13 @@ int main(int argc, char **argv)
                 open_log();
             }
         }
+
+        /* wait before the next fetch, interval adapted to the traffic */
+        if (poll_us > 0) {
+            sleep_time.tv_sec = poll_us / 1000000;
+            sleep_time.tv_nsec = (poll_us % 1000000) * 1000;
+            clock_nanosleep(CLOCK_MONOTONIC, 0, &sleep_time, NULL);
+        }
     }
 
     if (exit_sig == 1) {
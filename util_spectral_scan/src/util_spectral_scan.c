@@ -302,8 +302,12 @@ int main( int argc, char ** argv )
         printf("%d", freq);
 
         if (lbt_support == false) {
-            /* Set SX127x */
-            x = lgw_setup_sx127x(freq, MOD_FSK, channel_bw_khz, rssi_offset);
+            /* Set SX127x, fully configured for the first frequency, then only retuned */
+            if (j == 0) {
+                x = lgw_setup_sx127x(freq, MOD_FSK, channel_bw_khz, rssi_offset);
+            } else {
+                x = lgw_sx127x_retune(freq, channel_bw_khz);
+            }
             if( x != 0 )
             {
                 printf( "ERROR: SX127x setup failed\n" );
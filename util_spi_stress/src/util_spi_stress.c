@@ -31,8 +31,11 @@ Maintainer: Sylvain Miermont
 #include <signal.h>     /* sigaction */
 #include <unistd.h>     /* getopt access */
 #include <stdlib.h>     /* rand */
+#include <string.h>     /* strncpy */
+#include <time.h>       /* clock_gettime */
 
 #include "loragw_reg.h"
+#include "loragw_spi.h"
 
 /* -------------------------------------------------------------------------- */
 /* --- PRIVATE MACROS ------------------------------------------------------- */
@@ -79,6 +82,9 @@ void usage(void) {
     MSG( "Available options:\n");
     MSG( " -h print this help\n");
     MSG( " -t <int> specify which test you want to run (1-4)\n");
+    MSG( " -d <path> SPI device (default /dev/spidev0.0)\n");
+    MSG( " -s <int> SPI max clock in Hz (default 8000000)\n");
+    MSG( " -c <int> max size of SPI burst chunks in bytes (default 1024)\n");
 }
 
 /* -------------------------------------------------------------------------- */
@@ -105,8 +111,15 @@ int main(int argc, char **argv)
     uint8_t test_buff[BUFF_SIZE];
     uint8_t read_buff[BUFF_SIZE];
 
+    /* SPI link configuration & throughput measurement */
+    struct lgw_spi_native_conf_s spiconf;
+    struct timespec t0, t1;
+    double dt;
+
+    lgw_spi_native_getconf(&spiconf);
+
     /* parse command line options */
-    while ((i = getopt (argc, argv, "ht:")) != -1) {
+    while ((i = getopt (argc, argv, "ht:d:s:c:")) != -1) {
         switch (i) {
             case 'h':
                 usage();
@@ -123,6 +136,30 @@ int main(int argc, char **argv)
                 }
                 break;
 
+            case 'd':
+                strncpy(spiconf.dev_path, optarg, sizeof spiconf.dev_path - 1);
+                break;
+
+            case 's':
+                i = sscanf(optarg, "%i", &xi);
+                if ((i != 1) || (xi < 1)) {
+                    MSG("ERROR: invalid SPI clock\n");
+                    return EXIT_FAILURE;
+                } else {
+                    spiconf.speed_hz = xi;
+                }
+                break;
+
+            case 'c':
+                i = sscanf(optarg, "%i", &xi);
+                if ((i != 1) || (xi < 1) || (xi > 0xFFFF)) {
+                    MSG("ERROR: invalid SPI chunk size\n");
+                    return EXIT_FAILURE;
+                } else {
+                    spiconf.chunk_size = xi;
+                }
+                break;
+
             default:
                 MSG("ERROR: argument parsing use -h option for help\n");
                 usage();
@@ -140,11 +177,17 @@ int main(int argc, char **argv)
     sigaction(SIGTERM, &sigact, NULL);
 
     /* start SPI link */
+    if (lgw_spi_native_setconf(spiconf) != LGW_SPI_SUCCESS) {
+        MSG("ERROR: invalid SPI configuration\n");
+        return EXIT_FAILURE;
+    }
     i = lgw_connect(false, DEFAULT_TX_NOTCH_FREQ);
     if (i != LGW_REG_SUCCESS) {
         MSG("ERROR: lgw_connect() did not return SUCCESS");
         return EXIT_FAILURE;
     }
+    lgw_spi_native_getconf(&spiconf);
+    MSG("INFO: SPI device %s, clock requested %u Hz, applied %u Hz, chunk %u bytes\n", spiconf.dev_path, spiconf.speed_hz, spiconf.speed_applied, spiconf.chunk_size);
 
     if (test_number == 1) {
         /* single 8b register R/W stress test */
@@ -239,10 +282,13 @@ int main(int argc, char **argv)
             }
             printf("Cycle %i > ", cycle_number);
             test_addr = rand() & 0xFFFF;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
             lgw_reg_w(LGW_RX_DATA_BUF_ADDR, test_addr); /* write at random offset in memory */
             lgw_reg_wb(LGW_RX_DATA_BUF_DATA, test_buff, BUFF_SIZE);
             lgw_reg_w(LGW_RX_DATA_BUF_ADDR, test_addr); /* go back to start of segment */
             lgw_reg_rb(LGW_RX_DATA_BUF_DATA, read_buff, BUFF_SIZE);
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            dt = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1E9;
             for (i=0; ((i<BUFF_SIZE) && (test_buff[i] == read_buff[i])); ++i);
             if (i != BUFF_SIZE) {
                 printf("error during the buffer comparison\n");
@@ -268,7 +314,7 @@ int main(int argc, char **argv)
                 printf("\n");
                 return EXIT_FAILURE;
             } else {
-                printf("did a %i-byte R/W on a data buffer with no error\n", BUFF_SIZE);
+                printf("did a %i-byte R/W on a data buffer with no error (%.1f kB/s)\n", BUFF_SIZE, (2 * BUFF_SIZE) / (dt * 1E3));
                 ++cycle_number;
             }
         }